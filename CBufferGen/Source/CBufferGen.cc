@@ -0,0 +1,490 @@
+#include "CBufferGen.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+using namespace std;
+
+namespace CBufferGen {
+
+namespace {
+
+const uint32_t REGISTER_SIZE = 16;
+
+bool Fail(const string& message)
+{
+  fprintf(stderr, "CBufferGen: %s\n", message.c_str());
+  return false;
+}
+
+uint32_t AlignTo(uint32_t value, uint32_t alignment) { return (value + alignment - 1) / alignment * alignment; }
+
+string Trim(const string& text)
+{
+  const size_t begin = text.find_first_not_of(" \t\r");
+  if (begin == string::npos) return "";
+  const size_t end = text.find_last_not_of(" \t\r");
+  return text.substr(begin, end - begin + 1);
+}
+
+// DXC prefixes the names of its layout structs, "hostlayout.struct.PointLight" is the HLSL PointLight.
+string StripStructName(string name)
+{
+  for (const char* prefix : {"hostlayout.", "struct."}) {
+    const string prefixText(prefix);
+    if (name.compare(0, prefixText.size(), prefixText) == 0) name = name.substr(prefixText.size());
+  }
+  return name;
+}
+
+// "float3", "uint", "float4x4" or "bool2", false for types the engine does not upload, e.g. double and min precision types.
+bool ParseBuiltinType(const string& text, Type& type)
+{
+  static const char* const SCALARS[] = {"float", "uint", "int", "bool", "dword"};
+  for (const char* scalar : SCALARS) {
+    const string name(scalar);
+    if (text.compare(0, name.size(), name) != 0) continue;
+
+    const string dims = text.substr(name.size());
+    type.Name         = name == "dword" ? "uint" : name;
+    if (dims.empty()) {
+      type.Kind = TypeKind::SCALAR;
+      return true;
+    }
+    if (dims.size() == 1 && dims[0] >= '1' && dims[0] <= '4') {
+      type.Kind    = TypeKind::VECTOR;
+      type.Columns = dims[0] - '0';
+      return true;
+    }
+    if (dims.size() == 3 && dims[1] == 'x' && dims[0] >= '1' && dims[0] <= '4' && dims[2] >= '1' && dims[2] <= '4') {
+      type.Kind    = TypeKind::MATRIX;
+      type.Rows    = dims[0] - '0';
+      type.Columns = dims[2] - '0';
+      return true;
+    }
+  }
+  if (text == "matrix") {
+    type.Kind    = TypeKind::MATRIX;
+    type.Name    = "float";
+    type.Rows    = 4;
+    type.Columns = 4;
+    return true;
+  }
+  return false;
+}
+
+// "name[4];" into name and count.
+bool ParseDeclarator(string text, Field& field)
+{
+  const size_t semicolon = text.find(';');
+  if (semicolon == string::npos) return false;
+  text = Trim(text.substr(0, semicolon));
+
+  const size_t bracket = text.find('[');
+  field.Name           = Trim(text.substr(0, bracket));
+  field.ArrayCount     = bracket == string::npos ? 0 : static_cast<uint32_t>(stoul(text.substr(bracket + 1)));
+  return !field.Name.empty();
+}
+
+// The "; Offset: 208" and "Size: 268" comments at the end of a listing line.
+bool ParseListedNumber(const string& line, const string& key, uint32_t& value)
+{
+  const size_t pos = line.find(key);
+  if (pos == string::npos) return false;
+  value = static_cast<uint32_t>(stoul(line.substr(pos + key.size())));
+  return true;
+}
+
+}  // namespace
+
+bool ListingParser::Parse(const string& fileName)
+{
+  ifstream file(fileName);
+  if (!file) return Fail("can't open " + fileName);
+
+  mFileName = fileName;
+  vector<string> lines;
+  bool inDefinitions = false;
+  for (string line; getline(file, line);) {
+    // Only the leading comment block of the listing describes buffers.
+    if (line.compare(0, 1, ";") != 0) continue;
+    const string text = Trim(line.substr(1));
+    if (text == "Buffer Definitions:") {
+      inDefinitions = true;
+      continue;
+    }
+    if (text == "Resource Bindings:") break;
+    if (inDefinitions) lines.push_back(text);
+  }
+
+  for (size_t i = 0; i < lines.size(); ++i) {
+    // Other blocks, e.g. "Resource bind info for gInstances", describe structured buffers.
+    if (lines[i].compare(0, 8, "cbuffer ") != 0) continue;
+
+    const string cbufferName = Trim(lines[i].substr(8));
+    // "{", "struct cbPass", "{", the variables, "} cbPass; ; Offset: 0 Size: 268", "}".
+    size_t line = i + 1;
+    while (line < lines.size() && lines[line].compare(0, 7, "struct ") != 0) ++line;
+    StructDef cbuffer;
+    cbuffer.Name = cbufferName;
+    Field closing;
+    if (!ParseStruct(lines, line, cbuffer, closing)) return false;
+    if (!AddDefinition(mCBuffers, mCBufferOrder, cbuffer)) return false;
+    i = line;
+  }
+  return true;
+}
+
+// lines[line] is "struct name", on success it is the closing "} declarator;" line.
+bool ListingParser::ParseStruct(const vector<string>& lines, size_t& line, StructDef& def, Field& closing)
+{
+  if (line + 1 >= lines.size() || lines[line + 1] != "{") return Fail(mFileName + ": struct without body");
+  for (line += 2; line < lines.size(); ++line) {
+    const string& text = lines[line];
+    if (text.empty()) continue;
+
+    if (text[0] == '}') {
+      if (!ParseDeclarator(text.substr(1), closing)) return Fail(mFileName + ": bad struct end \"" + text + "\"");
+      ParseListedNumber(text, "Offset:", closing.ListedOffset);
+      ParseListedNumber(text, "Size:", def.ListedSize);
+      return true;
+    }
+
+    Field field;
+    if (text.compare(0, 7, "struct ") == 0) {
+      StructDef nested;
+      nested.Name = StripStructName(Trim(text.substr(7)));
+      if (!ParseStruct(lines, line, nested, field)) return false;
+      if (!AddDefinition(mStructs, mStructOrder, nested)) return false;
+      field.FieldType.Kind = TypeKind::STRUCT;
+      field.FieldType.Name = nested.Name;
+      field.Members        = nested.Fields;
+      def.Fields.push_back(field);
+      continue;
+    }
+
+    // "column_major float4x4 gViewProj; ; Offset: 0"
+    istringstream words(text);
+    string word;
+    words >> word;
+    if (word == "row_major" || word == "column_major") {
+      field.FieldType.RowMajor = word == "row_major";
+      words >> word;
+    }
+    if (!ParseBuiltinType(word, field.FieldType)) return Fail(mFileName + ": unsupported type " + word + " in " + def.Name);
+    string declarator;
+    getline(words, declarator);
+    if (!ParseDeclarator(declarator, field)) return Fail(mFileName + ": bad variable \"" + text + "\"");
+    if (!ParseListedNumber(text, "Offset:", field.ListedOffset)) return Fail(mFileName + ": no offset for " + field.Name);
+    def.Fields.push_back(field);
+  }
+  return Fail(mFileName + ": unterminated struct " + def.Name);
+}
+
+// The stages of a shader list the same cbuffers and structs, they must agree.
+bool ListingParser::AddDefinition(map<string, StructDef>& defs, vector<string>& order, const StructDef& def)
+{
+  auto iter = defs.find(def.Name);
+  if (iter == defs.end()) {
+    defs[def.Name] = def;
+    order.push_back(def.Name);
+    return true;
+  }
+
+  const StructDef& known = iter->second;
+  bool same              = known.Fields.size() == def.Fields.size();
+  for (size_t i = 0; same && i < def.Fields.size(); ++i) {
+    const Field& a = known.Fields[i];
+    const Field& b = def.Fields[i];
+    same = a.Name == b.Name && a.ArrayCount == b.ArrayCount && a.FieldType.Kind == b.FieldType.Kind && a.FieldType.Name == b.FieldType.Name &&
+           a.FieldType.Rows == b.FieldType.Rows && a.FieldType.Columns == b.FieldType.Columns && a.FieldType.RowMajor == b.FieldType.RowMajor;
+  }
+  return same ? true : Fail(mFileName + ": " + def.Name + " differs from an earlier listing");
+}
+
+bool Generator::Run(const Options& options)
+{
+  if (!Load(options)) return false;
+
+  ofstream out(options.Output);
+  if (!out) return Fail("can't write " + options.Output);
+  WriteHeader(out);
+  return true;
+}
+
+bool Generator::Load(const Options& options)
+{
+  mOptions = options;
+  ListingParser parser(mStructs, mStructOrder, mCBuffers, mCBufferOrder);
+  for (const string& listing : options.Listings) {
+    if (!parser.Parse(listing)) return false;
+  }
+  FilterCBuffers();
+  if (mCBufferOrder.empty()) return Fail("no cbuffer in the listings");
+
+  for (const string& name : mStructOrder) {
+    if (!LayoutStruct(mStructs[name], false)) return false;
+  }
+  for (const string& name : mCBufferOrder) {
+    if (!LayoutStruct(mCBuffers[name], true)) return false;
+  }
+  return true;
+}
+
+const StructDef* Generator::FindCBuffer(const string& name) const
+{
+  if (find(mCBufferOrder.begin(), mCBufferOrder.end(), name) == mCBufferOrder.end()) return nullptr;
+  return &mCBuffers.at(name);
+}
+
+const StructDef* Generator::FindStruct(const string& name) const
+{
+  if (find(mStructOrder.begin(), mStructOrder.end(), name) == mStructOrder.end()) return nullptr;
+  return &mStructs.at(name);
+}
+
+// Drops the cbuffers left out by -c and -x, and the structs only they use.
+void Generator::FilterCBuffers()
+{
+  vector<string> kept;
+  for (const string& name : mCBufferOrder) {
+    const bool selected = mOptions.OnlyCBuffers.empty() || mOptions.OnlyCBuffers.count(name) != 0;
+    if (selected && mOptions.SkippedCBuffers.count(name) == 0) kept.push_back(name);
+  }
+  mCBufferOrder = kept;
+
+  set<string> used;
+  vector<const vector<Field>*> pending;
+  for (const string& name : mCBufferOrder) pending.push_back(&mCBuffers[name].Fields);
+  while (!pending.empty()) {
+    const vector<Field>* fields = pending.back();
+    pending.pop_back();
+    for (const Field& field : *fields) {
+      if (field.FieldType.Kind != TypeKind::STRUCT || !used.insert(field.FieldType.Name).second) continue;
+      pending.push_back(&mStructs[field.FieldType.Name].Fields);
+    }
+  }
+
+  vector<string> usedOrder;
+  for (const string& name : mStructOrder) {
+    if (used.count(name) != 0) usedOrder.push_back(name);
+  }
+  mStructOrder = usedOrder;
+}
+
+// Size of one value, arrays are handled by the caller.
+uint32_t Generator::ValueSize(const Type& type) const
+{
+  switch (type.Kind) {
+    case TypeKind::SCALAR:
+      return 4;
+    case TypeKind::VECTOR:
+      return 4 * type.Columns;
+    case TypeKind::MATRIX:
+      // A register per column, or per row for row_major, the last one is not padded.
+      return type.RowMajor ? (type.Rows - 1) * REGISTER_SIZE + 4 * type.Columns : (type.Columns - 1) * REGISTER_SIZE + 4 * type.Rows;
+    case TypeKind::STRUCT:
+      return mStructs.at(type.Name).Size;
+  }
+  return 0;
+}
+
+// Arrays, structs and matrices of several registers start a register, anything else only when it would straddle one.
+bool Generator::StartsRegister(const Field& field) const
+{
+  if (field.ArrayCount != 0 || field.FieldType.Kind == TypeKind::STRUCT) return true;
+  if (field.FieldType.Kind == TypeKind::MATRIX) return field.FieldType.RowMajor ? field.FieldType.Rows > 1 : field.FieldType.Columns > 1;
+  return false;
+}
+
+// Lays out fields from the start of their struct, base is that start in the cbuffer to check the listed offsets against.
+// Struct definitions are laid out without a base, their listed offsets belong to one use.
+bool Generator::LayoutFields(const string& owner, vector<Field>& fields, uint32_t base, bool check, uint32_t& size)
+{
+  uint32_t offset = 0;
+  for (Field& field : fields) {
+    const Type& type = field.FieldType;
+    if (field.ArrayCount != 0 && type.Kind == TypeKind::MATRIX && !(type.Rows == 4 && type.Columns == 4)) {
+      return Fail(owner + "." + field.Name + ": arrays of padded matrices are not supported, use float4 rows");
+    }
+
+    const uint32_t valueSize = ValueSize(type);
+    field.Size = field.ArrayCount == 0 ? valueSize : AlignTo(valueSize, REGISTER_SIZE) * (field.ArrayCount - 1) + valueSize;
+
+    const bool straddles = offset % REGISTER_SIZE + field.Size > REGISTER_SIZE;
+    field.Offset         = StartsRegister(field) || straddles ? AlignTo(offset, REGISTER_SIZE) : offset;
+    offset               = field.Offset + field.Size;
+    if (!check) continue;
+
+    if (base + field.Offset != field.ListedOffset) {
+      return Fail(owner + "." + field.Name + " is listed at " + to_string(field.ListedOffset) + ", the packing rules place it at " +
+                  to_string(base + field.Offset));
+    }
+    uint32_t nestedSize = 0;
+    if (type.Kind == TypeKind::STRUCT && !LayoutFields(owner + "." + field.Name, field.Members, base + field.Offset, true, nestedSize)) return false;
+  }
+  size = offset;
+  return true;
+}
+
+bool Generator::LayoutStruct(StructDef& def, bool check)
+{
+  if (!LayoutFields(def.Name, def.Fields, 0, check, def.Size)) return false;
+  if (def.ListedSize != 0 && def.ListedSize != def.Size) {
+    return Fail(def.Name + " is listed with " + to_string(def.ListedSize) + " bytes, the packing rules give " + to_string(def.Size));
+  }
+  return true;
+}
+
+string Generator::ValueTypeName(const Type& type) const
+{
+  static const map<string, string> SCALAR_TYPES = {{"float", "float"}, {"uint", "uint32"}, {"int", "int32"}, {"bool", "uint32"}};
+  static const map<string, string> VECTOR_TYPES = {{"float", "DirectX::XMFLOAT"}, {"uint", "DirectX::XMUINT"}, {"int", "DirectX::XMINT"}, {"bool", "DirectX::XMUINT"}};
+  switch (type.Kind) {
+    case TypeKind::SCALAR:
+      return SCALAR_TYPES.at(type.Name);
+    case TypeKind::VECTOR:
+      return type.Columns == 1 ? SCALAR_TYPES.at(type.Name) : VECTOR_TYPES.at(type.Name) + to_string(type.Columns);
+    case TypeKind::MATRIX:
+      // Padded matrices, e.g. float3x3, are written as floats, see the field comment.
+      return type.Name == "float" && type.Rows == 4 && type.Columns == 4 ? "DirectX::XMFLOAT4X4" : SCALAR_TYPES.at(type.Name);
+    case TypeKind::STRUCT: {
+      auto iter = mOptions.MappedTypes.find(type.Name);
+      return iter != mOptions.MappedTypes.end() ? iter->second : type.Name;
+    }
+  }
+  return "";
+}
+
+string Generator::FieldComment(const Field& field) const
+{
+  const Type& type = field.FieldType;
+  if (type.Kind == TypeKind::MATRIX) {
+    if (type.Rows == 4 && type.Columns == 4) return type.RowMajor ? "row_major." : "column_major, store the transpose.";
+    const string dims = type.Name + to_string(type.Rows) + "x" + to_string(type.Columns);
+    return type.RowMajor ? "row_major " + dims + ", row r starts at [4 * r]." : "column_major " + dims + ", column c starts at [4 * c].";
+  }
+  if (type.Name == "bool") return "bool, 0 or 1.";
+  return "";
+}
+
+// Declaration of field and of the padding before it, as declaration and trailing comment.
+void Generator::AddFieldLines(const Field& field, uint32_t& cursor, uint32_t& padCount, vector<pair<string, string>>& lines) const
+{
+  if (field.Offset > cursor) {
+    const uint32_t padFloats = (field.Offset - cursor) / 4;
+    lines.emplace_back("float Pad" + to_string(padCount++) + (padFloats > 1 ? "[" + to_string(padFloats) + "];" : ";"), "");
+  }
+  cursor = field.Offset + field.Size;
+
+  const Type& type         = field.FieldType;
+  const string typeName    = ValueTypeName(type);
+  const uint32_t valueSize = ValueSize(type);
+  string declaration;
+  if (type.Kind == TypeKind::MATRIX && typeName != "DirectX::XMFLOAT4X4") {
+    declaration = typeName + " " + field.Name + "[" + to_string(valueSize / 4) + "];";
+  } else if (field.ArrayCount == 0) {
+    declaration = typeName + " " + field.Name + ";";
+  } else if (field.ArrayCount == 1 || valueSize % REGISTER_SIZE == 0) {
+    declaration = typeName + " " + field.Name + "[" + to_string(field.ArrayCount) + "];";
+  } else {
+    declaration = "CBufferArray<" + typeName + ", " + to_string(field.ArrayCount) + "> " + field.Name + ";";
+  }
+  lines.emplace_back(declaration, FieldComment(field));
+}
+
+void Generator::WriteStruct(ostream& out, const StructDef& def, bool isCBuffer) const
+{
+  out << "struct " << def.Name << " {\n";
+  uint32_t cursor   = 0;
+  uint32_t padCount = 0;
+  vector<pair<string, string>> lines;
+  for (const Field& field : def.Fields) AddFieldLines(field, cursor, padCount, lines);
+
+  // Trailing comments line up.
+  size_t width = 0;
+  for (const auto& line : lines) {
+    if (!line.second.empty()) width = max(width, line.first.size());
+  }
+  for (const auto& line : lines) {
+    out << "  " << line.first;
+    if (!line.second.empty()) out << string(width - line.first.size() + 2, ' ') << "// " << line.second;
+    out << "\n";
+  }
+
+  if (isCBuffer) {
+    out << "\n";
+    out << "  static constexpr CBufferVarName Name() { return CBufferVarName(CTEXT(\"" << def.Name << "\")); }\n";
+    out << "  static const CBufferLayout& Layout();\n";
+  }
+  out << "};\n";
+
+  for (const Field& field : def.Fields) {
+    out << "static_assert(offsetof(" << def.Name << ", " << field.Name << ") == " << field.Offset << ", \"" << def.Name << "." << field.Name
+        << " offset\");\n";
+  }
+  out << "static_assert(sizeof(" << def.Name << ") == " << def.Size << ", \"" << def.Name << " size\");\n";
+
+  if (!isCBuffer) return;
+  out << "\n";
+  out << "inline const CBufferLayout& " << def.Name << "::Layout()\n";
+  out << "{\n";
+  out << "  static const CBufferFieldLayout FIELDS[] = {\n";
+  for (const Field& field : def.Fields) {
+    out << "      {CTEXT(\"" << field.Name << "\"), " << field.Offset << ", " << field.Size << "},\n";
+  }
+  out << "  };\n";
+  out << "  static const CBufferLayout LAYOUT = {CTEXT(\"" << def.Name << "\"), " << def.Size << ", FIELDS, " << def.Fields.size() << "};\n";
+  out << "  return LAYOUT;\n";
+  out << "}\n";
+}
+
+void Generator::WriteHeader(ostream& out) const
+{
+  // PBRConstants gives GENERATED_PBR_CONSTANTS_H.
+  const string& name = mOptions.Namespace;
+  string guard       = "GENERATED_";
+  for (size_t i = 0; i < name.size(); ++i) {
+    const bool wordStart = i > 0 && isupper(name[i]) && (islower(name[i - 1]) || (i + 1 < name.size() && islower(name[i + 1]) && isupper(name[i - 1])));
+    if (wordStart) guard += '_';
+    guard += static_cast<char>(toupper(name[i]));
+  }
+  guard += "_H";
+
+  out << "// Generated by CBufferGen from";
+  for (const string& listing : mOptions.Listings) out << " " << listing.substr(listing.find_last_of("/\\") + 1);
+  out << ", do not edit.\n";
+  out << "#ifndef " << guard << "\n";
+  out << "#define " << guard << "\n";
+  out << "#include <DirectXMath.h>\n\n";
+  out << "#include <cstddef>\n\n";
+  out << "#include \"Shader/CBufferLayout.h\"\n";
+  for (const string& include : mOptions.Includes) out << "#include \"" << include << "\"\n";
+  out << "\n";
+  out << "namespace " << mOptions.Namespace << " {\n";
+
+  for (const string& name : mStructOrder) {
+    const StructDef& def = mStructs.at(name);
+    auto mapped          = mOptions.MappedTypes.find(name);
+    out << "\n";
+    if (mapped != mOptions.MappedTypes.end()) {
+      out << "static_assert(sizeof(" << mapped->second << ") == " << def.Size << ", \"" << mapped->second << " does not match the HLSL " << name
+          << "\");\n";
+      continue;
+    }
+    WriteStruct(out, def, false);
+  }
+  for (const string& name : mCBufferOrder) {
+    out << "\n";
+    WriteStruct(out, mCBuffers.at(name), true);
+  }
+
+  out << "\n";
+  out << "}  // namespace " << mOptions.Namespace << "\n";
+  out << "#endif  // " << guard << "\n";
+}
+
+}  // namespace CBufferGen
@@ -0,0 +1,115 @@
+// Listing parser and cbuffer layout of CBufferGen, Main.cc is the command line. CheeseTests runs them on DXC listings.
+#ifndef CBUFFER_GEN_CBUFFER_GEN_H
+#define CBUFFER_GEN_CBUFFER_GEN_H
+#include <cstdint>
+#include <map>
+#include <ostream>
+#include <set>
+#include <string>
+#include <vector>
+
+namespace CBufferGen {
+
+enum class TypeKind { SCALAR, VECTOR, MATRIX, STRUCT };
+
+struct Type {
+  TypeKind Kind = TypeKind::SCALAR;
+  // float, int, uint or bool for scalars, vectors and matrices, the struct name otherwise.
+  std::string Name;
+  uint32_t Rows    = 1;
+  uint32_t Columns = 1;
+  bool RowMajor    = false;
+};
+
+struct Field {
+  Type FieldType;
+  std::string Name;
+  // 0 for a single value.
+  uint32_t ArrayCount = 0;
+  // Offset DXC listed, from the start of the cbuffer.
+  uint32_t ListedOffset = 0;
+  // Offset from the start of the enclosing struct or cbuffer, from the packing rules.
+  uint32_t Offset = 0;
+  uint32_t Size   = 0;
+  // Fields of a struct as listed at this field, their listed offsets differ between uses of the struct.
+  std::vector<Field> Members;
+};
+
+struct StructDef {
+  std::string Name;
+  std::vector<Field> Fields;
+  uint32_t Size = 0;
+  // Listed size, 0 when the listing has none.
+  uint32_t ListedSize = 0;
+};
+
+struct Options {
+  std::map<std::string, std::string> MappedTypes;
+  std::vector<std::string> Includes;
+  std::set<std::string> OnlyCBuffers;
+  std::set<std::string> SkippedCBuffers;
+  std::string Namespace;
+  std::string Output;
+  std::vector<std::string> Listings;
+};
+
+// Reads the "Buffer Definitions" comment block of a listing, the cbuffers and the structs they use.
+class ListingParser
+{
+ public:
+  ListingParser(std::map<std::string, StructDef>& structs, std::vector<std::string>& structOrder, std::map<std::string, StructDef>& cbuffers,
+                std::vector<std::string>& cbufferOrder)
+      : mStructs(structs), mStructOrder(structOrder), mCBuffers(cbuffers), mCBufferOrder(cbufferOrder)
+  {
+  }
+
+  bool Parse(const std::string& fileName);
+
+ private:
+  bool ParseStruct(const std::vector<std::string>& lines, size_t& line, StructDef& def, Field& closing);
+  bool AddDefinition(std::map<std::string, StructDef>& defs, std::vector<std::string>& order, const StructDef& def);
+
+ private:
+  std::map<std::string, StructDef>& mStructs;
+  std::vector<std::string>& mStructOrder;
+  std::map<std::string, StructDef>& mCBuffers;
+  std::vector<std::string>& mCBufferOrder;
+  std::string mFileName;
+};
+
+class Generator
+{
+ public:
+  // Loads, then writes options.Output.
+  bool Run(const Options& options);
+  // Parses the listings and lays the selected cbuffers out, failing when an offset or size differs from the listing.
+  bool Load(const Options& options);
+  void WriteHeader(std::ostream& out) const;
+
+  // nullptr when the cbuffer or struct is not in the listings or was filtered out.
+  const StructDef* FindCBuffer(const std::string& name) const;
+  const StructDef* FindStruct(const std::string& name) const;
+  inline const std::vector<std::string>& GetCBufferOrder() const { return mCBufferOrder; }
+  inline const std::vector<std::string>& GetStructOrder() const { return mStructOrder; }
+
+ private:
+  void FilterCBuffers();
+  uint32_t ValueSize(const Type& type) const;
+  bool StartsRegister(const Field& field) const;
+  bool LayoutFields(const std::string& owner, std::vector<Field>& fields, uint32_t base, bool check, uint32_t& size);
+  bool LayoutStruct(StructDef& def, bool check);
+  std::string ValueTypeName(const Type& type) const;
+  std::string FieldComment(const Field& field) const;
+  void AddFieldLines(const Field& field, uint32_t& cursor, uint32_t& padCount, std::vector<std::pair<std::string, std::string>>& lines) const;
+  void WriteStruct(std::ostream& out, const StructDef& def, bool isCBuffer) const;
+
+ private:
+  Options mOptions;
+  std::map<std::string, StructDef> mStructs;
+  std::vector<std::string> mStructOrder;
+  std::map<std::string, StructDef> mCBuffers;
+  std::vector<std::string> mCBufferOrder;
+};
+
+}  // namespace CBufferGen
+#endif  // CBUFFER_GEN_CBUFFER_GEN_H
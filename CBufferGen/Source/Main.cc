@@ -0,0 +1,64 @@
+// Offline generator: C++ structs mirroring the cbuffers of a shader, filled by the engine and copied with one memcpy.
+// Reads the buffer definitions of DXC listings, e.g. "dxc -T vs_6_0 -E VS -Fc PBR.VS.lst PBR.hlsl", so it runs wherever DXC does.
+// Offsets are laid out with the HLSL cbuffer packing rules and checked against the listing, the header static_asserts them.
+// It only uses the standard library, build it with any C++14 compiler, e.g. g++ -std=c++14 -O2 -o CBufferGen Main.cc CBufferGen.cc
+//
+// Usage: CBufferGen [-t HlslStruct=CppType]... [-i include]... [-c cbuffer]... [-x cbuffer]... <namespace> <output.h> <listing>...
+//   -t  Uses an existing C++ type for an HLSL struct instead of generating one, its size is static_asserted.
+//   -i  Extra include of the header, e.g. the one declaring the -t types.
+//   -c  Only generates the given cbuffers, e.g. a block shared by several shaders.
+//   -x  Skips the given cbuffers, e.g. the shared blocks generated on their own.
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "CBufferGen.h"
+
+using namespace std;
+using namespace CBufferGen;
+
+namespace {
+
+bool ParseOptions(int argc, char** argv, Options& options)
+{
+  vector<string> positional;
+  for (int i = 1; i < argc; ++i) {
+    const string arg = argv[i];
+    if ((arg == "-t" || arg == "-i" || arg == "-c" || arg == "-x") && i + 1 < argc) {
+      const string value = argv[++i];
+      if (arg == "-i") {
+        options.Includes.push_back(value);
+        continue;
+      }
+      if (arg == "-c" || arg == "-x") {
+        (arg == "-c" ? options.OnlyCBuffers : options.SkippedCBuffers).insert(value);
+        continue;
+      }
+      const size_t equal = value.find('=');
+      if (equal == string::npos) return false;
+      options.MappedTypes[value.substr(0, equal)] = value.substr(equal + 1);
+      continue;
+    }
+    positional.push_back(arg);
+  }
+  if (positional.size() < 3) return false;
+
+  options.Namespace = positional[0];
+  options.Output    = positional[1];
+  options.Listings.assign(positional.begin() + 2, positional.end());
+  return true;
+}
+
+}  // namespace
+
+int main(int argc, char** argv)
+{
+  Options options;
+  if (!ParseOptions(argc, argv, options)) {
+    printf("Usage: CBufferGen [-t HlslStruct=CppType]... [-i include]... [-c cbuffer]... [-x cbuffer]... <namespace> <output.h> <listing>...\n");
+    return 1;
+  }
+
+  Generator generator;
+  return generator.Run(options) ? 0 : 1;
+}
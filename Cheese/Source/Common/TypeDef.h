@@ -1,19 +1,7 @@
 #ifndef COMMON_DEF_H
 #define COMMON_DEF_H
 
-#include <stdint.h>
-
-using uint8  = uint8_t;
-using uint16 = uint16_t;
-using uint32 = uint32_t;
-using uint64 = uint64_t;
-
-using int8  = int8_t;
-using int16 = int16_t;
-using int32 = int32_t;
-using int64 = int64_t;
-
-using Byte = uint8;
+#include "Types.h"
 
 #include <windows.h>
 
@@ -0,0 +1,19 @@
+#ifndef COMMON_TYPES_H
+#define COMMON_TYPES_H
+
+// Fixed width types without the platform headers, for code that must build and be tested away from windows.h.
+#include <stdint.h>
+
+using uint8  = uint8_t;
+using uint16 = uint16_t;
+using uint32 = uint32_t;
+using uint64 = uint64_t;
+
+using int8  = int8_t;
+using int16 = int16_t;
+using int32 = int32_t;
+using int64 = int64_t;
+
+using Byte = uint8;
+
+#endif  // COMMON_TYPES_H
@@ -68,6 +68,25 @@ XMMATRIX Camera::GetViewProjMatrixXM() const { return GetViewMatrixXM() * GetPro
 
 D3D12_VIEWPORT Camera::GetViewPort() const { return mViewPort; }
 
+void Camera::GetFrustumPlanes(XMFLOAT4 planes[6], FXMMATRIX objectToWorld) const
+{
+  ExtractFrustumPlanes(objectToWorld * GetViewProjMatrixXM(), planes);
+}
+
+void Camera::ExtractFrustumPlanes(FXMMATRIX viewProj, XMFLOAT4 planes[6])
+{
+  // Gribb-Hartmann: with clip = p * M every clip space inequality is a plane made of M columns.
+  // D3D clip space z runs from 0 to w.
+  const XMMATRIX columns = XMMatrixTranspose(viewProj);
+
+  XMStoreFloat4(&planes[0], XMPlaneNormalize(XMVectorAdd(columns.r[3], columns.r[0])));
+  XMStoreFloat4(&planes[1], XMPlaneNormalize(XMVectorSubtract(columns.r[3], columns.r[0])));
+  XMStoreFloat4(&planes[2], XMPlaneNormalize(XMVectorAdd(columns.r[3], columns.r[1])));
+  XMStoreFloat4(&planes[3], XMPlaneNormalize(XMVectorSubtract(columns.r[3], columns.r[1])));
+  XMStoreFloat4(&planes[4], XMPlaneNormalize(columns.r[2]));
+  XMStoreFloat4(&planes[5], XMPlaneNormalize(XMVectorSubtract(columns.r[3], columns.r[2])));
+}
+
 float Camera::GetNearZ() const { return mNearZ; }
 
 float Camera::GetFarZ() const { return mFarZ; }
@@ -43,6 +43,12 @@ class Camera
 
   D3D12_VIEWPORT GetViewPort() const;
 
+  // Left, right, bottom, top, near, far planes with inward normals: dot(xyz, p) + w >= 0 inside.
+  // The planes come out in the space objectToWorld maps from, world space by default.
+  void GetFrustumPlanes(DirectX::XMFLOAT4 planes[6], DirectX::FXMMATRIX objectToWorld = DirectX::XMMatrixIdentity()) const;
+  // Same planes for any view projection, such as the orthographic one of a shadow map.
+  static void ExtractFrustumPlanes(DirectX::FXMMATRIX viewProj, DirectX::XMFLOAT4 planes[6]);
+
   float GetNearZ() const;
   float GetFarZ() const;
   float GetFovY() const;
@@ -0,0 +1,51 @@
+#include "Graphics/CommandListPool.h"
+
+#include "Graphics/D3DUtil.h"
+
+namespace {
+// New lists start open.
+void CreateList(ID3D12Device* device, ComPtr<ID3D12CommandAllocator>& allocator, ComPtr<ID3D12GraphicsCommandList>& list)
+{
+  TIFF(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(allocator.GetAddressOf())));
+  TIFF(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Get(), nullptr, IID_PPV_ARGS(list.GetAddressOf())));
+}
+}  // namespace
+
+void CommandListPool::Reserve(ID3D12Device* device, uint32 count)
+{
+  while (mLists.size() < count) {
+    PooledList pooled;
+    CreateList(device, pooled.Allocator, pooled.List);
+    TIFF(pooled.List->Close());
+    mLists.push_back(pooled);
+  }
+  mSubmitLists.reserve(count);
+}
+
+ID3D12GraphicsCommandList* CommandListPool::Acquire(ID3D12Device* device)
+{
+  if (mUsedCount == mLists.size()) {
+    PooledList pooled;
+    CreateList(device, pooled.Allocator, pooled.List);
+    mLists.push_back(pooled);
+    return mLists[mUsedCount++].List.Get();
+  }
+
+  PooledList& pooled = mLists[mUsedCount++];
+  TIFF(pooled.Allocator->Reset());
+  TIFF(pooled.List->Reset(pooled.Allocator.Get(), nullptr));
+  return pooled.List.Get();
+}
+
+void CommandListPool::Submit(ID3D12CommandQueue* queue)
+{
+  if (mSubmittedCount == mUsedCount) return;
+
+  mSubmitLists.clear();
+  for (uint32 i = mSubmittedCount; i < mUsedCount; ++i) {
+    TIFF(mLists[i].List->Close());
+    mSubmitLists.push_back(mLists[i].List.Get());
+  }
+  mSubmittedCount = mUsedCount;
+  queue->ExecuteCommandLists(static_cast<uint32>(mSubmitLists.size()), mSubmitLists.data());
+}
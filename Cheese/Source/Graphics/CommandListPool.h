@@ -0,0 +1,44 @@
+#ifndef GRAPHICS_COMMAND_LIST_POOL_H
+#define GRAPHICS_COMMAND_LIST_POOL_H
+#include <d3d12.h>
+
+#include <vector>
+
+#include "Common/TypeDef.h"
+#include "Core/Helpers.h"
+
+// Direct command lists for recording parts of a frame on several threads. Every list has an allocator of its own,
+// so any number of them can record at once. Lists are submitted in the order they were acquired, whichever thread recorded them.
+// Acquire and Submit belong to the thread that owns the queue, other threads only record.
+class CommandListPool
+{
+ public:
+  CommandListPool() = default;
+  NO_COPY(CommandListPool)
+
+  // Creates lists up to count, so the frames that use them allocate nothing.
+  void Reserve(ID3D12Device* device, uint32 count);
+  // An open list, created when all lists are in use.
+  ID3D12GraphicsCommandList* Acquire(ID3D12Device* device);
+  // Closes the lists acquired since the last Submit and executes them in one call, in acquire order.
+  void Submit(ID3D12CommandQueue* queue);
+  // Makes every list available again, the GPU has to be done with them.
+  inline void Reset() { mUsedCount = mSubmittedCount = 0; }
+
+  inline uint32 GetListCount() const { return static_cast<uint32>(mLists.size()); }
+  inline uint32 GetUsedCount() const { return mUsedCount; }
+
+ private:
+  struct PooledList {
+    ComPtr<ID3D12CommandAllocator> Allocator;
+    ComPtr<ID3D12GraphicsCommandList> List;
+  };
+
+ private:
+  std::vector<PooledList> mLists;
+  uint32 mUsedCount      = 0;
+  uint32 mSubmittedCount = 0;
+  // Reused by Submit.
+  std::vector<ID3D12CommandList*> mSubmitLists;
+};
+#endif  // GRAPHICS_COMMAND_LIST_POOL_H
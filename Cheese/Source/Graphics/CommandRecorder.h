@@ -0,0 +1,266 @@
+#ifndef GRAPHICS_COMMAND_RECORDER_H
+#define GRAPHICS_COMMAND_RECORDER_H
+#include <cstring>
+
+#include "Common/Types.h"
+#include "Core/Helpers.h"
+
+// The state types a command list takes, specialized next to every command list type, see Graphics/D3D12CommandRecorder.h.
+// DescriptorHandle has a 64 bit ptr like D3D12_GPU_DESCRIPTOR_HANDLE, a value initialized PrimitiveTopology is the undefined one.
+// Kept out of this header so it builds without windows.h, e.g. in tests against a mock command list.
+template <typename CommandList>
+struct CommandListTraits;
+
+// Records state calls into a command list and drops the ones that would set what is bound already.
+// Draw loops call it for every draw and leave the filtering to it, everything else goes to GetCommandList() directly.
+// The recorder only knows what went through it: call Invalidate after recording on the list behind its back, e.g. FSR2.
+// CommandList is ID3D12GraphicsCommandList, or a mock of the same methods for tests, with a CommandListTraits specialization.
+template <typename CommandList>
+class CommandRecorder
+{
+ public:
+  using PipelineState     = typename CommandListTraits<CommandList>::PipelineState;
+  using RootSignature     = typename CommandListTraits<CommandList>::RootSignature;
+  using DescriptorHeap    = typename CommandListTraits<CommandList>::DescriptorHeap;
+  using GpuAddress        = typename CommandListTraits<CommandList>::GpuAddress;
+  using DescriptorHandle  = typename CommandListTraits<CommandList>::DescriptorHandle;
+  using VertexBufferView  = typename CommandListTraits<CommandList>::VertexBufferView;
+  using IndexBufferView   = typename CommandListTraits<CommandList>::IndexBufferView;
+  using PrimitiveTopology = typename CommandListTraits<CommandList>::PrimitiveTopology;
+
+  // A root signature has at most 64 parameters, every one fits a bit of the valid masks.
+  static const uint32 MAX_ROOT_PARAMETERS = 64;
+  // Vertex buffer slots past this are set every time.
+  static const uint32 MAX_VERTEX_BUFFERS   = 4;
+  static const uint32 MAX_DESCRIPTOR_HEAPS = 2;
+
+  CommandRecorder() = default;
+  NO_COPY(CommandRecorder)
+
+  // Starts recording into a reset command list, nothing is bound yet. The counters keep counting.
+  inline void Begin(CommandList* commandList)
+  {
+    mCommandList = commandList;
+    Invalidate();
+  }
+  void Invalidate();
+  inline void ResetCounters() { mIssuedCount = mFilteredCount = 0; }
+  // Forgets one root argument, e.g. after ExecuteIndirect with a command signature that sets it.
+  inline void InvalidateRootArgument(uint32 rootIndex)
+  {
+    if (rootIndex < MAX_ROOT_PARAMETERS) mRootArgumentMask &= ~(1ull << rootIndex);
+  }
+
+  inline CommandList* GetCommandList() const { return mCommandList; }
+  // State calls passed to the command list and dropped since ResetCounters.
+  inline uint32 GetIssuedCount() const { return mIssuedCount; }
+  inline uint32 GetFilteredCount() const { return mFilteredCount; }
+
+  void SetPipelineState(PipelineState* pipelineState);
+  // A new root signature drops all root arguments, as in D3D12.
+  void SetGraphicsRootSignature(RootSignature* rootSignature);
+  // Descriptor tables point into the bound heaps, new heaps drop them.
+  void SetDescriptorHeaps(uint32 count, DescriptorHeap* const* heaps);
+  void SetGraphicsRootConstantBufferView(uint32 rootIndex, GpuAddress address);
+  void SetGraphicsRootShaderResourceView(uint32 rootIndex, GpuAddress address);
+  void SetGraphicsRootDescriptorTable(uint32 rootIndex, DescriptorHandle handle);
+  void IASetVertexBuffers(uint32 startSlot, uint32 count, const VertexBufferView* views);
+  void IASetIndexBuffer(const IndexBufferView* view);
+  void IASetPrimitiveTopology(PrimitiveTopology topology);
+
+ private:
+  // The root argument cache is shared by root CBVs, root SRVs and tables, one root parameter is only ever one of them.
+  bool IsRootArgumentBound(uint32 rootIndex, uint64 value) const;
+  void SetRootArgument(uint32 rootIndex, uint64 value, bool table);
+
+ private:
+  CommandList* mCommandList = nullptr;
+  uint32 mIssuedCount       = 0;
+  uint32 mFilteredCount     = 0;
+
+  PipelineState* mPipelineState = nullptr;
+  RootSignature* mRootSignature = nullptr;
+  PrimitiveTopology mTopology   = PrimitiveTopology();
+  bool mHeapsBound              = false;
+  uint32 mDescriptorHeapCount   = 0;
+  DescriptorHeap* mDescriptorHeaps[MAX_DESCRIPTOR_HEAPS];
+
+  // Bit i is set when root parameter i holds mRootArguments[i], table bits are a subset.
+  uint64 mRootArgumentMask = 0;
+  uint64 mRootTableMask    = 0;
+  uint64 mRootArguments[MAX_ROOT_PARAMETERS];
+
+  uint32 mVertexBufferMask = 0;
+  VertexBufferView mVertexBuffers[MAX_VERTEX_BUFFERS];
+  bool mIndexBufferBound = false;
+  IndexBufferView mIndexBuffer;
+};
+
+template <typename CommandList>
+const uint32 CommandRecorder<CommandList>::MAX_ROOT_PARAMETERS;
+template <typename CommandList>
+const uint32 CommandRecorder<CommandList>::MAX_VERTEX_BUFFERS;
+template <typename CommandList>
+const uint32 CommandRecorder<CommandList>::MAX_DESCRIPTOR_HEAPS;
+
+template <typename CommandList>
+void CommandRecorder<CommandList>::Invalidate()
+{
+  mPipelineState       = nullptr;
+  mRootSignature       = nullptr;
+  mDescriptorHeapCount = 0;
+  mHeapsBound          = false;
+  mTopology            = PrimitiveTopology();
+  mRootArgumentMask    = 0;
+  mRootTableMask       = 0;
+  mVertexBufferMask    = 0;
+  mIndexBufferBound    = false;
+}
+
+template <typename CommandList>
+void CommandRecorder<CommandList>::SetPipelineState(PipelineState* pipelineState)
+{
+  if (pipelineState == mPipelineState) {
+    mFilteredCount++;
+    return;
+  }
+  mPipelineState = pipelineState;
+  mCommandList->SetPipelineState(pipelineState);
+  mIssuedCount++;
+}
+
+template <typename CommandList>
+void CommandRecorder<CommandList>::SetGraphicsRootSignature(RootSignature* rootSignature)
+{
+  if (rootSignature == mRootSignature) {
+    mFilteredCount++;
+    return;
+  }
+  mRootSignature    = rootSignature;
+  mRootArgumentMask = 0;
+  mRootTableMask    = 0;
+  mCommandList->SetGraphicsRootSignature(rootSignature);
+  mIssuedCount++;
+}
+
+template <typename CommandList>
+void CommandRecorder<CommandList>::SetDescriptorHeaps(uint32 count, DescriptorHeap* const* heaps)
+{
+  if (mHeapsBound && count == mDescriptorHeapCount && memcmp(heaps, mDescriptorHeaps, count * sizeof(DescriptorHeap*)) == 0) {
+    mFilteredCount++;
+    return;
+  }
+  mHeapsBound          = count <= MAX_DESCRIPTOR_HEAPS;
+  mDescriptorHeapCount = count;
+  if (mHeapsBound) memcpy(mDescriptorHeaps, heaps, count * sizeof(DescriptorHeap*));
+  mRootArgumentMask &= ~mRootTableMask;
+  mRootTableMask = 0;
+  mCommandList->SetDescriptorHeaps(count, heaps);
+  mIssuedCount++;
+}
+
+template <typename CommandList>
+void CommandRecorder<CommandList>::SetGraphicsRootConstantBufferView(uint32 rootIndex, GpuAddress address)
+{
+  if (IsRootArgumentBound(rootIndex, address)) {
+    mFilteredCount++;
+    return;
+  }
+  SetRootArgument(rootIndex, address, false);
+  mCommandList->SetGraphicsRootConstantBufferView(rootIndex, address);
+  mIssuedCount++;
+}
+
+template <typename CommandList>
+void CommandRecorder<CommandList>::SetGraphicsRootShaderResourceView(uint32 rootIndex, GpuAddress address)
+{
+  if (IsRootArgumentBound(rootIndex, address)) {
+    mFilteredCount++;
+    return;
+  }
+  SetRootArgument(rootIndex, address, false);
+  mCommandList->SetGraphicsRootShaderResourceView(rootIndex, address);
+  mIssuedCount++;
+}
+
+template <typename CommandList>
+void CommandRecorder<CommandList>::SetGraphicsRootDescriptorTable(uint32 rootIndex, DescriptorHandle handle)
+{
+  if (IsRootArgumentBound(rootIndex, handle.ptr)) {
+    mFilteredCount++;
+    return;
+  }
+  SetRootArgument(rootIndex, handle.ptr, true);
+  mCommandList->SetGraphicsRootDescriptorTable(rootIndex, handle);
+  mIssuedCount++;
+}
+
+template <typename CommandList>
+void CommandRecorder<CommandList>::IASetVertexBuffers(uint32 startSlot, uint32 count, const VertexBufferView* views)
+{
+  bool bound = views != nullptr && startSlot + count <= MAX_VERTEX_BUFFERS;
+  for (uint32 i = 0; i < count && bound; ++i) {
+    const uint32 slot = startSlot + i;
+    bound             = (mVertexBufferMask & (1u << slot)) != 0 && memcmp(&mVertexBuffers[slot], &views[i], sizeof(VertexBufferView)) == 0;
+  }
+  if (bound) {
+    mFilteredCount++;
+    return;
+  }
+
+  for (uint32 slot = startSlot; slot < startSlot + count && slot < MAX_VERTEX_BUFFERS; ++slot) {
+    if (views != nullptr) {
+      mVertexBuffers[slot] = views[slot - startSlot];
+      mVertexBufferMask |= 1u << slot;
+    } else {
+      mVertexBufferMask &= ~(1u << slot);
+    }
+  }
+  mCommandList->IASetVertexBuffers(startSlot, count, views);
+  mIssuedCount++;
+}
+
+template <typename CommandList>
+void CommandRecorder<CommandList>::IASetIndexBuffer(const IndexBufferView* view)
+{
+  if (view != nullptr && mIndexBufferBound && memcmp(&mIndexBuffer, view, sizeof(IndexBufferView)) == 0) {
+    mFilteredCount++;
+    return;
+  }
+  mIndexBufferBound = view != nullptr;
+  if (view != nullptr) mIndexBuffer = *view;
+  mCommandList->IASetIndexBuffer(view);
+  mIssuedCount++;
+}
+
+template <typename CommandList>
+void CommandRecorder<CommandList>::IASetPrimitiveTopology(PrimitiveTopology topology)
+{
+  if (topology == mTopology) {
+    mFilteredCount++;
+    return;
+  }
+  mTopology = topology;
+  mCommandList->IASetPrimitiveTopology(topology);
+  mIssuedCount++;
+}
+
+template <typename CommandList>
+bool CommandRecorder<CommandList>::IsRootArgumentBound(uint32 rootIndex, uint64 value) const
+{
+  return rootIndex < MAX_ROOT_PARAMETERS && (mRootArgumentMask & (1ull << rootIndex)) != 0 && mRootArguments[rootIndex] == value;
+}
+
+template <typename CommandList>
+void CommandRecorder<CommandList>::SetRootArgument(uint32 rootIndex, uint64 value, bool table)
+{
+  if (rootIndex >= MAX_ROOT_PARAMETERS) return;
+  mRootArguments[rootIndex] = value;
+  mRootArgumentMask |= 1ull << rootIndex;
+  if (table) {
+    mRootTableMask |= 1ull << rootIndex;
+  } else {
+    mRootTableMask &= ~(1ull << rootIndex);
+  }
+}
+#endif  // GRAPHICS_COMMAND_RECORDER_H
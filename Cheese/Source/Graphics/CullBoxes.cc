@@ -0,0 +1,51 @@
+#include "Graphics/CullBoxes.h"
+
+#include <cmath>
+
+void CullBoxes::Clear()
+{
+  mCenterX.clear();
+  mCenterY.clear();
+  mCenterZ.clear();
+  mExtentX.clear();
+  mExtentY.clear();
+  mExtentZ.clear();
+}
+
+void CullBoxes::Reserve(uint32 count)
+{
+  mCenterX.reserve(count);
+  mCenterY.reserve(count);
+  mCenterZ.reserve(count);
+  mExtentX.reserve(count);
+  mExtentY.reserve(count);
+  mExtentZ.reserve(count);
+}
+
+uint32 CullBoxes::Add(const Float3& center, const Float3& extent)
+{
+  mCenterX.push_back(center.x);
+  mCenterY.push_back(center.y);
+  mCenterZ.push_back(center.z);
+  mExtentX.push_back(extent.x);
+  mExtentY.push_back(extent.y);
+  mExtentZ.push_back(extent.z);
+  return GetCount() - 1;
+}
+
+uint32 CullBoxes::AddTransformed(const Float3& aabbMin, const Float3& aabbMax, const Float4x4& objectToWorld)
+{
+  const float(&m)[4][4] = objectToWorld.m;
+
+  const Float3 center = {(aabbMin.x + aabbMax.x) * 0.5f, (aabbMin.y + aabbMax.y) * 0.5f, (aabbMin.z + aabbMax.z) * 0.5f};
+  const Float3 extent = {(aabbMax.x - aabbMin.x) * 0.5f, (aabbMax.y - aabbMin.y) * 0.5f, (aabbMax.z - aabbMin.z) * 0.5f};
+
+  // Row vectors, p * M. The extent goes through the absolute rotation and scale part.
+  const Float3 worldCenter = {center.x * m[0][0] + center.y * m[1][0] + center.z * m[2][0] + m[3][0],
+                              center.x * m[0][1] + center.y * m[1][1] + center.z * m[2][1] + m[3][1],
+                              center.x * m[0][2] + center.y * m[1][2] + center.z * m[2][2] + m[3][2]};
+  const Float3 worldExtent = {extent.x * fabsf(m[0][0]) + extent.y * fabsf(m[1][0]) + extent.z * fabsf(m[2][0]),
+                              extent.x * fabsf(m[0][1]) + extent.y * fabsf(m[1][1]) + extent.z * fabsf(m[2][1]),
+                              extent.x * fabsf(m[0][2]) + extent.y * fabsf(m[1][2]) + extent.z * fabsf(m[2][2])};
+  return Add(worldCenter, worldExtent);
+}
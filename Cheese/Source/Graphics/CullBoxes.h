@@ -0,0 +1,34 @@
+#ifndef GRAPHICS_CULL_BOXES_H
+#define GRAPHICS_CULL_BOXES_H
+#include <vector>
+
+#include "Common/Types.h"
+#include "Math/Matrix.h"
+
+// Axis aligned boxes as center and half extent, one array per component so the cull kernels load 4 or 8 boxes at once.
+class CullBoxes
+{
+ public:
+  // Keeps the capacity, refilling every frame does not allocate.
+  void Clear();
+  void Reserve(uint32 count);
+
+  // Both return the box index.
+  uint32 Add(const Float3& center, const Float3& extent);
+  // The world space box that encloses the object space box aabbMin/aabbMax moved by objectToWorld.
+  uint32 AddTransformed(const Float3& aabbMin, const Float3& aabbMax, const Float4x4& objectToWorld);
+
+  inline uint32 GetCount() const { return static_cast<uint32>(mCenterX.size()); }
+
+ private:
+  friend class FrustumCuller;
+  friend class OcclusionCuller;
+
+  std::vector<float> mCenterX;
+  std::vector<float> mCenterY;
+  std::vector<float> mCenterZ;
+  std::vector<float> mExtentX;
+  std::vector<float> mExtentY;
+  std::vector<float> mExtentZ;
+};
+#endif  // GRAPHICS_CULL_BOXES_H
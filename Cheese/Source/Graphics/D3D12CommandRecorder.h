@@ -0,0 +1,19 @@
+#ifndef GRAPHICS_D3D12_COMMAND_RECORDER_H
+#define GRAPHICS_D3D12_COMMAND_RECORDER_H
+#include <d3d12.h>
+
+#include "Graphics/CommandRecorder.h"
+
+// CommandRecorder<ID3D12GraphicsCommandList> records into a D3D12 command list.
+template <>
+struct CommandListTraits<ID3D12GraphicsCommandList> {
+  using PipelineState     = ID3D12PipelineState;
+  using RootSignature     = ID3D12RootSignature;
+  using DescriptorHeap    = ID3D12DescriptorHeap;
+  using GpuAddress        = D3D12_GPU_VIRTUAL_ADDRESS;
+  using DescriptorHandle  = D3D12_GPU_DESCRIPTOR_HANDLE;
+  using VertexBufferView  = D3D12_VERTEX_BUFFER_VIEW;
+  using IndexBufferView   = D3D12_INDEX_BUFFER_VIEW;
+  using PrimitiveTopology = D3D12_PRIMITIVE_TOPOLOGY;
+};
+#endif  // GRAPHICS_D3D12_COMMAND_RECORDER_H
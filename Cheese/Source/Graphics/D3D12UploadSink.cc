@@ -0,0 +1,230 @@
+#include "Graphics/D3D12UploadSink.h"
+
+#include <cstring>
+
+#include "Graphics/D3DUtil.h"
+
+D3D12UploadSink::D3D12UploadSink(ID3D12Device* device, ID3D12CommandQueue* queue) : mDevice(device), mQueue(queue)
+{
+  TIFF(mDevice->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(mFence.GetAddressOf())));
+
+  CommandAllocator allocator;
+  TIFF(mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(allocator.Allocator.GetAddressOf())));
+  TIFF(mDevice->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, allocator.Allocator.Get(), nullptr, IID_PPV_ARGS(mCommandList.GetAddressOf())));
+  // Reset() reopens it at the first write.
+  TIFF(mCommandList->Close());
+  mAllocators.push_back(allocator);
+}
+
+D3D12UploadSink::~D3D12UploadSink()
+{
+  if (mFence->GetCompletedValue() < mCurrentFence) {
+    HANDLE eventHandle = CreateEventEx(nullptr, nullptr, false, EVENT_ALL_ACCESS);
+    mFence->SetEventOnCompletion(mCurrentFence, eventHandle);
+    WaitForSingleObject(eventHandle, INFINITE);
+    CloseHandle(eventHandle);
+  }
+  for (UploadPage& page : mPages) page.Buffer->Unmap(0, nullptr);
+}
+
+uint32 D3D12UploadSink::CreateBuffer(uint64 byteSize)
+{
+  SinkResource resource;
+  resource.State     = D3D12_RESOURCE_STATE_COMMON;
+  resource.IsTexture = false;
+  TIFF(mDevice->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+                                        &CD3DX12_RESOURCE_DESC::Buffer(byteSize), resource.State, nullptr,
+                                        IID_PPV_ARGS(resource.Resource.GetAddressOf())));
+  return AddResource(std::move(resource));
+}
+
+uint32 D3D12UploadSink::CreateTexture(uint32 width, uint32 height)
+{
+  SinkResource resource;
+  resource.State     = D3D12_RESOURCE_STATE_COPY_DEST;
+  resource.IsTexture = true;
+  TIFF(mDevice->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+                                        &CD3DX12_RESOURCE_DESC::Tex2D(DXGI_FORMAT_R8G8B8A8_UNORM, width, height, 1, 1), resource.State,
+                                        nullptr, IID_PPV_ARGS(resource.Resource.GetAddressOf())));
+  return AddResource(std::move(resource));
+}
+
+void D3D12UploadSink::WriteBuffer(uint32 resource, uint64 offset, const void* data, uint64 byteSize)
+{
+  SinkResource& target = mResources[resource];
+  uint64 pageOffset    = 0;
+  UploadPage& page     = Allocate(byteSize, 4, pageOffset);
+  memcpy(page.Mapped + pageOffset, data, byteSize);
+
+  Transition(target, D3D12_RESOURCE_STATE_COPY_DEST);
+  GetCommandList()->CopyBufferRegion(target.Resource.Get(), offset, page.Buffer.Get(), pageOffset, byteSize);
+}
+
+void D3D12UploadSink::WriteTextureRows(uint32 resource, uint32 firstRow, uint32 rowCount, const void* data, uint64 rowPitch)
+{
+  SinkResource& target = mResources[resource];
+  const uint32 width   = static_cast<uint32>(target.Resource->GetDesc().Width);
+
+  // Placed footprints need a 256 byte row pitch and a 512 byte aligned start.
+  const uint64 rowBytes     = width * 4ull;
+  const uint64 alignedPitch = (rowBytes + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) & ~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1ull);
+  uint64 pageOffset         = 0;
+  UploadPage& page          = Allocate(alignedPitch * rowCount, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT, pageOffset);
+
+  const Byte* source = static_cast<const Byte*>(data);
+  for (uint32 row = 0; row < rowCount; ++row) {
+    memcpy(page.Mapped + pageOffset + row * alignedPitch, source + row * rowPitch, rowBytes);
+  }
+
+  D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+  footprint.Offset                             = pageOffset;
+  footprint.Footprint.Format                   = DXGI_FORMAT_R8G8B8A8_UNORM;
+  footprint.Footprint.Width                    = width;
+  footprint.Footprint.Height                   = rowCount;
+  footprint.Footprint.Depth                    = 1;
+  footprint.Footprint.RowPitch                 = static_cast<UINT>(alignedPitch);
+
+  CD3DX12_TEXTURE_COPY_LOCATION dst(target.Resource.Get(), 0);
+  CD3DX12_TEXTURE_COPY_LOCATION src(page.Buffer.Get(), footprint);
+  GetCommandList()->CopyTextureRegion(&dst, 0, firstRow, 0, &src, nullptr);
+}
+
+void D3D12UploadSink::Finish(uint32 resource)
+{
+  SinkResource& target = mResources[resource];
+  Transition(target, target.IsTexture ? D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE : D3D12_RESOURCE_STATE_GENERIC_READ);
+}
+
+void D3D12UploadSink::Release(uint32 resource)
+{
+  if (resource == INVALID_UPLOAD_RESOURCE || mResources[resource].Resource == nullptr) return;
+  // Writes still being recorded complete with the next submit.
+  mPendingReleases.push_back({resource, mRecording ? mCurrentFence + 1 : mCurrentFence});
+  FreeReleased();
+}
+
+uint64 D3D12UploadSink::Submit()
+{
+  FreeReleased();
+  mCurrentFence++;
+  if (mRecording) {
+    TIFF(mCommandList->Close());
+    ID3D12CommandList* cmdLists[] = {mCommandList.Get()};
+    mQueue->ExecuteCommandLists(_countof(cmdLists), cmdLists);
+
+    mAllocators[mCurrentAllocator].Fence = mCurrentFence;
+    for (UploadPage& page : mPages) {
+      if (page.Fence == 0) page.Fence = mCurrentFence;
+    }
+    mCurrentPage = static_cast<uint32>(mPages.size());
+    mRecording   = false;
+  }
+  TIFF(mQueue->Signal(mFence.Get(), mCurrentFence));
+  return mCurrentFence;
+}
+
+ComPtr<ID3D12Resource> D3D12UploadSink::GetResource(uint32 resource) const
+{
+  if (resource == INVALID_UPLOAD_RESOURCE) return nullptr;
+  return mResources[resource].Resource;
+}
+
+void D3D12UploadSink::FreeReleased()
+{
+  const uint64 completedFence = mFence->GetCompletedValue();
+  for (size_t i = 0; i < mPendingReleases.size();) {
+    const PendingRelease& release = mPendingReleases[i];
+    if (release.Fence > completedFence) {
+      ++i;
+      continue;
+    }
+    mResources[release.Resource].Resource = nullptr;
+    mFreeResources.push_back(release.Resource);
+    mPendingReleases[i] = mPendingReleases.back();
+    mPendingReleases.pop_back();
+  }
+}
+
+uint32 D3D12UploadSink::AddResource(SinkResource&& resource)
+{
+  if (mFreeResources.empty()) {
+    mResources.push_back(std::move(resource));
+    return static_cast<uint32>(mResources.size() - 1);
+  }
+
+  const uint32 index = mFreeResources.back();
+  mFreeResources.pop_back();
+  mResources[index] = std::move(resource);
+  return index;
+}
+
+D3D12UploadSink::UploadPage& D3D12UploadSink::Allocate(uint64 byteSize, uint64 alignment, uint64& offset)
+{
+  if (mCurrentPage < mPages.size()) {
+    UploadPage& page = mPages[mCurrentPage];
+    offset           = (page.Used + alignment - 1) & ~(alignment - 1);
+    if (offset + byteSize <= page.Size) {
+      page.Used = offset + byteSize;
+      return page;
+    }
+  }
+
+  // A page whose copies are done, fence 0 marks the pages of the current recording.
+  const uint64 completedFence = mFence->GetCompletedValue();
+  mCurrentPage                = static_cast<uint32>(mPages.size());
+  for (uint32 i = 0; i < mPages.size(); ++i) {
+    if (mPages[i].Fence != 0 && mPages[i].Fence <= completedFence && mPages[i].Size >= byteSize) {
+      mCurrentPage = i;
+      break;
+    }
+  }
+
+  if (mCurrentPage == mPages.size()) {
+    UploadPage page;
+    page.Size = byteSize > PAGE_SIZE ? byteSize : PAGE_SIZE;
+    TIFF(mDevice->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE,
+                                          &CD3DX12_RESOURCE_DESC::Buffer(page.Size), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+                                          IID_PPV_ARGS(page.Buffer.GetAddressOf())));
+    // Upload heaps stay mapped for their whole life.
+    TIFF(page.Buffer->Map(0, nullptr, reinterpret_cast<void**>(&page.Mapped)));
+    mPages.push_back(page);
+  }
+
+  UploadPage& page = mPages[mCurrentPage];
+  page.Fence       = 0;
+  page.Used        = byteSize;
+  offset           = 0;
+  return page;
+}
+
+ID3D12GraphicsCommandList* D3D12UploadSink::GetCommandList()
+{
+  if (mRecording) return mCommandList.Get();
+
+  const uint64 completedFence = mFence->GetCompletedValue();
+  mCurrentAllocator           = static_cast<uint32>(mAllocators.size());
+  for (uint32 i = 0; i < mAllocators.size(); ++i) {
+    if (mAllocators[i].Fence <= completedFence) {
+      mCurrentAllocator = i;
+      break;
+    }
+  }
+  if (mCurrentAllocator == mAllocators.size()) {
+    CommandAllocator allocator;
+    TIFF(mDevice->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT, IID_PPV_ARGS(allocator.Allocator.GetAddressOf())));
+    mAllocators.push_back(allocator);
+  }
+
+  CommandAllocator& allocator = mAllocators[mCurrentAllocator];
+  TIFF(allocator.Allocator->Reset());
+  TIFF(mCommandList->Reset(allocator.Allocator.Get(), nullptr));
+  mRecording = true;
+  return mCommandList.Get();
+}
+
+void D3D12UploadSink::Transition(SinkResource& resource, D3D12_RESOURCE_STATES state)
+{
+  if (resource.State == state) return;
+  GetCommandList()->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(resource.Resource.Get(), resource.State, state));
+  resource.State = state;
+}
@@ -0,0 +1,97 @@
+#ifndef GRAPHICS_D3D12_UPLOAD_SINK_H
+#define GRAPHICS_D3D12_UPLOAD_SINK_H
+#include <d3d12.h>
+
+#include <vector>
+
+#include "Common/TypeDef.h"
+#include "Core/Helpers.h"
+#include "Graphics/ModelStreamer.h"
+
+// Records the streamer writes into its own command list and executes it on the given queue at Submit.
+// The bytes go through mapped upload pages, a page is reused once the fence of its last submit has passed.
+class D3D12UploadSink : public IUploadSink
+{
+ public:
+  static const uint64 PAGE_SIZE = 4ull << 20;
+
+  D3D12UploadSink(ID3D12Device* device, ID3D12CommandQueue* queue);
+  // Waits for the submitted copies.
+  ~D3D12UploadSink();
+  NO_COPY(D3D12UploadSink)
+
+  uint32 CreateBuffer(uint64 byteSize) override;
+  uint32 CreateTexture(uint32 width, uint32 height) override;
+
+  void WriteBuffer(uint32 resource, uint64 offset, const void* data, uint64 byteSize) override;
+  void WriteTextureRows(uint32 resource, uint32 firstRow, uint32 rowCount, const void* data, uint64 rowPitch) override;
+  // Buffers end up in GENERIC_READ, textures in PIXEL_SHADER_RESOURCE.
+  void Finish(uint32 resource) override;
+  // Drops the reference of the sink once the copies written so far completed, other references keep the resource alive.
+  // The index then goes back on a free list.
+  void Release(uint32 resource) override;
+
+  uint64 Submit() override;
+  uint64 GetCompletedFence() const override { return mFence->GetCompletedValue(); }
+
+  // Null for INVALID_UPLOAD_RESOURCE.
+  ComPtr<ID3D12Resource> GetResource(uint32 resource) const;
+
+  inline uint32 GetLiveResourceCount() const { return static_cast<uint32>(mResources.size() - mFreeResources.size()); }
+
+ private:
+  struct UploadPage {
+    ComPtr<ID3D12Resource> Buffer;
+    Byte* Mapped = nullptr;
+    uint64 Size  = 0;
+    uint64 Used  = 0;
+    // Last submit that reads from the page.
+    uint64 Fence = 0;
+  };
+
+  struct CommandAllocator {
+    ComPtr<ID3D12CommandAllocator> Allocator;
+    uint64 Fence = 0;
+  };
+
+  struct SinkResource {
+    ComPtr<ID3D12Resource> Resource;
+    D3D12_RESOURCE_STATES State;
+    bool IsTexture;
+  };
+
+  struct PendingRelease {
+    uint32 Resource;
+    uint64 Fence;
+  };
+
+  // Space in an upload page, returns the page and sets offset.
+  UploadPage& Allocate(uint64 byteSize, uint64 alignment, uint64& offset);
+  // Stores the resource in a free slot, or appends it.
+  uint32 AddResource(SinkResource&& resource);
+  // Frees the released resources whose fence has passed.
+  void FreeReleased();
+  ID3D12GraphicsCommandList* GetCommandList();
+  void Transition(SinkResource& resource, D3D12_RESOURCE_STATES state);
+
+ private:
+  ComPtr<ID3D12Device> mDevice;
+  ComPtr<ID3D12CommandQueue> mQueue;
+  ComPtr<ID3D12GraphicsCommandList> mCommandList;
+  ComPtr<ID3D12Fence> mFence;
+  uint64 mCurrentFence = 0;
+  bool mRecording      = false;
+
+  std::vector<CommandAllocator> mAllocators;
+  uint32 mCurrentAllocator = 0;
+  std::vector<UploadPage> mPages;
+  // Page written by the current recording, mPages.size() when there is none.
+  uint32 mCurrentPage = 0;
+
+  std::vector<SinkResource> mResources;
+  // Released indices, reused before mResources grows.
+  std::vector<uint32> mFreeResources;
+  // Released resources the GPU may still be copying into.
+  std::vector<PendingRelease> mPendingReleases;
+};
+#endif  // GRAPHICS_D3D12_UPLOAD_SINK_H
@@ -72,24 +72,68 @@ ComPtr<ID3D12Resource> D3DUtil::CreateDefaultBuffer(ID3D12Device* device, ID3D12
   return defaultBuffer;
 }
 
-ComPtr<ID3DBlob> D3DUtil::CompileShader(const CheString& fileName, const D3D_SHADER_MACRO* defines, const CheString& entryPoint,
-                                        const CheString& target)
+void D3DUtil::CreateTexture2DFromPixels(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, const void* pixels, uint32 width,
+                                        uint32 height, uint32 component, Texture2D& texture)
+{
+  texture.Dimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+
+  D3D12_RESOURCE_DESC textureDesc = {};
+  textureDesc.MipLevels           = 1;
+  textureDesc.Format              = DXGI_FORMAT_R8G8B8A8_UNORM;
+  textureDesc.Width               = width;
+  textureDesc.Height              = height;
+  textureDesc.Flags               = D3D12_RESOURCE_FLAG_NONE;
+  textureDesc.DepthOrArraySize    = 1;
+  textureDesc.SampleDesc.Count    = 1;
+  textureDesc.SampleDesc.Quality  = 0;
+  textureDesc.Dimension           = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
+
+  TIFF(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &textureDesc,
+                                       D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&texture.Resource)));
+
+  const uint64 uploadSize = GetRequiredIntermediateSize(texture.Resource.Get(), 0, 1);
+  TIFF(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE,
+                                       &CD3DX12_RESOURCE_DESC::Buffer(uploadSize), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+                                       IID_PPV_ARGS(&texture.ResourceUpload)));
+
+  D3D12_SUBRESOURCE_DATA textureData = {};
+  textureData.pData                  = pixels;
+  textureData.RowPitch               = static_cast<LONG_PTR>(width) * component;
+  textureData.SlicePitch             = textureData.RowPitch * height;
+
+  UpdateSubresources(cmdList, texture.Resource.Get(), texture.ResourceUpload.Get(), 0, 0, 1, &textureData);
+  cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(texture.Resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST,
+                                                                    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
+}
+
+uint32 D3DUtil::GetShaderCompileFlags()
 {
   UINT compileFlags = 0;
 #if defined(DEBUG) || defined(_DEBUG)
   compileFlags = D3DCOMPILE_DEBUG | D3DCOMPILE_SKIP_OPTIMIZATION;
 #endif
+  return compileFlags;
+}
 
-  HRESULT hr = S_OK;
-
+ComPtr<ID3DBlob> D3DUtil::CompileShader(const CheString& fileName, const D3D_SHADER_MACRO* defines, const CheString& entryPoint,
+                                        const CheString& target)
+{
   ComPtr<ID3DBlob> byteCode = nullptr;
+  TIFF(TryCompileShader(fileName, defines, entryPoint, target, byteCode));
+
+  return byteCode;
+}
+
+HRESULT D3DUtil::TryCompileShader(const CheString& fileName, const D3D_SHADER_MACRO* defines, const CheString& entryPoint, const CheString& target,
+                                  ComPtr<ID3DBlob>& byteCode)
+{
+  const UINT compileFlags = GetShaderCompileFlags();
+
   ComPtr<ID3DBlob> errors;
-  hr = D3DCompileFromFile(fileName.c_str(), defines, D3D_COMPILE_STANDARD_FILE_INCLUDE, ConvertToMultiByte(entryPoint).c_str(),
-                          ConvertToMultiByte(target).c_str(), compileFlags, 0, &byteCode, &errors);
+  const HRESULT hr = D3DCompileFromFile(fileName.c_str(), defines, D3D_COMPILE_STANDARD_FILE_INCLUDE, ConvertToMultiByte(entryPoint).c_str(),
+                                        ConvertToMultiByte(target).c_str(), compileFlags, 0, byteCode.ReleaseAndGetAddressOf(), &errors);
 
   if (errors != nullptr) logger.Error(ConvertToCheString((char*)errors->GetBufferPointer()));
 
-  TIFF(hr);
-
-  return byteCode;
+  return hr;
 }
\ No newline at end of file
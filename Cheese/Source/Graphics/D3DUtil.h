@@ -56,8 +56,17 @@ class D3DUtil
   static ComPtr<ID3D12Resource> CreateDefaultBuffer(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, const void* initData,
                                                     uint64 byteSize, ComPtr<ID3D12Resource>& uploadBuffer);
 
+  // Uploads tightly packed 8 bit per channel pixels into a new 2D texture.
+  static void CreateTexture2DFromPixels(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, const void* pixels, uint32 width,
+                                        uint32 height, uint32 component, Texture2D& texture);
+
+  // Debug builds compile shaders without optimizations, the flags are part of ShaderCache keys.
+  static uint32 GetShaderCompileFlags();
   static ComPtr<ID3DBlob> CompileShader(const CheString& fileName, const D3D_SHADER_MACRO* defines, const CheString& entryPoint,
                                         const CheString& target);
+  // Does not throw, logs the compiler errors and returns the compile result. byteCode may be null even when it succeeded.
+  static HRESULT TryCompileShader(const CheString& fileName, const D3D_SHADER_MACRO* defines, const CheString& entryPoint, const CheString& target,
+                                  ComPtr<ID3DBlob>& byteCode);
 
   static HRESULT CreateTexture2DFromDDS(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, CheString szFileName, Texture2D& texture,
                                         D3D12_SRV_DIMENSION dimension = D3D12_SRV_DIMENSION_TEXTURE2D)
@@ -0,0 +1,13 @@
+#include "Graphics/DescriptorHeap.h"
+
+const uint32 DescriptorHeap::DEFAULT_CAPACITY;
+
+DescriptorHeap::DescriptorHeap(ID3D12Device* device, uint32 capacity) : mSlots(capacity)
+{
+  D3D12_DESCRIPTOR_HEAP_DESC heapDesc = {};
+  heapDesc.NumDescriptors             = capacity;
+  heapDesc.Type                       = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
+  heapDesc.Flags                      = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
+  TIFF(device->CreateDescriptorHeap(&heapDesc, IID_PPV_ARGS(mHeap.GetAddressOf())));
+  mDescriptorSize = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+}
@@ -0,0 +1,44 @@
+#ifndef GRAPHICS_DESCRIPTOR_HEAP_H
+#define GRAPHICS_DESCRIPTOR_HEAP_H
+#include <d3d12.h>
+
+#include "Common/TypeDef.h"
+#include "Core/Helpers.h"
+#include "Graphics/D3DUtil.h"
+#include "Utils/TlsfAllocator.h"
+
+// One large shader visible CBV/SRV/UAV heap, several RenderData can share it so a frame binds a single heap.
+// Slots are handed out in contiguous ranges by a TlsfAllocator and keep their index until freed,
+// so bindless shaders can index the heap with indices kept in buffers.
+class DescriptorHeap
+{
+ public:
+  static const uint32 DEFAULT_CAPACITY = 1 << 16;
+
+  DescriptorHeap(ID3D12Device* device, uint32 capacity = DEFAULT_CAPACITY);
+  NO_COPY(DescriptorHeap)
+
+  // Invalid allocation when no free range is large enough.
+  inline TlsfAllocation Allocate(uint32 count) { return mSlots.Allocate(count); }
+  // Free only once the GPU is done with the views.
+  inline void Free(const TlsfAllocation& allocation) { mSlots.Free(allocation); }
+
+  inline ID3D12DescriptorHeap* GetHeap() const { return mHeap.Get(); }
+  inline uint32 GetCapacity() const { return mSlots.GetSize(); }
+  inline uint32 GetFreeCount() const { return mSlots.GetFreeSize(); }
+
+  inline CD3DX12_CPU_DESCRIPTOR_HANDLE GetCpuHandle(uint32 index) const
+  {
+    return CD3DX12_CPU_DESCRIPTOR_HANDLE(mHeap->GetCPUDescriptorHandleForHeapStart(), index, mDescriptorSize);
+  }
+  inline CD3DX12_GPU_DESCRIPTOR_HANDLE GetGpuHandle(uint32 index) const
+  {
+    return CD3DX12_GPU_DESCRIPTOR_HANDLE(mHeap->GetGPUDescriptorHandleForHeapStart(), index, mDescriptorSize);
+  }
+
+ private:
+  ComPtr<ID3D12DescriptorHeap> mHeap = nullptr;
+  uint32 mDescriptorSize             = 0;
+  TlsfAllocator mSlots;
+};
+#endif  // GRAPHICS_DESCRIPTOR_HEAP_H
@@ -0,0 +1,84 @@
+#include "Graphics/DrawSorter.h"
+
+#include <utility>
+
+namespace {
+inline uint64 Field(uint32 value, uint32 bits) { return value & ((1ull << bits) - 1); }
+}  // namespace
+
+uint64 DrawSorter::MakeOpaqueKey(uint32 pass, uint32 pipeline, uint32 material, bool indices32, float depth)
+{
+  uint64 key = Field(pass, PASS_BITS);
+  key        = (key << PIPELINE_BITS) | Field(pipeline, PIPELINE_BITS);
+  key        = (key << MATERIAL_BITS) | Field(material, MATERIAL_BITS);
+  key        = (key << 1) | (indices32 ? 1 : 0);
+  key        = (key << DEPTH_BITS) | QuantizeDepth(depth);
+  return key << (64 - PASS_BITS - PIPELINE_BITS - MATERIAL_BITS - 1 - DEPTH_BITS);
+}
+
+uint64 DrawSorter::MakeBlendKey(uint32 pass, uint32 pipeline, uint32 material, bool indices32, float depth)
+{
+  const uint32 maxDepth = (1u << DEPTH_BITS) - 1;
+
+  uint64 key = Field(pass, PASS_BITS);
+  key        = (key << DEPTH_BITS) | (maxDepth - QuantizeDepth(depth));
+  key        = (key << PIPELINE_BITS) | Field(pipeline, PIPELINE_BITS);
+  key        = (key << MATERIAL_BITS) | Field(material, MATERIAL_BITS);
+  key        = (key << 1) | (indices32 ? 1 : 0);
+  return key << (64 - PASS_BITS - PIPELINE_BITS - MATERIAL_BITS - 1 - DEPTH_BITS);
+}
+
+uint32 DrawSorter::QuantizeDepth(float depth)
+{
+  const uint32 maxDepth = (1u << DEPTH_BITS) - 1;
+  // Also catches NaN.
+  if (!(depth > 0.0f)) return 0;
+  if (depth >= 1.0f) return maxDepth;
+  return static_cast<uint32>(depth * maxDepth);
+}
+
+void DrawSorter::Sort(std::vector<DrawCommand>& commands, std::vector<DrawCommand>& scratch)
+{
+  const uint32 count = static_cast<uint32>(commands.size());
+  if (count < INSERTION_SORT_LIMIT) {
+    for (uint32 i = 1; i < count; ++i) {
+      const DrawCommand command = commands[i];
+      uint32 j                  = i;
+      for (; j > 0 && commands[j - 1].Key > command.Key; --j) commands[j] = commands[j - 1];
+      commands[j] = command;
+    }
+    return;
+  }
+
+  // A single read fills the histograms of all eight digits.
+  uint32 histograms[8][256] = {};
+  for (const DrawCommand& command : commands) {
+    uint64 key = command.Key;
+    for (uint32 digit = 0; digit < 8; ++digit) {
+      histograms[digit][key & 0xFF]++;
+      key >>= 8;
+    }
+  }
+
+  scratch.resize(count);
+  DrawCommand* source = commands.data();
+  DrawCommand* target = scratch.data();
+  for (uint32 digit = 0; digit < 8; ++digit) {
+    const uint32 shift = digit * 8;
+    uint32* offsets    = histograms[digit];
+    // Every key has the same digit, the pass would not move anything.
+    if (offsets[(source[0].Key >> shift) & 0xFF] == count) continue;
+
+    uint32 offset = 0;
+    for (uint32 bucket = 0; bucket < 256; ++bucket) {
+      const uint32 bucketSize = offsets[bucket];
+      offsets[bucket]         = offset;
+      offset += bucketSize;
+    }
+    for (uint32 i = 0; i < count; ++i) target[offsets[(source[i].Key >> shift) & 0xFF]++] = source[i];
+    std::swap(source, target);
+  }
+
+  // An odd number of passes leaves the result in scratch.
+  if (source != commands.data()) commands.swap(scratch);
+}
@@ -0,0 +1,37 @@
+#ifndef GRAPHICS_DRAW_SORTER_H
+#define GRAPHICS_DRAW_SORTER_H
+#include <vector>
+
+#include "Common/TypeDef.h"
+
+// A draw waiting for submission. Key decides the order, ItemIndex and ArgIndex say what to draw.
+struct DrawCommand {
+  uint64 Key;
+  uint32 ItemIndex;
+  uint32 ArgIndex;
+};
+
+// Builds 64 bit draw keys and sorts them, so draws sharing state end up next to each other.
+// Opaque keys, high to low bits: pass 4 | pipeline 8 | material 24 | index format 1 | depth 24 | unused 3,
+// the same state is then drawn front to back. Blend keys move the depth right after the pass and flip it,
+// far draws come first whatever their state. Ids larger than their field are wrapped.
+class DrawSorter
+{
+ public:
+  static const uint32 PASS_BITS     = 4;
+  static const uint32 PIPELINE_BITS = 8;
+  static const uint32 MATERIAL_BITS = 24;
+  static const uint32 DEPTH_BITS    = 24;
+  // Fewer commands than this are insertion sorted, the radix passes do not pay off.
+  static const uint32 INSERTION_SORT_LIMIT = 64;
+
+  // depth is in [0, 1], 0 at the near plane.
+  static uint64 MakeOpaqueKey(uint32 pass, uint32 pipeline, uint32 material, bool indices32, float depth);
+  static uint64 MakeBlendKey(uint32 pass, uint32 pipeline, uint32 material, bool indices32, float depth);
+  static uint32 QuantizeDepth(float depth);
+
+  // Stable LSD radix sort on 8 bit digits. scratch ends up with the command count and is meant to be reused across frames.
+  // Digits that are equal in every key are skipped, a frame with few passes and pipelines only pays for the digits that differ.
+  static void Sort(std::vector<DrawCommand>& commands, std::vector<DrawCommand>& scratch);
+};
+#endif  // GRAPHICS_DRAW_SORTER_H
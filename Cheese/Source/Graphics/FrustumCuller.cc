@@ -0,0 +1,166 @@
+#include "Graphics/FrustumCuller.h"
+
+#include <immintrin.h>
+
+#include <cmath>
+#include <cstring>
+
+#include "Utils/ThreadPool.h"
+
+using namespace DirectX;
+
+const uint32 FrustumCuller::CHUNK_SIZE;
+
+FrustumCuller::FrustumCuller() : mKernel(IsAvx2Supported() ? Kernel::AVX2 : Kernel::SSE) {}
+
+uint32 FrustumCuller::Cull(const CullBoxes& boxes, const XMFLOAT4 planes[6], std::vector<uint32>& visible)
+{
+  const uint32 count = boxes.GetCount();
+  visible.resize(count);
+  if (count <= CHUNK_SIZE) {
+    visible.resize(CullRange(mKernel, boxes, planes, 0, count, visible.data()));
+    return static_cast<uint32>(visible.size());
+  }
+
+  const uint32 chunkCount = (count + CHUNK_SIZE - 1) / CHUNK_SIZE;
+  mChunkCounts.resize(chunkCount);
+
+  const Kernel kernel = mKernel;
+  uint32* output      = visible.data();
+  uint32* chunkCounts = mChunkCounts.data();
+  ThreadPool::Get().ParallelFor(chunkCount, [&](uint32 chunk) {
+    const uint32 first = chunk * CHUNK_SIZE;
+    chunkCounts[chunk] = CullRange(kernel, boxes, planes, first, std::min<uint32>(CHUNK_SIZE, count - first), output + first);
+  });
+
+  // Every chunk wrote to the start of its own range, pack them in order.
+  uint32 visibleCount = 0;
+  for (uint32 chunk = 0; chunk < chunkCount; ++chunk) {
+    memmove(output + visibleCount, output + chunk * CHUNK_SIZE, chunkCounts[chunk] * sizeof(uint32));
+    visibleCount += chunkCounts[chunk];
+  }
+  visible.resize(visibleCount);
+  return visibleCount;
+}
+
+uint32 FrustumCuller::CullRange(Kernel kernel, const CullBoxes& boxes, const XMFLOAT4 planes[6], uint32 first, uint32 count, uint32* visible)
+{
+  switch (kernel) {
+    case Kernel::AVX2:
+      return CullAvx2(boxes, planes, first, count, visible);
+    case Kernel::SSE:
+      return CullSse(boxes, planes, first, count, visible);
+    default:
+      return CullScalar(boxes, planes, first, count, visible);
+  }
+}
+
+void FrustumCuller::SetKernel(Kernel kernel) { mKernel = kernel == Kernel::AVX2 && !IsAvx2Supported() ? Kernel::SSE : kernel; }
+
+uint32 FrustumCuller::CullScalar(const CullBoxes& boxes, const XMFLOAT4 planes[6], uint32 first, uint32 count, uint32* visible)
+{
+  uint32 visibleCount = 0;
+  for (uint32 i = first; i < first + count; ++i) {
+    bool inside = true;
+    for (uint32 p = 0; p < 6 && inside; ++p) {
+      const XMFLOAT4& plane = planes[p];
+      // Distance of the box corner furthest along the plane normal.
+      const float distance = plane.x * boxes.mCenterX[i] + plane.y * boxes.mCenterY[i] + plane.z * boxes.mCenterZ[i] + plane.w +
+                             fabsf(plane.x) * boxes.mExtentX[i] + fabsf(plane.y) * boxes.mExtentY[i] + fabsf(plane.z) * boxes.mExtentZ[i];
+      inside = distance >= 0.0f;
+    }
+    if (inside) visible[visibleCount++] = i;
+  }
+  return visibleCount;
+}
+
+uint32 FrustumCuller::CullSse(const CullBoxes& boxes, const XMFLOAT4 planes[6], uint32 first, uint32 count, uint32* visible)
+{
+  __m128 normalX[6], normalY[6], normalZ[6], offset[6], absX[6], absY[6], absZ[6];
+  for (uint32 p = 0; p < 6; ++p) {
+    normalX[p] = _mm_set1_ps(planes[p].x);
+    normalY[p] = _mm_set1_ps(planes[p].y);
+    normalZ[p] = _mm_set1_ps(planes[p].z);
+    offset[p]  = _mm_set1_ps(planes[p].w);
+    absX[p]    = _mm_set1_ps(fabsf(planes[p].x));
+    absY[p]    = _mm_set1_ps(fabsf(planes[p].y));
+    absZ[p]    = _mm_set1_ps(fabsf(planes[p].z));
+  }
+  const __m128 zero = _mm_setzero_ps();
+
+  const uint32 end    = first + count;
+  uint32 visibleCount = 0;
+  uint32 i            = first;
+  for (; i + 4 <= end; i += 4) {
+    const __m128 centerX = _mm_loadu_ps(&boxes.mCenterX[i]);
+    const __m128 centerY = _mm_loadu_ps(&boxes.mCenterY[i]);
+    const __m128 centerZ = _mm_loadu_ps(&boxes.mCenterZ[i]);
+    const __m128 extentX = _mm_loadu_ps(&boxes.mExtentX[i]);
+    const __m128 extentY = _mm_loadu_ps(&boxes.mExtentY[i]);
+    const __m128 extentZ = _mm_loadu_ps(&boxes.mExtentZ[i]);
+
+    __m128 outside = _mm_setzero_ps();
+    for (uint32 p = 0; p < 6; ++p) {
+      __m128 distance = _mm_add_ps(_mm_mul_ps(normalX[p], centerX), offset[p]);
+      distance        = _mm_add_ps(distance, _mm_mul_ps(normalY[p], centerY));
+      distance        = _mm_add_ps(distance, _mm_mul_ps(normalZ[p], centerZ));
+      distance        = _mm_add_ps(distance, _mm_mul_ps(absX[p], extentX));
+      distance        = _mm_add_ps(distance, _mm_mul_ps(absY[p], extentY));
+      distance        = _mm_add_ps(distance, _mm_mul_ps(absZ[p], extentZ));
+      outside         = _mm_or_ps(outside, _mm_cmplt_ps(distance, zero));
+    }
+
+    // Every lane writes its index, only visible lanes move the count, so there is no branch per box.
+    const uint32 mask = ~static_cast<uint32>(_mm_movemask_ps(outside));
+    for (uint32 lane = 0; lane < 4; ++lane) {
+      visible[visibleCount] = i + lane;
+      visibleCount += (mask >> lane) & 1;
+    }
+  }
+  return visibleCount + CullScalar(boxes, planes, i, end - i, visible + visibleCount);
+}
+
+TARGET_AVX2 uint32 FrustumCuller::CullAvx2(const CullBoxes& boxes, const XMFLOAT4 planes[6], uint32 first, uint32 count, uint32* visible)
+{
+  __m256 normalX[6], normalY[6], normalZ[6], offset[6], absX[6], absY[6], absZ[6];
+  for (uint32 p = 0; p < 6; ++p) {
+    normalX[p] = _mm256_set1_ps(planes[p].x);
+    normalY[p] = _mm256_set1_ps(planes[p].y);
+    normalZ[p] = _mm256_set1_ps(planes[p].z);
+    offset[p]  = _mm256_set1_ps(planes[p].w);
+    absX[p]    = _mm256_set1_ps(fabsf(planes[p].x));
+    absY[p]    = _mm256_set1_ps(fabsf(planes[p].y));
+    absZ[p]    = _mm256_set1_ps(fabsf(planes[p].z));
+  }
+  const __m256 zero = _mm256_setzero_ps();
+
+  const uint32 end    = first + count;
+  uint32 visibleCount = 0;
+  uint32 i            = first;
+  for (; i + 8 <= end; i += 8) {
+    const __m256 centerX = _mm256_loadu_ps(&boxes.mCenterX[i]);
+    const __m256 centerY = _mm256_loadu_ps(&boxes.mCenterY[i]);
+    const __m256 centerZ = _mm256_loadu_ps(&boxes.mCenterZ[i]);
+    const __m256 extentX = _mm256_loadu_ps(&boxes.mExtentX[i]);
+    const __m256 extentY = _mm256_loadu_ps(&boxes.mExtentY[i]);
+    const __m256 extentZ = _mm256_loadu_ps(&boxes.mExtentZ[i]);
+
+    __m256 outside = _mm256_setzero_ps();
+    for (uint32 p = 0; p < 6; ++p) {
+      __m256 distance = _mm256_add_ps(_mm256_mul_ps(normalX[p], centerX), offset[p]);
+      distance        = _mm256_add_ps(distance, _mm256_mul_ps(normalY[p], centerY));
+      distance        = _mm256_add_ps(distance, _mm256_mul_ps(normalZ[p], centerZ));
+      distance        = _mm256_add_ps(distance, _mm256_mul_ps(absX[p], extentX));
+      distance        = _mm256_add_ps(distance, _mm256_mul_ps(absY[p], extentY));
+      distance        = _mm256_add_ps(distance, _mm256_mul_ps(absZ[p], extentZ));
+      outside         = _mm256_or_ps(outside, _mm256_cmp_ps(distance, zero, _CMP_LT_OQ));
+    }
+
+    const uint32 mask = ~static_cast<uint32>(_mm256_movemask_ps(outside));
+    for (uint32 lane = 0; lane < 8; ++lane) {
+      visible[visibleCount] = i + lane;
+      visibleCount += (mask >> lane) & 1;
+    }
+  }
+  return visibleCount + CullSse(boxes, planes, i, end - i, visible + visibleCount);
+}
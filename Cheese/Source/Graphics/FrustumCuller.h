@@ -0,0 +1,47 @@
+#ifndef GRAPHICS_FRUSTUM_CULLER_H
+#define GRAPHICS_FRUSTUM_CULLER_H
+#include <DirectXMath.h>
+
+#include <vector>
+
+#include "Common/TypeDef.h"
+#include "Core/Helpers.h"
+#include "Graphics/CullBoxes.h"
+#include "Utils/CpuFeatures.h"
+
+// Tests CullBoxes against the six planes of a frustum, see Camera::GetFrustumPlanes.
+// A box is kept unless it lies completely behind one plane, so a few boxes near frustum corners pass although they are outside.
+class FrustumCuller
+{
+ public:
+  // SSE tests 4 boxes per step, AVX2 8.
+  using Kernel = SimdKernel;
+
+  // Boxes per thread pool job, sets up to this size are culled on the calling thread.
+  static const uint32 CHUNK_SIZE = 4096;
+
+  FrustumCuller();
+  NO_COPY(FrustumCuller)
+
+  // Writes the indices of the visible boxes to visible in increasing order and returns their count.
+  // visible and the chunk bookkeeping keep their capacity, culling the same number of boxes again does not allocate.
+  uint32 Cull(const CullBoxes& boxes, const DirectX::XMFLOAT4 planes[6], std::vector<uint32>& visible);
+
+  // Boxes [first, first + count) on the calling thread, visible needs room for count indices.
+  static uint32 CullRange(Kernel kernel, const CullBoxes& boxes, const DirectX::XMFLOAT4 planes[6], uint32 first, uint32 count, uint32* visible);
+
+  // The best supported kernel by default, a kernel the CPU cannot run falls back to SSE.
+  void SetKernel(Kernel kernel);
+  inline Kernel GetKernel() const { return mKernel; }
+
+ private:
+  static uint32 CullScalar(const CullBoxes& boxes, const DirectX::XMFLOAT4 planes[6], uint32 first, uint32 count, uint32* visible);
+  static uint32 CullSse(const CullBoxes& boxes, const DirectX::XMFLOAT4 planes[6], uint32 first, uint32 count, uint32* visible);
+  static uint32 CullAvx2(const CullBoxes& boxes, const DirectX::XMFLOAT4 planes[6], uint32 first, uint32 count, uint32* visible);
+
+ private:
+  Kernel mKernel = Kernel::SSE;
+  // Visible count of every chunk of the last parallel cull.
+  std::vector<uint32> mChunkCounts;
+};
+#endif  // GRAPHICS_FRUSTUM_CULLER_H
@@ -0,0 +1,117 @@
+#include "Graphics/GeometryHeap.h"
+
+#include <algorithm>
+#include <cstring>
+
+#include "Graphics/D3DUtil.h"
+
+const uint32 GeometryRange::INVALID_PAGE;
+const uint64 GeometryHeap::DEFAULT_PAGE_SIZE;
+const uint64 GeometryHeap::STAGING_PAGE_SIZE;
+
+GeometryHeap::GeometryHeap(uint32 elementSize, uint64 pageSize)
+    : mElementSize(elementSize), mPageElementCount(static_cast<uint32>(pageSize / elementSize) & ~3u)
+{
+}
+
+GeometryRange GeometryHeap::Allocate(ID3D12Device* device, uint32 elementCount, uint32 alignment)
+{
+  GeometryRange range;
+  for (uint32 i = 0; i < mPages.size(); ++i) {
+    range.Allocation = mPages[i].Allocator.Allocate(elementCount, alignment);
+    if (range.Allocation.IsValid()) {
+      range.Page = i;
+      return range;
+    }
+  }
+
+  // Offset 0 of a new page suits any alignment. Pages hold whole multiples of 4 elements,
+  // so a page of 16 bit elements also ends at a whole 32 bit index.
+  range.Page       = AddPage(device, std::max<uint32>((elementCount + 3) & ~3u, mPageElementCount));
+  range.Allocation = mPages[range.Page].Allocator.Allocate(elementCount, alignment);
+  return range;
+}
+
+void GeometryHeap::Free(const GeometryRange& range)
+{
+  if (!range.IsValid()) return;
+  mPages[range.Page].Allocator.Free(range.Allocation);
+}
+
+uint32 GeometryHeap::AddPage(ID3D12Device* device, uint32 elementCount)
+{
+  Page page;
+  page.Allocator = TlsfAllocator(elementCount);
+  page.State     = D3D12_RESOURCE_STATE_COMMON;
+  TIFF(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE,
+                                       &CD3DX12_RESOURCE_DESC::Buffer(static_cast<uint64>(elementCount) * mElementSize), page.State, nullptr,
+                                       IID_PPV_ARGS(page.Buffer.GetAddressOf())));
+  mPages.push_back(std::move(page));
+  return static_cast<uint32>(mPages.size() - 1);
+}
+
+void GeometryHeap::Upload(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, const GeometryRange& range, const void* data, uint32 elementCount)
+{
+  if (!range.IsValid() || elementCount == 0) return;
+
+  const uint64 byteSize = static_cast<uint64>(elementCount) * mElementSize;
+  uint64 stagingOffset;
+  StagingPage& staging = AllocateStaging(device, byteSize, stagingOffset);
+  memcpy(staging.Mapped + stagingOffset, data, byteSize);
+  CopyToPage(cmdList, range, staging.Buffer.Get(), stagingOffset, byteSize);
+}
+
+void GeometryHeap::QueueCopy(const GeometryRange& range, ComPtr<ID3D12Resource> source, uint32 elementCount)
+{
+  if (!range.IsValid() || source == nullptr || elementCount == 0) return;
+  mPendingCopies.push_back({range, std::move(source), elementCount});
+}
+
+void GeometryHeap::RecordCopies(ID3D12GraphicsCommandList* cmdList)
+{
+  for (PendingCopy& copy : mPendingCopies) {
+    CopyToPage(cmdList, copy.Range, copy.Source.Get(), 0, static_cast<uint64>(copy.ElementCount) * mElementSize);
+    mCopySources.push_back(std::move(copy.Source));
+  }
+  mPendingCopies.clear();
+}
+
+void GeometryHeap::ReleaseUploadBuffers()
+{
+  for (StagingPage& staging : mStagingPages) staging.Buffer->Unmap(0, nullptr);
+  mStagingPages.clear();
+  mCopySources.clear();
+}
+
+GeometryHeap::StagingPage& GeometryHeap::AllocateStaging(ID3D12Device* device, uint64 byteSize, uint64& offset)
+{
+  if (!mStagingPages.empty()) {
+    StagingPage& staging = mStagingPages.back();
+    if (staging.Used + byteSize <= staging.Size) {
+      offset       = staging.Used;
+      staging.Used = (offset + byteSize + 15) & ~15ull;
+      return staging;
+    }
+  }
+
+  StagingPage staging;
+  staging.Size = byteSize > STAGING_PAGE_SIZE ? byteSize : STAGING_PAGE_SIZE;
+  TIFF(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(staging.Size),
+                                       D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(staging.Buffer.GetAddressOf())));
+  // Upload heaps stay mapped for their whole life.
+  TIFF(staging.Buffer->Map(0, nullptr, reinterpret_cast<void**>(&staging.Mapped)));
+  staging.Used = (byteSize + 15) & ~15ull;
+  mStagingPages.push_back(staging);
+
+  offset = 0;
+  return mStagingPages.back();
+}
+
+void GeometryHeap::CopyToPage(ID3D12GraphicsCommandList* cmdList, const GeometryRange& range, ID3D12Resource* source, uint64 sourceOffset, uint64 byteSize)
+{
+  Page& page = mPages[range.Page];
+  cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(page.Buffer.Get(), page.State, D3D12_RESOURCE_STATE_COPY_DEST));
+  cmdList->CopyBufferRegion(page.Buffer.Get(), static_cast<uint64>(range.GetOffset()) * mElementSize, source, sourceOffset, byteSize);
+  cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(page.Buffer.Get(), D3D12_RESOURCE_STATE_COPY_DEST, D3D12_RESOURCE_STATE_GENERIC_READ));
+  page.State = D3D12_RESOURCE_STATE_GENERIC_READ;
+}
@@ -0,0 +1,87 @@
+#ifndef GRAPHICS_GEOMETRY_HEAP_H
+#define GRAPHICS_GEOMETRY_HEAP_H
+#include <d3d12.h>
+
+#include <vector>
+
+#include "Common/TypeDef.h"
+#include "Core/Helpers.h"
+#include "Utils/TlsfAllocator.h"
+
+// Elements of a GeometryHeap page, Allocation.Offset counts elements from the start of the page buffer.
+struct GeometryRange {
+  static const uint32 INVALID_PAGE = 0xFFFFFFFF;
+
+  uint32 Page = INVALID_PAGE;
+  TlsfAllocation Allocation;
+
+  inline bool IsValid() const { return Page != INVALID_PAGE; }
+  inline uint32 GetOffset() const { return Allocation.Offset; }
+};
+
+// Default heap buffers of fixed size elements that many items sub-allocate from, so draws of different items share one binding.
+// Pages of the given size are added when no page has room, larger requests get a page of their own. Pages are never released.
+// Copies into a page wrap it in COPY_DEST barriers, it is GENERIC_READ in between.
+class GeometryHeap
+{
+ public:
+  static const uint64 DEFAULT_PAGE_SIZE = 64ull << 20;
+  static const uint64 STAGING_PAGE_SIZE = 4ull << 20;
+
+  GeometryHeap(uint32 elementSize, uint64 pageSize = DEFAULT_PAGE_SIZE);
+  NO_COPY(GeometryHeap)
+
+  // alignment is in elements and has to be a power of two.
+  GeometryRange Allocate(ID3D12Device* device, uint32 elementCount, uint32 alignment = 1);
+  void Free(const GeometryRange& range);
+
+  // Records the copy of elementCount elements to the start of range. The bytes go through a mapped staging page,
+  // data only has to live until the call returns.
+  void Upload(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, const GeometryRange& range, const void* data, uint32 elementCount);
+  // Copy from a buffer that is readable already, for callers without an open command list. RecordCopies records it.
+  void QueueCopy(const GeometryRange& range, ComPtr<ID3D12Resource> source, uint32 elementCount);
+  void RecordCopies(ID3D12GraphicsCommandList* cmdList);
+  // Drops the staging pages and copy sources of recorded copies, the GPU has to be done with them.
+  void ReleaseUploadBuffers();
+
+  inline uint32 GetElementSize() const { return mElementSize; }
+  inline uint32 GetPageCount() const { return static_cast<uint32>(mPages.size()); }
+  inline ID3D12Resource* GetBuffer(uint32 page) const { return mPages[page].Buffer.Get(); }
+  inline uint64 GetPageByteSize(uint32 page) const { return static_cast<uint64>(mPages[page].Allocator.GetSize()) * mElementSize; }
+
+ private:
+  struct Page {
+    ComPtr<ID3D12Resource> Buffer;
+    TlsfAllocator Allocator;
+    D3D12_RESOURCE_STATES State;
+  };
+
+  struct StagingPage {
+    ComPtr<ID3D12Resource> Buffer;
+    Byte* Mapped = nullptr;
+    uint64 Size  = 0;
+    uint64 Used  = 0;
+  };
+
+  struct PendingCopy {
+    GeometryRange Range;
+    ComPtr<ID3D12Resource> Source;
+    uint32 ElementCount;
+  };
+
+  uint32 AddPage(ID3D12Device* device, uint32 elementCount);
+  // Space in a staging page, returns the page and sets offset.
+  StagingPage& AllocateStaging(ID3D12Device* device, uint64 byteSize, uint64& offset);
+  void CopyToPage(ID3D12GraphicsCommandList* cmdList, const GeometryRange& range, ID3D12Resource* source, uint64 sourceOffset, uint64 byteSize);
+
+ private:
+  uint32 mElementSize;
+  uint32 mPageElementCount;
+
+  std::vector<Page> mPages;
+  std::vector<StagingPage> mStagingPages;
+  std::vector<PendingCopy> mPendingCopies;
+  // Sources of recorded copies, kept until ReleaseUploadBuffers.
+  std::vector<ComPtr<ID3D12Resource>> mCopySources;
+};
+#endif  // GRAPHICS_GEOMETRY_HEAP_H
@@ -8,6 +8,8 @@
 #include "Core/CoreMinimal.h"
 #include "Core/CheeseWindow.h"
 #include "D3DUtil.h"
+#include "Graphics/CommandListPool.h"
+#include "Graphics/UploadRing.h"
 
 #pragma comment(lib, "d3dcompiler.lib")
 #pragma comment(lib, "D3D12.lib")
@@ -64,6 +66,10 @@ class Graphics
   ComPtr<ID3D12CommandQueue> mCommandQueue;
   ComPtr<ID3D12CommandAllocator> mDirectCmdListAlloc;
   ComPtr<ID3D12GraphicsCommandList> mCommandList;
+  // Lists for passes recorded on several threads, they go to mCommandQueue between parts of mCommandList.
+  CommandListPool mCommandListPool;
+  // Constants of the frames in flight, see RenderData::UploadConstants.
+  UploadRing mUploadRing;
 
   static const int SwapChainBufferCount = 2;
   int mCurrBackBuffer                   = 0;
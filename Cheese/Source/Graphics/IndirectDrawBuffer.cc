@@ -0,0 +1,90 @@
+#include "Graphics/IndirectDrawBuffer.h"
+
+#include "Graphics/D3DUtil.h"
+
+namespace {
+// Arguments of one command in IndirectDrawCommand order, CreateCommandSignature and Decode both walk this list.
+const D3D12_INDIRECT_ARGUMENT_TYPE COMMAND_LAYOUT[] = {
+    D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW,
+    D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT,
+    D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED,
+};
+const uint32 DRAW_CONSTANT_COUNT = 2;
+
+uint32 GetArgumentSize(D3D12_INDIRECT_ARGUMENT_TYPE type)
+{
+  switch (type) {
+    case D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW:
+      return sizeof(D3D12_GPU_VIRTUAL_ADDRESS);
+    case D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT:
+      return DRAW_CONSTANT_COUNT * sizeof(uint32);
+    case D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED:
+      return sizeof(D3D12_DRAW_INDEXED_ARGUMENTS);
+    default:
+      return 0;
+  }
+}
+}  // namespace
+
+const uint32 IndirectDrawBuffer::INVALID_INDEX;
+const uint32 IndirectDrawBuffer::COMMANDS_PER_TASK;
+
+ComPtr<ID3D12CommandSignature> IndirectDrawBuffer::CreateCommandSignature(ID3D12Device* device, ID3D12RootSignature* rootSignature, uint32 objectCbvRootIndex,
+                                                                          uint32 drawConstantsRootIndex)
+{
+  D3D12_INDIRECT_ARGUMENT_DESC arguments[_countof(COMMAND_LAYOUT)] = {};
+  for (uint32 i = 0; i < _countof(COMMAND_LAYOUT); ++i) {
+    arguments[i].Type = COMMAND_LAYOUT[i];
+    if (COMMAND_LAYOUT[i] == D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW) {
+      arguments[i].ConstantBufferView.RootParameterIndex = objectCbvRootIndex;
+    } else if (COMMAND_LAYOUT[i] == D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT) {
+      arguments[i].Constant.RootParameterIndex      = drawConstantsRootIndex;
+      arguments[i].Constant.DestOffsetIn32BitValues = 0;
+      arguments[i].Constant.Num32BitValuesToSet     = DRAW_CONSTANT_COUNT;
+    }
+  }
+
+  D3D12_COMMAND_SIGNATURE_DESC desc = {};
+  desc.ByteStride                   = sizeof(IndirectDrawCommand);
+  desc.NumArgumentDescs             = _countof(arguments);
+  desc.pArgumentDescs               = arguments;
+
+  ComPtr<ID3D12CommandSignature> signature;
+  TIFF(device->CreateCommandSignature(&desc, rootSignature, IID_PPV_ARGS(signature.GetAddressOf())));
+  return signature;
+}
+
+void IndirectDrawBuffer::Reserve(ID3D12Device* device, uint32 commandCount)
+{
+  if (commandCount <= mCapacity) return;
+
+  // Upload heaps stay mapped for their whole life.
+  if (mBuffer != nullptr) mBuffer->Unmap(0, nullptr);
+  TIFF(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE,
+                                       &CD3DX12_RESOURCE_DESC::Buffer(static_cast<uint64>(commandCount) * sizeof(IndirectDrawCommand)),
+                                       D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(mBuffer.ReleaseAndGetAddressOf())));
+  TIFF(mBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mMapped)));
+  mCapacity     = commandCount;
+  mCommandCount = 0;
+}
+
+void IndirectDrawBuffer::Decode(const void* data, uint32 count, std::vector<IndirectDrawCommand>& commands)
+{
+  commands.resize(count);
+  const Byte* source = static_cast<const Byte*>(data);
+  for (uint32 i = 0; i < count; ++i) {
+    const Byte* argument         = source + static_cast<uint64>(i) * sizeof(IndirectDrawCommand);
+    IndirectDrawCommand& command = commands[i];
+    for (D3D12_INDIRECT_ARGUMENT_TYPE type : COMMAND_LAYOUT) {
+      if (type == D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT_BUFFER_VIEW) {
+        memcpy(&command.ObjectCbv, argument, sizeof(command.ObjectCbv));
+      } else if (type == D3D12_INDIRECT_ARGUMENT_TYPE_CONSTANT) {
+        memcpy(&command.ObjectIndex, argument, sizeof(uint32));
+        memcpy(&command.MaterialId, argument + sizeof(uint32), sizeof(uint32));
+      } else if (type == D3D12_INDIRECT_ARGUMENT_TYPE_DRAW_INDEXED) {
+        memcpy(&command.Draw, argument, sizeof(command.Draw));
+      }
+      argument += GetArgumentSize(type);
+    }
+  }
+}
@@ -0,0 +1,95 @@
+#ifndef GRAPHICS_INDIRECT_DRAW_BUFFER_H
+#define GRAPHICS_INDIRECT_DRAW_BUFFER_H
+#include <d3d12.h>
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+#include "Common/TypeDef.h"
+#include "Core/Helpers.h"
+#include "Utils/ThreadPool.h"
+
+// One ExecuteIndirect command in the layout of IndirectDrawBuffer::CreateCommandSignature:
+// the per object CBV, the two cbDraw root constants, then the draw.
+struct IndirectDrawCommand {
+  D3D12_GPU_VIRTUAL_ADDRESS ObjectCbv;
+  // First instance of the draw in gInstances.
+  uint32 ObjectIndex;
+  // Material table row of the draw, see DrawArg::MaterialId.
+  uint32 MaterialId;
+  D3D12_DRAW_INDEXED_ARGUMENTS Draw;
+};
+
+// Draw arguments for ExecuteIndirect in a mapped upload heap, filled from the start every frame.
+// Commands are built on the thread pool and written straight to the mapped memory, a frame allocates nothing once Reserve covered it.
+class IndirectDrawBuffer
+{
+ public:
+  static const uint32 INVALID_INDEX = 0xFFFFFFFF;
+  // Commands per thread pool job, fewer are written on the calling thread.
+  static const uint32 COMMANDS_PER_TASK = 256;
+
+  IndirectDrawBuffer() = default;
+  NO_COPY(IndirectDrawBuffer)
+
+  // Command signature matching IndirectDrawCommand for a root signature with a root CBV at objectCbvRootIndex
+  // and two root constants at drawConstantsRootIndex.
+  static ComPtr<ID3D12CommandSignature> CreateCommandSignature(ID3D12Device* device, ID3D12RootSignature* rootSignature, uint32 objectCbvRootIndex,
+                                                               uint32 drawConstantsRootIndex);
+
+  // Resize only while the GPU is idle, and reset once the GPU is done with the previous frame.
+  void Reserve(ID3D12Device* device, uint32 commandCount);
+  inline void Reset() { mCommandCount = 0; }
+
+  // Calls fill(i, command) for every i in [0, count) over the thread pool and appends the commands in order.
+  // Returns the index of the first one, INVALID_INDEX when the reserved space is used up.
+  template <typename Fill>
+  uint32 Write(uint32 count, const Fill& fill);
+
+  inline ID3D12Resource* GetBuffer() const { return mBuffer.Get(); }
+  // Argument buffer offset of a command, for ExecuteIndirect.
+  inline uint64 GetOffset(uint32 commandIndex) const { return static_cast<uint64>(commandIndex) * sizeof(IndirectDrawCommand); }
+  inline uint32 GetCommandCount() const { return mCommandCount; }
+  inline const Byte* GetMappedData() const { return mMapped; }
+
+  // Reads count commands back the way the GPU does, argument by argument in the order of the command signature.
+  // For checks on the CPU, commands is resized to count.
+  static void Decode(const void* data, uint32 count, std::vector<IndirectDrawCommand>& commands);
+
+ private:
+  ComPtr<ID3D12Resource> mBuffer = nullptr;
+  Byte* mMapped                  = nullptr;
+  uint32 mCapacity               = 0;
+  uint32 mCommandCount           = 0;
+};
+
+template <typename Fill>
+uint32 IndirectDrawBuffer::Write(uint32 count, const Fill& fill)
+{
+  if (count > mCapacity - mCommandCount) return INVALID_INDEX;
+  const uint32 first = mCommandCount;
+  mCommandCount += count;
+
+  IndirectDrawCommand* output = reinterpret_cast<IndirectDrawCommand*>(mMapped) + first;
+
+  // Upload heaps are write combined, every command is built on the stack and copied out whole.
+  auto writeRange = [&](uint32 task) {
+    const uint32 begin = task * COMMANDS_PER_TASK;
+    const uint32 end   = std::min<uint32>(begin + COMMANDS_PER_TASK, count);
+    for (uint32 i = begin; i < end; ++i) {
+      IndirectDrawCommand command;
+      fill(i, command);
+      memcpy(output + i, &command, sizeof(IndirectDrawCommand));
+    }
+  };
+
+  const uint32 taskCount = (count + COMMANDS_PER_TASK - 1) / COMMANDS_PER_TASK;
+  if (taskCount == 1) {
+    writeRange(0);
+  } else if (taskCount > 1) {
+    ThreadPool::Get().ParallelFor(taskCount, writeRange);
+  }
+  return first;
+}
+#endif  // GRAPHICS_INDIRECT_DRAW_BUFFER_H
@@ -0,0 +1,64 @@
+#include "Graphics/InstanceBatcher.h"
+
+namespace {
+inline uint64 Field(uint32 value, uint32 bits) { return value & ((1ull << bits) - 1); }
+}  // namespace
+
+uint64 InstanceBatcher::MakeKey(uint32 geometryId, uint32 argIndex, uint32 lod)
+{
+  uint64 key = Field(geometryId, GEOMETRY_BITS);
+  key        = (key << ARG_BITS) | Field(argIndex, ARG_BITS);
+  return (key << LOD_BITS) | Field(lod, LOD_BITS);
+}
+
+uint64 InstanceBatcher::MakeSingleKey(uint32 drawIndex)
+{
+  // MakeKey leaves the top bit clear.
+  return (1ull << 63) | drawIndex;
+}
+
+void InstanceBatcher::Reserve(uint32 drawCount)
+{
+  mCandidates.reserve(drawCount);
+  mOrder.reserve(drawCount);
+  mBatchOrder.reserve(drawCount);
+  mScratch.reserve(drawCount);
+  mUnsortedBatches.reserve(drawCount);
+  mBatches.reserve(drawCount);
+  mInstanceItems.reserve(drawCount);
+}
+
+void InstanceBatcher::Clear()
+{
+  mCandidates.clear();
+  mBatches.clear();
+  mInstanceItems.clear();
+}
+
+void InstanceBatcher::Build()
+{
+  const uint32 count = static_cast<uint32>(mCandidates.size());
+
+  // The sort is stable, the instances of a batch keep the order they were added in.
+  mOrder.clear();
+  for (uint32 i = 0; i < count; ++i) mOrder.push_back({mCandidates[i].BatchKey, i, 0});
+  DrawSorter::Sort(mOrder, mScratch);
+
+  mUnsortedBatches.clear();
+  mInstanceItems.clear();
+  mBatchOrder.clear();
+  for (uint32 i = 0; i < count; ++i) {
+    const Candidate& candidate = mCandidates[mOrder[i].ItemIndex];
+    if (i == 0 || mOrder[i].Key != mOrder[i - 1].Key) {
+      // Batches are submitted in the order of their first draw.
+      mBatchOrder.push_back({candidate.SortKey, static_cast<uint32>(mUnsortedBatches.size()), 0});
+      mUnsortedBatches.push_back({candidate.ItemIndex, candidate.ArgIndex, i, 0});
+    }
+    mUnsortedBatches.back().InstanceCount++;
+    mInstanceItems.push_back(candidate.ItemIndex);
+  }
+  DrawSorter::Sort(mBatchOrder, mScratch);
+
+  mBatches.clear();
+  for (const DrawCommand& command : mBatchOrder) mBatches.push_back(mUnsortedBatches[command.ItemIndex]);
+}
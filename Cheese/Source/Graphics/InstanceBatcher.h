@@ -0,0 +1,69 @@
+#ifndef GRAPHICS_INSTANCE_BATCHER_H
+#define GRAPHICS_INSTANCE_BATCHER_H
+#include <vector>
+
+#include "Common/TypeDef.h"
+#include "Graphics/DrawSorter.h"
+
+// Consecutive instances drawn by one instanced call. ItemIndex is the first instance,
+// it supplies the buffers and bindings the other instances share.
+struct InstanceBatch {
+  uint32 ItemIndex;
+  uint32 ArgIndex;
+  // Range in InstanceBatcher::GetInstanceItems().
+  uint32 FirstInstance;
+  uint32 InstanceCount;
+};
+
+// Merges the visible draws of a frame into instanced draws.
+// Every draw is added with a batch key and a sort key. Draws with equal batch keys become one batch, in the order they were added,
+// and the batches come out ordered by the sort key of their first draw. Both steps are DrawSorter radix sorts,
+// so a frame allocates nothing once Reserve covered its draws.
+class InstanceBatcher
+{
+ public:
+  static const uint32 LOD_BITS      = 4;
+  static const uint32 ARG_BITS      = 27;
+  static const uint32 GEOMETRY_BITS = 32;
+
+  // Draws of the same geometry, draw arg and LOD can be instanced, the draw arg picks the index range and the textures.
+  static uint64 MakeKey(uint32 geometryId, uint32 argIndex, uint32 lod);
+  // A key no MakeKey result or other drawIndex shares, the draw stays a batch of its own.
+  // Used for blended draws, which have to keep their back to front order.
+  static uint64 MakeSingleKey(uint32 drawIndex);
+
+  void Reserve(uint32 drawCount);
+  void Clear();
+  inline void Add(uint64 batchKey, uint64 sortKey, uint32 itemIndex, uint32 argIndex)
+  {
+    mCandidates.push_back({batchKey, sortKey, itemIndex, argIndex});
+  }
+
+  void Build();
+
+  // Valid after Build, in submission order.
+  inline const std::vector<InstanceBatch>& GetBatches() const { return mBatches; }
+  // Item index of every instance, the instances of a batch are contiguous.
+  inline const std::vector<uint32>& GetInstanceItems() const { return mInstanceItems; }
+  inline uint32 GetDrawCount() const { return static_cast<uint32>(mCandidates.size()); }
+
+ private:
+  struct Candidate {
+    uint64 BatchKey;
+    uint64 SortKey;
+    uint32 ItemIndex;
+    uint32 ArgIndex;
+  };
+
+ private:
+  std::vector<Candidate> mCandidates;
+  // Candidates by batch key and batches by sort key, ItemIndex holds the candidate and the batch index.
+  std::vector<DrawCommand> mOrder;
+  std::vector<DrawCommand> mBatchOrder;
+  std::vector<DrawCommand> mScratch;
+  // In batch key order.
+  std::vector<InstanceBatch> mUnsortedBatches;
+  std::vector<InstanceBatch> mBatches;
+  std::vector<uint32> mInstanceItems;
+};
+#endif  // GRAPHICS_INSTANCE_BATCHER_H
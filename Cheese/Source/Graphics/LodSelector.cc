@@ -0,0 +1,33 @@
+#include "LodSelector.h"
+
+#include <algorithm>
+#include <cmath>
+#include "Core/Camera.h"
+
+void LodSelector::SetView(const Camera& camera)
+{
+  mEyePosition   = camera.GetPostion();
+  mPixelsPerUnit = camera.GetViewPort().Height / (2.0f * tanf(camera.GetFovY() * 0.5f));
+  mNearZ         = std::max<float>(camera.GetNearZ(), 1e-4f);
+}
+
+uint32 LodSelector::Select(const DrawArg& arg, const DirectX::XMFLOAT3& worldCenter, float worldRadius, float scale) const
+{
+  if (arg.LodCount <= 1) return 0;
+
+  const float dx       = worldCenter.x - mEyePosition.x;
+  const float dy       = worldCenter.y - mEyePosition.y;
+  const float dz       = worldCenter.z - mEyePosition.z;
+  const float distance = std::max<float>(sqrtf(dx * dx + dy * dy + dz * dz) - worldRadius, mNearZ);
+
+  auto projectedError = [&](uint32 lod) { return ProjectError(arg.Lods[lod].Error * scale, distance); };
+
+  uint32 lod = std::min<uint32>(arg.CurrentLod, arg.LodCount - 1);
+  while (lod > 0 && projectedError(lod) > mPixelThreshold * (1.0f + mHysteresis)) {
+    lod--;
+  }
+  while (lod + 1 < arg.LodCount && projectedError(lod + 1) <= mPixelThreshold * (1.0f - mHysteresis)) {
+    lod++;
+  }
+  return lod;
+}
@@ -0,0 +1,38 @@
+#ifndef GRAPHICS_LOD_SELECTOR_H
+#define GRAPHICS_LOD_SELECTOR_H
+#include <DirectXMath.h>
+#include "Common/TypeDef.h"
+#include "Graphics/RenderData.h"
+
+class Camera;
+
+// Picks the coarsest LOD whose geometric error covers at most pixelThreshold pixels on screen.
+// A draw only leaves its current LOD once the error is outside threshold * (1 +- hysteresis),
+// so an object resting near a switching distance does not pop back and forth.
+class LodSelector
+{
+ public:
+  explicit LodSelector(float pixelThreshold = 1.0f, float hysteresis = 0.25f) : mPixelThreshold(pixelThreshold), mHysteresis(hysteresis) {}
+
+  // Reads the eye position, GetFovY and the viewport height, call it once per frame before selecting.
+  void SetView(const Camera& camera);
+
+  // Size in pixels of a world space error seen at distance.
+  inline float ProjectError(float worldError, float distance) const { return worldError * mPixelsPerUnit / distance; }
+
+  // worldCenter/worldRadius bound the draw in world space, scale takes the object space LOD errors to world space.
+  uint32 Select(const DrawArg& arg, const DirectX::XMFLOAT3& worldCenter, float worldRadius, float scale) const;
+
+  inline void SetPixelThreshold(float pixelThreshold) { mPixelThreshold = pixelThreshold; }
+  inline float GetPixelThreshold() const { return mPixelThreshold; }
+
+ private:
+  float mPixelThreshold = 1.0f;
+  float mHysteresis     = 0.25f;
+
+  DirectX::XMFLOAT3 mEyePosition = {0.0f, 0.0f, 0.0f};
+  // Pixels covered by one world unit at distance one.
+  float mPixelsPerUnit = 0.0f;
+  float mNearZ         = 0.0f;
+};
+#endif  // GRAPHICS_LOD_SELECTOR_H
@@ -0,0 +1,42 @@
+#include "Graphics/MaterialTable.h"
+
+#include <algorithm>
+
+const uint32 MaterialTable::INVALID_ID;
+
+MaterialTable::MaterialTable(uint32 textureCount) : mTextureCount(textureCount) {}
+
+uint32 MaterialTable::Acquire(const uint32* textures)
+{
+  mKey.assign(textures, textures + mTextureCount);
+  auto iter = mLookup.find(mKey);
+  if (iter != mLookup.end()) {
+    mReferenceCounts[iter->second]++;
+    return iter->second;
+  }
+
+  uint32 materialId;
+  if (!mFreeIds.empty()) {
+    materialId = mFreeIds.back();
+    mFreeIds.pop_back();
+    mReferenceCounts[materialId] = 1;
+    std::copy(mKey.begin(), mKey.end(), mRows.begin() + materialId * mTextureCount);
+  } else {
+    materialId = GetRowCount();
+    mReferenceCounts.push_back(1);
+    mRows.insert(mRows.end(), mKey.begin(), mKey.end());
+  }
+  mLookup.emplace(mKey, materialId);
+  return materialId;
+}
+
+void MaterialTable::Release(uint32 materialId)
+{
+  if (materialId >= GetRowCount() || mReferenceCounts[materialId] == 0) return;
+  if (--mReferenceCounts[materialId] != 0) return;
+
+  // The row keeps its indices until it is reused, a draw still in flight reads valid descriptors.
+  mKey.assign(GetTextures(materialId), GetTextures(materialId) + mTextureCount);
+  mLookup.erase(mKey);
+  mFreeIds.push_back(materialId);
+}
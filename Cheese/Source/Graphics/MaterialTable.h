@@ -0,0 +1,40 @@
+#ifndef GRAPHICS_MATERIAL_TABLE_H
+#define GRAPHICS_MATERIAL_TABLE_H
+#include <map>
+#include <vector>
+
+#include "Common/TypeDef.h"
+
+// Texture sets of the draws for bindless shaders. A material is a row of descriptor heap indices, one per texture kind,
+// shaders read row gMaterialId of gMaterialTextures and index gTextures with it.
+// Equal rows share one material id, ids are reference counted and stay put while in use. Released rows are reused.
+class MaterialTable
+{
+ public:
+  static const uint32 INVALID_ID = 0xFFFFFFFF;
+
+  explicit MaterialTable(uint32 textureCount);
+
+  // textures holds GetTextureCount() heap indices. Returns the id of the row and adds a reference to it.
+  uint32 Acquire(const uint32* textures);
+  void Release(uint32 materialId);
+
+  inline uint32 GetTextureCount() const { return mTextureCount; }
+  // Rows of the table, released ones included.
+  inline uint32 GetRowCount() const { return static_cast<uint32>(mReferenceCounts.size()); }
+  inline uint32 GetMaterialCount() const { return GetRowCount() - static_cast<uint32>(mFreeIds.size()); }
+  inline uint32 GetReferenceCount(uint32 materialId) const { return mReferenceCounts[materialId]; }
+  inline const uint32* GetTextures(uint32 materialId) const { return mRows.data() + materialId * mTextureCount; }
+  // GetRowCount() rows one after the other, the layout of gMaterialTextures.
+  inline const std::vector<uint32>& GetData() const { return mRows; }
+
+ private:
+  uint32 mTextureCount;
+  std::vector<uint32> mRows;
+  std::vector<uint32> mReferenceCounts;
+  std::vector<uint32> mFreeIds;
+  // Row: material id, only rows in use.
+  std::map<std::vector<uint32>, uint32> mLookup;
+  std::vector<uint32> mKey;
+};
+#endif  // GRAPHICS_MATERIAL_TABLE_H
@@ -0,0 +1,186 @@
+#include "Graphics/ModelStreamer.h"
+
+#include "Utils/Log/Logger.h"
+#include "Utils/ThreadPool.h"
+
+StreamHandle ModelStreamer::LoadAsync(const CheString& fileName, const ModelLoadOptions& options)
+{
+  std::shared_ptr<Load> load = std::make_shared<Load>();
+  load->FileName             = fileName;
+  load->Options              = options;
+
+  const StreamHandle handle = mNextHandle++;
+  mLoads[handle]            = load;
+
+  // The job keeps the load alive, it may still be decoding after a Release.
+  ThreadPool::Get().Submit([load]() {
+    DecodedModel decoded;
+    if (ModelLoader::DecodeModel(load->FileName, decoded, load->Options)) {
+      for (IMesh* mesh : decoded.Meshes) load->Model.CpuModel.AddMesh(mesh);
+      load->Model.Images     = std::move(decoded.Images);
+      load->Model.MeshImages = std::move(decoded.MeshImages);
+      RenderItem::PackGeometry(&load->Model.CpuModel, load->Model.Geometry);
+    } else {
+      load->Failed = true;
+    }
+    load->Decoded.store(true, std::memory_order_release);
+  });
+  return handle;
+}
+
+void ModelStreamer::Update()
+{
+  mFrameBytes = 0;
+
+  std::vector<Load*> submitted;
+  for (auto& pair : mLoads) {
+    Load& load = *pair.second;
+
+    if (load.State == StreamState::DECODING && load.Decoded.load(std::memory_order_acquire)) {
+      if (load.Failed) {
+        logger.Error(CTEXT("Failed to stream model:") + load.FileName);
+        load.State = StreamState::FAILED;
+        continue;
+      }
+      BeginUpload(load);
+      load.State = StreamState::UPLOADING;
+    }
+
+    if (load.State != StreamState::UPLOADING) continue;
+    while (load.NextJob < load.Jobs.size() && WriteJob(load.Jobs[load.NextJob])) {
+      mSink->Finish(load.Jobs[load.NextJob].Resource);
+      load.NextJob++;
+    }
+    if (load.NextJob == load.Jobs.size()) {
+      load.State = StreamState::WAITING_GPU;
+      submitted.push_back(&load);
+    }
+  }
+
+  if (mFrameBytes != 0 || !submitted.empty()) {
+    const uint64 fence = mSink->Submit();
+    for (Load* load : submitted) load->Fence = fence;
+  }
+
+  const uint64 completedFence = mSink->GetCompletedFence();
+  for (auto& pair : mLoads) {
+    Load& load = *pair.second;
+    if (load.State != StreamState::WAITING_GPU || load.Fence > completedFence) continue;
+
+    load.State = StreamState::READY;
+    load.Jobs.clear();
+    ReleaseCpuData(load.Model);
+  }
+
+  mPeakFrameBytes = std::max<uint64>(mPeakFrameBytes, mFrameBytes);
+  mTotalBytes += mFrameBytes;
+}
+
+StreamState ModelStreamer::GetState(StreamHandle handle) const
+{
+  auto iter = mLoads.find(handle);
+  return iter != mLoads.end() ? iter->second->State : StreamState::FAILED;
+}
+
+StreamedModel* ModelStreamer::GetModel(StreamHandle handle)
+{
+  auto iter = mLoads.find(handle);
+  if (iter == mLoads.end() || iter->second->State != StreamState::READY) return nullptr;
+  return &iter->second->Model;
+}
+
+void ModelStreamer::Release(StreamHandle handle)
+{
+  auto iter = mLoads.find(handle);
+  if (iter == mLoads.end()) return;
+
+  // A decoding load has no resources yet, BeginUpload creates them on this thread. The jobs of an upload fill exactly the resources
+  // of the model, and those handed on to a render item are INVALID_UPLOAD_RESOURCE already.
+  StreamedModel& model = iter->second->Model;
+  for (uint32 resource : {model.VertexBuffer, model.CompactVertexBuffer, model.IndexBuffer16, model.IndexBuffer32}) {
+    mSink->Release(resource);
+  }
+  for (uint32 texture : model.Textures) mSink->Release(texture);
+  mLoads.erase(iter);
+}
+
+void ModelStreamer::BeginUpload(Load& load)
+{
+  StreamedModel& model     = load.Model;
+  PackedGeometry& geometry = model.Geometry;
+
+  model.VertexBuffer        = AddBufferJob(load, geometry.Vertices.data(), geometry.Vertices.size() * sizeof(Vertex));
+  model.CompactVertexBuffer = AddBufferJob(load, geometry.CompactVertices.data(), geometry.CompactVertices.size() * sizeof(CompactVertex));
+  model.IndexBuffer16       = AddBufferJob(load, geometry.Indices16.data(), geometry.Indices16.size() * sizeof(uint16));
+  model.IndexBuffer32       = AddBufferJob(load, geometry.Indices32.data(), geometry.Indices32.size() * sizeof(uint32));
+
+  model.Textures.assign(model.Images.size(), INVALID_UPLOAD_RESOURCE);
+  for (uint32 i = 0; i < model.Images.size(); ++i) {
+    const DecodedImage& image = model.Images[i];
+    if (image.Component != 4 || image.Width == 0 || image.Height == 0) {
+      logger.Warning(CTEXT("Skip streamed image that is not 8 bit RGBA in ") + load.FileName);
+      continue;
+    }
+
+    UploadJob job;
+    job.Resource = mSink->CreateTexture(image.Width, image.Height);
+    job.Data     = image.Pixels.data();
+    job.ByteSize = image.Pixels.size();
+    job.Width    = image.Width;
+    job.Height   = image.Height;
+    job.Progress = 0;
+    load.Jobs.push_back(job);
+    model.Textures[i] = job.Resource;
+  }
+}
+
+uint32 ModelStreamer::AddBufferJob(Load& load, const void* data, uint64 byteSize)
+{
+  if (byteSize == 0) return INVALID_UPLOAD_RESOURCE;
+
+  UploadJob job;
+  job.Resource = mSink->CreateBuffer(byteSize);
+  job.Data     = static_cast<const Byte*>(data);
+  job.ByteSize = byteSize;
+  job.Width    = 0;
+  job.Height   = 0;
+  job.Progress = 0;
+  load.Jobs.push_back(job);
+  return job.Resource;
+}
+
+bool ModelStreamer::WriteJob(UploadJob& job)
+{
+  const uint64 available = mFrameBudget > mFrameBytes ? mFrameBudget - mFrameBytes : 0;
+
+  if (job.Width == 0) {
+    const uint64 chunk = std::min<uint64>(available, job.ByteSize - job.Progress);
+    if (chunk != 0) {
+      mSink->WriteBuffer(job.Resource, job.Progress, job.Data + job.Progress, chunk);
+      job.Progress += chunk;
+      mFrameBytes += chunk;
+    }
+    return job.Progress == job.ByteSize;
+  }
+
+  // Textures go in whole rows.
+  const uint64 rowPitch = job.Width * 4ull;
+  uint64 rows           = std::min<uint64>(available / rowPitch, job.Height - job.Progress);
+  if (rows == 0 && mFrameBytes == 0) rows = 1;
+  if (rows != 0) {
+    mSink->WriteTextureRows(job.Resource, static_cast<uint32>(job.Progress), static_cast<uint32>(rows), job.Data + job.Progress * rowPitch, rowPitch);
+    job.Progress += rows;
+    mFrameBytes += rows * rowPitch;
+  }
+  return job.Progress == job.Height;
+}
+
+void ModelStreamer::ReleaseCpuData(StreamedModel& model)
+{
+  // Swap with empty vectors, clear() would keep the capacity.
+  std::vector<Vertex>().swap(model.Geometry.Vertices);
+  std::vector<CompactVertex>().swap(model.Geometry.CompactVertices);
+  std::vector<uint16>().swap(model.Geometry.Indices16);
+  std::vector<uint32>().swap(model.Geometry.Indices32);
+  std::vector<DecodedImage>().swap(model.Images);
+}
@@ -0,0 +1,206 @@
+#ifndef GRAPHICS_MODEL_STREAMER_H
+#define GRAPHICS_MODEL_STREAMER_H
+#include <algorithm>
+#include <atomic>
+#include <map>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "Common/TypeDef.h"
+#include "Core/Helpers.h"
+#include "Graphics/RenderData.h"
+#include "Model/ModelLoader.h"
+
+const uint32 INVALID_UPLOAD_RESOURCE = 0xFFFFFFFF;
+
+// Destination of the bytes ModelStreamer uploads. D3D12UploadSink records GPU copies, NullUploadSink only counts them.
+// Every call comes from the thread that runs ModelStreamer::Update.
+class IUploadSink
+{
+ public:
+  virtual ~IUploadSink() {}
+
+  virtual uint32 CreateBuffer(uint64 byteSize) = 0;
+  // R8G8B8A8_UNORM with a single mip.
+  virtual uint32 CreateTexture(uint32 width, uint32 height) = 0;
+
+  // The data only has to live until the call returns.
+  virtual void WriteBuffer(uint32 resource, uint64 offset, const void* data, uint64 byteSize) = 0;
+  // rowPitch is the distance between two rows in data.
+  virtual void WriteTextureRows(uint32 resource, uint32 firstRow, uint32 rowCount, const void* data, uint64 rowPitch) = 0;
+  // Called after the last write of a resource, it can be read once the next Submit completes.
+  virtual void Finish(uint32 resource) = 0;
+  // The resource is no longer used. Writes already made may still be copying into it, the sink frees it once they completed.
+  // A later Create may return the same index, forget it after this call.
+  virtual void Release(uint32 resource) = 0;
+
+  // Sends everything written since the last Submit and returns the fence value that marks its completion.
+  virtual uint64 Submit() = 0;
+  virtual uint64 GetCompletedFence() const = 0;
+};
+
+// Keeps no data, for running the streamer without a device.
+// Submits complete at once, or only through Complete() when completeAtOnce is false.
+class NullUploadSink : public IUploadSink
+{
+ public:
+  explicit NullUploadSink(bool completeAtOnce = true) : mCompleteAtOnce(completeAtOnce) {}
+
+  uint32 CreateBuffer(uint64 byteSize) override { return mResourceCount++; }
+  uint32 CreateTexture(uint32 width, uint32 height) override { return mResourceCount++; }
+
+  void WriteBuffer(uint32 resource, uint64 offset, const void* data, uint64 byteSize) override
+  {
+    mWrittenBytes += byteSize;
+    mUnsubmitted = true;
+  }
+  void WriteTextureRows(uint32 resource, uint32 firstRow, uint32 rowCount, const void* data, uint64 rowPitch) override
+  {
+    mWrittenBytes += rowCount * rowPitch;
+    mUnsubmitted = true;
+  }
+  void Finish(uint32 resource) override { mFinishedCount++; }
+  // Counted as freed once the submit of the writes made so far completes.
+  void Release(uint32 resource) override
+  {
+    if (resource != INVALID_UPLOAD_RESOURCE) mReleaseFences.push_back(mUnsubmitted ? mSubmittedFence + 1 : mSubmittedFence);
+  }
+
+  uint64 Submit() override
+  {
+    mSubmittedFence++;
+    mUnsubmitted = false;
+    if (mCompleteAtOnce) mCompletedFence = mSubmittedFence;
+    return mSubmittedFence;
+  }
+  uint64 GetCompletedFence() const override { return mCompletedFence; }
+  inline void Complete(uint64 fence) { mCompletedFence = std::max<uint64>(mCompletedFence, std::min<uint64>(fence, mSubmittedFence)); }
+
+  inline uint64 GetSubmittedFence() const { return mSubmittedFence; }
+  inline uint32 GetResourceCount() const { return mResourceCount; }
+  inline uint32 GetFinishedCount() const { return mFinishedCount; }
+  inline uint64 GetWrittenBytes() const { return mWrittenBytes; }
+  // Created resources that were not released, or whose release still waits for its fence.
+  inline uint32 GetLiveResourceCount() const
+  {
+    const uint64 completed = mCompletedFence;
+    return mResourceCount - static_cast<uint32>(std::count_if(mReleaseFences.begin(), mReleaseFences.end(), [=](uint64 fence) { return fence <= completed; }));
+  }
+
+ private:
+  bool mCompleteAtOnce   = true;
+  bool mUnsubmitted      = false;
+  uint32 mResourceCount  = 0;
+  uint32 mFinishedCount  = 0;
+  uint64 mWrittenBytes   = 0;
+  uint64 mSubmittedFence = 0;
+  uint64 mCompletedFence = 0;
+  // Per released resource, the fence that frees it.
+  std::vector<uint64> mReleaseFences;
+};
+
+enum class StreamState : uint8 {
+  // Parsing and decoding on a worker thread.
+  DECODING,
+  // Writing chunks to the sink, a few per frame.
+  UPLOADING,
+  // Everything is submitted, waiting for the fence.
+  WAITING_GPU,
+  // The sink resources are readable and the model can be drawn.
+  READY,
+  FAILED,
+};
+
+using StreamHandle = uint32;
+const StreamHandle INVALID_STREAM_HANDLE = 0;
+
+// A model loaded by ModelStreamer. Vertices, indices and pixels are dropped once it is READY,
+// the meshes in CpuModel keep their own copies for draw args and bounds.
+struct StreamedModel {
+  Model CpuModel;
+  PackedGeometry Geometry;
+  std::vector<DecodedImage> Images;
+  // Per mesh, texture slot name: index into Textures.
+  std::vector<std::unordered_map<CheString, uint32>> MeshImages;
+
+  // Sink resources, INVALID_UPLOAD_RESOURCE when the part is empty or could not be uploaded.
+  uint32 VertexBuffer        = INVALID_UPLOAD_RESOURCE;
+  uint32 CompactVertexBuffer = INVALID_UPLOAD_RESOURCE;
+  uint32 IndexBuffer16       = INVALID_UPLOAD_RESOURCE;
+  uint32 IndexBuffer32       = INVALID_UPLOAD_RESOURCE;
+  std::vector<uint32> Textures;
+};
+
+// Loads glTF models without stalling the frame.
+// LoadAsync returns a handle at once and decodes on the thread pool, one worker per load since nested ParallelFor calls run inline.
+// Update, called once per frame on the render thread, then hands at most the frame budget of bytes to the sink, so a large model
+// is spread over several frames.
+class ModelStreamer
+{
+ public:
+  ModelStreamer(IUploadSink* sink, uint64 frameBudget = 8ull << 20) : mSink(sink), mFrameBudget(frameBudget) {}
+  NO_COPY(ModelStreamer)
+
+  StreamHandle LoadAsync(const CheString& fileName, const ModelLoadOptions& options = ModelLoadOptions());
+
+  void Update();
+
+  StreamState GetState(StreamHandle handle) const;
+  // Null unless the load is READY.
+  StreamedModel* GetModel(StreamHandle handle);
+  // Forgets a load and releases the sink resources it still owns, the sink frees them once their copies completed.
+  void Release(StreamHandle handle);
+
+  // A single texture row larger than the budget is still written, alone in its frame.
+  inline void SetFrameBudget(uint64 frameBudget) { mFrameBudget = frameBudget; }
+  inline uint64 GetFrameBudget() const { return mFrameBudget; }
+  inline uint64 GetFrameBytes() const { return mFrameBytes; }
+  inline uint64 GetPeakFrameBytes() const { return mPeakFrameBytes; }
+  inline uint64 GetTotalBytes() const { return mTotalBytes; }
+
+ private:
+  // One resource to fill. Progress counts bytes for buffers and rows for textures.
+  struct UploadJob {
+    uint32 Resource;
+    const Byte* Data;
+    uint64 ByteSize;
+    // Zero for buffers.
+    uint32 Width;
+    uint32 Height;
+    uint64 Progress;
+  };
+
+  struct Load {
+    CheString FileName;
+    ModelLoadOptions Options;
+    StreamedModel Model;
+    // Set by the decode job, everything above is owned by the render thread after that.
+    std::atomic<bool> Decoded{false};
+    bool Failed = false;
+
+    StreamState State = StreamState::DECODING;
+    std::vector<UploadJob> Jobs;
+    uint32 NextJob = 0;
+    uint64 Fence   = 0;
+  };
+
+  void BeginUpload(Load& load);
+  uint32 AddBufferJob(Load& load, const void* data, uint64 byteSize);
+  // Returns true once the job is complete.
+  bool WriteJob(UploadJob& job);
+  static void ReleaseCpuData(StreamedModel& model);
+
+ private:
+  IUploadSink* mSink = nullptr;
+
+  // Ordered by handle, so earlier loads are uploaded first.
+  std::map<StreamHandle, std::shared_ptr<Load>> mLoads;
+  StreamHandle mNextHandle = 1;
+
+  uint64 mFrameBudget    = 0;
+  uint64 mFrameBytes     = 0;
+  uint64 mPeakFrameBytes = 0;
+  uint64 mTotalBytes     = 0;
+};
+#endif  // GRAPHICS_MODEL_STREAMER_H
@@ -0,0 +1,340 @@
+#include "Graphics/OcclusionCuller.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+// Clip w below this counts as behind the camera.
+const float MIN_CLIP_W = 1e-5f;
+// Boxes lying on an occluder, as the box of the occluder item itself, stay visible despite rounding of the interpolated depth.
+const float DEPTH_BIAS = 1e-5f;
+// Corner i of a box is at max on x, y and z for bits 0, 1 and 2 of i. Every face is clockwise seen from outside.
+const uint32 BOX_INDICES[36] = {0, 6, 2, 0, 4, 6, 1, 3, 7, 1, 7, 5, 0, 1, 5, 0, 5, 4, 2, 7, 3, 2, 6, 7, 0, 3, 1, 0, 2, 3, 4, 5, 7, 4, 7, 6};
+
+inline void ToScreen(float clipX, float clipY, float clipZ, float clipW, float width, float height, float& screenX, float& screenY, float& screenZ)
+{
+  const float invW = 1.0f / clipW;
+  screenX          = (clipX * invW * 0.5f + 0.5f) * width;
+  screenY          = (0.5f - clipY * invW * 0.5f) * height;
+  screenZ          = clipZ * invW;
+}
+}  // namespace
+
+const uint32 OcclusionCuller::DEFAULT_WIDTH;
+const uint32 OcclusionCuller::DEFAULT_HEIGHT;
+
+OcclusionCuller::OcclusionCuller(uint32 width, uint32 height) : mKernel(IsAvx2Supported() ? Kernel::AVX2 : Kernel::SSE)
+{
+  uint32 levelWidth  = std::max<uint32>((width + 7) & ~7u, 8);
+  uint32 levelHeight = std::max<uint32>(height, 1);
+  while (true) {
+    mLevels.push_back({levelWidth, levelHeight, std::vector<float>(levelWidth * levelHeight, 1.0f)});
+    if (levelWidth == 1 && levelHeight == 1) break;
+    levelWidth  = (levelWidth + 1) / 2;
+    levelHeight = (levelHeight + 1) / 2;
+  }
+}
+
+uint32 OcclusionCuller::AddOccluder(const Float3* positions, uint32 vertexCount, const uint32* indices, uint32 indexCount)
+{
+  Occluder occluder;
+  occluder.FirstVertex = static_cast<uint32>(mPositionX.size());
+  occluder.VertexCount = vertexCount;
+  occluder.FirstIndex  = static_cast<uint32>(mIndices.size());
+  occluder.IndexCount  = indexCount - indexCount % 3;
+  mOccluders.push_back(occluder);
+
+  for (uint32 i = 0; i < vertexCount; ++i) {
+    mPositionX.push_back(positions[i].x);
+    mPositionY.push_back(positions[i].y);
+    mPositionZ.push_back(positions[i].z);
+  }
+  mIndices.insert(mIndices.end(), indices, indices + occluder.IndexCount);
+
+  if (mClipW.size() < vertexCount) {
+    mScreenX.resize(vertexCount);
+    mScreenY.resize(vertexCount);
+    mScreenZ.resize(vertexCount);
+    mClipW.resize(vertexCount);
+  }
+  return GetOccluderCount() - 1;
+}
+
+uint32 OcclusionCuller::AddBoxOccluder(const Float3& boxMin, const Float3& boxMax)
+{
+  Float3 corners[8];
+  for (uint32 corner = 0; corner < 8; ++corner) {
+    corners[corner] = {corner & 1 ? boxMax.x : boxMin.x, corner & 2 ? boxMax.y : boxMin.y, corner & 4 ? boxMax.z : boxMin.z};
+  }
+  return AddOccluder(corners, 8, BOX_INDICES, 36);
+}
+
+void OcclusionCuller::SetOccluderTransform(uint32 occluder, const Float4x4& objectToWorld) { mOccluders[occluder].World = objectToWorld; }
+
+void OcclusionCuller::SetKernel(Kernel kernel) { mKernel = kernel == Kernel::AVX2 && !IsAvx2Supported() ? Kernel::SSE : kernel; }
+
+void OcclusionCuller::Render(const Float4x4& viewProj)
+{
+  mViewProj = viewProj;
+  std::fill(mLevels[0].Depth.begin(), mLevels[0].Depth.end(), 1.0f);
+
+  for (const Occluder& occluder : mOccluders) {
+    TransformVertices(occluder, Multiply(occluder.World, viewProj));
+    const uint32* indices = mIndices.data() + occluder.FirstIndex;
+    for (uint32 i = 0; i < occluder.IndexCount; i += 3) {
+      RasterizeTriangle(indices[i], indices[i + 1], indices[i + 2]);
+    }
+  }
+  BuildPyramid();
+}
+
+void OcclusionCuller::TransformVertices(const Occluder& occluder, const Float4x4& objectToClip)
+{
+  const float(&m)[4][4] = objectToClip.m;
+  const float width  = static_cast<float>(GetWidth());
+  const float height = static_cast<float>(GetHeight());
+
+  const float* positionX = mPositionX.data() + occluder.FirstVertex;
+  const float* positionY = mPositionY.data() + occluder.FirstVertex;
+  const float* positionZ = mPositionZ.data() + occluder.FirstVertex;
+
+  // Row vectors, p * M, 4 vertices per step. The scalar kernel and the tail do the same operations in the same order.
+  uint32 i = 0;
+  if (mKernel != Kernel::SCALAR) {
+    const __m128 half        = _mm_set1_ps(0.5f);
+    const __m128 one         = _mm_set1_ps(1.0f);
+    const __m128 widthScale  = _mm_set1_ps(width);
+    const __m128 heightScale = _mm_set1_ps(height);
+    for (; i + 4 <= occluder.VertexCount; i += 4) {
+      const __m128 x = _mm_loadu_ps(positionX + i);
+      const __m128 y = _mm_loadu_ps(positionY + i);
+      const __m128 z = _mm_loadu_ps(positionZ + i);
+
+      __m128 clip[4];
+      for (uint32 c = 0; c < 4; ++c) {
+        __m128 value = _mm_add_ps(_mm_mul_ps(x, _mm_set1_ps(m[0][c])), _mm_mul_ps(y, _mm_set1_ps(m[1][c])));
+        value        = _mm_add_ps(value, _mm_mul_ps(z, _mm_set1_ps(m[2][c])));
+        clip[c]      = _mm_add_ps(value, _mm_set1_ps(m[3][c]));
+      }
+
+      const __m128 invW = _mm_div_ps(one, clip[3]);
+      _mm_storeu_ps(&mScreenX[i], _mm_mul_ps(_mm_add_ps(_mm_mul_ps(_mm_mul_ps(clip[0], invW), half), half), widthScale));
+      _mm_storeu_ps(&mScreenY[i], _mm_mul_ps(_mm_sub_ps(half, _mm_mul_ps(_mm_mul_ps(clip[1], invW), half)), heightScale));
+      _mm_storeu_ps(&mScreenZ[i], _mm_mul_ps(clip[2], invW));
+      _mm_storeu_ps(&mClipW[i], clip[3]);
+    }
+  }
+  for (; i < occluder.VertexCount; ++i) {
+    float clip[4];
+    for (uint32 c = 0; c < 4; ++c) {
+      clip[c] = positionX[i] * m[0][c] + positionY[i] * m[1][c] + positionZ[i] * m[2][c] + m[3][c];
+    }
+    ToScreen(clip[0], clip[1], clip[2], clip[3], width, height, mScreenX[i], mScreenY[i], mScreenZ[i]);
+    mClipW[i] = clip[3];
+  }
+}
+
+void OcclusionCuller::RasterizeTriangle(uint32 v0, uint32 v1, uint32 v2)
+{
+  if (!(mClipW[v0] >= MIN_CLIP_W && mClipW[v1] >= MIN_CLIP_W && mClipW[v2] >= MIN_CLIP_W)) return;
+
+  const float x[3] = {mScreenX[v0], mScreenX[v1], mScreenX[v2]};
+  const float y[3] = {mScreenY[v0], mScreenY[v1], mScreenY[v2]};
+  const float z[3] = {mScreenZ[v0], mScreenZ[v1], mScreenZ[v2]};
+
+  // Twice the signed area, positive for clockwise triangles on screen. Back faces are culled as by the default rasterizer state.
+  const float area = (x[1] - x[0]) * (y[2] - y[0]) - (x[2] - x[0]) * (y[1] - y[0]);
+  if (!(area > 0.0f)) return;
+
+  // Pixel centers sit at +0.5, the clamped box holds every center inside the triangle.
+  const float width  = static_cast<float>(GetWidth());
+  const float height = static_cast<float>(GetHeight());
+  const float minX   = std::max<float>(floorf(std::min<float>(x[0], std::min<float>(x[1], x[2]))), 0.0f);
+  const float maxX   = std::min<float>(ceilf(std::max<float>(x[0], std::max<float>(x[1], x[2]))), width - 1.0f);
+  const float minY   = std::max<float>(floorf(std::min<float>(y[0], std::min<float>(y[1], y[2]))), 0.0f);
+  const float maxY   = std::min<float>(ceilf(std::max<float>(y[0], std::max<float>(y[1], y[2]))), height - 1.0f);
+  if (minX > maxX || minY > maxY) return;
+
+  // Edge i runs from vertex i to vertex i + 1, E(p) = A * p.x + B * p.y + C.
+  TriangleSetup setup;
+  for (uint32 e = 0; e < 3; ++e) {
+    const uint32 next = (e + 1) % 3;
+    setup.EdgeA[e]    = y[e] - y[next];
+    setup.EdgeB[e]    = x[next] - x[e];
+    setup.EdgeC[e]    = (y[next] - y[e]) * x[e] - (x[next] - x[e]) * y[e];
+  }
+  // Edge 1 faces vertex 0 and edge 2 faces vertex 1, so z = z0 + E2 / area * (z1 - z0) + E0 / area * (z2 - z0).
+  setup.Z0          = z[0];
+  setup.DepthScale1 = (z[1] - z[0]) / area;
+  setup.DepthScale2 = (z[2] - z[0]) / area;
+
+  DepthLevel& level  = mLevels[0];
+  const int32 begin  = static_cast<int32>(minX);
+  const int32 end    = static_cast<int32>(maxX);
+  const int32 rowEnd = static_cast<int32>(maxY);
+  for (int32 row = static_cast<int32>(minY); row <= rowEnd; ++row) {
+    const float centerY = static_cast<float>(row) + 0.5f;
+    const float rowEdges[3] = {setup.EdgeB[0] * centerY + setup.EdgeC[0], setup.EdgeB[1] * centerY + setup.EdgeC[1], setup.EdgeB[2] * centerY + setup.EdgeC[2]};
+    float* depthRow = level.Depth.data() + row * level.Width;
+    switch (mKernel) {
+      case Kernel::AVX2:
+        RasterizeSpanAvx2(setup, rowEdges, depthRow, begin, end);
+        break;
+      case Kernel::SSE:
+        RasterizeSpanSse(setup, rowEdges, depthRow, begin, end);
+        break;
+      default:
+        RasterizeSpanScalar(setup, rowEdges, depthRow, begin, end);
+        break;
+    }
+  }
+}
+
+void OcclusionCuller::RasterizeSpanScalar(const TriangleSetup& setup, const float rowEdges[3], float* row, int32 begin, int32 end)
+{
+  for (int32 x = begin; x <= end; ++x) {
+    const float centerX = static_cast<float>(x) + 0.5f;
+    const float edge0   = setup.EdgeA[0] * centerX + rowEdges[0];
+    const float edge1   = setup.EdgeA[1] * centerX + rowEdges[1];
+    const float edge2   = setup.EdgeA[2] * centerX + rowEdges[2];
+    if (edge0 < 0.0f || edge1 < 0.0f || edge2 < 0.0f) continue;
+
+    const float depth = setup.Z0 + edge2 * setup.DepthScale1 + edge0 * setup.DepthScale2;
+    row[x]            = std::min<float>(row[x], depth);
+  }
+}
+
+void OcclusionCuller::RasterizeSpanSse(const TriangleSetup& setup, const float rowEdges[3], float* row, int32 begin, int32 end)
+{
+  const __m128 edgeA0  = _mm_set1_ps(setup.EdgeA[0]);
+  const __m128 edgeA1  = _mm_set1_ps(setup.EdgeA[1]);
+  const __m128 edgeA2  = _mm_set1_ps(setup.EdgeA[2]);
+  const __m128 rowE0   = _mm_set1_ps(rowEdges[0]);
+  const __m128 rowE1   = _mm_set1_ps(rowEdges[1]);
+  const __m128 rowE2   = _mm_set1_ps(rowEdges[2]);
+  const __m128 z0      = _mm_set1_ps(setup.Z0);
+  const __m128 scale1  = _mm_set1_ps(setup.DepthScale1);
+  const __m128 scale2  = _mm_set1_ps(setup.DepthScale2);
+  const __m128 zero    = _mm_setzero_ps();
+  const __m128 centers = _mm_setr_ps(0.5f, 1.5f, 2.5f, 3.5f);
+
+  for (int32 x = begin & ~3; x <= end; x += 4) {
+    const __m128 centerX = _mm_add_ps(_mm_set1_ps(static_cast<float>(x)), centers);
+    const __m128 edge0   = _mm_add_ps(_mm_mul_ps(edgeA0, centerX), rowE0);
+    const __m128 edge1   = _mm_add_ps(_mm_mul_ps(edgeA1, centerX), rowE1);
+    const __m128 edge2   = _mm_add_ps(_mm_mul_ps(edgeA2, centerX), rowE2);
+    const __m128 inside  = _mm_and_ps(_mm_and_ps(_mm_cmpge_ps(edge0, zero), _mm_cmpge_ps(edge1, zero)), _mm_cmpge_ps(edge2, zero));
+    if (_mm_movemask_ps(inside) == 0) continue;
+
+    const __m128 depth   = _mm_add_ps(_mm_add_ps(z0, _mm_mul_ps(edge2, scale1)), _mm_mul_ps(edge0, scale2));
+    const __m128 current = _mm_loadu_ps(row + x);
+    const __m128 nearest = _mm_min_ps(current, depth);
+    _mm_storeu_ps(row + x, _mm_or_ps(_mm_and_ps(inside, nearest), _mm_andnot_ps(inside, current)));
+  }
+}
+
+TARGET_AVX2 void OcclusionCuller::RasterizeSpanAvx2(const TriangleSetup& setup, const float rowEdges[3], float* row, int32 begin, int32 end)
+{
+  const __m256 edgeA0  = _mm256_set1_ps(setup.EdgeA[0]);
+  const __m256 edgeA1  = _mm256_set1_ps(setup.EdgeA[1]);
+  const __m256 edgeA2  = _mm256_set1_ps(setup.EdgeA[2]);
+  const __m256 rowE0   = _mm256_set1_ps(rowEdges[0]);
+  const __m256 rowE1   = _mm256_set1_ps(rowEdges[1]);
+  const __m256 rowE2   = _mm256_set1_ps(rowEdges[2]);
+  const __m256 z0      = _mm256_set1_ps(setup.Z0);
+  const __m256 scale1  = _mm256_set1_ps(setup.DepthScale1);
+  const __m256 scale2  = _mm256_set1_ps(setup.DepthScale2);
+  const __m256 zero    = _mm256_setzero_ps();
+  const __m256 centers = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+
+  for (int32 x = begin & ~7; x <= end; x += 8) {
+    const __m256 centerX = _mm256_add_ps(_mm256_set1_ps(static_cast<float>(x)), centers);
+    const __m256 edge0   = _mm256_add_ps(_mm256_mul_ps(edgeA0, centerX), rowE0);
+    const __m256 edge1   = _mm256_add_ps(_mm256_mul_ps(edgeA1, centerX), rowE1);
+    const __m256 edge2   = _mm256_add_ps(_mm256_mul_ps(edgeA2, centerX), rowE2);
+    const __m256 inside  = _mm256_and_ps(_mm256_and_ps(_mm256_cmp_ps(edge0, zero, _CMP_GE_OQ), _mm256_cmp_ps(edge1, zero, _CMP_GE_OQ)),
+                                         _mm256_cmp_ps(edge2, zero, _CMP_GE_OQ));
+    if (_mm256_movemask_ps(inside) == 0) continue;
+
+    const __m256 depth   = _mm256_add_ps(_mm256_add_ps(z0, _mm256_mul_ps(edge2, scale1)), _mm256_mul_ps(edge0, scale2));
+    const __m256 current = _mm256_loadu_ps(row + x);
+    _mm256_storeu_ps(row + x, _mm256_blendv_ps(current, _mm256_min_ps(current, depth), inside));
+  }
+}
+
+void OcclusionCuller::BuildPyramid()
+{
+  for (uint32 l = 1; l < mLevels.size(); ++l) {
+    const DepthLevel& source = mLevels[l - 1];
+    DepthLevel& level        = mLevels[l];
+    for (uint32 y = 0; y < level.Height; ++y) {
+      // Odd sizes leave the last texel of a level with a single row or column below it.
+      const float* row0 = source.Depth.data() + 2 * y * source.Width;
+      const float* row1 = 2 * y + 1 < source.Height ? row0 + source.Width : row0;
+      for (uint32 x = 0; x < level.Width; ++x) {
+        const uint32 x0 = 2 * x;
+        const uint32 x1 = std::min<uint32>(x0 + 1, source.Width - 1);
+        level.Depth[y * level.Width + x] = std::max<float>(std::max<float>(row0[x0], row0[x1]), std::max<float>(row1[x0], row1[x1]));
+      }
+    }
+  }
+}
+
+bool OcclusionCuller::IsOccluded(const Float3& center, const Float3& extent) const
+{
+  const float(&m)[4][4] = mViewProj.m;
+  const float width     = static_cast<float>(GetWidth());
+  const float height    = static_cast<float>(GetHeight());
+
+  float minX = width, maxX = 0.0f, minY = height, maxY = 0.0f, minZ = 1.0f;
+  for (uint32 corner = 0; corner < 8; ++corner) {
+    const float x = center.x + (corner & 1 ? extent.x : -extent.x);
+    const float y = center.y + (corner & 2 ? extent.y : -extent.y);
+    const float z = center.z + (corner & 4 ? extent.z : -extent.z);
+    float clip[4];
+    for (uint32 c = 0; c < 4; ++c) clip[c] = x * m[0][c] + y * m[1][c] + z * m[2][c] + m[3][c];
+    if (!(clip[3] >= MIN_CLIP_W)) return false;
+
+    float screenX, screenY, screenZ;
+    ToScreen(clip[0], clip[1], clip[2], clip[3], width, height, screenX, screenY, screenZ);
+    minX = std::min<float>(minX, screenX);
+    maxX = std::max<float>(maxX, screenX);
+    minY = std::min<float>(minY, screenY);
+    maxY = std::max<float>(maxY, screenY);
+    minZ = std::min<float>(minZ, screenZ);
+  }
+  // Boxes off screen are left to the frustum culler.
+  if (maxX < 0.0f || minX >= width || maxY < 0.0f || minY >= height) return false;
+
+  const int32 x0 = static_cast<int32>(std::max<float>(minX, 0.0f));
+  const int32 x1 = static_cast<int32>(std::min<float>(maxX, width - 1.0f));
+  const int32 y0 = static_cast<int32>(std::max<float>(minY, 0.0f));
+  const int32 y1 = static_cast<int32>(std::min<float>(maxY, height - 1.0f));
+
+  // The finest level where the rectangle spans at most 2x2 texels.
+  uint32 l = 0;
+  while (((x1 >> l) - (x0 >> l) > 1 || (y1 >> l) - (y0 >> l) > 1) && l + 1 < mLevels.size()) ++l;
+
+  const DepthLevel& level = mLevels[l];
+  float farthest          = 0.0f;
+  for (int32 y = y0 >> l; y <= y1 >> l; ++y) {
+    for (int32 x = x0 >> l; x <= x1 >> l; ++x) {
+      farthest = std::max<float>(farthest, level.Depth[y * level.Width + x]);
+    }
+  }
+  return minZ > farthest + DEPTH_BIAS;
+}
+
+uint32 OcclusionCuller::Cull(const CullBoxes& boxes, std::vector<uint32>& visible) const
+{
+  uint32 visibleCount = 0;
+  for (uint32 box : visible) {
+    const Float3 center = {boxes.mCenterX[box], boxes.mCenterY[box], boxes.mCenterZ[box]};
+    const Float3 extent = {boxes.mExtentX[box], boxes.mExtentY[box], boxes.mExtentZ[box]};
+    if (!IsOccluded(center, extent)) visible[visibleCount++] = box;
+  }
+  visible.resize(visibleCount);
+  return visibleCount;
+}
@@ -0,0 +1,108 @@
+#ifndef GRAPHICS_OCCLUSION_CULLER_H
+#define GRAPHICS_OCCLUSION_CULLER_H
+#include <vector>
+
+#include "Common/Types.h"
+#include "Core/Helpers.h"
+#include "Graphics/CullBoxes.h"
+#include "Math/Matrix.h"
+#include "Utils/CpuFeatures.h"
+
+// Software occlusion culling on the CPU. A few occluder meshes are rasterized into a small depth buffer every frame,
+// which is reduced into a hierarchical Z pyramid, then CullBoxes are tested against the pyramid level that covers them with 2x2 texels.
+// Depth is clip z / w, 0 at the near plane, and every pyramid texel holds the farthest depth below it,
+// so a box is only occluded when its nearest point lies behind all occluder depths over its screen rectangle.
+// Occluder triangles crossing the camera plane are skipped and boxes crossing it always pass, both only lose culling.
+// Free of platform headers so the golden tests and benchmarks build anywhere, Graphics/XMOcclusionCuller.h takes DirectXMath types.
+class OcclusionCuller
+{
+ public:
+  using Kernel = SimdKernel;
+
+  // The width is rounded up to a multiple of 8, the rasterizer steps through rows 8 pixels at a time.
+  static const uint32 DEFAULT_WIDTH  = 320;
+  static const uint32 DEFAULT_HEIGHT = 180;
+
+  OcclusionCuller(uint32 width = DEFAULT_WIDTH, uint32 height = DEFAULT_HEIGHT);
+  NO_COPY(OcclusionCuller)
+
+  // Copies the object space triangle list, returns the occluder index. Clockwise triangles face the camera, back faces do not occlude.
+  uint32 AddOccluder(const Float3* positions, uint32 vertexCount, const uint32* indices, uint32 indexCount);
+  // An object space box, e.g. a proxy authored inside a mesh too detailed to rasterize every frame. Returns the occluder index.
+  uint32 AddBoxOccluder(const Float3& boxMin, const Float3& boxMax);
+  void SetOccluderTransform(uint32 occluder, const Float4x4& objectToWorld);
+  inline uint32 GetOccluderCount() const { return static_cast<uint32>(mOccluders.size()); }
+
+  // Clears the depth buffer, draws every occluder with viewProj and builds the pyramid.
+  void Render(const Float4x4& viewProj);
+
+  // Whether the world space box lies behind the occluders of the last Render.
+  bool IsOccluded(const Float3& center, const Float3& extent) const;
+  // Drops the occluded boxes from visible, the others keep their order. Returns the new count.
+  uint32 Cull(const CullBoxes& boxes, std::vector<uint32>& visible) const;
+
+  // The best supported kernel by default, a kernel the CPU cannot run falls back to SSE. All kernels write the same depths.
+  void SetKernel(Kernel kernel);
+  inline Kernel GetKernel() const { return mKernel; }
+
+  inline uint32 GetLevelCount() const { return static_cast<uint32>(mLevels.size()); }
+  inline uint32 GetWidth(uint32 level = 0) const { return mLevels[level].Width; }
+  inline uint32 GetHeight(uint32 level = 0) const { return mLevels[level].Height; }
+  // Level 0 is the rasterized depth, row major.
+  inline const float* GetDepth(uint32 level = 0) const { return mLevels[level].Depth.data(); }
+
+ private:
+  struct Occluder {
+    uint32 FirstVertex;
+    uint32 VertexCount;
+    uint32 FirstIndex;
+    uint32 IndexCount;
+    Float4x4 World;
+  };
+
+  struct DepthLevel {
+    uint32 Width;
+    uint32 Height;
+    std::vector<float> Depth;
+  };
+
+  // Edge functions and depth of one triangle, interior pixels have all three edges >= 0.
+  struct TriangleSetup {
+    float EdgeA[3];
+    float EdgeB[3];
+    float EdgeC[3];
+    float Z0;
+    // Depth change per unit of edge 1 and edge 2, the barycentric weights of vertex 1 and 2 scaled by the area.
+    float DepthScale1;
+    float DepthScale2;
+  };
+
+  // Screen x and y in pixels, z and clip w of the occluder vertices.
+  void TransformVertices(const Occluder& occluder, const Float4x4& objectToClip);
+  void RasterizeTriangle(uint32 v0, uint32 v1, uint32 v2);
+  void BuildPyramid();
+
+  // Pixels [begin, end] of a row, SSE and AVX2 start at multiples of 4 and 8.
+  static void RasterizeSpanScalar(const TriangleSetup& setup, const float rowEdges[3], float* row, int32 begin, int32 end);
+  static void RasterizeSpanSse(const TriangleSetup& setup, const float rowEdges[3], float* row, int32 begin, int32 end);
+  static void RasterizeSpanAvx2(const TriangleSetup& setup, const float rowEdges[3], float* row, int32 begin, int32 end);
+
+ private:
+  Kernel mKernel = Kernel::SSE;
+  Float4x4 mViewProj;
+  std::vector<DepthLevel> mLevels;
+
+  std::vector<Occluder> mOccluders;
+  // Object space positions of all occluders, one array per component.
+  std::vector<float> mPositionX;
+  std::vector<float> mPositionY;
+  std::vector<float> mPositionZ;
+  std::vector<uint32> mIndices;
+
+  // TransformVertices output for the occluder being drawn.
+  std::vector<float> mScreenX;
+  std::vector<float> mScreenY;
+  std::vector<float> mScreenZ;
+  std::vector<float> mClipW;
+};
+#endif  // GRAPHICS_OCCLUSION_CULLER_H
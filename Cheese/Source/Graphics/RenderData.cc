@@ -1,23 +1,104 @@
 #include "RenderData.h"
 
-RenderItem::RenderItem(const Model* model, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList)
-    : mPerObjectCBManagers(), mDrawArgs(model->GetMeshes().size())
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <map>
+#include "Graphics/D3D12UploadSink.h"
+#include "Graphics/LodSelector.h"
+#include "Graphics/ModelStreamer.h"
+#include "Utils/ThreadPool.h"
+
+const uint32 RenderData::MATERIAL_TEXTURE_COUNT;
+const CheChar* const RenderData::MATERIAL_TEXTURE_NAMES[] = {CTEXT("gAlbedoMap"), CTEXT("gNormalMap"), CTEXT("gORMMap")};
+
+RenderItem::RenderItem(const Model* model, GeometryHeaps& heaps, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList)
+    : mDrawArgs(model->GetMeshes().size())
 {
   BuildDrawArgs(model);
-  BuildMeshUploadResource(model, device, cmdList);
+
+  PackedGeometry geometry;
+  PackGeometry(model, geometry);
+  BuildMeshUploadResource(geometry, heaps, device, cmdList);
+  mQuantization = geometry.Quantization;
+  mMeshlets     = std::make_shared<std::vector<MeshletData>>(std::move(geometry.Meshlets));
+}
+
+RenderItem::RenderItem(const Model* model, PackedGeometry&& geometry, const GeometryBuffers& buffers, GeometryHeaps& heaps, ID3D12Device* device)
+    : mDrawArgs(model->GetMeshes().size())
+{
+  BuildDrawArgs(model);
+  AllocateGeometry(heaps, device);
+
+  mQuantization = geometry.Quantization;
+  mMeshlets     = std::make_shared<std::vector<MeshletData>>(std::move(geometry.Meshlets));
+  heaps.Vertices.QueueCopy(mVertexRange, buffers.VertexBuffer, mTotalVertexCount);
+  heaps.CompactVertices.QueueCopy(mCompactVertexRange, buffers.CompactVertexBuffer, mTotalCompactVertexCount);
+  heaps.Indices.QueueCopy(mIndexRange16, buffers.IndexBuffer16, mTotalIndexCount16);
+  heaps.Indices.QueueCopy(mIndexRange32, buffers.IndexBuffer32, mTotalIndexCount32 * 2);
 }
 
-void RenderItem::BuildPerObjectCBuffer(ID3D12Device* device, const CheString& shaderName,
-                                       std::unordered_map<CheString, CBufferInfo> cbSettings)
+RenderItem::RenderItem(const CookedModel& model, GeometryHeaps& heaps, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList)
+    : mDrawArgs(model.GetHeader().DrawCount)
 {
-  for (auto pair : cbSettings) {
-    auto cbName = pair.first;
-    auto cbInfo = pair.second;
-    // RenderItem just save tag:PEROBJECT data.
-    if (CBufferManager::CBufferConfig[cbName] == CBufferType::PEROBJECT) {
-      mPerObjectCBManagers[shaderName].AddCBuffer(device, cbName, cbInfo);
+  const CookedFormat::Header& header = model.GetHeader();
+
+  mTotalVertexCount        = header.VertexCount;
+  mTotalIndexCount16       = header.IndexCount16;
+  mTotalIndexCount32       = header.IndexCount32;
+  mTotalSrvDescriptorCount = 0;
+
+  mTextures.resize(header.ImageCount);
+  for (uint32 i = 0; i < header.ImageCount; i++) {
+    const CookedFormat::Image& image = model.GetImages()[i];
+    D3DUtil::CreateTexture2DFromPixels(device, cmdList, model.GetImagePixels(i), image.Width, image.Height, image.Component, mTextures[i]);
+  }
+
+  // The draw table already holds the offsets BuildDrawArgs would compute.
+  for (uint32 i = 0; i < header.DrawCount; i++) {
+    const CookedFormat::Draw& draw = model.GetDraws()[i];
+
+    mDrawArgs[i].IsBlend            = draw.IsBlend != 0;
+    mDrawArgs[i].Format             = VertexFormat::STANDARD;
+    mDrawArgs[i].BaseVertexLocation = draw.BaseVertexLocation;
+    mDrawArgs[i].IndexCount         = draw.Lods[0].IndexCount;
+    mDrawArgs[i].StartIndexLocation = draw.StartIndexLocation + draw.Lods[0].StartIndex;
+    mDrawArgs[i].IndexFormat        = draw.IndexSize == sizeof(uint16) ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+    mDrawArgs[i].BoundsCenter       = {draw.BoundsCenter[0], draw.BoundsCenter[1], draw.BoundsCenter[2]};
+    mDrawArgs[i].BoundsRadius       = draw.BoundsRadius;
+    mDrawArgs[i].BoundsMin          = {draw.BoundsMin[0], draw.BoundsMin[1], draw.BoundsMin[2]};
+    mDrawArgs[i].BoundsMax          = {draw.BoundsMax[0], draw.BoundsMax[1], draw.BoundsMax[2]};
+
+    mDrawArgs[i].LodCount = draw.LodCount;
+    for (uint32 lod = 0; lod < draw.LodCount; lod++) {
+      mDrawArgs[i].Lods[lod] = {draw.Lods[lod].IndexCount, draw.StartIndexLocation + draw.Lods[lod].StartIndex, draw.Lods[lod].Error};
+    }
+
+    mDrawArgs[i].FirstSrv = static_cast<uint32>(mDrawSrvs.size());
+    mDrawArgs[i].SrvCount = draw.BindingCount;
+    for (uint32 j = 0; j < draw.BindingCount; j++) {
+      const CookedFormat::Binding& binding = model.GetBindings()[draw.FirstBinding + j];
+      const Texture2D& texture             = mTextures[binding.ImageIndex];
+
+      mDrawSrvs.push_back({ConvertToCheString(binding.Name), mTotalSrvDescriptorCount, texture.Dimension, texture.Resource});
+      mTotalSrvDescriptorCount++;
     }
   }
+
+  // No CPU side copy, the staging pages are filled straight from the mapped file.
+  AllocateGeometry(heaps, device);
+  heaps.Indices.Upload(device, cmdList, mIndexRange16, model.GetIndexData16(), mTotalIndexCount16);
+  heaps.Indices.Upload(device, cmdList, mIndexRange32, model.GetIndexData32(), mTotalIndexCount32 * 2);
+  heaps.Vertices.Upload(device, cmdList, mVertexRange, model.GetVertexData(), mTotalVertexCount);
+}
+
+const DrawMaterial* RenderItem::FindDrawSrv(uint32 drawArgIndex, const CheString& name) const
+{
+  const DrawArg& arg = mDrawArgs[drawArgIndex];
+  for (uint32 i = arg.FirstSrv; i < arg.FirstSrv + arg.SrvCount; ++i) {
+    if (mDrawSrvs[i].Name == name) return &mDrawSrvs[i];
+  }
+  return nullptr;
 }
 
 D3D12_INDEX_BUFFER_VIEW RenderItem::GetIndexBufferView16() const
@@ -29,7 +110,7 @@ D3D12_INDEX_BUFFER_VIEW RenderItem::GetIndexBufferView16() const
   }
   ibv.BufferLocation = mIndexBufferGPU16->GetGPUVirtualAddress();
   ibv.Format         = DXGI_FORMAT_R16_UINT;
-  ibv.SizeInBytes    = static_cast<UINT>(mTotalIndexCount16 * sizeof(uint16));
+  ibv.SizeInBytes    = static_cast<UINT>(mIndexBufferGPU16->GetDesc().Width);
   return ibv;
 }
 
@@ -42,22 +123,40 @@ D3D12_INDEX_BUFFER_VIEW RenderItem::GetIndexBufferView32() const
   }
   ibv.BufferLocation = mIndexBufferGPU32->GetGPUVirtualAddress();
   ibv.Format         = DXGI_FORMAT_R32_UINT;
-  ibv.SizeInBytes    = static_cast<UINT>(mTotalIndexCount16 * sizeof(uint32));
+  ibv.SizeInBytes    = static_cast<UINT>(mIndexBufferGPU32->GetDesc().Width);
   return ibv;
 }
 
 D3D12_VERTEX_BUFFER_VIEW RenderItem::GetVertexBufferView() const
 {
   D3D12_VERTEX_BUFFER_VIEW vbv;
+  if (mVertexBufferGPU == nullptr) {
+    ZeroMemory(&vbv, sizeof(D3D12_VERTEX_BUFFER_VIEW));
+    return vbv;
+  }
   vbv.BufferLocation = mVertexBufferGPU->GetGPUVirtualAddress();
   vbv.StrideInBytes  = sizeof(Vertex);
-  vbv.SizeInBytes    = static_cast<UINT>(mTotalVertexCount * sizeof(Vertex));
+  vbv.SizeInBytes    = static_cast<UINT>(mVertexBufferGPU->GetDesc().Width);
+  return vbv;
+}
+
+D3D12_VERTEX_BUFFER_VIEW RenderItem::GetCompactVertexBufferView() const
+{
+  D3D12_VERTEX_BUFFER_VIEW vbv;
+  if (mCompactVertexBufferGPU == nullptr) {
+    ZeroMemory(&vbv, sizeof(D3D12_VERTEX_BUFFER_VIEW));
+    return vbv;
+  }
+  vbv.BufferLocation = mCompactVertexBufferGPU->GetGPUVirtualAddress();
+  vbv.StrideInBytes  = sizeof(CompactVertex);
+  vbv.SizeInBytes    = static_cast<UINT>(mCompactVertexBufferGPU->GetDesc().Width);
   return vbv;
 }
 
 void RenderItem::BuildDrawArgs(const Model* model)
 {
   mTotalVertexCount        = 0;
+  mTotalCompactVertexCount = 0;
   mTotalIndexCount16       = 0;
   mTotalIndexCount32       = 0;
   mTotalSrvDescriptorCount = 0;
@@ -69,8 +168,9 @@ void RenderItem::BuildDrawArgs(const Model* model)
     mDrawArgs[i].IsBlend = mesh->GetBlend();
 
     // Record render desc.
-    mDrawArgs[i].BaseVertexLocation = mTotalVertexCount;
-    mDrawArgs[i].IndexCount         = mesh->GetIndexCount();
+    mDrawArgs[i].Format             = mesh->GetVertexFormat();
+    mDrawArgs[i].BaseVertexLocation = mesh->GetVertexFormat() == VertexFormat::COMPACT ? mTotalCompactVertexCount : mTotalVertexCount;
+    mDrawArgs[i].IndexCount         = mesh->GetLod(0).IndexCount;
     if (mesh->GetIndexFormat() == DXGI_FORMAT_R16_UINT) {
       mDrawArgs[i].IndexFormat        = DXGI_FORMAT_R16_UINT;
       mDrawArgs[i].StartIndexLocation = mTotalIndexCount16;
@@ -81,93 +181,422 @@ void RenderItem::BuildDrawArgs(const Model* model)
       mTotalIndexCount32 += mesh->GetIndexCount();
     }
 
-    mTotalVertexCount += mesh->GetVertexCount();
+    // The LODs of a mesh sit behind LOD 0 in its index range.
+    mDrawArgs[i].LodCount = mesh->GetLodCount();
+    for (uint32 lod = 0; lod < mesh->GetLodCount(); lod++) {
+      const MeshLod meshLod  = mesh->GetLod(lod);
+      mDrawArgs[i].Lods[lod] = {meshLod.IndexCount, mDrawArgs[i].StartIndexLocation + meshLod.StartIndex, meshLod.Error};
+    }
+    mesh->GetBoundingSphere(mDrawArgs[i].BoundsCenter, mDrawArgs[i].BoundsRadius);
+    mesh->GetBoundingBox(mDrawArgs[i].BoundsMin, mDrawArgs[i].BoundsMax);
+
+    if (mesh->GetVertexFormat() == VertexFormat::COMPACT) {
+      mTotalCompactVertexCount += mesh->GetVertexCount();
+    } else {
+      mTotalVertexCount += mesh->GetVertexCount();
+    }
 
-    Material& material = mesh->GetMaterial();
+    Material& material    = mesh->GetMaterial();
+    mDrawArgs[i].FirstSrv = static_cast<uint32>(mDrawSrvs.size());
+    mDrawArgs[i].SrvCount = static_cast<uint32>(material.Textures.size());
     for (auto pair : material.Textures) {
       auto texName = pair.first;
       auto texture = pair.second;
 
-      mDrawArgs[i].DrawSrvs[texName].SrvIndex  = mTotalSrvDescriptorCount;
-      mDrawArgs[i].DrawSrvs[texName].Dimension = texture.Dimension;
-      mDrawArgs[i].DrawSrvs[texName].Resource  = texture.Resource;
+      mDrawSrvs.push_back({texName, mTotalSrvDescriptorCount, texture.Dimension, texture.Resource});
       mTotalSrvDescriptorCount++;
     }
   }
 }
 
-void RenderItem::BuildMeshUploadResource(const Model* model, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList)
+void RenderItem::PackGeometry(const Model* model, PackedGeometry& geometry)
 {
-  std::vector<Vertex> totalVertices(mTotalVertexCount);
-  std::vector<uint16> totalIndices16(mTotalIndexCount16);
-  std::vector<uint32> totalIndices32(mTotalIndexCount32);
+  const std::vector<IMesh*>& meshes = model->GetMeshes();
+
+  uint32 vertexCount        = 0;
+  uint32 compactVertexCount = 0;
+  uint32 indexCount16       = 0;
+  uint32 indexCount32       = 0;
+  for (const IMesh* mesh : meshes) {
+    // One quantization box around all compact meshes, so the item needs a single set of dequantization constants.
+    if (mesh->GetVertexFormat() == VertexFormat::COMPACT) {
+      geometry.Quantization = VertexCompressor::ComputeQuantization(mesh->GetVertices(), compactVertexCount != 0 ? &geometry.Quantization : nullptr);
+      compactVertexCount += mesh->GetVertexCount();
+    } else {
+      vertexCount += mesh->GetVertexCount();
+    }
 
-  // Copy vertices&indices data.
-  uint32 copyVertexOffset  = 0;
-  uint32 copyIndexOffset16 = 0;
-  uint32 copyIndexOffset32 = 0;
+    if (mesh->GetIndexFormat() == DXGI_FORMAT_R16_UINT) {
+      indexCount16 += mesh->GetIndexCount();
+    } else {
+      indexCount32 += mesh->GetIndexCount();
+    }
+  }
 
-  for (uint32 i = 0; i < model->GetMeshes().size(); i++) {
-    const IMesh* mesh     = model->GetMeshes()[i];
-    const uint32 copySize = mesh->GetVertexByteSize();
-    Byte* copyTarget      = reinterpret_cast<Byte*>(totalVertices.data());
-    memcpy_s(copyTarget + copyVertexOffset, copySize, mesh->GetVertexByteData(), copySize);
-    copyVertexOffset += mesh->GetVertexByteSize();
+  geometry.Vertices.resize(vertexCount);
+  geometry.CompactVertices.resize(compactVertexCount);
+  geometry.Indices16.resize(indexCount16);
+  geometry.Indices32.resize(indexCount32);
+
+  // Copy vertices&indices data.
+  uint32 copyVertexOffset        = 0;
+  uint32 copyCompactVertexOffset = 0;
+  uint32 copyIndexOffset16       = 0;
+  uint32 copyIndexOffset32       = 0;
+
+  for (const IMesh* mesh : meshes) {
+    if (mesh->GetVertexFormat() == VertexFormat::COMPACT) {
+      VertexCompressor::Encode(mesh->GetVertices().data(), mesh->GetVertexCount(), geometry.Quantization, &geometry.CompactVertices[copyCompactVertexOffset]);
+      copyCompactVertexOffset += mesh->GetVertexCount();
+    } else {
+      const uint32 copySize = mesh->GetVertexByteSize();
+      Byte* copyTarget      = reinterpret_cast<Byte*>(geometry.Vertices.data());
+      memcpy_s(copyTarget + copyVertexOffset, copySize, mesh->GetVertexByteData(), copySize);
+      copyVertexOffset += mesh->GetVertexByteSize();
+    }
 
     if (mesh->GetIndexFormat() == DXGI_FORMAT_R16_UINT) {
       const uint32 copySize = mesh->GetIndexByteSize();
-      Byte* copyTarget      = reinterpret_cast<Byte*>(totalIndices16.data());
+      Byte* copyTarget      = reinterpret_cast<Byte*>(geometry.Indices16.data());
       memcpy_s(copyTarget + copyIndexOffset16, copySize, mesh->GetIndexByteData(), copySize);
       copyIndexOffset16 += mesh->GetIndexByteSize();
     } else {
       const uint32 copySize = mesh->GetIndexByteSize();
-      Byte* copyTarget      = reinterpret_cast<Byte*>(totalIndices32.data());
+      Byte* copyTarget      = reinterpret_cast<Byte*>(geometry.Indices32.data());
       memcpy_s(copyTarget + copyIndexOffset32, copySize, mesh->GetIndexByteData(), copySize);
       copyIndexOffset32 += mesh->GetIndexByteSize();
     }
   }
 
-  const uint32 vbByteSize   = static_cast<uint32>(totalVertices.size() * sizeof(Vertex));
-  const uint32 ibByteSize16 = static_cast<uint32>(totalIndices16.size() * sizeof(uint16));
-  const uint32 ibByteSize32 = static_cast<uint32>(totalIndices32.size() * sizeof(uint32));
+  geometry.Meshlets.resize(meshes.size());
+  ThreadPool::Get().ParallelFor(static_cast<uint32>(meshes.size()), [&](uint32 i) { meshes[i]->BuildMeshlets(geometry.Meshlets[i]); });
+}
+
+RenderItem RenderItem::MakeInstance() const
+{
+  RenderItem instance(*this);
+  instance.mTransform = Transform();
+  return instance;
+}
 
-  if (ibByteSize16 != 0) {
-    mIndexBufferGPU16 = D3DUtil::CreateDefaultBuffer(device, cmdList, totalIndices16.data(), ibByteSize16, mIndexBufferUploader16);
+void RenderItem::BuildMeshUploadResource(const PackedGeometry& geometry, GeometryHeaps& heaps, ID3D12Device* device,
+                                         ID3D12GraphicsCommandList* cmdList)
+{
+  AllocateGeometry(heaps, device);
+  heaps.Indices.Upload(device, cmdList, mIndexRange16, geometry.Indices16.data(), mTotalIndexCount16);
+  heaps.Indices.Upload(device, cmdList, mIndexRange32, geometry.Indices32.data(), mTotalIndexCount32 * 2);
+  heaps.Vertices.Upload(device, cmdList, mVertexRange, geometry.Vertices.data(), mTotalVertexCount);
+  heaps.CompactVertices.Upload(device, cmdList, mCompactVertexRange, geometry.CompactVertices.data(), mTotalCompactVertexCount);
+}
+
+void RenderItem::AllocateGeometry(GeometryHeaps& heaps, ID3D12Device* device)
+{
+  if (mTotalVertexCount != 0) {
+    mVertexRange     = heaps.Vertices.Allocate(device, mTotalVertexCount);
+    mVertexBufferGPU = heaps.Vertices.GetBuffer(mVertexRange.Page);
+  }
+  if (mTotalCompactVertexCount != 0) {
+    mCompactVertexRange     = heaps.CompactVertices.Allocate(device, mTotalCompactVertexCount);
+    mCompactVertexBufferGPU = heaps.CompactVertices.GetBuffer(mCompactVertexRange.Page);
+  }
+  if (mTotalIndexCount16 != 0) {
+    mIndexRange16     = heaps.Indices.Allocate(device, mTotalIndexCount16);
+    mIndexBufferGPU16 = heaps.Indices.GetBuffer(mIndexRange16.Page);
   }
-  if (ibByteSize32 != 0) {
-    mIndexBufferGPU32 = D3DUtil::CreateDefaultBuffer(device, cmdList, totalIndices32.data(), ibByteSize32, mIndexBufferUploader32);
+  if (mTotalIndexCount32 != 0) {
+    // Even elements, so the range starts at a whole 32 bit index.
+    mIndexRange32     = heaps.Indices.Allocate(device, mTotalIndexCount32 * 2, 2);
+    mIndexBufferGPU32 = heaps.Indices.GetBuffer(mIndexRange32.Page);
   }
-  mVertexBufferGPU = D3DUtil::CreateDefaultBuffer(device, cmdList, totalVertices.data(), vbByteSize, mVertexBufferUploader);
+
+  for (DrawArg& arg : mDrawArgs) {
+    arg.BaseVertexLocation += arg.Format == VertexFormat::COMPACT ? mCompactVertexRange.GetOffset() : mVertexRange.GetOffset();
+
+    const uint32 indexOffset = arg.IndexFormat == DXGI_FORMAT_R16_UINT ? mIndexRange16.GetOffset() : mIndexRange32.GetOffset() / 2;
+    arg.StartIndexLocation += indexOffset;
+    for (uint32 lod = 0; lod < arg.LodCount; lod++) arg.Lods[lod].StartIndexLocation += indexOffset;
+  }
+}
+
+void RenderItem::ReleaseGeometry(GeometryHeaps& heaps)
+{
+  heaps.Vertices.Free(mVertexRange);
+  heaps.CompactVertices.Free(mCompactVertexRange);
+  heaps.Indices.Free(mIndexRange16);
+  heaps.Indices.Free(mIndexRange32);
+  mVertexRange        = GeometryRange();
+  mCompactVertexRange = GeometryRange();
+  mIndexRange16       = GeometryRange();
+  mIndexRange32       = GeometryRange();
 }
 
-void RenderData::AddRenderItem(const CheString& name, Model* model)
+void RenderItem::SelectLods(const LodSelector& selector)
+{
+  const XMMATRIX world = GetTransMatrix();
+  const XMFLOAT3 scale = mTransform.GetScale();
+  const float maxScale = std::max<float>(fabsf(scale.x), std::max<float>(fabsf(scale.y), fabsf(scale.z)));
+
+  for (DrawArg& arg : mDrawArgs) {
+    if (arg.LodCount <= 1) continue;
+
+    XMFLOAT3 worldCenter;
+    XMStoreFloat3(&worldCenter, XMVector3TransformCoord(XMLoadFloat3(&arg.BoundsCenter), world));
+    arg.CurrentLod = selector.Select(arg, worldCenter, arg.BoundsRadius * maxScale, maxScale);
+  }
+}
+
+RenderItemHandle RenderData::AddRenderItem(const CheString& name, Model* model)
 {
   // Deal with the render item of the same name.
-  if (mRenderItems.find(name) == mRenderItems.end()) {
-    mRenderItems[name] = RenderItem(model, mDevice.Get(), mCmdList.Get());
-    for (auto shader : mShaders) {
-      mRenderItems[name].BuildPerObjectCBuffer(mDevice.Get(), shader->GetName(), shader->GetSettings().GetCBSetting());
+  RenderItemHandle handle = FindItem(name);
+  if (handle.IsValid()) return handle;
+
+  return InsertItem(name, RenderItem(model, mGeometryHeaps, mDevice.Get(), mCmdList.Get()));
+}
+
+RenderItemHandle RenderData::AddRenderItem(const CheString& name, const CookedModel& model)
+{
+  if (model.GetHeader().VertexStride != sizeof(Vertex)) {
+    logger.Error(CTEXT("Cooked model vertex layout does not match, recook it: ") + name);
+    return RenderItemHandle();
+  }
+
+  RenderItemHandle handle = FindItem(name);
+  if (handle.IsValid()) return handle;
+
+  return InsertItem(name, RenderItem(model, mGeometryHeaps, mDevice.Get(), mCmdList.Get()));
+}
+
+RenderItemHandle RenderData::AddRenderItem(const CheString& name, StreamedModel& model, D3D12UploadSink& sink)
+{
+  RenderItemHandle handle = FindItem(name);
+  if (handle.IsValid()) return handle;
+
+  // The meshes were decoded without textures, bind the streamed ones now.
+  const std::vector<IMesh*>& meshes = model.CpuModel.GetMeshes();
+  for (uint32 i = 0; i < meshes.size(); i++) {
+    Material material;
+    for (const auto& pair : model.MeshImages[i]) {
+      const uint32 texture = model.Textures[pair.second];
+      if (texture == INVALID_UPLOAD_RESOURCE) continue;
+      material.Textures[pair.first].Dimension = D3D12_SRV_DIMENSION_TEXTURE2D;
+      material.Textures[pair.first].Resource  = sink.GetResource(texture);
+    }
+    meshes[i]->SetMaterial(material);
+  }
+
+  GeometryBuffers buffers;
+  buffers.VertexBuffer        = sink.GetResource(model.VertexBuffer);
+  buffers.CompactVertexBuffer = sink.GetResource(model.CompactVertexBuffer);
+  buffers.IndexBuffer16       = sink.GetResource(model.IndexBuffer16);
+  buffers.IndexBuffer32       = sink.GetResource(model.IndexBuffer32);
+
+  // The render item and materials hold their own references now, give the sink slots back.
+  for (uint32* resource : {&model.VertexBuffer, &model.CompactVertexBuffer, &model.IndexBuffer16, &model.IndexBuffer32}) {
+    sink.Release(*resource);
+    *resource = INVALID_UPLOAD_RESOURCE;
+  }
+  for (uint32& texture : model.Textures) {
+    sink.Release(texture);
+    texture = INVALID_UPLOAD_RESOURCE;
+  }
+
+  return InsertItem(name, RenderItem(&model.CpuModel, std::move(model.Geometry), buffers, mGeometryHeaps, mDevice.Get()));
+}
+
+RenderItemHandle RenderData::AddInstance(const CheString& name, RenderItemHandle source)
+{
+  if (!IsValid(source)) return RenderItemHandle();
+
+  RenderItemHandle handle = FindItem(name);
+  if (handle.IsValid()) return handle;
+
+  const uint32 materialIndex = GetMaterialIndex(source);
+  handle                     = InsertItem(name, GetItem(source).MakeInstance());
+  SetMaterialIndex(handle, materialIndex);
+  return handle;
+}
+
+RenderItemHandle RenderData::InsertItem(const CheString& name, RenderItem&& item)
+{
+  if (item.GetGeometryId() == RenderItem::INVALID_GEOMETRY_ID) {
+    item.SetGeometryId(mNextGeometryId++);
+    mGeometrySrvSlots.resize(mNextGeometryId);
+    mGeometryRefCounts.resize(mNextGeometryId, 0);
+    CreateItemViews(item);
+  }
+  mGeometryRefCounts[item.GetGeometryId()]++;
+
+  // The item only keeps the PEROBJECT cbuffers of each shader.
+  for (auto shader : mShaders) {
+    CBufferManager cbManager;
+    for (const auto& pair : shader->GetSettings().GetCBSetting()) {
+      if (CBufferManager::CBufferConfig[pair.first] == CBufferType::PEROBJECT) cbManager.AddCBuffer(pair.first, pair.second);
     }
+    mObjectCBuffers.push_back(std::move(cbManager));
   }
+
+  // Until the first UpdateInstanceData both worlds are the transform the item was added with.
+  InstanceData instance = {};
+  XMStoreFloat4x4(&instance.World, XMMatrixTranspose(item.GetTransMatrix()));
+  instance.PrevWorld = instance.World;
+
+  RenderItemHandle handle;
+  if (!mFreeSlots.empty()) {
+    handle.Slot = mFreeSlots.back();
+    mFreeSlots.pop_back();
+  } else {
+    handle.Slot = static_cast<uint32>(mSlots.size());
+    mSlots.push_back(ItemSlot());
+  }
+  handle.Generation = mSlots[handle.Slot].Generation;
+
+  mSlots[handle.Slot].DenseIndex = static_cast<uint32>(mItems.size());
+  mItems.push_back(std::move(item));
+  mItemNames.push_back(name);
+  mItemSlots.push_back(handle.Slot);
+  mInstances.push_back(instance);
+  mHasInstanceData.push_back(0);
+  mItemLookup[name] = handle;
+  return handle;
 }
 
-uint32 RenderData::GetTotalDescriptorCount()
+void RenderData::RemoveRenderItem(RenderItemHandle handle)
 {
-  uint32 totalCount = 0;
-  for (auto pair : mRenderItems) {
-    auto itemName    = pair.first;
-    auto& renderItem = mRenderItems[itemName];
-    totalCount += renderItem.GetSrvDescriptorCount();
+  if (!IsValid(handle)) return;
+
+  // Move the last item into the hole, its handle stays valid through the slot table.
+  const uint32 index = mSlots[handle.Slot].DenseIndex;
+  const uint32 last  = static_cast<uint32>(mItems.size() - 1);
+
+  // Instances share the geometry ranges, the last item of the geometry returns them.
+  if (--mGeometryRefCounts[mItems[index].GetGeometryId()] == 0) {
+    mItems[index].ReleaseGeometry(mGeometryHeaps);
+    ReleaseItemViews(mItems[index]);
+  }
+
+  mItemLookup.erase(mItemNames[index]);
+  const size_t shaderCount = mShaders.size();
+  if (index != last) {
+    mItems[index]                        = std::move(mItems[last]);
+    mItemNames[index]                    = std::move(mItemNames[last]);
+    mItemSlots[index]                    = mItemSlots[last];
+    mInstances[index]                    = mInstances[last];
+    mHasInstanceData[index]              = mHasInstanceData[last];
+    mSlots[mItemSlots[index]].DenseIndex = index;
+    std::move(mObjectCBuffers.begin() + last * shaderCount, mObjectCBuffers.end(), mObjectCBuffers.begin() + index * shaderCount);
   }
-  return totalCount;
+  mItems.pop_back();
+  mItemNames.pop_back();
+  mItemSlots.pop_back();
+  mInstances.pop_back();
+  mHasInstanceData.pop_back();
+  mObjectCBuffers.resize(mObjectCBuffers.size() - shaderCount);
+
+  // A new generation makes old copies of the handle invalid.
+  mSlots[handle.Slot].DenseIndex = INVALID_INDEX;
+  mSlots[handle.Slot].Generation++;
+  mFreeSlots.push_back(handle.Slot);
+
+  // The draws are item major, the ones of the moved item change their indices.
+  BuildBindings();
+  UpdateDrawBounds();
+}
+
+void RenderData::RecordGeometryCopies()
+{
+  mGeometryHeaps.Vertices.RecordCopies(mCmdList.Get());
+  mGeometryHeaps.CompactVertices.RecordCopies(mCmdList.Get());
+  mGeometryHeaps.Indices.RecordCopies(mCmdList.Get());
+}
+
+void RenderData::ReleaseUploadBuffers()
+{
+  mGeometryHeaps.Vertices.ReleaseUploadBuffers();
+  mGeometryHeaps.CompactVertices.ReleaseUploadBuffers();
+  mGeometryHeaps.Indices.ReleaseUploadBuffers();
 }
 
-RenderData::RenderData(ComPtr<ID3D12Device> device, ComPtr<ID3D12GraphicsCommandList> cmdList) : mDevice(device), mCmdList(cmdList)
+RenderItemHandle RenderData::FindItem(const CheString& itemName) const
 {
-  mSrvDescriptorSize = mDevice->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
+  auto iter = mItemLookup.find(itemName);
+  return iter != mItemLookup.end() ? iter->second : RenderItemHandle();
+}
+
+uint32 RenderData::GetShaderIndex(const Shader* shader) const
+{
+  for (uint32 i = 0; i < mShaders.size(); ++i) {
+    if (mShaders[i] == shader) return i;
+  }
+  return INVALID_INDEX;
+}
+
+uint32 RenderData::AddMaterial(const MaterialDesc& material)
+{
+  mMaterials.push_back(material);
+  return static_cast<uint32>(mMaterials.size() - 1);
+}
+
+RenderData::RenderData(ComPtr<ID3D12Device> device, ComPtr<ID3D12GraphicsCommandList> cmdList, uint64 geometryPageSize, DescriptorHeap* descriptorHeap)
+    : mDevice(device), mCmdList(cmdList), mGeometryHeaps(geometryPageSize), mMaterialTable(MATERIAL_TEXTURE_COUNT), mDescriptorHeap(descriptorHeap)
+{
+  if (mDescriptorHeap == nullptr) {
+    mOwnedDescriptorHeap = std::make_unique<DescriptorHeap>(mDevice.Get());
+    mDescriptorHeap      = mOwnedDescriptorHeap.get();
+  }
+  mReservedSrvSlots  = mDescriptorHeap->Allocate(2);
+  mNullSrvIndex      = mReservedSrvSlots.Offset;
+  mShadowMapSrvIndex = mReservedSrvSlots.Offset + 1;
   BuildNullSrvResource();
 }
 
+RenderData::~RenderData()
+{
+  // A shared heap outlives the RenderData, its slots go back.
+  for (const TlsfAllocation& slots : mGeometrySrvSlots) mDescriptorHeap->Free(slots);
+  mDescriptorHeap->Free(mReservedSrvSlots);
+}
+
+void RenderData::CreateItemViews(RenderItem& item)
+{
+  TlsfAllocation& slots = mGeometrySrvSlots[item.GetGeometryId()];
+  if (item.GetSrvDescriptorCount() != 0) {
+    slots = mDescriptorHeap->Allocate(item.GetSrvDescriptorCount());
+    if (!slots.IsValid()) logger.Error(CTEXT("Descriptor heap is full, the textures of the item are not bound."));
+  }
+  item.SetSrvDescriptorOffset(slots.Offset);
+
+  uint32 textures[MATERIAL_TEXTURE_COUNT];
+  for (uint32 argIndex = 0; argIndex < item.GetDrawArgs().size(); ++argIndex) {
+    for (uint32 i = 0; i < MATERIAL_TEXTURE_COUNT; ++i) {
+      const DrawMaterial* drawSrv = item.FindDrawSrv(argIndex, MATERIAL_TEXTURE_NAMES[i]);
+      textures[i]                 = slots.IsValid() && drawSrv != nullptr ? slots.Offset + drawSrv->SrvIndex : mNullSrvIndex;
+    }
+    item.SetDrawMaterialId(argIndex, mMaterialTable.Acquire(textures));
+  }
+
+  if (!slots.IsValid()) return;
+  for (const DrawMaterial& drawSrv : item.GetDrawSrvs()) {
+    D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
+    srvDesc.Shader4ComponentMapping         = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
+    srvDesc.Format                          = drawSrv.Resource->GetDesc().Format;
+    srvDesc.ViewDimension                   = drawSrv.Dimension;
+    srvDesc.Texture2D.MostDetailedMip       = 0;
+    srvDesc.Texture2D.MipLevels             = drawSrv.Resource->GetDesc().MipLevels;
+    srvDesc.Texture2D.ResourceMinLODClamp   = 0.0f;
+    mDevice->CreateShaderResourceView(drawSrv.Resource.Get(), &srvDesc, mDescriptorHeap->GetCpuHandle(slots.Offset + drawSrv.SrvIndex));
+  }
+}
+
+void RenderData::ReleaseItemViews(RenderItem& item)
+{
+  for (const DrawArg& arg : item.GetDrawArgs()) mMaterialTable.Release(arg.MaterialId);
+
+  TlsfAllocation& slots = mGeometrySrvSlots[item.GetGeometryId()];
+  mDescriptorHeap->Free(slots);
+  slots = TlsfAllocation();
+}
+
 void RenderData::BuildNullSrvResource()
 {
   D3D12_RESOURCE_DESC texDesc;
@@ -186,18 +615,6 @@ void RenderData::BuildNullSrvResource()
 
   TIFF(mDevice->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &texDesc,
                                         D3D12_RESOURCE_STATE_COMMON, nullptr, IID_PPV_ARGS(&mNullResource)));
-}
-
-void RenderData::BuildRenderData()
-{
-  mSrvDescriptorCount = GetTotalDescriptorCount();
-
-  D3D12_DESCRIPTOR_HEAP_DESC srvHeapDesc = {};
-  uint32 srvDescriptorCount              = mSrvDescriptorCount + mDescriptorOffset;
-  srvHeapDesc.NumDescriptors             = srvDescriptorCount;
-  srvHeapDesc.Type                       = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV;
-  srvHeapDesc.Flags                      = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE;
-  TIFF(mDevice->CreateDescriptorHeap(&srvHeapDesc, IID_PPV_ARGS(&mSrvDescriptorHeap)));
 
   D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
   srvDesc.Shader4ComponentMapping         = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
@@ -206,35 +623,215 @@ void RenderData::BuildRenderData()
   srvDesc.Texture2D.MostDetailedMip       = 0;
   srvDesc.Texture2D.MipLevels             = mNullResource->GetDesc().MipLevels;
   srvDesc.Texture2D.ResourceMinLODClamp   = 0.0f;
+  mDevice->CreateShaderResourceView(mNullResource.Get(), &srvDesc, mDescriptorHeap->GetCpuHandle(mNullSrvIndex));
+}
 
-  CD3DX12_CPU_DESCRIPTOR_HANDLE nullSrvHandle(mSrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), mNullSrvIndex, mSrvDescriptorSize);
-  mDevice->CreateShaderResourceView(mNullResource.Get(), &srvDesc, nullSrvHandle);
-
-  uint32 renderItemSrvOffset = mDescriptorOffset;
-  for (auto pair : mRenderItems) {
-    auto itemName    = pair.first;
-    auto& renderItem = mRenderItems[itemName];
-
-    renderItem.SetSrvDescriptorOffset(renderItemSrvOffset);
-    renderItemSrvOffset += renderItem.GetSrvDescriptorCount();
-
-    for (const DrawArg& arg : renderItem.GetDrawArgs()) {
-      for (auto pair : arg.DrawSrvs) {
-        auto drawSrv = pair.second;
-
-        uint32 srvDescriptorIndex = renderItemSrvOffset - renderItem.GetSrvDescriptorCount() + drawSrv.SrvIndex;
-        CD3DX12_CPU_DESCRIPTOR_HANDLE srvDescriptor(mSrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart(), srvDescriptorIndex,
-                                                    mSrvDescriptorSize);
-
-        D3D12_SHADER_RESOURCE_VIEW_DESC srvDesc = {};
-        srvDesc.Shader4ComponentMapping         = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING;
-        srvDesc.Format                          = drawSrv.Resource->GetDesc().Format;
-        srvDesc.ViewDimension                   = drawSrv.Dimension;
-        srvDesc.Texture2D.MostDetailedMip       = 0;
-        srvDesc.Texture2D.MipLevels             = drawSrv.Resource->GetDesc().MipLevels;
-        srvDesc.Texture2D.ResourceMinLODClamp   = 0.0f;
-        mDevice->CreateShaderResourceView(drawSrv.Resource.Get(), &srvDesc, srvDescriptor);
+void RenderData::BuildRenderData()
+{
+  BuildMaterialBuffer();
+  BuildMaterialTextureBuffer();
+  BuildBindings();
+}
+
+void RenderData::BuildMaterialBuffer()
+{
+  // gMaterials is never empty, items without a material read a zeroed one.
+  const uint32 materialCount = std::max<uint32>(static_cast<uint32>(mMaterials.size()), 1);
+  const uint64 byteSize      = materialCount * sizeof(MaterialDesc);
+
+  TIFF(mDevice->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(byteSize),
+                                        D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(mMaterialBuffer.ReleaseAndGetAddressOf())));
+
+  Byte* mapped = nullptr;
+  TIFF(mMaterialBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mapped)));
+  memset(mapped, 0, byteSize);
+  if (!mMaterials.empty()) memcpy(mapped, mMaterials.data(), mMaterials.size() * sizeof(MaterialDesc));
+  mMaterialBuffer->Unmap(0, nullptr);
+}
+
+void RenderData::BuildMaterialTextureBuffer()
+{
+  // Like gMaterials, gMaterialTextures always holds a row.
+  const std::vector<uint32>& rows = mMaterialTable.GetData();
+  const uint64 byteSize           = std::max<uint64>(rows.size(), MATERIAL_TEXTURE_COUNT) * sizeof(uint32);
+
+  TIFF(mDevice->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE, &CD3DX12_RESOURCE_DESC::Buffer(byteSize),
+                                        D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(mMaterialTextureBuffer.ReleaseAndGetAddressOf())));
+
+  Byte* mapped = nullptr;
+  TIFF(mMaterialTextureBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mapped)));
+  memset(mapped, 0, byteSize);
+  if (!rows.empty()) memcpy(mapped, rows.data(), rows.size() * sizeof(uint32));
+  mMaterialTextureBuffer->Unmap(0, nullptr);
+}
+
+void RenderData::BuildBindings()
+{
+  mShaderBindings.resize(mShaders.size());
+  for (uint32 shaderIndex = 0; shaderIndex < mShaders.size(); ++shaderIndex) {
+    Shader* shader                 = mShaders[shaderIndex];
+    const ShaderSettings& settings = shader->GetSettings();
+    ShaderBinding& binding         = mShaderBindings[shaderIndex];
+    binding.BoundShader            = shader;
+
+    binding.PassCbvs.clear();
+    for (const auto& pair : shader->GetCBufferManager().GetCBuffers()) {
+      binding.PassCbvs.push_back({pair.second.GetCBufferInfo().GetSlot(), 0, pair.second.GetData(), pair.second.GetCBufferInfo().GetByteSize()});
+    }
+
+    // Root indices of cbuffers are their slots.
+    binding.DrawConstantsRootIndex = INVALID_INDEX;
+    binding.ObjectCbvRootIndex     = INVALID_INDEX;
+    binding.ViewCbvRootIndex       = INVALID_INDEX;
+    uint32 objectCbvCount          = 0;
+    for (const auto& pair : settings.GetCBSetting()) {
+      auto config = CBufferManager::CBufferConfig.find(pair.first);
+      if (config != CBufferManager::CBufferConfig.end() && config->second == CBufferType::DRAW) {
+        binding.DrawConstantsRootIndex = pair.second.GetSlot();
+      } else if (config != CBufferManager::CBufferConfig.end() && config->second == CBufferType::VIEW) {
+        binding.ViewCbvRootIndex = pair.second.GetSlot();
+      } else if (config == CBufferManager::CBufferConfig.end() || config->second == CBufferType::PEROBJECT) {
+        binding.ObjectCbvRootIndex = pair.second.GetSlot();
+        objectCbvCount++;
       }
     }
+    if (objectCbvCount != 1) binding.ObjectCbvRootIndex = INVALID_INDEX;
+
+    // Texture tables and structured buffers follow the cbuffer root parameters.
+    binding.SrvParams.clear();
+    binding.InstanceRootIndex        = INVALID_INDEX;
+    binding.MaterialRootIndex        = INVALID_INDEX;
+    binding.MaterialTextureRootIndex = INVALID_INDEX;
+    binding.TextureTableRootIndex    = INVALID_INDEX;
+    for (const auto& pair : settings.GetSRVSetting()) {
+      const uint32 rootIndex = pair.second.GetSlot() + settings.GetCBSettingCount();
+      if (pair.first == CTEXT("gInstances")) {
+        binding.InstanceRootIndex = rootIndex;
+      } else if (pair.first == CTEXT("gMaterials")) {
+        binding.MaterialRootIndex = rootIndex;
+      } else if (pair.first == CTEXT("gMaterialTextures")) {
+        binding.MaterialTextureRootIndex = rootIndex;
+      } else if (pair.first == CTEXT("gTextures")) {
+        binding.TextureTableRootIndex = rootIndex;
+      } else {
+        binding.SrvParams.push_back({pair.first, rootIndex});
+      }
+    }
+  }
+
+  mItemFirstDraws.clear();
+  mDrawRefs.clear();
+  mDrawMaterialIds.clear();
+  for (uint32 itemIndex = 0; itemIndex < mItems.size(); ++itemIndex) {
+    mItemFirstDraws.push_back(static_cast<uint32>(mDrawRefs.size()));
+    for (uint32 argIndex = 0; argIndex < mItems[itemIndex].GetDrawArgs().size(); ++argIndex) {
+      mDrawRefs.push_back({itemIndex, argIndex});
+      mDrawMaterialIds.push_back(mItems[itemIndex].GetDrawArgs()[argIndex].MaterialId);
+    }
   }
+
+  mItemBindings.resize(mItems.size() * mShaders.size());
+  mObjectCbvs.clear();
+  for (uint32 i = 0; i < mItemBindings.size(); ++i) {
+    mItemBindings[i].FirstObjectCbv = static_cast<uint32>(mObjectCbvs.size());
+    for (const auto& pair : mObjectCBuffers[i].GetCBuffers()) {
+      mObjectCbvs.push_back({pair.second.GetCBufferInfo().GetSlot(), 0, pair.second.GetData(), pair.second.GetCBufferInfo().GetByteSize()});
+    }
+    mItemBindings[i].ObjectCbvCount = static_cast<uint32>(mObjectCbvs.size()) - mItemBindings[i].FirstObjectCbv;
+  }
+
+  // SRV set: material id.
+  std::map<std::vector<uint32>, uint32> materials;
+  std::vector<uint32> srvSet;
+
+  for (ShaderBinding& binding : mShaderBindings) {
+    materials.clear();
+    binding.DrawSrvIndices.clear();
+    binding.DrawSrvIndices.reserve(mDrawRefs.size() * binding.SrvParams.size());
+    binding.DrawMaterialIds.clear();
+    binding.DrawMaterialIds.reserve(mDrawRefs.size());
+    for (const DrawRef& ref : mDrawRefs) {
+      const RenderItem& item = mItems[ref.ItemIndex];
+      srvSet.clear();
+      for (const SrvParam& param : binding.SrvParams) {
+        // Default bind null srv.
+        uint32 srvIndex = mNullSrvIndex;
+        if (param.Name == CTEXT("gShadowMap")) {
+          srvIndex = mShadowMapSrvIndex;
+        } else if (mGeometrySrvSlots[item.GetGeometryId()].IsValid()) {
+          const DrawMaterial* drawSrv = item.FindDrawSrv(ref.ArgIndex, param.Name);
+          if (drawSrv != nullptr) srvIndex = item.GetSrvDescriptorOffset() + drawSrv->SrvIndex;
+        }
+        srvSet.push_back(srvIndex);
+      }
+      binding.DrawSrvIndices.insert(binding.DrawSrvIndices.end(), srvSet.begin(), srvSet.end());
+
+      auto material = materials.emplace(srvSet, static_cast<uint32>(materials.size()));
+      binding.DrawMaterialIds.push_back(material.first->second);
+    }
+  }
+}
+
+void RenderData::UpdateDrawBounds()
+{
+  mDrawBounds.Clear();
+  mDrawBounds.Reserve(GetDrawCount());
+
+  for (uint32 itemIndex = 0; itemIndex < mItems.size(); ++itemIndex) {
+    XMFLOAT4X4 world;
+    XMStoreFloat4x4(&world, GetItemWorld(itemIndex));
+    const Float4x4 objectToWorld = ToFloat4x4(world);
+    for (const DrawArg& arg : mItems[itemIndex].GetDrawArgs()) mDrawBounds.AddTransformed(ToFloat3(arg.BoundsMin), ToFloat3(arg.BoundsMax), objectToWorld);
+  }
+}
+
+void RenderData::UpdateInstanceData()
+{
+  for (uint32 i = 0; i < mItems.size(); ++i) {
+    XMFLOAT4X4 world;
+    XMStoreFloat4x4(&world, XMMatrixTranspose(mItems[i].GetTransMatrix()));
+    mInstances[i].PrevWorld = mHasInstanceData[i] ? mInstances[i].World : world;
+    mInstances[i].World     = world;
+    mHasInstanceData[i]     = 1;
+  }
+}
+
+void RenderData::ReserveInstances(uint32 instanceCount)
+{
+  if (instanceCount <= mInstanceCapacity) return;
+
+  if (mInstanceBuffer != nullptr) mInstanceBuffer->Unmap(0, nullptr);
+  TIFF(mDevice->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE,
+                                        &CD3DX12_RESOURCE_DESC::Buffer(instanceCount * sizeof(InstanceData)), D3D12_RESOURCE_STATE_GENERIC_READ,
+                                        nullptr, IID_PPV_ARGS(mInstanceBuffer.ReleaseAndGetAddressOf())));
+  // Upload heaps stay mapped for their whole life.
+  TIFF(mInstanceBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mMappedInstances)));
+  mInstanceCapacity = instanceCount;
+  mInstanceCount    = 0;
+}
+
+void RenderData::UploadConstants(UploadRing& ring)
+{
+  auto upload = [&](RootCbv& cbv) {
+    const UploadAllocation allocation = ring.Allocate(mDevice.Get(), cbv.ByteSize);
+    memcpy(allocation.CpuAddress, cbv.Data, cbv.ByteSize);
+    cbv.Address = allocation.GpuAddress;
+  };
+  for (ShaderBinding& binding : mShaderBindings) {
+    for (RootCbv& cbv : binding.PassCbvs) upload(cbv);
+  }
+  for (RootCbv& cbv : mObjectCbvs) upload(cbv);
+}
+
+D3D12_GPU_VIRTUAL_ADDRESS RenderData::WriteInstances(const std::vector<uint32>& itemIndices)
+{
+  const uint32 count = static_cast<uint32>(itemIndices.size());
+  if (count == 0 || mInstanceCount + count > mInstanceCapacity) return 0;
+
+  InstanceData* target = mMappedInstances + mInstanceCount;
+  for (uint32 i = 0; i < count; ++i) target[i] = mInstances[itemIndices[i]];
+
+  const D3D12_GPU_VIRTUAL_ADDRESS address = mInstanceBuffer->GetGPUVirtualAddress() + mInstanceCount * sizeof(InstanceData);
+  mInstanceCount += count;
+  return address;
 }
\ No newline at end of file
@@ -1,48 +1,215 @@
 #ifndef GRAPHICS_RENDER_DATA_H
 #define GRAPHICS_RENDER_DATA_H
 #include "Common/TypeDef.h"
+#include <memory>
 #include <unordered_map>
 #include <vector>
 #include <d3d12.h>
 #include "Graphics/D3DUtil.h"
+#include "Graphics/DescriptorHeap.h"
+#include "Graphics/FrustumCuller.h"
+#include "Graphics/GeometryHeap.h"
+#include "Graphics/MaterialTable.h"
+#include "Graphics/UploadRing.h"
+#include "Model/CookedModel.h"
 #include "Model/Model.h"
 #include "Shader/ConstantBuffer.h"
+#include "Shader/ShaderResource.h"
+
+class D3D12UploadSink;
+class LodSelector;
+struct StreamedModel;
 
 struct DrawMaterial {
+  // Shader variable the texture binds to, e.g. gAlbedoMap.
+  CheString Name;
   uint32 SrvIndex;
   D3D12_SRV_DIMENSION Dimension;
   ComPtr<ID3D12Resource> Resource;
 };
 
+struct DrawLod {
+  uint32 IndexCount;
+  uint32 StartIndexLocation;
+  // Geometric error in object space units.
+  float Error;
+};
+
 struct DrawArg {
   uint32 IndexCount;
   uint32 StartIndexLocation;
   DXGI_FORMAT IndexFormat;
 
+  // Picks the vertex buffer and pipeline, BaseVertexLocation is relative to the buffer of this format.
+  // Items in GeometryHeaps bind whole heap pages, the locations then include the offsets of their ranges.
+  VertexFormat Format;
   uint32 BaseVertexLocation;
 
   bool IsBlend;
 
-  std::unordered_map<CheString, DrawMaterial> DrawSrvs;
+  // Object space bounding sphere and box.
+  DirectX::XMFLOAT3 BoundsCenter;
+  float BoundsRadius;
+  DirectX::XMFLOAT3 BoundsMin;
+  DirectX::XMFLOAT3 BoundsMax;
+
+  // Lods[0] is the IndexCount/StartIndexLocation range.
+  uint32 LodCount;
+  DrawLod Lods[IMesh::MAX_LODS];
+  // Level to draw, updated by RenderItem::SelectLods.
+  uint32 CurrentLod;
+
+  // Range of the textures of the draw in RenderItem::GetDrawSrvs.
+  uint32 FirstSrv;
+  uint32 SrvCount;
+  // Row of the textures in the material table of the RenderData, set when the item is added.
+  // Instances share it, the draw loop reads the copy in RenderData::GetDrawMaterialId.
+  uint32 MaterialId;
+};
+
+// Root constant buffer view, resolved once so the draw loop needs no cbuffer lookups.
+// Address is the copy of Data made by RenderData::UploadConstants for the current frame.
+struct RootCbv {
+  uint32 Slot;
+  D3D12_GPU_VIRTUAL_ADDRESS Address;
+  const Byte* Data;
+  uint32 ByteSize;
+};
+
+// Texture root parameter of a shader.
+struct SrvParam {
+  CheString Name;
+  uint32 RootIndex;
+};
+
+// Per shader bindings shared by all items.
+struct ShaderBinding {
+  const Shader* BoundShader;
+  std::vector<RootCbv> PassCbvs;
+  std::vector<SrvParam> SrvParams;
+  // Root SRVs of the gInstances and gMaterials structured buffers, INVALID_INDEX when the shader has none.
+  uint32 InstanceRootIndex;
+  uint32 MaterialRootIndex;
+  // Root SRV of gMaterialTextures and the descriptor table of the unbounded gTextures array of bindless shaders,
+  // INVALID_INDEX when the shader has none.
+  uint32 MaterialTextureRootIndex;
+  uint32 TextureTableRootIndex;
+  // Root constants of cbDraw, INVALID_INDEX when the shader has none.
+  uint32 DrawConstantsRootIndex;
+  // Root CBV of the only PEROBJECT cbuffer, INVALID_INDEX when the shader has none or several.
+  uint32 ObjectCbvRootIndex;
+  // Root CBV of cbView, bound per pass to the view it renders. INVALID_INDEX when the shader has none.
+  uint32 ViewCbvRootIndex;
+
+  // Heap index for every draw of the RenderData and SrvParam, draw major. Missing textures point at the null SRV.
+  std::vector<uint32> DrawSrvIndices;
+  // Per draw, equal ids have equal SrvIndices, so the draw loop can skip rebinding them.
+  std::vector<uint32> DrawMaterialIds;
+};
+
+// Per object CBVs of one item for one shader, a range of RenderData::GetObjectCbv.
+struct ItemShaderBinding {
+  uint32 FirstObjectCbv;
+  uint32 ObjectCbvCount;
+};
+
+// Stable reference to an item of a RenderData, stays valid while other items are added or removed.
+struct RenderItemHandle {
+  static const uint32 INVALID_SLOT = 0xFFFFFFFF;
+
+  uint32 Slot       = INVALID_SLOT;
+  uint32 Generation = 0;
+
+  inline bool IsValid() const { return Slot != INVALID_SLOT; }
+};
+
+// A draw arg of a RenderData item, draws are numbered item major.
+struct DrawRef {
+  uint32 ItemIndex;
+  uint32 ArgIndex;
+};
+
+// Vertex and index data of a model in the layout of the RenderItem buffers, built on the CPU.
+struct PackedGeometry {
+  std::vector<Vertex> Vertices;
+  std::vector<CompactVertex> CompactVertices;
+  std::vector<uint16> Indices16;
+  std::vector<uint32> Indices32;
+  VertexQuantization Quantization;
+  // One meshlet set per mesh.
+  std::vector<MeshletData> Meshlets;
+};
+
+// GPU copies of PackedGeometry, empty parts stay null.
+struct GeometryBuffers {
+  ComPtr<ID3D12Resource> VertexBuffer;
+  ComPtr<ID3D12Resource> CompactVertexBuffer;
+  ComPtr<ID3D12Resource> IndexBuffer16;
+  ComPtr<ID3D12Resource> IndexBuffer32;
+};
+
+// Buffers the items of a RenderData sub-allocate their geometry from, so a pass binds its vertex and index buffers once.
+// Both index sizes share one heap of 16 bit elements, 32 bit ranges take two elements per index and start at even elements.
+struct GeometryHeaps {
+  explicit GeometryHeaps(uint64 pageSize)
+      : Vertices(sizeof(Vertex), pageSize), CompactVertices(sizeof(CompactVertex), pageSize), Indices(sizeof(uint16), pageSize)
+  {
+  }
+
+  GeometryHeap Vertices;
+  GeometryHeap CompactVertices;
+  GeometryHeap Indices;
 };
 
 class RenderItem
 {
  public:
-  RenderItem()                       = default;
-  RenderItem(const RenderItem&)      = default;
-  RenderItem(RenderItem&&) noexcept  = default;
-  RenderItem& operator=(RenderItem&) = default;
+  static const uint32 INVALID_GEOMETRY_ID = 0xFFFFFFFF;
+
+  RenderItem()                                 = default;
+  RenderItem(const RenderItem&)                = default;
+  RenderItem(RenderItem&&) noexcept            = default;
+  RenderItem& operator=(const RenderItem&)     = default;
+  RenderItem& operator=(RenderItem&&) noexcept = default;
+
+  RenderItem(const Model* model, GeometryHeaps& heaps, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList);
+  // Uploads the cooked blobs as they are, the model only has to stay open until the constructor returns.
+  RenderItem(const CookedModel& model, GeometryHeaps& heaps, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList);
+  // Copies buffers uploaded elsewhere, e.g. by ModelStreamer. They have to hold PackGeometry(model) and be readable already.
+  // The copies are only queued, see GeometryHeap::QueueCopy.
+  RenderItem(const Model* model, PackedGeometry&& geometry, const GeometryBuffers& buffers, GeometryHeaps& heaps, ID3D12Device* device);
 
-  RenderItem(const Model* model, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList);
+  // Everything the model constructor uploads, without touching the device. Safe to call from a worker thread.
+  static void PackGeometry(const Model* model, PackedGeometry& geometry);
 
-  void BuildPerObjectCBuffer(ID3D12Device* device, const CheString& shaderName, std::unordered_map<CheString, CBufferInfo> cbSettings);
+  // Another placement of the same geometry: buffers, draw args and textures are shared, the transform is not.
+  RenderItem MakeInstance() const;
+  // Returns the heap ranges, instances share them, so only the last item of a geometry id may do this.
+  void ReleaseGeometry(GeometryHeaps& heaps);
 
   D3D12_INDEX_BUFFER_VIEW GetIndexBufferView16() const;
   D3D12_INDEX_BUFFER_VIEW GetIndexBufferView32() const;
   D3D12_VERTEX_BUFFER_VIEW GetVertexBufferView() const;
+  D3D12_VERTEX_BUFFER_VIEW GetCompactVertexBufferView() const;
+  inline D3D12_VERTEX_BUFFER_VIEW GetVertexBufferView(VertexFormat format) const
+  {
+    return format == VertexFormat::COMPACT ? GetCompactVertexBufferView() : GetVertexBufferView();
+  }
+
+  // Dequantization of the compact vertices, shared by all compact meshes of the item.
+  inline const VertexQuantization& GetVertexQuantization() const { return mQuantization; }
 
   inline const std::vector<DrawArg>& GetDrawArgs() const { return mDrawArgs; }
+  // Textures of all draw args, see DrawArg::FirstSrv.
+  inline const std::vector<DrawMaterial>& GetDrawSrvs() const { return mDrawSrvs; }
+  // Null when the draw arg has no texture for the shader variable.
+  const DrawMaterial* FindDrawSrv(uint32 drawArgIndex, const CheString& name) const;
+  // Cooked items carry no meshlets and are always drawn whole.
+  inline bool HasMeshlets() const { return mMeshlets != nullptr && !mMeshlets->empty(); }
+  inline const MeshletData& GetMeshlets(uint32 drawArgIndex) const { return (*mMeshlets)[drawArgIndex]; }
+
+  // Picks the LOD of every draw arg from its projected error.
+  void SelectLods(const LodSelector& selector);
 
   inline void SetPosition(float x, float y, float z) { mTransform.SetPosition(x, y, z); }
   inline DirectX::XMFLOAT3 GetPosition() { return mTransform.GetPosition(); }
@@ -50,103 +217,261 @@ class RenderItem
   inline void SetRotation(float x, float y, float z) { mTransform.SetRotation(x, y, z); }
   inline DirectX::XMMATRIX GetTransMatrix() { return mTransform.GetLocalToWorldMatrixXM(); }
 
-  inline CBufferManager& GetPerObjectCBuffer(const CheString& shaderName) { return mPerObjectCBManagers[shaderName]; }
+  // Items of equal ids are instances of each other, set by RenderData.
+  inline uint32 GetGeometryId() const { return mGeometryId; }
+  inline void SetGeometryId(uint32 geometryId) { mGeometryId = geometryId; }
+
   inline uint32 GetSrvDescriptorOffset() const { return mSrvDescriptorOffset; }
   inline uint32 GetSrvDescriptorCount() const { return mTotalSrvDescriptorCount; }
 
   inline void SetSrvDescriptorOffset(uint32 offset) { mSrvDescriptorOffset = offset; }
+  inline void SetDrawMaterialId(uint32 drawArgIndex, uint32 materialId) { mDrawArgs[drawArgIndex].MaterialId = materialId; }
 
  private:
   inline void BuildDrawArgs(const Model* model);
-  inline void BuildMeshUploadResource(const Model* model, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList);
+  inline void BuildMeshUploadResource(const PackedGeometry& geometry, GeometryHeaps& heaps, ID3D12Device* device, ID3D12GraphicsCommandList* cmdList);
+  // Sub-allocates the total counts from the heaps and moves the draw args into the ranges.
+  void AllocateGeometry(GeometryHeaps& heaps, ID3D12Device* device);
 
  private:
   uint32 mTotalVertexCount        = 0;
+  uint32 mTotalCompactVertexCount = 0;
   uint32 mTotalIndexCount16       = 0;
   uint32 mTotalIndexCount32       = 0;
   uint32 mTotalSrvDescriptorCount = 0;
   uint32 mSrvDescriptorOffset     = 0;
 
   Transform mTransform;
+  VertexQuantization mQuantization;
+  uint32 mGeometryId = INVALID_GEOMETRY_ID;
 
-  // Shader name: cbuffer manager.
-  std::unordered_map<CheString, CBufferManager> mPerObjectCBManagers;
   std::vector<DrawArg> mDrawArgs;
-
-  ComPtr<ID3D12Resource> mIndexBufferGPU16 = nullptr;
-  ComPtr<ID3D12Resource> mIndexBufferGPU32 = nullptr;
-  ComPtr<ID3D12Resource> mVertexBufferGPU  = nullptr;
-
-  ComPtr<ID3D12Resource> mIndexBufferUploader16 = nullptr;
-  ComPtr<ID3D12Resource> mIndexBufferUploader32 = nullptr;
-  ComPtr<ID3D12Resource> mVertexBufferUploader  = nullptr;
+  std::vector<DrawMaterial> mDrawSrvs;
+  // One meshlet set per draw arg, for cluster culling. Shared with the instances of the item.
+  std::shared_ptr<const std::vector<MeshletData>> mMeshlets;
+  // Textures of cooked items, items built from a Model keep theirs in the mesh materials.
+  std::vector<Texture2D> mTextures;
+
+  // Heap pages holding the ranges below, the views cover the whole pages.
+  ComPtr<ID3D12Resource> mIndexBufferGPU16       = nullptr;
+  ComPtr<ID3D12Resource> mIndexBufferGPU32       = nullptr;
+  ComPtr<ID3D12Resource> mVertexBufferGPU        = nullptr;
+  ComPtr<ID3D12Resource> mCompactVertexBufferGPU = nullptr;
+
+  GeometryRange mIndexRange16;
+  GeometryRange mIndexRange32;
+  GeometryRange mVertexRange;
+  GeometryRange mCompactVertexRange;
 };
 
+// Items live in dense arrays, index i of mItems, mItemNames, mItemSlots, mInstances, mObjectCBuffers and the bindings belongs to the same item.
+// Handles go through a slot table, so removing an item can move the last one into its place.
+// Names are only for lookups by tools and setup code, drawing walks the dense arrays: per item the transforms and material indices
+// of mInstances and the object CBV ranges, per draw the refs, bounds and material ids.
+// Texture views are created when an item is added and keep their heap slots until it is removed,
+// bindless shaders reach them through the material table, see MaterialTable.
 class RenderData
 {
  public:
-  RenderData(ComPtr<ID3D12Device> device, ComPtr<ID3D12GraphicsCommandList> cmdList);
-
+  // Columns of the material table, in the order of the *_TEXTURE indices of the shaders.
+  static const uint32 MATERIAL_TEXTURE_COUNT = 3;
+  static const CheChar* const MATERIAL_TEXTURE_NAMES[MATERIAL_TEXTURE_COUNT];
+
+  // geometryPageSize is the size of the vertex and index buffers the items share, see GeometryHeap.
+  // Views go to descriptorHeap when it is given, it can be shared with other RenderData and has to outlive them.
+  // Otherwise the RenderData creates a heap of its own.
+  RenderData(ComPtr<ID3D12Device> device, ComPtr<ID3D12GraphicsCommandList> cmdList, uint64 geometryPageSize = GeometryHeap::DEFAULT_PAGE_SIZE,
+             DescriptorHeap* descriptorHeap = nullptr);
+  ~RenderData();
+  NO_COPY(RenderData)
+
+  // Add the shaders before the items, every item gets per object cbuffers for the shaders added so far.
   void AddShader(Shader* shader) { mShaders.push_back(shader); }
-  void AddRenderItem(const CheString& name, Model* model);
+  // Adding a name that is already in use returns the existing item.
+  RenderItemHandle AddRenderItem(const CheString& name, Model* model);
+  RenderItemHandle AddRenderItem(const CheString& name, const CookedModel& model);
+  // A ModelStreamer load that reached StreamState::READY, its geometry is moved into the item.
+  // The copy into the geometry heaps is recorded by the next RecordGeometryCopies, run it before drawing the item.
+  // The sink lets go of the streamed geometry buffers, the heaps keep them until the copy is done.
+  RenderItemHandle AddRenderItem(const CheString& name, StreamedModel& model, D3D12UploadSink& sink);
+  // Another placement of the source item, see RenderItem::MakeInstance. Draws of instances are batched into instanced draws.
+  // The instance starts with the material index of the source.
+  RenderItemHandle AddInstance(const CheString& name, RenderItemHandle source);
+  // The last item of a geometry returns its ranges, heap slots and materials, they are free for new items at once.
+  // Rebuilds the bindings and draw arrays, so remove items only while the GPU is idle.
+  void RemoveRenderItem(RenderItemHandle handle);
+
+  // Records the queued copies of streamed items on the command list of the RenderData.
+  void RecordGeometryCopies();
+  // Drops the staging memory of geometry uploads, run it once the GPU executed them.
+  void ReleaseUploadBuffers();
+
+  // Appends to the material table read through gMaterials and returns the index for SetMaterialIndex.
+  // The table is uploaded by BuildRenderData, items default to index 0.
+  uint32 AddMaterial(const MaterialDesc& material);
+  inline uint32 GetMaterialCount() const { return static_cast<uint32>(mMaterials.size()); }
+  inline D3D12_GPU_VIRTUAL_ADDRESS GetMaterialBufferAddress() const { return mMaterialBuffer->GetGPUVirtualAddress(); }
+  // Texture sets of the draws, see DrawArg::MaterialId.
+  inline const MaterialTable& GetMaterialTable() const { return mMaterialTable; }
+  inline D3D12_GPU_VIRTUAL_ADDRESS GetMaterialTextureBufferAddress() const { return mMaterialTextureBuffer->GetGPUVirtualAddress(); }
+
+  // Uploads the material tables and resolves the bindings of all items.
+  // Run it again after adding or removing items, once the GPU is done with the old tables.
+  void BuildRenderData();
 
-  uint32 GetTotalDescriptorCount();
+  // Invalid handle when there is no item of that name.
+  RenderItemHandle FindItem(const CheString& itemName) const;
+  inline bool IsValid(RenderItemHandle handle) const
+  {
+    return handle.Slot < mSlots.size() && mSlots[handle.Slot].Generation == handle.Generation && mSlots[handle.Slot].DenseIndex != INVALID_INDEX;
+  }
+  inline uint32 GetDenseIndex(RenderItemHandle handle) const { return mSlots[handle.Slot].DenseIndex; }
 
-  void BuildRenderData();
+  inline RenderItem& GetItem(RenderItemHandle handle) { return mItems[GetDenseIndex(handle)]; }
+  // The item has to exist.
+  inline RenderItem& GetItem(const CheString& itemName) { return GetItem(FindItem(itemName)); }
 
-  inline RenderItem& GetItem(const CheString& itemName) { return mRenderItems[itemName]; }
-  inline std::unordered_map<CheString, RenderItem>& GetRenderItems() { return mRenderItems; }
-  inline ID3D12DescriptorHeap* GetSrvDescriptorHeap() const { return mSrvDescriptorHeap.Get(); }
-  inline uint32 GetNullSrvIndex() const { return mNullSrvIndex; }
+  // Dense access for per frame loops.
+  inline uint32 GetItemCount() const { return static_cast<uint32>(mItems.size()); }
+  inline RenderItem& GetItemAt(uint32 index) { return mItems[index]; }
+  inline const CheString& GetItemName(uint32 index) const { return mItemNames[index]; }
+
+  inline void SetMaterialIndex(RenderItemHandle handle, uint32 materialIndex) { mInstances[GetDenseIndex(handle)].MaterialIndex = materialIndex; }
+  inline uint32 GetMaterialIndex(RenderItemHandle handle) const { return mInstances[GetDenseIndex(handle)].MaterialIndex; }
+  // World matrix of the last UpdateInstanceData.
+  inline DirectX::XMMATRIX GetItemWorld(uint32 index) const { return XMMatrixTranspose(XMLoadFloat4x4(&mInstances[index].World)); }
 
-  inline CBufferManager& GetItemPerObjectCB(const CheString& itemName, const CheString& shaderName)
+  // The shader has to be added, see GetShaderIndex.
+  inline CBufferManager& GetPerObjectCBuffer(RenderItemHandle handle, uint32 shaderIndex)
   {
-    return mRenderItems[itemName].GetPerObjectCBuffer(shaderName);
+    return mObjectCBuffers[GetDenseIndex(handle) * mShaders.size() + shaderIndex];
   }
 
-  inline void SetCBValueWithItemTrans(const CheString& itemName, const CheString& shaderName, const CheString& varName)
+  inline ID3D12DescriptorHeap* GetSrvDescriptorHeap() const { return mDescriptorHeap->GetHeap(); }
+  inline uint32 GetNullSrvIndex() const { return mNullSrvIndex; }
+
+  // Index of shader in the bindings, INVALID_INDEX when it was not added.
+  uint32 GetShaderIndex(const Shader* shader) const;
+  inline const ShaderBinding& GetShaderBinding(uint32 shaderIndex) const { return mShaderBindings[shaderIndex]; }
+  // Valid after BuildRenderData.
+  inline const ItemShaderBinding& GetItemBinding(uint32 itemIndex, uint32 shaderIndex) const
   {
-    mRenderItems[itemName].GetPerObjectCBuffer(shaderName).SetValue(varName, XMMatrixTranspose(mRenderItems[itemName].GetTransMatrix()));
+    return mItemBindings[itemIndex * mShaders.size() + shaderIndex];
   }
-
-  inline CD3DX12_CPU_DESCRIPTOR_HANDLE GetShadowMapHandleCPU() const
+  // Address is set by UploadConstants.
+  inline const RootCbv& GetObjectCbv(uint32 index) const { return mObjectCbvs[index]; }
+
+  // Draws of all items, valid after BuildRenderData.
+  inline uint32 GetDrawCount() const { return static_cast<uint32>(mDrawRefs.size()); }
+  inline const DrawRef& GetDrawRef(uint32 drawIndex) const { return mDrawRefs[drawIndex]; }
+  inline uint32 GetDrawIndex(uint32 itemIndex, uint32 argIndex) const { return mItemFirstDraws[itemIndex] + argIndex; }
+  // Material table row of the draw, see DrawArg::MaterialId.
+  inline uint32 GetDrawMaterialId(uint32 drawIndex) const { return mDrawMaterialIds[drawIndex]; }
+  // Refreshes the world space boxes of all draws from the item worlds, run it after UpdateInstanceData and before culling.
+  void UpdateDrawBounds();
+  // One box per draw, in draw index order.
+  inline const CullBoxes& GetDrawBounds() const { return mDrawBounds; }
+
+  // Moves the world matrices of all items to PrevWorld and stores the ones of their transforms, run it once per frame after moving items.
+  void UpdateInstanceData();
+  // The instance buffer is a mapped upload heap filled from the start every frame.
+  // Resize it only while the GPU is idle, and reset it once the GPU is done with the previous frame.
+  void ReserveInstances(uint32 instanceCount);
+  inline void ResetInstances() { mInstanceCount = 0; }
+  // Copies the instance data of the items to the instance buffer and returns the address of the first one.
+  // Returns 0 when the reserved space is used up.
+  D3D12_GPU_VIRTUAL_ADDRESS WriteInstances(const std::vector<uint32>& itemIndices);
+  // Copies the pass and per object constants into ring and points the bindings at the copies, run it every frame before drawing.
+  void UploadConstants(UploadRing& ring);
+
+  inline CBufferManager& GetItemPerObjectCB(const CheString& itemName, const Shader* shader)
   {
-    CD3DX12_CPU_DESCRIPTOR_HANDLE handle(mSrvDescriptorHeap->GetCPUDescriptorHandleForHeapStart());
-    handle.Offset(mShadowMapSrvIndex, mSrvDescriptorSize);
-    return handle;
+    return GetPerObjectCBuffer(FindItem(itemName), GetShaderIndex(shader));
   }
 
-  inline CD3DX12_GPU_DESCRIPTOR_HANDLE GetShadowMapHandleGPU() const
+  inline void SetCBValueWithItemTrans(const CheString& itemName, const Shader* shader, const CheString& varName)
   {
-    CD3DX12_GPU_DESCRIPTOR_HANDLE handle(mSrvDescriptorHeap->GetGPUDescriptorHandleForHeapStart());
-    handle.Offset(mShadowMapSrvIndex, mSrvDescriptorSize);
-    return handle;
+    GetItemPerObjectCB(itemName, shader).SetValue(varName, XMMatrixTranspose(GetItem(itemName).GetTransMatrix()));
   }
 
+  inline CD3DX12_CPU_DESCRIPTOR_HANDLE GetShadowMapHandleCPU() const { return mDescriptorHeap->GetCpuHandle(mShadowMapSrvIndex); }
+  inline CD3DX12_GPU_DESCRIPTOR_HANDLE GetShadowMapHandleGPU() const { return mDescriptorHeap->GetGpuHandle(mShadowMapSrvIndex); }
+
  public:
   static const uint32 NULL_SRV_WIDTH  = 4;
   static const uint32 NULL_SRV_HEIGHT = 4;
+  static const uint32 INVALID_INDEX   = 0xFFFFFFFF;
 
  private:
+  struct ItemSlot {
+    // INVALID_INDEX while the slot is free.
+    uint32 DenseIndex = INVALID_INDEX;
+    uint32 Generation = 0;
+  };
+
+  RenderItemHandle InsertItem(const CheString& name, RenderItem&& item);
+  // Views and materials of the first item of a geometry, instances share them.
+  void CreateItemViews(RenderItem& item);
+  void ReleaseItemViews(RenderItem& item);
   void BuildNullSrvResource();
+  void BuildMaterialBuffer();
+  void BuildMaterialTextureBuffer();
+  void BuildBindings();
 
  private:
   ComPtr<ID3D12Device> mDevice;
   ComPtr<ID3D12GraphicsCommandList> mCmdList;
 
   std::vector<Shader*> mShaders;
-  std::unordered_map<CheString, RenderItem> mRenderItems;
-
-  ComPtr<ID3D12DescriptorHeap> mSrvDescriptorHeap = nullptr;
-  ComPtr<ID3D12Resource> mNullResource            = nullptr;
-
-  uint32 mSrvDescriptorSize  = 0;
-  uint32 mSrvDescriptorCount = 0;
-
-  const uint32 mNullSrvIndex      = 0;
-  const uint32 mShadowMapSrvIndex = 1;
 
-  // Shadow Map Srv + NullSrv
-  const uint32 mDescriptorOffset = 2;
+  std::vector<RenderItem> mItems;
+  std::vector<CheString> mItemNames;
+  std::vector<uint32> mItemSlots;
+  // Transforms and material index of every item.
+  std::vector<InstanceData> mInstances;
+  // False until the first UpdateInstanceData of the item, which then has no previous transform.
+  std::vector<uint8> mHasInstanceData;
+  // mItems.size() * mShaders.size(), item major.
+  std::vector<CBufferManager> mObjectCBuffers;
+
+  std::vector<ItemSlot> mSlots;
+  std::vector<uint32> mFreeSlots;
+  std::unordered_map<CheString, RenderItemHandle> mItemLookup;
+
+  std::vector<ShaderBinding> mShaderBindings;
+  // mItems.size() * mShaders.size(), item major, ranges of mObjectCbvs.
+  std::vector<ItemShaderBinding> mItemBindings;
+  std::vector<RootCbv> mObjectCbvs;
+  // Per item, index of its first draw.
+  std::vector<uint32> mItemFirstDraws;
+  // Per draw, in draw index order.
+  std::vector<DrawRef> mDrawRefs;
+  std::vector<uint32> mDrawMaterialIds;
+  CullBoxes mDrawBounds;
+  uint32 mNextGeometryId = 0;
+  // Items of every geometry id, the last one to go releases the geometry.
+  std::vector<uint32> mGeometryRefCounts;
+  GeometryHeaps mGeometryHeaps;
+
+  std::vector<MaterialDesc> mMaterials;
+  ComPtr<ID3D12Resource> mMaterialBuffer = nullptr;
+  MaterialTable mMaterialTable;
+  ComPtr<ID3D12Resource> mMaterialTextureBuffer = nullptr;
+
+  ComPtr<ID3D12Resource> mInstanceBuffer = nullptr;
+  InstanceData* mMappedInstances         = nullptr;
+  uint32 mInstanceCapacity               = 0;
+  uint32 mInstanceCount                  = 0;
+
+  std::unique_ptr<DescriptorHeap> mOwnedDescriptorHeap;
+  DescriptorHeap* mDescriptorHeap      = nullptr;
+  ComPtr<ID3D12Resource> mNullResource = nullptr;
+  // Views of every geometry id, invalid while it has none.
+  std::vector<TlsfAllocation> mGeometrySrvSlots;
+
+  // NullSrv + Shadow Map Srv
+  TlsfAllocation mReservedSrvSlots;
+  uint32 mNullSrvIndex      = 0;
+  uint32 mShadowMapSrvIndex = 0;
 };
 #endif  // GRAPHICS_RENDER_DATA_H
\ No newline at end of file
@@ -0,0 +1,78 @@
+#include "Graphics/UploadRing.h"
+
+#include "Graphics/D3DUtil.h"
+
+const uint64 UploadRingAllocator::INVALID_OFFSET;
+const uint64 UploadRing::DEFAULT_PAGE_SIZE;
+
+uint64 UploadRingAllocator::Allocate(uint64 size, uint64 alignment)
+{
+  if (size == 0 || size > mCapacity) return INVALID_OFFSET;
+
+  const uint64 offset  = mHead % mCapacity;
+  const uint64 aligned = (offset + alignment - 1) & ~(alignment - 1);
+  // Offset 0 is aligned, the allocation moves there when it does not fit before the end.
+  const uint64 start = aligned + size <= mCapacity ? mHead + (aligned - offset) : mHead + (mCapacity - offset);
+  if (start + size - mTail > mCapacity) return INVALID_OFFSET;
+
+  mHead = start + size;
+  return start % mCapacity;
+}
+
+void UploadRingAllocator::EndFrame(uint64 fence)
+{
+  // Nothing allocated since the last frame.
+  if (mHead == (mFrames.empty() ? mTail : mFrames.back().End)) return;
+  mFrames.push_back({fence, mHead});
+}
+
+void UploadRingAllocator::Reclaim(uint64 completedFence)
+{
+  uint32 completedCount = 0;
+  while (completedCount < mFrames.size() && mFrames[completedCount].Fence <= completedFence) {
+    mTail = mFrames[completedCount].End;
+    completedCount++;
+  }
+  mFrames.erase(mFrames.begin(), mFrames.begin() + completedCount);
+}
+
+UploadAllocation UploadRing::Allocate(ID3D12Device* device, uint64 size, uint64 alignment)
+{
+  UploadAllocation allocation;
+  for (uint32 i = 0; i < mPages.size(); ++i) {
+    const uint32 pageIndex = (mCurrentPage + i) % mPages.size();
+    const uint64 offset    = mPages[pageIndex].Ring.Allocate(size, alignment);
+    if (offset == UploadRingAllocator::INVALID_OFFSET) continue;
+
+    mCurrentPage          = pageIndex;
+    allocation.CpuAddress = mPages[pageIndex].Mapped + offset;
+    allocation.GpuAddress = mPages[pageIndex].Buffer->GetGPUVirtualAddress() + offset;
+    return allocation;
+  }
+
+  Page page;
+  page.Ring = UploadRingAllocator(size > mPageSize ? size : mPageSize);
+  TIFF(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE,
+                                       &CD3DX12_RESOURCE_DESC::Buffer(page.Ring.GetCapacity()), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
+                                       IID_PPV_ARGS(page.Buffer.GetAddressOf())));
+  // Upload heaps stay mapped for their whole life.
+  TIFF(page.Buffer->Map(0, nullptr, reinterpret_cast<void**>(&page.Mapped)));
+  mPages.push_back(page);
+
+  // The new page is empty, buffers start at offset 0 and 0 satisfies any alignment.
+  mCurrentPage          = static_cast<uint32>(mPages.size() - 1);
+  const uint64 offset   = mPages.back().Ring.Allocate(size, alignment);
+  allocation.CpuAddress = mPages.back().Mapped + offset;
+  allocation.GpuAddress = mPages.back().Buffer->GetGPUVirtualAddress() + offset;
+  return allocation;
+}
+
+void UploadRing::EndFrame(uint64 fence)
+{
+  for (Page& page : mPages) page.Ring.EndFrame(fence);
+}
+
+void UploadRing::Reclaim(uint64 completedFence)
+{
+  for (Page& page : mPages) page.Ring.Reclaim(completedFence);
+}
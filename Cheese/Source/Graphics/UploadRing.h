@@ -0,0 +1,83 @@
+#ifndef GRAPHICS_UPLOAD_RING_H
+#define GRAPHICS_UPLOAD_RING_H
+#include <d3d12.h>
+
+#include <vector>
+
+#include "Common/TypeDef.h"
+#include "Core/Helpers.h"
+
+// Offsets into a ring of capacity bytes, handed out front to back and given back a frame at a time once the GPU is done with it.
+// Only bookkeeping, UploadRing puts it over mapped upload buffers. Fences are the values the queue signals after each frame.
+class UploadRingAllocator
+{
+ public:
+  static const uint64 INVALID_OFFSET = 0xFFFFFFFFFFFFFFFF;
+
+  explicit UploadRingAllocator(uint64 capacity = 0) : mCapacity(capacity) {}
+
+  // Offset of size bytes at a multiple of alignment, a power of two. An allocation never wraps, the end of the ring is skipped instead.
+  // INVALID_OFFSET when the frames in flight hold too much of the ring.
+  uint64 Allocate(uint64 size, uint64 alignment);
+  // Closes the allocations made since the last call, they are reclaimed once fence completed.
+  void EndFrame(uint64 fence);
+  // Frees the frames whose fence is at most completedFence.
+  void Reclaim(uint64 completedFence);
+
+  inline uint64 GetCapacity() const { return mCapacity; }
+  inline uint64 GetUsedSize() const { return mHead - mTail; }
+  inline uint32 GetFramesInFlight() const { return static_cast<uint32>(mFrames.size()); }
+
+ private:
+  struct FrameMark {
+    uint64 Fence;
+    uint64 End;
+  };
+
+ private:
+  uint64 mCapacity;
+  // Bytes handed out and given back since the start, the ring offset is the count modulo mCapacity.
+  uint64 mHead = 0;
+  uint64 mTail = 0;
+  // Oldest first, fences increase.
+  std::vector<FrameMark> mFrames;
+};
+
+struct UploadAllocation {
+  Byte* CpuAddress                     = nullptr;
+  D3D12_GPU_VIRTUAL_ADDRESS GpuAddress = 0;
+};
+
+// Per frame upload memory for data the GPU reads in the frame it was written, e.g. constant buffers.
+// Pages are large persistently mapped upload buffers with a ring each, a frame never overwrites what frames in flight read.
+// When every page is held by frames in flight another page is created instead of waiting.
+class UploadRing
+{
+ public:
+  static const uint64 DEFAULT_PAGE_SIZE = 4 << 20;
+
+  explicit UploadRing(uint64 pageSize = DEFAULT_PAGE_SIZE) : mPageSize(pageSize) {}
+  NO_COPY(UploadRing)
+
+  // Write combined memory, copy whole blocks into CpuAddress and never read it back.
+  UploadAllocation Allocate(ID3D12Device* device, uint64 size, uint64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+  // Call once per frame with the fence signaled after the frame's command lists, and Reclaim with the completed value before allocating.
+  void EndFrame(uint64 fence);
+  void Reclaim(uint64 completedFence);
+
+  inline uint32 GetPageCount() const { return static_cast<uint32>(mPages.size()); }
+
+ private:
+  struct Page {
+    ComPtr<ID3D12Resource> Buffer;
+    Byte* Mapped;
+    UploadRingAllocator Ring;
+  };
+
+ private:
+  uint64 mPageSize;
+  std::vector<Page> mPages;
+  // Tried first, the page of the last allocation.
+  uint32 mCurrentPage = 0;
+};
+#endif  // GRAPHICS_UPLOAD_RING_H
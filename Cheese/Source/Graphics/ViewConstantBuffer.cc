@@ -0,0 +1,22 @@
+#include "Graphics/ViewConstantBuffer.h"
+
+ViewConstantBuffer::ViewConstantBuffer(uint32 byteSize)
+    : mByteSize(byteSize),
+      mStride((byteSize + D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1) & ~(D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT - 1))
+{
+}
+
+uint32 ViewConstantBuffer::AddView()
+{
+  mData.resize(mData.size() + mStride, 0);
+  return mViewCount++;
+}
+
+void ViewConstantBuffer::Upload(ID3D12Device* device, UploadRing& ring)
+{
+  if (mViewCount == 0) return;
+
+  const UploadAllocation allocation = ring.Allocate(device, mData.size());
+  memcpy(allocation.CpuAddress, mData.data(), mData.size());
+  mGpuAddress = allocation.GpuAddress;
+}
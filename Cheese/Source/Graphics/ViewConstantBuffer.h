@@ -0,0 +1,48 @@
+#ifndef GRAPHICS_VIEW_CONSTANT_BUFFER_H
+#define GRAPHICS_VIEW_CONSTANT_BUFFER_H
+#include <d3d12.h>
+
+#include <cstring>
+#include <type_traits>
+#include <vector>
+
+#include "Common/TypeDef.h"
+#include "Core/Helpers.h"
+#include "Graphics/UploadRing.h"
+
+// The cbView constants of every view rendered in a frame, e.g. the camera and the shadow light.
+// Written once per view whatever the number of shaders reading it, and uploaded as a single allocation with one CBV per view.
+class ViewConstantBuffer
+{
+ public:
+  // byteSize is the size of the cbView struct, views are placed at multiples of the constant buffer alignment.
+  explicit ViewConstantBuffer(uint32 byteSize);
+  NO_COPY(ViewConstantBuffer)
+
+  // Index of the new view, its constants are zero until set.
+  uint32 AddView();
+
+  template <typename ViewStruct>
+  void SetView(uint32 view, const ViewStruct& data)
+  {
+    static_assert(std::is_trivially_copyable<ViewStruct>::value, "View constants are copied as bytes");
+    if (view >= mViewCount || sizeof(ViewStruct) > mByteSize) return;
+    memcpy(mData.data() + view * mStride, &data, sizeof(ViewStruct));
+  }
+
+  // Copies all views to ring, call once per frame after the views are set and before recording the passes.
+  void Upload(ID3D12Device* device, UploadRing& ring);
+
+  inline uint32 GetViewCount() const { return mViewCount; }
+  inline uint32 GetStride() const { return mStride; }
+  // CBV of view as of the last Upload.
+  inline D3D12_GPU_VIRTUAL_ADDRESS GetAddress(uint32 view) const { return mGpuAddress + view * mStride; }
+
+ private:
+  uint32 mByteSize;
+  uint32 mStride;
+  uint32 mViewCount = 0;
+  std::vector<Byte> mData;
+  D3D12_GPU_VIRTUAL_ADDRESS mGpuAddress = 0;
+};
+#endif  // GRAPHICS_VIEW_CONSTANT_BUFFER_H
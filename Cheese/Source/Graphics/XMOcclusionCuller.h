@@ -0,0 +1,28 @@
+#ifndef GRAPHICS_XM_OCCLUSION_CULLER_H
+#define GRAPHICS_XM_OCCLUSION_CULLER_H
+#include <DirectXMath.h>
+
+#include "Core/Camera.h"
+#include "Graphics/OcclusionCuller.h"
+
+// OcclusionCuller fed with DirectXMath types, e.g. the proxy boxes and world matrices of RenderItems and the Camera.
+class XMOcclusionCuller : public OcclusionCuller
+{
+ public:
+  using OcclusionCuller::OcclusionCuller;
+  using OcclusionCuller::AddBoxOccluder;
+  using OcclusionCuller::Render;
+  using OcclusionCuller::SetOccluderTransform;
+
+  uint32 AddBoxOccluder(const DirectX::XMFLOAT3& boxMin, const DirectX::XMFLOAT3& boxMax) { return AddBoxOccluder(ToFloat3(boxMin), ToFloat3(boxMax)); }
+  void SetOccluderTransform(uint32 occluder, DirectX::FXMMATRIX objectToWorld) { SetOccluderTransform(occluder, ToFloat4x4(objectToWorld)); }
+  void Render(const Camera& camera) { Render(ToFloat4x4(camera.GetViewProjMatrixXM())); }
+
+  static Float4x4 ToFloat4x4(DirectX::FXMMATRIX matrix)
+  {
+    DirectX::XMFLOAT4X4 stored;
+    DirectX::XMStoreFloat4x4(&stored, matrix);
+    return ::ToFloat4x4(stored);
+  }
+};
+#endif  // GRAPHICS_XM_OCCLUSION_CULLER_H
@@ -0,0 +1,57 @@
+#ifndef MATH_MATRIX_H
+#define MATH_MATRIX_H
+#include "Math/Vector.h"
+
+// Plain row major 4x4 matrix for row vectors, p * M, laid out like DirectX::XMFLOAT4X4 but without the platform headers.
+struct Float4x4 {
+  float m[4][4] = {{1.0f, 0.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f, 0.0f}, {0.0f, 0.0f, 1.0f, 0.0f}, {0.0f, 0.0f, 0.0f, 1.0f}};
+};
+
+// From anything with an m[4][4] member, e.g. DirectX::XMFLOAT4X4.
+template <typename T>
+inline Float4x4 ToFloat4x4(const T& matrix)
+{
+  Float4x4 result;
+  for (int row = 0; row < 4; row++) {
+    for (int column = 0; column < 4; column++) result.m[row][column] = matrix.m[row][column];
+  }
+  return result;
+}
+
+// a * b, first a then b applied to a row vector.
+inline Float4x4 Multiply(const Float4x4& a, const Float4x4& b)
+{
+  Float4x4 result;
+  for (int row = 0; row < 4; row++) {
+    for (int column = 0; column < 4; column++) {
+      result.m[row][column] = a.m[row][0] * b.m[0][column] + a.m[row][1] * b.m[1][column] + a.m[row][2] * b.m[2][column] + a.m[row][3] * b.m[3][column];
+    }
+  }
+  return result;
+}
+
+inline Float4x4 Translation(float x, float y, float z)
+{
+  Float4x4 result;
+  result.m[3][0] = x;
+  result.m[3][1] = y;
+  result.m[3][2] = z;
+  return result;
+}
+
+// Left handed perspective projection to depth 0 at nearZ and 1 at farZ, as DirectX::XMMatrixPerspectiveFovLH builds it.
+inline Float4x4 PerspectiveFovLH(float fovY, float aspect, float nearZ, float farZ)
+{
+  const float yScale = 1.0f / tanf(fovY * 0.5f);
+  const float range  = farZ / (farZ - nearZ);
+
+  Float4x4 result;
+  result.m[0][0] = yScale / aspect;
+  result.m[1][1] = yScale;
+  result.m[2][2] = range;
+  result.m[2][3] = 1.0f;
+  result.m[3][2] = -range * nearZ;
+  result.m[3][3] = 0.0f;
+  return result;
+}
+#endif  // MATH_MATRIX_H
@@ -0,0 +1,25 @@
+#ifndef MATH_VECTOR_H
+#define MATH_VECTOR_H
+#include <cmath>
+
+// Plain float vector for CPU side geometry code. Unlike DirectXMath it needs no platform headers, so that code builds and is tested anywhere.
+struct Float3 {
+  float x = 0.0f;
+  float y = 0.0f;
+  float z = 0.0f;
+};
+
+// From anything with x, y and z members, e.g. DirectX::XMFLOAT3.
+template <typename T>
+inline Float3 ToFloat3(const T& v)
+{
+  return {v.x, v.y, v.z};
+}
+
+inline Float3 Add(const Float3& a, const Float3& b) { return {a.x + b.x, a.y + b.y, a.z + b.z}; }
+inline Float3 Sub(const Float3& a, const Float3& b) { return {a.x - b.x, a.y - b.y, a.z - b.z}; }
+inline Float3 Scale(const Float3& v, float s) { return {v.x * s, v.y * s, v.z * s}; }
+inline Float3 Cross(const Float3& a, const Float3& b) { return {a.y * b.z - a.z * b.y, a.z * b.x - a.x * b.z, a.x * b.y - a.y * b.x}; }
+inline float Dot(const Float3& a, const Float3& b) { return a.x * b.x + a.y * b.y + a.z * b.z; }
+inline float Length(const Float3& v) { return sqrtf(Dot(v, v)); }
+#endif  // MATH_VECTOR_H
@@ -0,0 +1,233 @@
+#include "CompactVertex.h"
+
+#include <emmintrin.h>
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include "Model/Mesh.h"
+
+using namespace DirectX;
+
+namespace {
+const float UNORM16_MAX = 65535.0f;
+const float SNORM16_MAX = 32767.0f;
+
+inline uint32 AsUint(float value)
+{
+  uint32 bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+inline float AsFloat(uint32 bits)
+{
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+inline float InverseOrZero(float value) { return value > 0.0f ? 1.0f / value : 0.0f; }
+
+// Four unit vectors to octahedral coordinates in [-1, 1].
+inline void OctEncode(__m128 x, __m128 y, __m128 z, __m128& u, __m128& v)
+{
+  const __m128 signMask = _mm_set1_ps(-0.0f);
+  const __m128 one      = _mm_set1_ps(1.0f);
+
+  const __m128 absX = _mm_andnot_ps(signMask, x);
+  const __m128 absY = _mm_andnot_ps(signMask, y);
+  const __m128 absZ = _mm_andnot_ps(signMask, z);
+  // Zero vectors end up at (0, 0), which decodes to +z.
+  const __m128 l1 = _mm_max_ps(_mm_add_ps(_mm_add_ps(absX, absY), absZ), _mm_set1_ps(1e-20f));
+
+  const __m128 px = _mm_div_ps(x, l1);
+  const __m128 py = _mm_div_ps(y, l1);
+
+  // The lower hemisphere is folded over the diagonals: (1 - |y|, 1 - |x|) with the signs of x and y.
+  const __m128 foldX = _mm_or_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, py)), _mm_and_ps(signMask, px));
+  const __m128 foldY = _mm_or_ps(_mm_sub_ps(one, _mm_andnot_ps(signMask, px)), _mm_and_ps(signMask, py));
+
+  const __m128 lower = _mm_cmplt_ps(z, _mm_setzero_ps());
+  u                  = _mm_or_ps(_mm_and_ps(lower, foldX), _mm_andnot_ps(lower, px));
+  v                  = _mm_or_ps(_mm_and_ps(lower, foldY), _mm_andnot_ps(lower, py));
+}
+
+inline __m128i ToSnorm16(__m128 value)
+{
+  const __m128 clamped = _mm_min_ps(_mm_max_ps(value, _mm_set1_ps(-1.0f)), _mm_set1_ps(1.0f));
+  return _mm_cvtps_epi32(_mm_mul_ps(clamped, _mm_set1_ps(SNORM16_MAX)));
+}
+
+// Float to half with round to nearest even, infinities and NaNs are kept. The low 16 bits of every lane hold the result.
+inline __m128i FloatToHalf4(__m128 value)
+{
+  const __m128i f16Max        = _mm_set1_epi32((127 + 16) << 23);
+  const __m128i minNormal     = _mm_set1_epi32((127 - 14) << 23);
+  const __m128i subnormalBias = _mm_set1_epi32(((127 - 15) + (23 - 10) + 1) << 23);
+  const __m128i normalBias    = _mm_set1_epi32(0xfff - ((127 - 15) << 23));
+
+  const __m128 sign         = _mm_and_ps(_mm_set1_ps(-0.0f), value);
+  const __m128 absValue     = _mm_xor_ps(value, sign);
+  const __m128i absBits     = _mm_castps_si128(absValue);
+  const __m128i isNan       = _mm_castps_si128(_mm_cmpunord_ps(absValue, absValue));
+  const __m128i inRange     = _mm_cmpgt_epi32(f16Max, absBits);
+  const __m128i special     = _mm_or_si128(_mm_and_si128(isNan, _mm_set1_epi32(0x200)), _mm_set1_epi32(0x7c00));
+  const __m128i isSubnormal = _mm_cmpgt_epi32(minNormal, absBits);
+
+  // Subnormals: the float adder rounds the mantissa into place.
+  const __m128i subnormal = _mm_sub_epi32(_mm_castps_si128(_mm_add_ps(absValue, _mm_castsi128_ps(subnormalBias))), subnormalBias);
+  // Normals: rebias the exponent and round, odd mantissas round up on ties.
+  const __m128i mantissaOdd = _mm_srai_epi32(_mm_slli_epi32(absBits, 31 - 13), 31);
+  const __m128i normal      = _mm_srli_epi32(_mm_sub_epi32(_mm_add_epi32(absBits, normalBias), mantissaOdd), 13);
+
+  const __m128i finite = _mm_or_si128(_mm_and_si128(isSubnormal, subnormal), _mm_andnot_si128(isSubnormal, normal));
+  const __m128i joined = _mm_or_si128(_mm_and_si128(inRange, finite), _mm_andnot_si128(inRange, special));
+  return _mm_or_si128(joined, _mm_srli_epi32(_mm_castps_si128(sign), 16));
+}
+
+inline float FromSnorm16(int16 value) { return std::max<float>(value / SNORM16_MAX, -1.0f); }
+
+XMFLOAT3 OctDecode(int16 encodedX, int16 encodedY)
+{
+  const float u = FromSnorm16(encodedX);
+  const float v = FromSnorm16(encodedY);
+  const float z = 1.0f - fabsf(u) - fabsf(v);
+  // Unfolds the lower hemisphere.
+  const float t = std::max<float>(-z, 0.0f);
+  const float x = u >= 0.0f ? u - t : u + t;
+  const float y = v >= 0.0f ? v - t : v + t;
+
+  const float length = sqrtf(x * x + y * y + z * z);
+  return {x / length, y / length, z / length};
+}
+}  // namespace
+
+VertexQuantization VertexCompressor::ComputeQuantization(const std::vector<Vertex>& vertices, const VertexQuantization* extend)
+{
+  if (vertices.empty()) {
+    return extend != nullptr ? *extend : VertexQuantization();
+  }
+
+  XMFLOAT3 boxMin = vertices[0].Position;
+  XMFLOAT3 boxMax = vertices[0].Position;
+  if (extend != nullptr) {
+    boxMin = extend->Offset;
+    boxMax = {extend->Offset.x + extend->Scale.x, extend->Offset.y + extend->Scale.y, extend->Offset.z + extend->Scale.z};
+  }
+
+  for (const Vertex& vertex : vertices) {
+    boxMin = {std::min<float>(boxMin.x, vertex.Position.x), std::min<float>(boxMin.y, vertex.Position.y), std::min<float>(boxMin.z, vertex.Position.z)};
+    boxMax = {std::max<float>(boxMax.x, vertex.Position.x), std::max<float>(boxMax.y, vertex.Position.y), std::max<float>(boxMax.z, vertex.Position.z)};
+  }
+
+  VertexQuantization quantization;
+  quantization.Offset = boxMin;
+  quantization.Scale  = {boxMax.x - boxMin.x, boxMax.y - boxMin.y, boxMax.z - boxMin.z};
+  return quantization;
+}
+
+XMFLOAT3 VertexCompressor::GetPositionErrorBound(const VertexQuantization& quantization)
+{
+  // Half a step, plus a little for the float rounding of encode and decode.
+  const float halfStep = (0.5f + 1.0f / 64.0f) / UNORM16_MAX;
+  return {quantization.Scale.x * halfStep, quantization.Scale.y * halfStep, quantization.Scale.z * halfStep};
+}
+
+void VertexCompressor::Encode(const Vertex* vertices, uint32 count, const VertexQuantization& quantization, CompactVertex* compactVertices)
+{
+  const __m128 zero        = _mm_setzero_ps();
+  const __m128 one         = _mm_set1_ps(1.0f);
+  const __m128 unormMax    = _mm_set1_ps(UNORM16_MAX);
+  const __m128 offset[3]   = {_mm_set1_ps(quantization.Offset.x), _mm_set1_ps(quantization.Offset.y), _mm_set1_ps(quantization.Offset.z)};
+  const __m128 invScale[3] = {_mm_set1_ps(InverseOrZero(quantization.Scale.x)), _mm_set1_ps(InverseOrZero(quantization.Scale.y)),
+                              _mm_set1_ps(InverseOrZero(quantization.Scale.z))};
+
+  // Four vertices per iteration, the tail is padded by repeating the last vertex.
+  for (uint32 first = 0; first < count; first += 4) {
+    const Vertex* v[4];
+    for (uint32 lane = 0; lane < 4; lane++) {
+      v[lane] = &vertices[std::min<uint32>(first + lane, count - 1)];
+    }
+
+    alignas(16) int32 position[3][4];
+    const __m128 positions[3] = {_mm_setr_ps(v[0]->Position.x, v[1]->Position.x, v[2]->Position.x, v[3]->Position.x),
+                                 _mm_setr_ps(v[0]->Position.y, v[1]->Position.y, v[2]->Position.y, v[3]->Position.y),
+                                 _mm_setr_ps(v[0]->Position.z, v[1]->Position.z, v[2]->Position.z, v[3]->Position.z)};
+    for (uint32 axis = 0; axis < 3; axis++) {
+      const __m128 unorm = _mm_min_ps(_mm_max_ps(_mm_mul_ps(_mm_sub_ps(positions[axis], offset[axis]), invScale[axis]), zero), one);
+      _mm_store_si128(reinterpret_cast<__m128i*>(position[axis]), _mm_cvtps_epi32(_mm_mul_ps(unorm, unormMax)));
+    }
+
+    alignas(16) int32 normal[2][4];
+    __m128 u, w;
+    OctEncode(_mm_setr_ps(v[0]->Normal.x, v[1]->Normal.x, v[2]->Normal.x, v[3]->Normal.x),
+              _mm_setr_ps(v[0]->Normal.y, v[1]->Normal.y, v[2]->Normal.y, v[3]->Normal.y),
+              _mm_setr_ps(v[0]->Normal.z, v[1]->Normal.z, v[2]->Normal.z, v[3]->Normal.z), u, w);
+    _mm_store_si128(reinterpret_cast<__m128i*>(normal[0]), ToSnorm16(u));
+    _mm_store_si128(reinterpret_cast<__m128i*>(normal[1]), ToSnorm16(w));
+
+    // Tangent w is the handedness and not part of the direction.
+    alignas(16) int32 tangent[2][4];
+    OctEncode(_mm_setr_ps(v[0]->Tangent.x, v[1]->Tangent.x, v[2]->Tangent.x, v[3]->Tangent.x),
+              _mm_setr_ps(v[0]->Tangent.y, v[1]->Tangent.y, v[2]->Tangent.y, v[3]->Tangent.y),
+              _mm_setr_ps(v[0]->Tangent.z, v[1]->Tangent.z, v[2]->Tangent.z, v[3]->Tangent.z), u, w);
+    _mm_store_si128(reinterpret_cast<__m128i*>(tangent[0]), ToSnorm16(u));
+    _mm_store_si128(reinterpret_cast<__m128i*>(tangent[1]), ToSnorm16(w));
+
+    alignas(16) int32 texCoord[2][4];
+    _mm_store_si128(reinterpret_cast<__m128i*>(texCoord[0]),
+                    FloatToHalf4(_mm_setr_ps(v[0]->TexCoord.x, v[1]->TexCoord.x, v[2]->TexCoord.x, v[3]->TexCoord.x)));
+    _mm_store_si128(reinterpret_cast<__m128i*>(texCoord[1]),
+                    FloatToHalf4(_mm_setr_ps(v[0]->TexCoord.y, v[1]->TexCoord.y, v[2]->TexCoord.y, v[3]->TexCoord.y)));
+
+    const uint32 laneCount = std::min<uint32>(count - first, 4);
+    for (uint32 lane = 0; lane < laneCount; lane++) {
+      CompactVertex& out = compactVertices[first + lane];
+      out.Position[0]    = static_cast<uint16>(position[0][lane]);
+      out.Position[1]    = static_cast<uint16>(position[1][lane]);
+      out.Position[2]    = static_cast<uint16>(position[2][lane]);
+      out.Position[3]    = v[lane]->Tangent.w < 0.0f ? 0 : 0xFFFF;
+      out.Normal[0]      = static_cast<int16>(normal[0][lane]);
+      out.Normal[1]      = static_cast<int16>(normal[1][lane]);
+      out.Tangent[0]     = static_cast<int16>(tangent[0][lane]);
+      out.Tangent[1]     = static_cast<int16>(tangent[1][lane]);
+      out.TexCoord[0]    = static_cast<uint16>(texCoord[0][lane]);
+      out.TexCoord[1]    = static_cast<uint16>(texCoord[1][lane]);
+    }
+  }
+}
+
+Vertex VertexCompressor::Decode(const CompactVertex& compactVertex, const VertexQuantization& quantization)
+{
+  Vertex vertex;
+  vertex.Position = {quantization.Offset.x + compactVertex.Position[0] / UNORM16_MAX * quantization.Scale.x,
+                     quantization.Offset.y + compactVertex.Position[1] / UNORM16_MAX * quantization.Scale.y,
+                     quantization.Offset.z + compactVertex.Position[2] / UNORM16_MAX * quantization.Scale.z};
+  vertex.Normal   = OctDecode(compactVertex.Normal[0], compactVertex.Normal[1]);
+
+  const XMFLOAT3 tangent = OctDecode(compactVertex.Tangent[0], compactVertex.Tangent[1]);
+  vertex.Tangent         = {tangent.x, tangent.y, tangent.z, compactVertex.Position[3] / UNORM16_MAX * 2.0f - 1.0f};
+  vertex.TexCoord        = {HalfToFloat(compactVertex.TexCoord[0]), HalfToFloat(compactVertex.TexCoord[1])};
+  return vertex;
+}
+
+uint16 VertexCompressor::FloatToHalf(float value)
+{
+  alignas(16) int32 result[4];
+  _mm_store_si128(reinterpret_cast<__m128i*>(result), FloatToHalf4(_mm_set1_ps(value)));
+  return static_cast<uint16>(result[0]);
+}
+
+float VertexCompressor::HalfToFloat(uint16 value)
+{
+  const uint32 exponent = value & 0x7c00;
+  uint32 bits           = ((value & 0x7fff) << 13) + ((127 - 15) << 23);
+  if (exponent == 0x7c00) {
+    // Infinity or NaN.
+    bits += (128 - 16) << 23;
+  } else if (exponent == 0) {
+    // Zero or subnormal, renormalized by the float unit.
+    bits = AsUint(AsFloat(bits + (1 << 23)) - AsFloat(113 << 23));
+  }
+  return AsFloat(bits | ((value & 0x8000) << 16));
+}
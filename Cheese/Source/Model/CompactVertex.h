@@ -0,0 +1,57 @@
+#ifndef MODEL_COMPACT_VERTEX_H
+#define MODEL_COMPACT_VERTEX_H
+#include <DirectXMath.h>
+
+#include <vector>
+
+#include "Common/Types.h"
+
+struct Vertex;
+
+enum class VertexFormat : uint8 {
+  // Vertex, 48 bytes of floats.
+  STANDARD = 0,
+  // CompactVertex, 20 bytes.
+  COMPACT = 1,
+};
+
+// Quantized vertex. Decoding lives in Shaders/VertexCompression.hlsli, the input layout in Mesh.h.
+struct CompactVertex {
+  // xyz: position in the quantization box, w: tangent handedness, 0 is -1 and 65535 is +1. R16G16B16A16_UNORM.
+  uint16 Position[4];
+  // Octahedral unit vectors, R16G16_SNORM.
+  int16 Normal[2];
+  int16 Tangent[2];
+  // R16G16_FLOAT.
+  uint16 TexCoord[2];
+};
+static_assert(sizeof(CompactVertex) == 20, "CompactVertex has to match its input layout");
+
+// Maps UNORM positions back to mesh space: position = Offset + unorm * Scale.
+struct VertexQuantization {
+  DirectX::XMFLOAT3 Offset = {0.0f, 0.0f, 0.0f};
+  DirectX::XMFLOAT3 Scale  = {1.0f, 1.0f, 1.0f};
+};
+
+// SSE2 encoding into CompactVertex, plus a scalar decode that mirrors the shader.
+class VertexCompressor
+{
+ public:
+  // Largest angle between a unit vector and its decoded octahedral encoding, in radians.
+  static constexpr float OCT_MAX_ANGLE_ERROR = 1e-4f;
+  // Largest relative error of a half float texture coordinate in the normal range.
+  static constexpr float HALF_MAX_RELATIVE_ERROR = 1.0f / 2048.0f;
+
+  // The box around the vertices. Pass the result back in to grow it over several meshes.
+  static VertexQuantization ComputeQuantization(const std::vector<Vertex>& vertices, const VertexQuantization* extend = nullptr);
+  // Largest per axis position error of the quantization, about half a UNORM step.
+  static DirectX::XMFLOAT3 GetPositionErrorBound(const VertexQuantization& quantization);
+
+  // Positions outside the quantization box are clamped to it.
+  static void Encode(const Vertex* vertices, uint32 count, const VertexQuantization& quantization, CompactVertex* compactVertices);
+  static Vertex Decode(const CompactVertex& compactVertex, const VertexQuantization& quantization);
+
+  static uint16 FloatToHalf(float value);
+  static float HalfToFloat(uint16 value);
+};
+#endif  // MODEL_COMPACT_VERTEX_H
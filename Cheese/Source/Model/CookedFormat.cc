@@ -0,0 +1,78 @@
+#include "CookedFormat.h"
+
+#include <cstring>
+
+namespace {
+// True if [offset, offset + count * elementSize) is an aligned range inside the file.
+bool IsSectionValid(uint64 offset, uint64 count, uint64 elementSize, uint64 fileSize)
+{
+  if (offset % CookedFormat::SECTION_ALIGN != 0 || offset > fileSize) return false;
+  if (elementSize != 0 && count > (fileSize - offset) / elementSize) return false;
+  return true;
+}
+}  // namespace
+
+namespace CookedFormat {
+bool Validate(const Byte* data, uint64 size)
+{
+  if (data == nullptr || size < sizeof(Header)) return false;
+  const Header* header = reinterpret_cast<const Header*>(data);
+  if (header->Magic != MAGIC || header->Version != VERSION || header->FileSize != size || header->VertexStride == 0) return false;
+
+  if (!IsSectionValid(header->DrawOffset, header->DrawCount, sizeof(Draw), size)) return false;
+  if (!IsSectionValid(header->BindingOffset, header->BindingCount, sizeof(Binding), size)) return false;
+  if (!IsSectionValid(header->ImageOffset, header->ImageCount, sizeof(Image), size)) return false;
+  if (!IsSectionValid(header->VertexOffset, header->VertexCount, header->VertexStride, size)) return false;
+  if (!IsSectionValid(header->Index16Offset, header->IndexCount16, sizeof(uint16), size)) return false;
+  if (!IsSectionValid(header->Index32Offset, header->IndexCount32, sizeof(uint32), size)) return false;
+
+  const Draw* draws = reinterpret_cast<const Draw*>(data + header->DrawOffset);
+  for (uint32 i = 0; i < header->DrawCount; ++i) {
+    const Draw& draw          = draws[i];
+    const uint64 indexEnd     = static_cast<uint64>(draw.StartIndexLocation) + draw.IndexCount;
+    const uint64 bindingEnd   = static_cast<uint64>(draw.FirstBinding) + draw.BindingCount;
+    const uint32 totalIndices = draw.IndexSize == sizeof(uint16) ? header->IndexCount16 : header->IndexCount32;
+    if (draw.IndexSize != sizeof(uint16) && draw.IndexSize != sizeof(uint32)) return false;
+    if (indexEnd > totalIndices || bindingEnd > header->BindingCount || draw.BaseVertexLocation > header->VertexCount) return false;
+
+    if (draw.LodCount == 0 || draw.LodCount > MAX_LODS) return false;
+    for (uint32 lod = 0; lod < draw.LodCount; ++lod) {
+      if (static_cast<uint64>(draw.Lods[lod].StartIndex) + draw.Lods[lod].IndexCount > draw.IndexCount) return false;
+    }
+  }
+
+  const Binding* bindings = reinterpret_cast<const Binding*>(data + header->BindingOffset);
+  for (uint32 i = 0; i < header->BindingCount; ++i) {
+    if (bindings[i].ImageIndex >= header->ImageCount) return false;
+    if (memchr(bindings[i].Name, '\0', BINDING_NAME_LEN) == nullptr) return false;
+  }
+
+  const Image* images = reinterpret_cast<const Image*>(data + header->ImageOffset);
+  for (uint32 i = 0; i < header->ImageCount; ++i) {
+    const Image& image = images[i];
+    if (image.Component != IMAGE_COMPONENT) return false;
+    if (image.PixelSize != static_cast<uint64>(image.Width) * image.Height * image.Component) return false;
+    if (image.PixelOffset > size || image.PixelSize > size - image.PixelOffset) return false;
+  }
+
+  return true;
+}
+
+bool ExpandToRgba(const Byte* pixels, uint64 pixelCount, uint32 component, Byte* rgba)
+{
+  if (component < 1 || component > 4) return false;
+  if (component == 4) {
+    memcpy(rgba, pixels, pixelCount * 4);
+    return true;
+  }
+
+  for (uint64 i = 0; i < pixelCount; ++i, pixels += component, rgba += 4) {
+    // Grey images replicate into rgb, only 2 and 4 component images carry alpha.
+    rgba[0] = pixels[0];
+    rgba[1] = component >= 3 ? pixels[1] : pixels[0];
+    rgba[2] = component >= 3 ? pixels[2] : pixels[0];
+    rgba[3] = component == 2 ? pixels[1] : 0xFF;
+  }
+  return true;
+}
+}  // namespace CookedFormat
@@ -0,0 +1,84 @@
+#ifndef MODEL_COOKED_FORMAT_H
+#define MODEL_COOKED_FORMAT_H
+#include "Common/Types.h"
+
+// Engine native mesh file (.chm). Holds the vertex/index blobs exactly as RenderItem uploads them,
+// so loading is a mapping plus validation. All offsets are from the start of the file.
+namespace CookedFormat {
+const uint32 MAGIC            = 0x004D4843;  // "CHM\0"
+const uint32 VERSION          = 4;
+const uint32 IMAGE_COMPONENT  = 4;
+const uint32 SECTION_ALIGN    = 16;
+const uint32 BINDING_NAME_LEN = 32;
+const uint32 MAX_LODS         = 8;
+
+struct Header {
+  uint32 Magic;
+  uint32 Version;
+  uint32 VertexStride;
+  uint32 DrawCount;
+  uint32 BindingCount;
+  uint32 ImageCount;
+  uint32 VertexCount;
+  uint32 IndexCount16;
+  uint32 IndexCount32;
+  uint32 Reserved;
+
+  uint64 DrawOffset;
+  uint64 BindingOffset;
+  uint64 ImageOffset;
+  uint64 VertexOffset;
+  uint64 Index16Offset;
+  uint64 Index32Offset;
+  uint64 FileSize;
+};
+
+// Index range relative to the draw's StartIndexLocation.
+struct Lod {
+  uint32 StartIndex;
+  uint32 IndexCount;
+  float Error;
+  uint32 Reserved;
+};
+
+// One RenderItem draw arg. IndexSize picks the 16 or 32 bit index blob.
+// IndexCount covers every LOD, Lods[0] is the full detail range.
+struct Draw {
+  uint32 IndexCount;
+  uint32 StartIndexLocation;
+  uint32 BaseVertexLocation;
+  uint32 IndexSize;
+  uint32 IsBlend;
+  uint32 FirstBinding;
+  uint32 BindingCount;
+  uint32 LodCount;
+  float BoundsCenter[3];
+  float BoundsRadius;
+  float BoundsMin[3];
+  float BoundsMax[3];
+  Lod Lods[MAX_LODS];
+};
+
+// Shader texture name (null terminated) to image.
+struct Binding {
+  char Name[BINDING_NAME_LEN];
+  uint32 ImageIndex;
+};
+
+// Decoded 8 bit RGBA pixels, Component is always IMAGE_COMPONENT so images upload as R8G8B8A8 without conversion.
+struct Image {
+  uint32 Width;
+  uint32 Height;
+  uint32 Component;
+  uint32 Reserved;
+  uint64 PixelOffset;
+  uint64 PixelSize;
+};
+
+// Checks the header, that every section lies inside the file, and every draw, binding and image references valid data.
+bool Validate(const Byte* data, uint64 size);
+
+// Writes pixelCount RGBA pixels from 1 (grey), 2 (grey, alpha), 3 or 4 component pixels. Returns false for other counts.
+bool ExpandToRgba(const Byte* pixels, uint64 pixelCount, uint32 component, Byte* rgba);
+}  // namespace CookedFormat
+#endif  // MODEL_COOKED_FORMAT_H
@@ -0,0 +1,162 @@
+#include "CookedModel.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include "Utils/Log/Logger.h"
+
+using namespace CookedFormat;
+
+namespace {
+uint64 AlignUp(uint64 value, uint64 alignment) { return (value + alignment - 1) & ~(alignment - 1); }
+
+void WritePadding(std::ofstream& fout, uint64 alignment)
+{
+  static const char zeros[SECTION_ALIGN] = {};
+  const uint64 position                  = static_cast<uint64>(fout.tellp());
+  fout.write(zeros, static_cast<std::streamsize>(AlignUp(position, alignment) - position));
+}
+
+template <typename T>
+void WriteSection(std::ofstream& fout, const std::vector<T>& data)
+{
+  WritePadding(fout, SECTION_ALIGN);
+  if (!data.empty()) fout.write(reinterpret_cast<const char*>(data.data()), static_cast<std::streamsize>(data.size() * sizeof(T)));
+}
+}  // namespace
+
+uint32 CookedModelBuilder::AddImage(const Byte* pixels, uint32 width, uint32 height, uint32 component)
+{
+  Image image       = {};
+  image.Width       = width;
+  image.Height      = height;
+  image.Component   = IMAGE_COMPONENT;
+  image.PixelSize   = static_cast<uint64>(width) * height * IMAGE_COMPONENT;
+  // Relative to the pixel section until Save knows where that section lands.
+  image.PixelOffset = mPixels.size();
+
+  // Loaders upload cooked images as R8G8B8A8, expand fewer components here rather than at every load.
+  mPixels.resize(image.PixelOffset + image.PixelSize);
+  if (!ExpandToRgba(pixels, static_cast<uint64>(width) * height, component, mPixels.data() + image.PixelOffset)) {
+    logger.Warning(CTEXT("Cooked image with unsupported component count ") + ConvertToCheString(static_cast<int>(component)) +
+                   CTEXT(", writing black pixels"));
+    memset(mPixels.data() + image.PixelOffset, 0, image.PixelSize);
+  }
+  mPixels.resize(AlignUp(mPixels.size(), SECTION_ALIGN));
+  mImages.push_back(image);
+  return static_cast<uint32>(mImages.size() - 1);
+}
+
+void CookedModelBuilder::AddDraw(const Byte* vertices, uint32 vertexCount, const Byte* indices, uint32 indexCount, uint32 indexSize,
+                                 bool isBlend, const std::vector<std::pair<std::string, uint32>>& bindings, const float boundsCenter[3],
+                                 float boundsRadius, const float boundsMin[3], const float boundsMax[3], const Lod* lods, uint32 lodCount)
+{
+  Draw draw               = {};
+  draw.IndexCount         = indexCount;
+  draw.BaseVertexLocation = mVertexCount;
+  draw.IndexSize          = indexSize;
+  draw.IsBlend            = isBlend ? 1 : 0;
+  draw.FirstBinding       = static_cast<uint32>(mBindings.size());
+  draw.BindingCount       = static_cast<uint32>(bindings.size());
+  draw.LodCount           = std::min<uint32>(lodCount, MAX_LODS);
+  draw.BoundsRadius       = boundsRadius;
+  memcpy(draw.BoundsCenter, boundsCenter, sizeof(draw.BoundsCenter));
+  memcpy(draw.BoundsMin, boundsMin, sizeof(draw.BoundsMin));
+  memcpy(draw.BoundsMax, boundsMax, sizeof(draw.BoundsMax));
+  memcpy(draw.Lods, lods, draw.LodCount * sizeof(Lod));
+
+  mVertices.insert(mVertices.end(), vertices, vertices + static_cast<uint64>(vertexCount) * mVertexStride);
+  mVertexCount += vertexCount;
+
+  const uint64 indexByteSize = static_cast<uint64>(indexCount) * indexSize;
+  if (indexSize == sizeof(uint16)) {
+    draw.StartIndexLocation = mIndexCount16;
+    mIndices16.insert(mIndices16.end(), indices, indices + indexByteSize);
+    mIndexCount16 += indexCount;
+  } else {
+    draw.StartIndexLocation = mIndexCount32;
+    mIndices32.insert(mIndices32.end(), indices, indices + indexByteSize);
+    mIndexCount32 += indexCount;
+  }
+
+  for (const auto& pair : bindings) {
+    Binding binding = {};
+    strncpy(binding.Name, pair.first.c_str(), BINDING_NAME_LEN - 1);
+    binding.ImageIndex = pair.second;
+    mBindings.push_back(binding);
+  }
+  mDraws.push_back(draw);
+}
+
+bool CookedModelBuilder::Save(const CheString& fileName) const
+{
+  Header header       = {};
+  header.Magic        = MAGIC;
+  header.Version      = VERSION;
+  header.VertexStride = mVertexStride;
+  header.DrawCount    = static_cast<uint32>(mDraws.size());
+  header.BindingCount = static_cast<uint32>(mBindings.size());
+  header.ImageCount   = static_cast<uint32>(mImages.size());
+  header.VertexCount  = mVertexCount;
+  header.IndexCount16 = mIndexCount16;
+  header.IndexCount32 = mIndexCount32;
+
+  // Sections follow the header in this order, each aligned to SECTION_ALIGN.
+  header.DrawOffset        = AlignUp(sizeof(Header), SECTION_ALIGN);
+  header.BindingOffset     = AlignUp(header.DrawOffset + mDraws.size() * sizeof(Draw), SECTION_ALIGN);
+  header.ImageOffset       = AlignUp(header.BindingOffset + mBindings.size() * sizeof(Binding), SECTION_ALIGN);
+  header.VertexOffset      = AlignUp(header.ImageOffset + mImages.size() * sizeof(Image), SECTION_ALIGN);
+  header.Index16Offset     = AlignUp(header.VertexOffset + mVertices.size(), SECTION_ALIGN);
+  header.Index32Offset     = AlignUp(header.Index16Offset + mIndices16.size(), SECTION_ALIGN);
+  const uint64 pixelOffset = AlignUp(header.Index32Offset + mIndices32.size(), SECTION_ALIGN);
+  header.FileSize          = pixelOffset + mPixels.size();
+
+  std::vector<Image> images = mImages;
+  for (Image& image : images) {
+    image.PixelOffset += pixelOffset;
+  }
+
+  std::ofstream fout(fileName, std::ios::binary | std::ios::trunc);
+  if (!fout) {
+    logger.Error(CTEXT("Can't write cooked model: ") + fileName);
+    return false;
+  }
+
+  fout.write(reinterpret_cast<const char*>(&header), sizeof(Header));
+  WriteSection(fout, mDraws);
+  WriteSection(fout, mBindings);
+  WriteSection(fout, images);
+  WriteSection(fout, mVertices);
+  WriteSection(fout, mIndices16);
+  WriteSection(fout, mIndices32);
+  WriteSection(fout, mPixels);
+
+  if (!fout || static_cast<uint64>(fout.tellp()) != header.FileSize) {
+    logger.Error(CTEXT("Failed writing cooked model: ") + fileName);
+    return false;
+  }
+  return true;
+}
+
+bool CookedModel::Open(const CheString& fileName)
+{
+  if (!mFile.Open(fileName)) return false;
+  if (!Load(mFile.GetData(), mFile.GetSize())) {
+    logger.Error(CTEXT("Invalid cooked model: ") + fileName);
+    mFile.Close();
+    return false;
+  }
+  return true;
+}
+
+bool CookedModel::Load(const Byte* data, uint64 size)
+{
+  mData   = nullptr;
+  mHeader = nullptr;
+
+  if (!Validate(data, size)) return false;
+
+  mData   = data;
+  mHeader = reinterpret_cast<const Header*>(data);
+  return true;
+}
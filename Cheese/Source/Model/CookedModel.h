@@ -0,0 +1,69 @@
+#ifndef MODEL_COOKED_MODEL_H
+#define MODEL_COOKED_MODEL_H
+#include <vector>
+#include "Common/TypeDef.h"
+#include "Core/Helpers.h"
+#include "Model/CookedFormat.h"
+#include "Utils/MappedFile.h"
+
+// Collects the cooked blobs and writes a .chm file. Draws are appended in the order RenderItem would build them.
+class CookedModelBuilder
+{
+ public:
+  explicit CookedModelBuilder(uint32 vertexStride) : mVertexStride(vertexStride) {}
+
+  uint32 AddImage(const Byte* pixels, uint32 width, uint32 height, uint32 component);
+  void AddDraw(const Byte* vertices, uint32 vertexCount, const Byte* indices, uint32 indexCount, uint32 indexSize, bool isBlend,
+               const std::vector<std::pair<std::string, uint32>>& bindings, const float boundsCenter[3], float boundsRadius,
+               const float boundsMin[3], const float boundsMax[3], const CookedFormat::Lod* lods, uint32 lodCount);
+
+  bool Save(const CheString& fileName) const;
+
+ private:
+  uint32 mVertexStride = 0;
+  uint32 mVertexCount  = 0;
+  uint32 mIndexCount16 = 0;
+  uint32 mIndexCount32 = 0;
+
+  std::vector<CookedFormat::Draw> mDraws;
+  std::vector<CookedFormat::Binding> mBindings;
+  std::vector<CookedFormat::Image> mImages;
+  std::vector<Byte> mVertices;
+  std::vector<Byte> mIndices16;
+  std::vector<Byte> mIndices32;
+  std::vector<Byte> mPixels;
+};
+
+// A read-only view of a .chm file that passed CookedFormat::Validate. The data pointers stay valid while the model is open.
+class CookedModel
+{
+ public:
+  CookedModel() = default;
+  NO_COPY(CookedModel)
+
+  bool Open(const CheString& fileName);
+  // Validates a cooked file already in memory, the memory must outlive the model.
+  bool Load(const Byte* data, uint64 size);
+
+  inline const CookedFormat::Header& GetHeader() const { return *mHeader; }
+  inline const CookedFormat::Draw* GetDraws() const { return reinterpret_cast<const CookedFormat::Draw*>(mData + mHeader->DrawOffset); }
+  inline const CookedFormat::Binding* GetBindings() const
+  {
+    return reinterpret_cast<const CookedFormat::Binding*>(mData + mHeader->BindingOffset);
+  }
+  inline const CookedFormat::Image* GetImages() const { return reinterpret_cast<const CookedFormat::Image*>(mData + mHeader->ImageOffset); }
+  inline const Byte* GetImagePixels(uint32 image) const { return mData + GetImages()[image].PixelOffset; }
+
+  inline const Byte* GetVertexData() const { return mData + mHeader->VertexOffset; }
+  inline const Byte* GetIndexData16() const { return mData + mHeader->Index16Offset; }
+  inline const Byte* GetIndexData32() const { return mData + mHeader->Index32Offset; }
+  inline uint64 GetVertexByteSize() const { return static_cast<uint64>(mHeader->VertexCount) * mHeader->VertexStride; }
+  inline uint64 GetIndexByteSize16() const { return static_cast<uint64>(mHeader->IndexCount16) * sizeof(uint16); }
+  inline uint64 GetIndexByteSize32() const { return static_cast<uint64>(mHeader->IndexCount32) * sizeof(uint32); }
+
+ private:
+  MappedFile mFile;
+  const Byte* mData                   = nullptr;
+  const CookedFormat::Header* mHeader = nullptr;
+};
+#endif  // MODEL_COOKED_MODEL_H
@@ -1,6 +1,8 @@
 #include "Mesh.h"
 
 #include <d3dcompiler.h>
+#include <algorithm>
+#include <cmath>
 #include "Graphics/D3DUtil.h"
 
 using namespace std;
@@ -12,7 +14,61 @@ std::vector<D3D12_INPUT_ELEMENT_DESC> Vertex::InputLayout = {
     {"TEXCOORD", 0, DXGI_FORMAT_R32G32_FLOAT, 0, 40, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
 };
 
+const std::vector<D3D12_INPUT_ELEMENT_DESC>& GetInputLayout(VertexFormat format)
+{
+  static const std::vector<D3D12_INPUT_ELEMENT_DESC> compactLayout = {
+      {"POSITION", 0, DXGI_FORMAT_R16G16B16A16_UNORM, 0, 0, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+      {"NORMAL", 0, DXGI_FORMAT_R16G16_SNORM, 0, 8, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+      {"TANGENT", 0, DXGI_FORMAT_R16G16_SNORM, 0, 12, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+      {"TEXCOORD", 0, DXGI_FORMAT_R16G16_FLOAT, 0, 16, D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA, 0},
+  };
+  return format == VertexFormat::COMPACT ? compactLayout : Vertex::InputLayout;
+}
+
 IMesh::IMesh() : IMesh(std::vector<Vertex>()) {}
 
 IMesh::IMesh(const std::vector<Vertex>& vertices) : mVertices(vertices) {}
-IMesh::IMesh(std::vector<Vertex>&& vertices) : mVertices(std::move(vertices)) {}
\ No newline at end of file
+IMesh::IMesh(std::vector<Vertex>&& vertices) : mVertices(std::move(vertices)) {}
+
+void IMesh::GetBoundingBox(DirectX::XMFLOAT3& aabbMin, DirectX::XMFLOAT3& aabbMax) const
+{
+  aabbMin = {0.0f, 0.0f, 0.0f};
+  aabbMax = {0.0f, 0.0f, 0.0f};
+  if (mVertices.empty()) return;
+
+  aabbMin = mVertices[0].Position;
+  aabbMax = mVertices[0].Position;
+  for (const Vertex& vertex : mVertices) {
+    aabbMin = {std::min<float>(aabbMin.x, vertex.Position.x), std::min<float>(aabbMin.y, vertex.Position.y), std::min<float>(aabbMin.z, vertex.Position.z)};
+    aabbMax = {std::max<float>(aabbMax.x, vertex.Position.x), std::max<float>(aabbMax.y, vertex.Position.y), std::max<float>(aabbMax.z, vertex.Position.z)};
+  }
+}
+
+void IMesh::GetBoundingSphere(DirectX::XMFLOAT3& center, float& radius) const
+{
+  center = {0.0f, 0.0f, 0.0f};
+  radius = 0.0f;
+  if (mVertices.empty()) return;
+
+  DirectX::XMFLOAT3 aabbMin;
+  DirectX::XMFLOAT3 aabbMax;
+  GetBoundingBox(aabbMin, aabbMax);
+  center = {(aabbMin.x + aabbMax.x) * 0.5f, (aabbMin.y + aabbMax.y) * 0.5f, (aabbMin.z + aabbMax.z) * 0.5f};
+
+  float radiusSq = 0.0f;
+  for (const Vertex& vertex : mVertices) {
+    const float dx = vertex.Position.x - center.x;
+    const float dy = vertex.Position.y - center.y;
+    const float dz = vertex.Position.z - center.z;
+    radiusSq       = std::max<float>(radiusSq, dx * dx + dy * dy + dz * dz);
+  }
+  radius = sqrtf(radiusSq);
+}
+
+void IMesh::BuildMeshlets(MeshletData& meshlets, uint32 maxVertices, uint32 maxTriangles) const
+{
+  std::vector<uint32> indices;
+  GetIndices(indices);
+  indices.resize(GetLod(0).IndexCount);
+  MeshletBuilder::Build(mVertices, indices, meshlets, maxVertices, maxTriangles);
+}
@@ -8,6 +8,8 @@
 #include <vector>
 
 #include "Common/TypeDef.h"
+#include "Model/CompactVertex.h"
+#include "Model/Meshlet.h"
 #include "Model/Texture2D.h"
 #include "Shader/ShaderHelper.h"
 #include "Utils/Log/Logger.h"
@@ -20,6 +22,16 @@ struct Vertex {
   static std::vector<D3D12_INPUT_ELEMENT_DESC> InputLayout;
 };
 
+// Vertex::InputLayout, or the layout of CompactVertex, which lives here so CompactVertex.h needs no d3d12.h.
+const std::vector<D3D12_INPUT_ELEMENT_DESC>& GetInputLayout(VertexFormat format);
+
+// A level of detail: an index range of the mesh and its geometric error in mesh units.
+struct MeshLod {
+  uint32 StartIndex;
+  uint32 IndexCount;
+  float Error;
+};
+
 struct Material {
   std::unordered_map<CheString, Texture2D> Textures;
 };
@@ -27,6 +39,8 @@ struct Material {
 class IMesh
 {
  public:
+  static const uint32 MAX_LODS = 8;
+
   IMesh();
   IMesh(const std::vector<Vertex>& vertices);
   IMesh(std::vector<Vertex>&& vertices);
@@ -36,7 +50,12 @@ class IMesh
   inline void SetMaterial(const Material& material) { mMaterial = material; }
   inline bool GetBlend() const { return mIsBlend; }
   inline void SetBlend(bool isBlend) { mIsBlend = isBlend; }
+  // Layout the vertices take on the GPU, the CPU copy always stays in Vertex.
+  inline VertexFormat GetVertexFormat() const { return mVertexFormat; }
+  inline void SetVertexFormat(VertexFormat format) { mVertexFormat = format; }
 
+  inline std::vector<Vertex>& GetVertices() { return mVertices; }
+  inline const std::vector<Vertex>& GetVertices() const { return mVertices; }
   inline const Byte* GetVertexByteData() const { return reinterpret_cast<const Byte*>(mVertices.data()); }
   inline uint32 GetVertexCount() const { return static_cast<uint32>(mVertices.size()); }
   inline uint32 GetVertexByteSize() const { return static_cast<uint32>(mVertices.size() * sizeof(Vertex)); }
@@ -46,12 +65,32 @@ class IMesh
   inline virtual uint32 GetIndexByteSize() const    = 0;
   inline virtual DXGI_FORMAT GetIndexFormat() const = 0;
 
+  // Index access independent of the stored index width, for CPU side processing.
+  virtual void GetIndices(std::vector<uint32>& indices) const = 0;
+  virtual void SetIndices(const std::vector<uint32>& indices) = 0;
+
+  // LOD 0 is the whole mesh until MeshSimplifier::BuildLodChain appends coarser levels to the index buffer.
+  // Index processing has to happen before that, the ranges are not updated.
+  inline uint32 GetLodCount() const { return mLods.empty() ? 1 : static_cast<uint32>(mLods.size()); }
+  inline MeshLod GetLod(uint32 lod) const { return mLods.empty() ? MeshLod{0, GetIndexCount(), 0.0f} : mLods[lod]; }
+  inline void SetLods(const std::vector<MeshLod>& lods) { mLods = lods; }
+
+  // Object space bounds of the vertices, all zero for an empty mesh.
+  void GetBoundingBox(DirectX::XMFLOAT3& aabbMin, DirectX::XMFLOAT3& aabbMax) const;
+  void GetBoundingSphere(DirectX::XMFLOAT3& center, float& radius) const;
+
+  // Splits LOD 0 into meshlets in index order, see MeshletBuilder::Build.
+  void BuildMeshlets(MeshletData& meshlets, uint32 maxVertices = MeshletBuilder::DEFAULT_MAX_VERTICES,
+                     uint32 maxTriangles = MeshletBuilder::DEFAULT_MAX_TRIANGLES) const;
+
  protected:
   std::vector<Vertex> mVertices;
+  std::vector<MeshLod> mLods;
 
   Material mMaterial;
 
-  bool mIsBlend = false;
+  bool mIsBlend              = false;
+  VertexFormat mVertexFormat = VertexFormat::STANDARD;
 };
 
 // The Mesh class supports different index lengths.
@@ -74,6 +113,15 @@ class Mesh : public IMesh
     }
   }
 
+  inline virtual void GetIndices(std::vector<uint32>& indices) const override { indices.assign(mIndices.begin(), mIndices.end()); }
+  inline virtual void SetIndices(const std::vector<uint32>& indices) override
+  {
+    mIndices.resize(indices.size());
+    for (size_t i = 0; i < indices.size(); i++) {
+      mIndices[i] = static_cast<IndexType>(indices[i]);
+    }
+  }
+
  private:
   inline virtual uint32 GetIndexByteSize() const override { return static_cast<uint32>(mIndices.size() * sizeof(IndexType)); }
 
@@ -0,0 +1,281 @@
+#include "MeshOptimizer.h"
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+const uint32 INVALID_INDEX = ~0u;
+
+// Forsyth scoring, see "Linear-Speed Vertex Cache Optimisation".
+const float CACHE_DECAY_POWER   = 1.5f;
+const float LAST_TRI_SCORE      = 0.75f;
+const float VALENCE_BOOST_SCALE = 2.0f;
+const float VALENCE_BOOST_POWER = 0.5f;
+
+float VertexScore(int32 cachePosition, uint32 liveTriangles)
+{
+  // No triangles left to draw, the vertex is of no use any more.
+  if (liveTriangles == 0) return -1.0f;
+
+  float score = 0.0f;
+  if (cachePosition >= 0) {
+    if (cachePosition < 3) {
+      // Vertices of the last triangle get a fixed score, so the next triangle does not simply reuse them.
+      score = LAST_TRI_SCORE;
+    } else {
+      const float scaler = 1.0f / (MeshOptimizer::CACHE_SIZE - 3);
+      score              = powf(1.0f - (cachePosition - 3) * scaler, CACHE_DECAY_POWER);
+    }
+  }
+  // Boost vertices with few triangles left, so lone triangles are not left for last.
+  score += VALENCE_BOOST_SCALE * powf(static_cast<float>(liveTriangles), -VALENCE_BOOST_POWER);
+  return score;
+}
+}  // namespace
+
+// std::min takes its arguments by reference, which needs the constants defined.
+const uint32 MeshOptimizer::CACHE_SIZE;
+const uint32 MeshOptimizer::UNUSED_VERTEX;
+
+bool MeshOptimizer::ValidateIndices(const std::vector<uint32>& indices, uint32 vertexCount)
+{
+  for (uint32 index : indices) {
+    if (index >= vertexCount) return false;
+  }
+  return true;
+}
+
+void MeshOptimizer::OptimizeVertexCache(std::vector<uint32>& indices, uint32 vertexCount)
+{
+  const uint32 triangleCount = static_cast<uint32>(indices.size() / 3);
+  if (triangleCount == 0) return;
+  if (!ValidateIndices(indices, vertexCount)) return;
+
+  // Vertex to triangle adjacency. The live triangles of vertex v are
+  // adjacency[adjacencyOffset[v], adjacencyOffset[v] + liveTriangles[v]).
+  std::vector<uint32> liveTriangles(vertexCount, 0);
+  for (uint32 index : indices) {
+    liveTriangles[index]++;
+  }
+
+  std::vector<uint32> adjacencyOffset(vertexCount, 0);
+  for (uint32 v = 1; v < vertexCount; v++) {
+    adjacencyOffset[v] = adjacencyOffset[v - 1] + liveTriangles[v - 1];
+  }
+
+  std::vector<uint32> adjacency(indices.size());
+  std::vector<uint32> fillCursor = adjacencyOffset;
+  for (uint32 t = 0; t < triangleCount; t++) {
+    for (uint32 k = 0; k < 3; k++) {
+      adjacency[fillCursor[indices[t * 3 + k]]++] = t;
+    }
+  }
+
+  std::vector<int32> cachePosition(vertexCount, -1);
+  std::vector<float> vertexScore(vertexCount);
+  for (uint32 v = 0; v < vertexCount; v++) {
+    vertexScore[v] = VertexScore(-1, liveTriangles[v]);
+  }
+
+  std::vector<float> triangleScore(triangleCount);
+  std::vector<bool> isEmitted(triangleCount, false);
+  uint32 bestTriangle = 0;
+  for (uint32 t = 0; t < triangleCount; t++) {
+    triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+    if (triangleScore[t] > triangleScore[bestTriangle]) bestTriangle = t;
+  }
+
+  // The simulated LRU cache. It holds up to three extra entries while a triangle pushes vertices out.
+  uint32 cache[CACHE_SIZE + 3];
+  uint32 cacheCount = 0;
+
+  std::vector<uint32> output;
+  output.reserve(indices.size());
+  uint32 inputCursor = 0;
+
+  while (bestTriangle != INVALID_INDEX) {
+    const uint32* triangle = &indices[bestTriangle * 3];
+    isEmitted[bestTriangle] = true;
+
+    for (uint32 k = 0; k < 3; k++) {
+      const uint32 v = triangle[k];
+      output.push_back(v);
+
+      // Drop the triangle from the vertex's live list.
+      uint32* live = &adjacency[adjacencyOffset[v]];
+      for (uint32 i = 0; i < liveTriangles[v]; i++) {
+        if (live[i] == bestTriangle) {
+          std::swap(live[i], live[liveTriangles[v] - 1]);
+          liveTriangles[v]--;
+          break;
+        }
+      }
+    }
+
+    // Move the triangle's vertices to the front of the cache.
+    uint32 newCache[CACHE_SIZE + 3];
+    uint32 newCacheCount = 0;
+    for (uint32 k = 0; k < 3; k++) {
+      const uint32 v = triangle[k];
+      if (std::find(newCache, newCache + newCacheCount, v) == newCache + newCacheCount) newCache[newCacheCount++] = v;
+    }
+    for (uint32 i = 0; i < cacheCount; i++) {
+      const uint32 v = cache[i];
+      if (v != triangle[0] && v != triangle[1] && v != triangle[2]) newCache[newCacheCount++] = v;
+    }
+
+    for (uint32 i = 0; i < newCacheCount; i++) {
+      const uint32 v   = newCache[i];
+      cachePosition[v] = i < CACHE_SIZE ? static_cast<int32>(i) : -1;
+      vertexScore[v]   = VertexScore(cachePosition[v], liveTriangles[v]);
+    }
+
+    // Only triangles touching the cache changed score, pick the best of them.
+    bestTriangle    = INVALID_INDEX;
+    float bestScore = -1.0f;
+    for (uint32 i = 0; i < newCacheCount; i++) {
+      const uint32 v     = newCache[i];
+      const uint32* live = &adjacency[adjacencyOffset[v]];
+      for (uint32 j = 0; j < liveTriangles[v]; j++) {
+        const uint32 t   = live[j];
+        triangleScore[t] = vertexScore[indices[t * 3]] + vertexScore[indices[t * 3 + 1]] + vertexScore[indices[t * 3 + 2]];
+        if (triangleScore[t] > bestScore) {
+          bestScore    = triangleScore[t];
+          bestTriangle = t;
+        }
+      }
+    }
+
+    cacheCount = std::min<uint32>(newCacheCount, CACHE_SIZE);
+    std::copy(newCache, newCache + cacheCount, cache);
+
+    // Nothing in the cache is connected to what is left, restart from the first triangle not drawn yet.
+    if (bestTriangle == INVALID_INDEX) {
+      while (inputCursor < triangleCount && isEmitted[inputCursor]) inputCursor++;
+      if (inputCursor < triangleCount) bestTriangle = inputCursor;
+    }
+  }
+
+  indices.swap(output);
+}
+
+void MeshOptimizer::OptimizeOverdraw(std::vector<uint32>& indices, const PositionStream& positions, float threshold)
+{
+  const uint32 triangleCount = static_cast<uint32>(indices.size() / 3);
+  if (triangleCount == 0 || positions.Count == 0) return;
+
+  // Cache misses of every triangle in the current order.
+  std::vector<uint32> cacheTime(positions.Count, 0);
+  std::vector<uint32> triangleMisses(triangleCount, 0);
+  uint32 time        = CACHE_SIZE + 1;
+  uint32 totalMisses = 0;
+  for (uint32 t = 0; t < triangleCount; t++) {
+    for (uint32 k = 0; k < 3; k++) {
+      const uint32 v = indices[t * 3 + k];
+      if (time - cacheTime[v] > CACHE_SIZE) {
+        cacheTime[v] = time++;
+        triangleMisses[t]++;
+      }
+    }
+    totalMisses += triangleMisses[t];
+  }
+  const float meshAcmr = static_cast<float>(totalMisses) / triangleCount;
+
+  // Cut where the cache restarts anyway (a triangle with three new vertices), as long as the
+  // cluster so far stays within threshold of the mesh ACMR. Reordering such clusters costs few extra misses.
+  std::vector<uint32> clusterStarts(1, 0);
+  uint32 clusterMisses = 0;
+  for (uint32 t = 0; t < triangleCount; t++) {
+    const uint32 clusterSize = t - clusterStarts.back();
+    if (clusterSize > 0 && triangleMisses[t] == 3 && clusterMisses <= threshold * meshAcmr * clusterSize) {
+      clusterStarts.push_back(t);
+      clusterMisses = 0;
+    }
+    clusterMisses += triangleMisses[t];
+  }
+  if (clusterStarts.size() < 2) return;
+  clusterStarts.push_back(triangleCount);
+
+  Float3 center;
+  for (uint32 v = 0; v < positions.Count; v++) {
+    center = Add(center, positions[v]);
+  }
+  center = Scale(center, 1.0f / positions.Count);
+
+  struct Cluster {
+    uint32 Start;
+    uint32 End;
+    float SortKey;
+  };
+  std::vector<Cluster> clusters(clusterStarts.size() - 1);
+
+  for (uint32 c = 0; c < clusters.size(); c++) {
+    Float3 areaCenter;
+    Float3 normal;
+    float totalArea = 0.0f;
+    for (uint32 t = clusterStarts[c]; t < clusterStarts[c + 1]; t++) {
+      const Float3 p0 = positions[indices[t * 3]];
+      const Float3 p1 = positions[indices[t * 3 + 1]];
+      const Float3 p2 = positions[indices[t * 3 + 2]];
+
+      // Length of the cross product is twice the area, so summing it area weights the normal.
+      const Float3 faceNormal = Cross(Sub(p1, p0), Sub(p2, p0));
+      const float area        = Length(faceNormal);
+
+      areaCenter = Add(areaCenter, Scale(Add(Add(p0, p1), p2), area / 3.0f));
+      normal     = Add(normal, faceNormal);
+      totalArea += area;
+    }
+
+    const float normalLength = Length(normal);
+    float sortKey            = 0.0f;
+    if (totalArea > 0.0f && normalLength > 0.0f) {
+      const Float3 offset = Sub(Scale(areaCenter, 1.0f / totalArea), center);
+      sortKey             = Dot(offset, normal) / normalLength;
+    }
+    clusters[c] = {clusterStarts[c], clusterStarts[c + 1], sortKey};
+  }
+
+  // Clusters facing away from the center tend to occlude the rest, draw them first.
+  std::stable_sort(clusters.begin(), clusters.end(), [](const Cluster& a, const Cluster& b) { return a.SortKey > b.SortKey; });
+
+  std::vector<uint32> output;
+  output.reserve(indices.size());
+  for (const Cluster& cluster : clusters) {
+    output.insert(output.end(), indices.begin() + cluster.Start * 3, indices.begin() + cluster.End * 3);
+  }
+  indices.swap(output);
+}
+
+uint32 MeshOptimizer::OptimizeVertexFetch(std::vector<uint32>& indices, uint32 vertexCount, std::vector<uint32>& remap)
+{
+  remap.assign(vertexCount, UNUSED_VERTEX);
+  uint32 nextVertex = 0;
+  for (uint32& index : indices) {
+    if (remap[index] == UNUSED_VERTEX) remap[index] = nextVertex++;
+    index = remap[index];
+  }
+  return nextVertex;
+}
+
+VertexCacheStats MeshOptimizer::AnalyzeVertexCache(const std::vector<uint32>& indices, uint32 vertexCount, uint32 cacheSize)
+{
+  VertexCacheStats stats;
+  stats.TriangleCount = static_cast<uint32>(indices.size() / 3);
+
+  // FIFO cache: a vertex is a hit while fewer than cacheSize misses happened since it was loaded.
+  std::vector<uint32> cacheTime(vertexCount, 0);
+  std::vector<bool> isReferenced(vertexCount, false);
+  uint32 time = cacheSize + 1;
+  for (uint32 index : indices) {
+    if (time - cacheTime[index] > cacheSize) {
+      cacheTime[index] = time++;
+      stats.Misses++;
+    }
+    if (!isReferenced[index]) {
+      isReferenced[index] = true;
+      stats.VertexCount++;
+    }
+  }
+  return stats;
+}
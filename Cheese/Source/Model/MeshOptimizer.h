@@ -0,0 +1,63 @@
+#ifndef MODEL_MESH_OPTIMIZER_H
+#define MODEL_MESH_OPTIMIZER_H
+#include <cstring>
+#include <vector>
+#include "Common/Types.h"
+#include "Math/Vector.h"
+
+// Post-transform vertex cache behaviour of an index buffer.
+// ACMR: cache misses per triangle, ATVR: cache misses per referenced vertex (1.0 is optimal).
+struct VertexCacheStats {
+  uint32 TriangleCount = 0;
+  uint32 VertexCount   = 0;
+  uint32 Misses        = 0;
+
+  inline float GetAcmr() const { return TriangleCount == 0 ? 0.0f : static_cast<float>(Misses) / TriangleCount; }
+  inline float GetAtvr() const { return VertexCount == 0 ? 0.0f : static_cast<float>(Misses) / VertexCount; }
+
+  inline void Add(const VertexCacheStats& rhs)
+  {
+    TriangleCount += rhs.TriangleCount;
+    VertexCount += rhs.VertexCount;
+    Misses += rhs.Misses;
+  }
+};
+
+// Vertex positions read in place from any vertex layout: three floats at Data + i * Stride.
+struct PositionStream {
+  const Byte* Data = nullptr;
+  uint32 Stride    = 0;
+  uint32 Count     = 0;
+
+  inline Float3 operator[](uint32 i) const
+  {
+    float position[3];
+    memcpy(position, Data + static_cast<uint64>(i) * Stride, sizeof(position));
+    return {position[0], position[1], position[2]};
+  }
+};
+
+// CPU side reordering of triangle list indices and vertices. Everything is deterministic.
+// Works on plain index buffers and positions, MeshOptimizerAdapter runs it on an IMesh.
+class MeshOptimizer
+{
+ public:
+  // Cache size the triangle order is tuned for, and the FIFO size the stats are simulated with.
+  static const uint32 CACHE_SIZE = 32;
+  // remap entry of a vertex no triangle references.
+  static const uint32 UNUSED_VERTEX = ~0u;
+
+  // True if every index is below vertexCount. The passes below index per vertex arrays with them unchecked.
+  static bool ValidateIndices(const std::vector<uint32>& indices, uint32 vertexCount);
+
+  // Tom Forsyth's linear-speed vertex cache optimization. Leaves indices untouched if ValidateIndices fails.
+  static void OptimizeVertexCache(std::vector<uint32>& indices, uint32 vertexCount);
+  // Splits the cache optimized order into clusters and draws outward facing clusters first.
+  // threshold bounds how much ACMR may grow to get more, smaller clusters.
+  static void OptimizeOverdraw(std::vector<uint32>& indices, const PositionStream& positions, float threshold = 1.05f);
+  // Renumbers vertices by first use. remap[old vertex] is the new one, or UNUSED_VERTEX. Returns the used vertex count.
+  static uint32 OptimizeVertexFetch(std::vector<uint32>& indices, uint32 vertexCount, std::vector<uint32>& remap);
+
+  static VertexCacheStats AnalyzeVertexCache(const std::vector<uint32>& indices, uint32 vertexCount, uint32 cacheSize = CACHE_SIZE);
+};
+#endif  // MODEL_MESH_OPTIMIZER_H
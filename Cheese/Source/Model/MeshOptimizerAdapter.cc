@@ -0,0 +1,39 @@
+#include "MeshOptimizerAdapter.h"
+
+#include <cstddef>
+
+bool MeshOptimizerAdapter::Optimize(IMesh* mesh, VertexCacheStats* before, VertexCacheStats* after)
+{
+  std::vector<uint32> indices;
+  mesh->GetIndices(indices);
+  std::vector<Vertex>& vertices = mesh->GetVertices();
+  if (!MeshOptimizer::ValidateIndices(indices, mesh->GetVertexCount())) return false;
+
+  if (before != nullptr) *before = MeshOptimizer::AnalyzeVertexCache(indices, mesh->GetVertexCount());
+
+  // Only triangle lists are handled.
+  if (indices.size() % 3 == 0) {
+    MeshOptimizer::OptimizeVertexCache(indices, mesh->GetVertexCount());
+    MeshOptimizer::OptimizeOverdraw(indices, GetPositions(vertices));
+
+    std::vector<uint32> remap;
+    std::vector<Vertex> reordered(MeshOptimizer::OptimizeVertexFetch(indices, mesh->GetVertexCount(), remap));
+    for (uint32 v = 0; v < remap.size(); v++) {
+      if (remap[v] != MeshOptimizer::UNUSED_VERTEX) reordered[remap[v]] = vertices[v];
+    }
+    vertices.swap(reordered);
+    mesh->SetIndices(indices);
+  }
+
+  if (after != nullptr) *after = MeshOptimizer::AnalyzeVertexCache(indices, mesh->GetVertexCount());
+  return true;
+}
+
+PositionStream MeshOptimizerAdapter::GetPositions(const std::vector<Vertex>& vertices)
+{
+  PositionStream positions;
+  positions.Data   = reinterpret_cast<const Byte*>(vertices.data()) + offsetof(Vertex, Position);
+  positions.Stride = sizeof(Vertex);
+  positions.Count  = static_cast<uint32>(vertices.size());
+  return positions;
+}
@@ -0,0 +1,17 @@
+#ifndef MODEL_MESH_OPTIMIZER_ADAPTER_H
+#define MODEL_MESH_OPTIMIZER_ADAPTER_H
+#include "Common/TypeDef.h"
+#include "Mesh.h"
+#include "MeshOptimizer.h"
+
+// Runs the MeshOptimizer passes on the indices and Vertex array of an IMesh.
+class MeshOptimizerAdapter
+{
+ public:
+  // Vertex cache, overdraw and vertex fetch order in one go. Triangle lists only, other meshes are only analyzed.
+  // Returns false and leaves the mesh untouched if an index is out of range.
+  static bool Optimize(IMesh* mesh, VertexCacheStats* before = nullptr, VertexCacheStats* after = nullptr);
+
+  static PositionStream GetPositions(const std::vector<Vertex>& vertices);
+};
+#endif  // MODEL_MESH_OPTIMIZER_ADAPTER_H
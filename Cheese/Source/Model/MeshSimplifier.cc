@@ -0,0 +1,285 @@
+#include "MeshSimplifier.h"
+
+#include <algorithm>
+#include <cfloat>
+#include <cmath>
+#include <cstring>
+#include <unordered_set>
+#include "MeshOptimizer.h"
+#include "Math/Vector.h"
+
+namespace {
+// Sum of squared distances to a set of area weighted planes.
+struct Quadric {
+  float A00 = 0.0f, A11 = 0.0f, A22 = 0.0f;
+  float A01 = 0.0f, A02 = 0.0f, A12 = 0.0f;
+  float B0 = 0.0f, B1 = 0.0f, B2 = 0.0f;
+  float C      = 0.0f;
+  float Weight = 0.0f;
+
+  void AddPlane(const Float3& n, float d, float weight)
+  {
+    A00 += weight * n.x * n.x;
+    A11 += weight * n.y * n.y;
+    A22 += weight * n.z * n.z;
+    A01 += weight * n.x * n.y;
+    A02 += weight * n.x * n.z;
+    A12 += weight * n.y * n.z;
+    B0 += weight * n.x * d;
+    B1 += weight * n.y * d;
+    B2 += weight * n.z * d;
+    C += weight * d * d;
+    Weight += weight;
+  }
+
+  void Add(const Quadric& q)
+  {
+    A00 += q.A00;
+    A11 += q.A11;
+    A22 += q.A22;
+    A01 += q.A01;
+    A02 += q.A02;
+    A12 += q.A12;
+    B0 += q.B0;
+    B1 += q.B1;
+    B2 += q.B2;
+    C += q.C;
+    Weight += q.Weight;
+  }
+
+  // Mean squared distance of p to the planes.
+  float Evaluate(const Float3& p) const
+  {
+    const float error = A00 * p.x * p.x + A11 * p.y * p.y + A22 * p.z * p.z + 2.0f * (A01 * p.x * p.y + A02 * p.x * p.z + A12 * p.y * p.z) +
+                        2.0f * (B0 * p.x + B1 * p.y + B2 * p.z) + C;
+    return Weight > 0.0f ? std::max<float>(error, 0.0f) / Weight : 0.0f;
+  }
+};
+
+struct Collapse {
+  uint32 From;
+  uint32 To;
+  float Error;
+};
+
+// Maps every vertex to the first vertex at the same position.
+void BuildPositionRemap(const std::vector<Vertex>& vertices, std::vector<uint32>& remap)
+{
+  const uint32 vertexCount = static_cast<uint32>(vertices.size());
+  std::vector<uint32> order(vertexCount);
+  for (uint32 i = 0; i < vertexCount; i++) order[i] = i;
+
+  auto less = [&](uint32 a, uint32 b) {
+    const int cmp = memcmp(&vertices[a].Position, &vertices[b].Position, sizeof(DirectX::XMFLOAT3));
+    return cmp != 0 ? cmp < 0 : a < b;
+  };
+  std::sort(order.begin(), order.end(), less);
+
+  remap.resize(vertexCount);
+  for (uint32 i = 0; i < vertexCount; i++) {
+    const bool isSame = i > 0 && memcmp(&vertices[order[i]].Position, &vertices[order[i - 1]].Position, sizeof(DirectX::XMFLOAT3)) == 0;
+    remap[order[i]]   = isSame ? remap[order[i - 1]] : order[i];
+  }
+}
+
+// Locks vertices shared by several attribute sets (seams) and vertices on open edges (borders).
+void BuildLocks(const std::vector<uint32>& indices, const std::vector<uint32>& positionRemap, std::vector<uint8>& isLocked)
+{
+  const uint32 vertexCount = static_cast<uint32>(positionRemap.size());
+  std::vector<uint32> positionUsers(vertexCount, 0);
+  for (uint32 v = 0; v < vertexCount; v++) {
+    positionUsers[positionRemap[v]]++;
+  }
+
+  std::unordered_set<uint64> edges;
+  edges.reserve(indices.size());
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    for (uint32 e = 0; e < 3; e++) {
+      const uint64 a = positionRemap[indices[i + e]];
+      const uint64 b = positionRemap[indices[i + (e + 1) % 3]];
+      edges.insert((a << 32) | b);
+    }
+  }
+
+  // An edge without its twin is open, both its positions are locked.
+  std::vector<uint8> isBorderPosition(vertexCount, 0);
+  for (uint64 edge : edges) {
+    const uint64 twin = (edge << 32) | (edge >> 32);
+    if (edges.find(twin) == edges.end()) {
+      isBorderPosition[edge >> 32]        = 1;
+      isBorderPosition[edge & 0xFFFFFFFF] = 1;
+    }
+  }
+
+  isLocked.resize(vertexCount);
+  for (uint32 v = 0; v < vertexCount; v++) {
+    const uint32 position = positionRemap[v];
+    isLocked[v]           = positionUsers[position] > 1 || isBorderPosition[position] != 0;
+  }
+}
+
+// Collapsing from onto to must not turn any remaining triangle of from around.
+bool IsFlipFree(const std::vector<Vertex>& vertices, const std::vector<uint32>& indices, const std::vector<uint32>& triangleOffsets,
+                const std::vector<uint32>& vertexTriangles, uint32 from, uint32 to)
+{
+  const Float3 target = ToFloat3(vertices[to].Position);
+  for (uint32 t = triangleOffsets[from]; t < triangleOffsets[from + 1]; t++) {
+    const uint32* corners = &indices[vertexTriangles[t] * 3];
+    if (corners[0] == to || corners[1] == to || corners[2] == to) continue;
+
+    const Float3 p0 = ToFloat3(vertices[corners[0]].Position);
+    const Float3 p1 = ToFloat3(vertices[corners[1]].Position);
+    const Float3 p2 = ToFloat3(vertices[corners[2]].Position);
+    const Float3 q0 = corners[0] == from ? target : p0;
+    const Float3 q1 = corners[1] == from ? target : p1;
+    const Float3 q2 = corners[2] == from ? target : p2;
+
+    if (Dot(Cross(Sub(p1, p0), Sub(p2, p0)), Cross(Sub(q1, q0), Sub(q2, q0))) <= 0.0f) return false;
+  }
+  return true;
+}
+}  // namespace
+
+float MeshSimplifier::Simplify(const std::vector<Vertex>& vertices, const std::vector<uint32>& indices, uint32 targetIndexCount, float maxError,
+                               std::vector<uint32>& result)
+{
+  const uint32 vertexCount = static_cast<uint32>(vertices.size());
+  result.assign(indices.begin(), indices.end());
+  if (vertexCount == 0 || result.size() <= targetIndexCount) return 0.0f;
+
+  std::vector<uint32> positionRemap;
+  std::vector<uint8> isLocked;
+  BuildPositionRemap(vertices, positionRemap);
+  BuildLocks(result, positionRemap, isLocked);
+
+  std::vector<Quadric> quadrics(vertexCount);
+  for (size_t i = 0; i < result.size(); i += 3) {
+    const Float3 p0     = ToFloat3(vertices[result[i]].Position);
+    const Float3 normal = Cross(Sub(ToFloat3(vertices[result[i + 1]].Position), p0), Sub(ToFloat3(vertices[result[i + 2]].Position), p0));
+    const float length  = Length(normal);
+    if (length == 0.0f) continue;
+
+    const Float3 unitNormal = Scale(normal, 1.0f / length);
+    for (uint32 c = 0; c < 3; c++) {
+      quadrics[result[i + c]].AddPlane(unitNormal, -Dot(unitNormal, p0), length * 0.5f);
+    }
+  }
+
+  const float maxErrorSq = maxError * maxError;
+  float resultErrorSq    = 0.0f;
+
+  std::vector<uint32> triangleOffsets(vertexCount + 1);
+  std::vector<uint32> vertexTriangles;
+  std::vector<Collapse> collapses;
+  std::vector<uint32> collapseTarget(vertexCount);
+  std::vector<uint8> isTouched(vertexCount);
+
+  while (result.size() > targetIndexCount) {
+    const uint32 triangleCount = static_cast<uint32>(result.size() / 3);
+
+    // Vertex to triangle adjacency of the current result.
+    std::fill(triangleOffsets.begin(), triangleOffsets.end(), 0);
+    for (uint32 index : result) triangleOffsets[index + 1]++;
+    for (uint32 v = 0; v < vertexCount; v++) triangleOffsets[v + 1] += triangleOffsets[v];
+    vertexTriangles.resize(result.size());
+    std::vector<uint32> cursor(triangleOffsets.begin(), triangleOffsets.end() - 1);
+    for (uint32 t = 0; t < triangleCount; t++) {
+      for (uint32 c = 0; c < 3; c++) vertexTriangles[cursor[result[t * 3 + c]]++] = t;
+    }
+
+    // One candidate per edge, in its cheaper direction. The twin triangle sees the edge reversed and skips it.
+    collapses.clear();
+    for (uint32 i = 0; i < result.size(); i += 3) {
+      for (uint32 e = 0; e < 3; e++) {
+        const uint32 a = result[i + e];
+        const uint32 b = result[i + (e + 1) % 3];
+        if (a > b || (isLocked[a] && isLocked[b])) continue;
+
+        const float errorAB = isLocked[a] ? FLT_MAX : quadrics[a].Evaluate(ToFloat3(vertices[b].Position));
+        const float errorBA = isLocked[b] ? FLT_MAX : quadrics[b].Evaluate(ToFloat3(vertices[a].Position));
+        collapses.push_back(errorAB <= errorBA ? Collapse{a, b, errorAB} : Collapse{b, a, errorBA});
+      }
+    }
+    std::sort(collapses.begin(), collapses.end(), [](const Collapse& lhs, const Collapse& rhs) { return lhs.Error < rhs.Error; });
+
+    // Every collapse removes about two triangles, stop the pass around the target and re-evaluate.
+    const uint32 collapseGoal = std::max<uint32>((static_cast<uint32>(result.size()) - targetIndexCount) / 6, 1);
+    uint32 collapseCount      = 0;
+
+    for (uint32 v = 0; v < vertexCount; v++) collapseTarget[v] = v;
+    std::fill(isTouched.begin(), isTouched.end(), 0);
+
+    for (const Collapse& collapse : collapses) {
+      if (collapse.Error > maxErrorSq || collapseCount >= collapseGoal) break;
+      if (isTouched[collapse.From] || isTouched[collapse.To]) continue;
+      if (!IsFlipFree(vertices, result, triangleOffsets, vertexTriangles, collapse.From, collapse.To)) continue;
+
+      collapseTarget[collapse.From] = collapse.To;
+      quadrics[collapse.To].Add(quadrics[collapse.From]);
+      resultErrorSq = std::max<float>(resultErrorSq, collapse.Error);
+
+      // Triangles around the collapse changed, nothing else in their fan may collapse in this pass.
+      for (uint32 t = triangleOffsets[collapse.From]; t < triangleOffsets[collapse.From + 1]; t++) {
+        const uint32* corners = &result[vertexTriangles[t] * 3];
+        isTouched[corners[0]] = isTouched[corners[1]] = isTouched[corners[2]] = 1;
+      }
+      collapseCount++;
+    }
+    if (collapseCount == 0) break;
+
+    // Apply the collapses and drop the triangles that became degenerate.
+    size_t writeIndex = 0;
+    for (size_t i = 0; i < result.size(); i += 3) {
+      const uint32 a = collapseTarget[result[i]];
+      const uint32 b = collapseTarget[result[i + 1]];
+      const uint32 c = collapseTarget[result[i + 2]];
+      if (a == b || b == c || c == a) continue;
+
+      result[writeIndex++] = a;
+      result[writeIndex++] = b;
+      result[writeIndex++] = c;
+    }
+    result.resize(writeIndex);
+  }
+
+  return sqrtf(resultErrorSq);
+}
+
+uint32 MeshSimplifier::BuildLodChain(IMesh* mesh, const LodChainOptions& options)
+{
+  std::vector<uint32> indices;
+  mesh->GetIndices(indices);
+  indices.resize(mesh->GetLod(0).IndexCount);
+
+  DirectX::XMFLOAT3 center;
+  float radius;
+  mesh->GetBoundingSphere(center, radius);
+
+  std::vector<MeshLod> lods = {{0, static_cast<uint32>(indices.size()), 0.0f}};
+  std::vector<uint32> allIndices(indices);
+  std::vector<uint32> levelIndices;
+
+  const uint32 maxLods = std::min<uint32>(options.MaxLods, IMesh::MAX_LODS);
+  while (lods.size() < maxLods) {
+    const MeshLod previous        = lods.back();
+    const uint32 targetIndexCount = static_cast<uint32>(previous.IndexCount * options.Reduction) / 3 * 3;
+
+    // Each level starts from the one before, so its error stacks on top of the previous error.
+    const float errorBudget = options.MaxError * radius - previous.Error;
+    if (errorBudget <= 0.0f) break;
+
+    const float error = Simplify(mesh->GetVertices(), indices, targetIndexCount, errorBudget, levelIndices);
+    if (levelIndices.empty() || levelIndices.size() > previous.IndexCount * options.MaxKeptRatio) break;
+
+    MeshOptimizer::OptimizeVertexCache(levelIndices, mesh->GetVertexCount());
+    lods.push_back({static_cast<uint32>(allIndices.size()), static_cast<uint32>(levelIndices.size()), previous.Error + error});
+    allIndices.insert(allIndices.end(), levelIndices.begin(), levelIndices.end());
+    indices.swap(levelIndices);
+  }
+
+  if (lods.size() > 1) {
+    mesh->SetIndices(allIndices);
+    mesh->SetLods(lods);
+  }
+  return static_cast<uint32>(lods.size());
+}
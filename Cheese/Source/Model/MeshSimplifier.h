@@ -0,0 +1,33 @@
+#ifndef MODEL_MESH_SIMPLIFIER_H
+#define MODEL_MESH_SIMPLIFIER_H
+#include <vector>
+#include "Common/TypeDef.h"
+#include "Mesh.h"
+
+struct LodChainOptions {
+  // Levels including LOD 0, at most IMesh::MAX_LODS.
+  uint32 MaxLods = 4;
+  // Index count of every level relative to the one before it.
+  float Reduction = 0.5f;
+  // Largest error a level may reach, relative to the mesh bounding radius.
+  float MaxError = 0.05f;
+  // The chain stops once a level would keep more than this share of the previous level's indices.
+  float MaxKeptRatio = 0.85f;
+};
+
+// Quadric error metric simplification by half edge collapse.
+// Vertices are never moved or created, every level indexes the vertex buffer of the source mesh.
+class MeshSimplifier
+{
+ public:
+  // Collapses edges until the index count reaches targetIndexCount or the next collapse would exceed maxError.
+  // Border vertices and vertices on attribute seams are locked, so UVs and normals stay continuous.
+  // Returns the geometric error of the result in mesh units.
+  static float Simplify(const std::vector<Vertex>& vertices, const std::vector<uint32>& indices, uint32 targetIndexCount, float maxError,
+                        std::vector<uint32>& result);
+
+  // Simplifies the mesh level by level, appends every level to the index buffer and records them as mesh LODs.
+  // Run it after welding and optimization. Returns the number of levels including LOD 0.
+  static uint32 BuildLodChain(IMesh* mesh, const LodChainOptions& options = LodChainOptions());
+};
+#endif  // MODEL_MESH_SIMPLIFIER_H
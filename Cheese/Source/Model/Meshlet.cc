@@ -0,0 +1,196 @@
+#include "Meshlet.h"
+
+#include <algorithm>
+#include <cmath>
+#include "Core/Camera.h"
+#include "Math/Vector.h"
+#include "Model/Mesh.h"
+
+namespace {
+const uint8 INVALID_LOCAL_INDEX = 0xFF;
+
+// Normal spread beyond which a cone cannot reject anything useful.
+const float MIN_CONE_DOT = 0.1f;
+}  // namespace
+
+// std::min takes its arguments by reference, which needs the limits defined.
+const uint32 MeshletBuilder::MAX_VERTICES_LIMIT;
+const uint32 MeshletBuilder::MAX_TRIANGLES_LIMIT;
+
+void MeshletBuilder::Build(const std::vector<Vertex>& vertices, const std::vector<uint32>& indices, MeshletData& meshlets, uint32 maxVertices,
+                           uint32 maxTriangles)
+{
+  maxVertices  = std::min<uint32>(std::max<uint32>(maxVertices, 3), MAX_VERTICES_LIMIT);
+  maxTriangles = std::min<uint32>(std::max<uint32>(maxTriangles, 1), MAX_TRIANGLES_LIMIT);
+
+  meshlets.Meshlets.clear();
+  meshlets.Bounds.clear();
+  meshlets.Vertices.clear();
+  meshlets.Triangles.clear();
+
+  const uint32 triangleCount = static_cast<uint32>(indices.size() / 3);
+  meshlets.Triangles.reserve(triangleCount * 3);
+
+  // Local index of every mesh vertex in the meshlet being filled.
+  std::vector<uint8> localIndices(vertices.size(), INVALID_LOCAL_INDEX);
+  Meshlet current = {0, 0, 0, 0};
+
+  auto flush = [&]() {
+    for (uint32 i = 0; i < current.VertexCount; i++) {
+      localIndices[meshlets.Vertices[current.VertexOffset + i]] = INVALID_LOCAL_INDEX;
+    }
+    meshlets.Meshlets.push_back(current);
+    meshlets.Bounds.push_back(ComputeBounds(vertices, indices, current.TriangleOffset, current.TriangleCount));
+
+    current.VertexOffset   = static_cast<uint32>(meshlets.Vertices.size());
+    current.VertexCount    = 0;
+    current.TriangleOffset = current.TriangleOffset + current.TriangleCount;
+    current.TriangleCount  = 0;
+  };
+
+  for (uint32 t = 0; t < triangleCount; t++) {
+    const uint32* corners = &indices[t * 3];
+
+    // Repeated corners of degenerate triangles are counted twice, that only closes the meshlet a little early.
+    const uint32 newVertices = (localIndices[corners[0]] == INVALID_LOCAL_INDEX) + (localIndices[corners[1]] == INVALID_LOCAL_INDEX) +
+                               (localIndices[corners[2]] == INVALID_LOCAL_INDEX);
+    if (current.VertexCount + newVertices > maxVertices || current.TriangleCount == maxTriangles) {
+      flush();
+    }
+
+    for (uint32 c = 0; c < 3; c++) {
+      uint8& local = localIndices[corners[c]];
+      if (local == INVALID_LOCAL_INDEX) {
+        local = static_cast<uint8>(current.VertexCount++);
+        meshlets.Vertices.push_back(corners[c]);
+      }
+      meshlets.Triangles.push_back(local);
+    }
+    current.TriangleCount++;
+  }
+
+  if (current.TriangleCount > 0) {
+    flush();
+  }
+}
+
+MeshletBounds MeshletBuilder::ComputeBounds(const std::vector<Vertex>& vertices, const std::vector<uint32>& indices, uint32 firstTriangle,
+                                            uint32 triangleCount)
+{
+  MeshletBounds bounds = {};
+  if (triangleCount == 0) {
+    bounds.ConeCutoff = 1.0f;
+    return bounds;
+  }
+
+  const uint32* first = &indices[firstTriangle * 3];
+  Float3 aabbMin      = ToFloat3(vertices[first[0]].Position);
+  Float3 aabbMax      = aabbMin;
+  Float3 normalSum;
+
+  for (uint32 i = 0; i < triangleCount * 3; i += 3) {
+    const Float3 p0 = ToFloat3(vertices[first[i]].Position);
+    const Float3 p1 = ToFloat3(vertices[first[i + 1]].Position);
+    const Float3 p2 = ToFloat3(vertices[first[i + 2]].Position);
+
+    for (const Float3& p : {p0, p1, p2}) {
+      aabbMin = {std::min<float>(aabbMin.x, p.x), std::min<float>(aabbMin.y, p.y), std::min<float>(aabbMin.z, p.z)};
+      aabbMax = {std::max<float>(aabbMax.x, p.x), std::max<float>(aabbMax.y, p.y), std::max<float>(aabbMax.z, p.z)};
+    }
+
+    // Unit normals, so large triangles do not pull the axis away from small ones.
+    const Float3 normal = Cross(Sub(p1, p0), Sub(p2, p0));
+    const float length  = Length(normal);
+    if (length > 0.0f) {
+      normalSum = {normalSum.x + normal.x / length, normalSum.y + normal.y / length, normalSum.z + normal.z / length};
+    }
+  }
+
+  const Float3 center = {(aabbMin.x + aabbMax.x) * 0.5f, (aabbMin.y + aabbMax.y) * 0.5f, (aabbMin.z + aabbMax.z) * 0.5f};
+  float radiusSq      = 0.0f;
+  for (uint32 i = 0; i < triangleCount * 3; i++) {
+    const Float3 offset = Sub(ToFloat3(vertices[first[i]].Position), center);
+    radiusSq            = std::max<float>(radiusSq, Dot(offset, offset));
+  }
+
+  bounds.Center  = {center.x, center.y, center.z};
+  bounds.Radius  = sqrtf(radiusSq);
+  bounds.AabbMin = {aabbMin.x, aabbMin.y, aabbMin.z};
+  bounds.AabbMax = {aabbMax.x, aabbMax.y, aabbMax.z};
+
+  const float axisLength = Length(normalSum);
+  if (axisLength == 0.0f) {
+    bounds.ConeCutoff = 1.0f;
+    return bounds;
+  }
+
+  const Float3 axis = {normalSum.x / axisLength, normalSum.y / axisLength, normalSum.z / axisLength};
+  float minDot      = 1.0f;
+  for (uint32 i = 0; i < triangleCount * 3; i += 3) {
+    const Float3 p0     = ToFloat3(vertices[first[i]].Position);
+    const Float3 normal = Cross(Sub(ToFloat3(vertices[first[i + 1]].Position), p0), Sub(ToFloat3(vertices[first[i + 2]].Position), p0));
+    const float length  = Length(normal);
+    if (length > 0.0f) {
+      minDot = std::min<float>(minDot, Dot(axis, normal) / length);
+    }
+  }
+
+  bounds.ConeAxis = {axis.x, axis.y, axis.z};
+  // A view direction sees only back faces when it is within 90 degrees minus the cone half angle of the axis: cos(90 - acos(minDot)).
+  bounds.ConeCutoff = minDot <= MIN_CONE_DOT ? 1.0f : sqrtf(1.0f - minDot * minDot);
+  return bounds;
+}
+
+ClusterCullView ClusterCuller::MakeView(const Camera& camera, DirectX::FXMMATRIX objectToWorld, bool cullBackfaces)
+{
+  ClusterCullView view;
+  camera.GetFrustumPlanes(view.Planes, objectToWorld);
+
+  XMVECTOR determinant;
+  const XMMATRIX worldToObject = XMMatrixInverse(&determinant, objectToWorld);
+  XMStoreFloat3(&view.CameraPosition, XMVector3TransformCoord(camera.GetPositionXM(), worldToObject));
+
+  view.CullBackfaces = cullBackfaces && XMVectorGetX(determinant) > 0.0f;
+  return view;
+}
+
+bool ClusterCuller::IsVisible(const MeshletBounds& bounds, const ClusterCullView& view, ClusterCullStats* stats)
+{
+  const Float3 center = ToFloat3(bounds.Center);
+  for (const DirectX::XMFLOAT4& plane : view.Planes) {
+    if (plane.x * center.x + plane.y * center.y + plane.z * center.z + plane.w < -bounds.Radius) {
+      if (stats != nullptr) stats->FrustumCulled++;
+      return false;
+    }
+  }
+
+  if (view.CullBackfaces && bounds.ConeCutoff < 1.0f) {
+    const Float3 toCenter = Sub(center, ToFloat3(view.CameraPosition));
+    if (Dot(toCenter, ToFloat3(bounds.ConeAxis)) >= bounds.ConeCutoff * Length(toCenter) + bounds.Radius) {
+      if (stats != nullptr) stats->BackfaceCulled++;
+      return false;
+    }
+  }
+  return true;
+}
+
+uint32 ClusterCuller::Cull(const MeshletData& meshlets, const ClusterCullView& view, std::vector<ClusterDrawRange>& ranges, ClusterCullStats* stats)
+{
+  ranges.clear();
+
+  uint32 visibleCount = 0;
+  for (uint32 i = 0; i < meshlets.GetMeshletCount(); i++) {
+    if (stats != nullptr) stats->Total++;
+    if (!IsVisible(meshlets.Bounds[i], view, stats)) continue;
+
+    const Meshlet& meshlet = meshlets.Meshlets[i];
+    const uint32 start     = meshlet.TriangleOffset * 3;
+    if (!ranges.empty() && ranges.back().StartIndex + ranges.back().IndexCount == start) {
+      ranges.back().IndexCount += meshlet.TriangleCount * 3;
+    } else {
+      ranges.push_back({start, meshlet.TriangleCount * 3});
+    }
+    visibleCount++;
+  }
+  return visibleCount;
+}
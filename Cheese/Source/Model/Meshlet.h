@@ -0,0 +1,101 @@
+#ifndef MODEL_MESHLET_H
+#define MODEL_MESHLET_H
+#include <DirectXMath.h>
+
+#include <vector>
+
+#include "Common/TypeDef.h"
+
+class Camera;
+struct Vertex;
+
+// A cluster of triangles that is culled as one unit.
+// Meshlets are cut from the index buffer in order, so meshlet triangles stay contiguous in the source index buffer:
+// the cluster is also drawable as DrawIndexed(TriangleCount * 3, start + TriangleOffset * 3).
+struct Meshlet {
+  // Range in MeshletData::Vertices.
+  uint32 VertexOffset;
+  uint32 VertexCount;
+  // Range in triangles, both in MeshletData::Triangles and in the source index buffer.
+  uint32 TriangleOffset;
+  uint32 TriangleCount;
+};
+
+struct MeshletBounds {
+  DirectX::XMFLOAT3 Center;
+  float Radius;
+
+  DirectX::XMFLOAT3 AabbMin;
+  DirectX::XMFLOAT3 AabbMax;
+
+  // All triangles face away from a camera at position p when dot(Center - p, ConeAxis) >= ConeCutoff * |Center - p| + Radius.
+  // ConeCutoff is 1 when the normals spread too far to ever reject the cluster.
+  DirectX::XMFLOAT3 ConeAxis;
+  float ConeCutoff;
+};
+
+struct MeshletData {
+  std::vector<Meshlet> Meshlets;
+  std::vector<MeshletBounds> Bounds;
+  // Mesh vertex indices referenced by each meshlet.
+  std::vector<uint32> Vertices;
+  // Three meshlet local vertex indices per triangle, for mesh shader style consumers.
+  std::vector<uint8> Triangles;
+
+  inline uint32 GetMeshletCount() const { return static_cast<uint32>(Meshlets.size()); }
+};
+
+class MeshletBuilder
+{
+ public:
+  // Defaults fit common mesh shader limits. Vertices are capped so local indices fit in 8 bits.
+  static const uint32 DEFAULT_MAX_VERTICES  = 64;
+  static const uint32 DEFAULT_MAX_TRIANGLES = 124;
+  static const uint32 MAX_VERTICES_LIMIT    = 255;
+  static const uint32 MAX_TRIANGLES_LIMIT   = 512;
+
+  // Splits the triangle list into meshlets of at most maxVertices unique vertices and maxTriangles triangles.
+  // Triangles are taken in index order, run MeshOptimizer first to get spatially compact clusters.
+  static void Build(const std::vector<Vertex>& vertices, const std::vector<uint32>& indices, MeshletData& meshlets,
+                    uint32 maxVertices = DEFAULT_MAX_VERTICES, uint32 maxTriangles = DEFAULT_MAX_TRIANGLES);
+
+  static MeshletBounds ComputeBounds(const std::vector<Vertex>& vertices, const std::vector<uint32>& indices, uint32 firstTriangle,
+                                     uint32 triangleCount);
+};
+
+// Frustum and eye, both in the space the meshlet bounds are in.
+struct ClusterCullView {
+  // xyz is the inward plane normal, a point p is inside when dot(xyz, p) + w >= 0.
+  DirectX::XMFLOAT4 Planes[6];
+  DirectX::XMFLOAT3 CameraPosition;
+  // Off for double sided geometry or pipelines without back face culling.
+  bool CullBackfaces = true;
+};
+
+struct ClusterCullStats {
+  uint32 Total          = 0;
+  uint32 FrustumCulled  = 0;
+  uint32 BackfaceCulled = 0;
+};
+
+// Index range of a run of visible meshlets, relative to the first index of the mesh.
+struct ClusterDrawRange {
+  uint32 StartIndex;
+  uint32 IndexCount;
+};
+
+class ClusterCuller
+{
+ public:
+  // Moves the camera frustum and position into the object space of objectToWorld.
+  // Back face rejection is turned off for mirroring transforms, they flip the winding.
+  static ClusterCullView MakeView(const Camera& camera, DirectX::FXMMATRIX objectToWorld, bool cullBackfaces = true);
+
+  static bool IsVisible(const MeshletBounds& bounds, const ClusterCullView& view, ClusterCullStats* stats = nullptr);
+
+  // Writes the surviving meshlets as index ranges, neighbouring meshlets are merged into a single range.
+  // Returns the number of visible meshlets.
+  static uint32 Cull(const MeshletData& meshlets, const ClusterCullView& view, std::vector<ClusterDrawRange>& ranges,
+                     ClusterCullStats* stats = nullptr);
+};
+#endif  // MODEL_MESHLET_H
@@ -20,7 +20,12 @@ class Model
   inline void AddMesh(IMesh *mesh) { mMeshes.push_back(mesh); }
   inline const std::vector<IMesh *> &GetMeshes() const { return mMeshes; }
 
+  // Upload buffers of textures created for this model alone, release them once the load's command list completed.
+  inline void AddUploadBuffer(ComPtr<ID3D12Resource> buffer) { mUploadBuffers.push_back(std::move(buffer)); }
+  inline void ReleaseUploadBuffers() { mUploadBuffers.clear(); }
+
  private:
   std::vector<IMesh *> mMeshes;
+  std::vector<ComPtr<ID3D12Resource>> mUploadBuffers;
 };
 #endif  // MODEL_MODEL_H
\ No newline at end of file
@@ -1,4 +1,9 @@
+#include "Model.h"
 #include "ModelLoader.h"
+#include "CookedModel.h"
+#include "MeshOptimizerAdapter.h"
+#include "MeshSimplifier.h"
+#include "VertexWelder.h"
 
 #define TINYGLTF_IMPLEMENTATION
 #define STB_IMAGE_IMPLEMENTATION
@@ -8,151 +13,830 @@
 #define STBI_MSC_SECURE_CRT
 
 #include <d3d12.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
 #include "d3dx12.h"
 #include "Graphics/D3DUtil.h"
 #include "Utils/Log/Logger.h"
+#include "Utils/MappedFile.h"
+#include "Utils/ThreadPool.h"
 #include "tinygltf/tiny_gltf.h"
 
-void ModelLoader::LoadGLTF(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, const CheString& fileName, Model& model)
+namespace {
+static_assert(CookedFormat::MAX_LODS == IMesh::MAX_LODS, "Cooked draws must be able to hold every mesh LOD");
+
+struct BufferSpan {
+  const Byte* Data = nullptr;
+  uint64 Size      = 0;
+};
+
+struct BufferViewRange {
+  int Buffer        = -1;
+  uint64 ByteOffset = 0;
+  uint64 ByteLength = 0;
+};
+
+// A parsed glTF plus the memory its buffers live in.
+// Buffers either point at tinygltf's own copies or into the file mappings.
+struct GLTFDocument {
+  tinygltf::Model Model;
+  std::vector<BufferSpan> Buffers;
+  std::vector<BufferViewRange> BufferViews;
+  std::vector<MappedFile> Mappings;
+};
+
+// A one byte data uri. tinygltf requires every buffer to carry data, the real bytes come from the mapping.
+const char* PLACEHOLDER_BUFFER_URI = "data:application/octet-stream;base64,AA==";
+// Images stored in a buffer view are redirected to this pseudo file, served by MappedReadWholeFile.
+const std::string MAPPED_VIEW_PREFIX = "cheese-mapped-view-";
+
+const uint32 GLB_MAGIC      = 0x46546C67;  // "glTF"
+const uint32 GLB_CHUNK_JSON = 0x4E4F534A;  // "JSON"
+const uint32 GLB_CHUNK_BIN  = 0x004E4942;  // "BIN\0"
+
+bool IsGLB(const CheString& fileName)
+{
+  if (fileName.size() < 4) return false;
+  CheString ext = fileName.substr(fileName.size() - 4);
+  for (CheChar& c : ext) c = static_cast<CheChar>(tolower(c));
+  return ext == CTEXT(".glb");
+}
+
+std::string GetBaseDir(const std::string& filePath)
+{
+  const size_t split = filePath.find_last_of("/\\");
+  return split == std::string::npos ? std::string() : filePath.substr(0, split + 1);
+}
+
+std::string PercentDecode(const std::string& uri)
+{
+  std::string decoded;
+  decoded.reserve(uri.size());
+  for (size_t i = 0; i < uri.size(); ++i) {
+    if (uri[i] == '%' && i + 2 < uri.size() && isxdigit(uri[i + 1]) && isxdigit(uri[i + 2])) {
+      decoded.push_back(static_cast<char>(std::stoi(uri.substr(i + 1, 2), nullptr, 16)));
+      i += 2;
+    } else {
+      decoded.push_back(uri[i]);
+    }
+  }
+  return decoded;
+}
+
+bool ParseGLBChunks(const Byte* data, uint64 size, BufferSpan& json, BufferSpan& bin)
+{
+  uint32 header[3];
+  if (size < sizeof(header) + 8) return false;
+  memcpy(header, data, sizeof(header));
+  if (header[0] != GLB_MAGIC || header[1] != 2 || header[2] > size) return false;
+
+  uint64 offset = sizeof(header);
+  while (offset + 8 <= header[2]) {
+    uint32 chunk[2];
+    memcpy(chunk, data + offset, sizeof(chunk));
+    offset += sizeof(chunk);
+    if (offset + chunk[0] > header[2]) return false;
+
+    if (chunk[1] == GLB_CHUNK_JSON && json.Data == nullptr) {
+      json = {data + offset, chunk[0]};
+    } else if (chunk[1] == GLB_CHUNK_BIN && bin.Data == nullptr) {
+      bin = {data + offset, chunk[0]};
+    }
+    // Chunks are 4 byte aligned.
+    offset += (chunk[0] + 3) & ~3ull;
+  }
+  return json.Data != nullptr;
+}
+
+bool MappedFileExists(const std::string& absFileName, void* userData)
+{
+  if (absFileName.find(MAPPED_VIEW_PREFIX) != std::string::npos) return true;
+  return tinygltf::FileExists(absFileName, userData);
+}
+
+bool MappedReadWholeFile(std::vector<unsigned char>* out, std::string* err, const std::string& filePath, void* userData)
+{
+  const size_t prefix = filePath.find(MAPPED_VIEW_PREFIX);
+  if (prefix == std::string::npos) return tinygltf::ReadWholeFile(out, err, filePath, userData);
+
+  const GLTFDocument* document = static_cast<const GLTFDocument*>(userData);
+  const uint64 viewIndex       = std::stoull(filePath.substr(prefix + MAPPED_VIEW_PREFIX.size()));
+  if (viewIndex >= document->BufferViews.size()) return false;
+
+  const BufferViewRange& view = document->BufferViews[viewIndex];
+  if (view.Buffer < 0 || view.Buffer >= static_cast<int>(document->Buffers.size())) return false;
+  const BufferSpan& span = document->Buffers[view.Buffer];
+  if (span.Data == nullptr || view.ByteOffset + view.ByteLength > span.Size) return false;
+
+  // Encoded image bytes still need a heap copy, stb_image decodes them into a new buffer anyway.
+  out->assign(span.Data + view.ByteOffset, span.Data + view.ByteOffset + view.ByteLength);
+  return true;
+}
+
+bool LoadDocument(const CheString& fileName, GLTFDocument& document)
 {
-  logger.Info(CTEXT("Loading model:") + fileName);
   tinygltf::TinyGLTF loader;
   std::string err;
   std::string warn;
-  tinygltf::Model gltfModel;
-  bool res = loader.LoadASCIIFromFile(&gltfModel, &err, &warn, ConvertToMultiByte(fileName).c_str());
+  const std::string filePath = ConvertToMultiByte(fileName);
+  bool res = IsGLB(fileName) ? loader.LoadBinaryFromFile(&document.Model, &err, &warn, filePath)
+                             : loader.LoadASCIIFromFile(&document.Model, &err, &warn, filePath);
   if (!res) {
-    logger.Error(CTEXT("Load") + fileName + CTEXT("Error"));
-    return;
+    logger.Error(ConvertToCheString(err.c_str()));
+    return false;
   }
 
-  for (tinygltf::Node node : gltfModel.nodes) {
-    tinygltf::Mesh drawMesh = gltfModel.meshes[node.mesh];
-    for (tinygltf::Primitive primitive : drawMesh.primitives) {
-      if (primitive.attributes.size() == 3) continue;
+  for (const tinygltf::Buffer& buffer : document.Model.buffers) {
+    document.Buffers.push_back({buffer.data.data(), buffer.data.size()});
+  }
+  return true;
+}
 
-      // get indices gltf buffer&view.
-      tinygltf::Accessor& indicesAccessor     = gltfModel.accessors[primitive.indices];
-      tinygltf::BufferView& indicesBufferView = gltfModel.bufferViews[indicesAccessor.bufferView];
-      tinygltf::Buffer& indicesData           = gltfModel.buffers[indicesBufferView.buffer];
-
-      // get position gltf buffer&view.
-      tinygltf::Accessor& posAccessor     = gltfModel.accessors[primitive.attributes.at("POSITION")];
-      tinygltf::BufferView& posBufferView = gltfModel.bufferViews[posAccessor.bufferView];
-      tinygltf::Buffer& posBuffer         = gltfModel.buffers[posBufferView.buffer];
-
-      const float* posData = reinterpret_cast<const float*>(&(posBuffer.data[posBufferView.byteOffset + posAccessor.byteOffset]));
-
-      std::vector<Vertex> vertexData(posAccessor.count);
-
-      // assemble vertex data.
-      for (int i = 0; i < vertexData.size(); i++) {
-        Vertex vertex;
-        vertex.Position = DirectX::XMFLOAT3(&posData[i * 3]);
-        // for normal
-        if (primitive.attributes.find("NORMAL") != primitive.attributes.end()) {
-          tinygltf::Accessor& normalAccessor     = gltfModel.accessors[primitive.attributes.at("NORMAL")];
-          tinygltf::BufferView& normalBufferView = gltfModel.bufferViews[normalAccessor.bufferView];
-          tinygltf::Buffer& normalBuffer         = gltfModel.buffers[normalBufferView.buffer];
-
-          const float* normalData =
-              reinterpret_cast<const float*>(&(normalBuffer.data[normalBufferView.byteOffset + normalAccessor.byteOffset]));
-          vertex.Normal = DirectX::XMFLOAT3(&normalData[i * 3]);
-        }
+bool LoadMappedDocument(const CheString& fileName, GLTFDocument& document)
+{
+  MappedFile file;
+  if (!file.Open(fileName)) return false;
 
-        // for tangent
-        if (primitive.attributes.find("TANGENT") != primitive.attributes.end()) {
-          tinygltf::Accessor& tangentAccessor     = gltfModel.accessors[primitive.attributes.at("TANGENT")];
-          tinygltf::BufferView& tangentBufferView = gltfModel.bufferViews[tangentAccessor.bufferView];
-          tinygltf::Buffer& tangentBuffer         = gltfModel.buffers[tangentBufferView.buffer];
+  BufferSpan jsonText = {file.GetData(), file.GetSize()};
+  BufferSpan binChunk;
+  if (IsGLB(fileName)) {
+    jsonText = {};
+    if (!ParseGLBChunks(file.GetData(), file.GetSize(), jsonText, binChunk)) {
+      logger.Error(CTEXT("Invalid glb container: ") + fileName);
+      return false;
+    }
+  }
 
-          const float* tangentData =
-              reinterpret_cast<const float*>(&(tangentBuffer.data[tangentBufferView.byteOffset + tangentAccessor.byteOffset]));
-          vertex.Tangent = DirectX::XMFLOAT4(&tangentData[i * 4]);
-        }
+  const char* jsonBegin = reinterpret_cast<const char*>(jsonText.Data);
+  nlohmann::json json   = nlohmann::json::parse(jsonBegin, jsonBegin + jsonText.Size, nullptr, false);
+  if (json.is_discarded() || !json.is_object()) {
+    logger.Error(CTEXT("Invalid gltf json: ") + fileName);
+    return false;
+  }
 
-        // for tex coord
-        if (primitive.attributes.find("TEXCOORD_0") != primitive.attributes.end()) {
-          tinygltf::Accessor& texcoordAccessor     = gltfModel.accessors[primitive.attributes.at("TEXCOORD_0")];
-          tinygltf::BufferView& texcoordBufferView = gltfModel.bufferViews[texcoordAccessor.bufferView];
-          tinygltf::Buffer& texcoordBuffer         = gltfModel.buffers[texcoordBufferView.buffer];
+  const std::string baseDir = GetBaseDir(ConvertToMultiByte(fileName));
 
-          const float* texcoordData =
-              reinterpret_cast<const float*>(&(texcoordBuffer.data[texcoordBufferView.byteOffset + texcoordAccessor.byteOffset]));
-          vertex.TexCoord = DirectX::XMFLOAT2(&texcoordData[i * 2]);
+  // Map every external/BIN buffer and swap it for a placeholder before tinygltf sees the document.
+  std::vector<bool> isMapped;
+  auto buffers = json.find("buffers");
+  if (buffers != json.end() && buffers->is_array()) {
+    document.Buffers.resize(buffers->size());
+    isMapped.resize(buffers->size(), false);
+    for (size_t i = 0; i < buffers->size(); ++i) {
+      nlohmann::json& buffer = (*buffers)[i];
+      if (!buffer.is_object()) continue;
+
+      const std::string uri = buffer.value("uri", std::string());
+      if (uri.compare(0, 5, "data:") == 0) continue;
+
+      if (uri.empty()) {
+        if (binChunk.Data == nullptr) {
+          logger.Error(CTEXT("Buffer without uri or BIN chunk: ") + fileName);
+          return false;
         }
-        vertexData[i] = vertex;
+        document.Buffers[i] = binChunk;
+      } else {
+        MappedFile mapping;
+        if (!mapping.Open(ConvertToCheString((baseDir + PercentDecode(uri)).c_str()))) return false;
+        document.Buffers[i] = {mapping.GetData(), mapping.GetSize()};
+        document.Mappings.push_back(std::move(mapping));
+      }
+      buffer      = {{"byteLength", 1}, {"uri", PLACEHOLDER_BUFFER_URI}};
+      isMapped[i] = true;
+    }
+  }
+
+  auto bufferViews = json.find("bufferViews");
+  if (bufferViews != json.end() && bufferViews->is_array()) {
+    for (const nlohmann::json& view : *bufferViews) {
+      BufferViewRange range;
+      if (view.is_object()) {
+        range.Buffer     = view.value("buffer", -1);
+        range.ByteOffset = view.value("byteOffset", uint64(0));
+        range.ByteLength = view.value("byteLength", uint64(0));
       }
+      document.BufferViews.push_back(range);
+    }
+  }
 
-      IMesh* mesh;
+  auto images = json.find("images");
+  if (images != json.end() && images->is_array()) {
+    for (nlohmann::json& image : *images) {
+      if (!image.is_object() || image.find("bufferView") == image.end()) continue;
+      const int viewIndex = image.value("bufferView", -1);
+      image.erase("bufferView");
+      image["uri"] = MAPPED_VIEW_PREFIX + std::to_string(viewIndex);
+    }
+  }
 
-      if (indicesAccessor.componentType == TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT) {
-        std::vector<uint16> indexData(indicesAccessor.count);
-        const void* ibdata    = indicesData.data.data() + indicesBufferView.byteOffset + indicesAccessor.byteOffset;
-        const uint32 byteSize = static_cast<uint32>(indexData.size() * sizeof(uint16));
-        memcpy_s(indexData.data(), byteSize, ibdata, byteSize);
-        Mesh<uint16>* tempMesh = new Mesh<uint16>(std::move(vertexData), std::move(indexData));
-        mesh                   = tempMesh;
-      } else {
-        std::vector<uint32> indexData(indicesAccessor.count);
-        const void* ibdata    = indicesData.data.data() + indicesBufferView.byteOffset + indicesAccessor.byteOffset;
-        const uint32 byteSize = static_cast<uint32>(indexData.size() * sizeof(uint32));
-        memcpy_s(indexData.data(), byteSize, ibdata, byteSize);
-        Mesh<uint32>* tempMesh = new Mesh<uint32>(std::move(vertexData), std::move(indexData));
-        mesh                   = tempMesh;
+  tinygltf::FsCallbacks callbacks = {};
+  callbacks.FileExists            = &MappedFileExists;
+  callbacks.ExpandFilePath        = &tinygltf::ExpandFilePath;
+  callbacks.ReadWholeFile         = &MappedReadWholeFile;
+  callbacks.WriteWholeFile        = &tinygltf::WriteWholeFile;
+  callbacks.user_data             = &document;
+
+  tinygltf::TinyGLTF loader;
+  loader.SetFsCallbacks(callbacks);
+
+  std::string err;
+  std::string warn;
+  const std::string rewritten = json.dump();
+  if (!loader.LoadASCIIFromString(&document.Model, &err, &warn, rewritten.c_str(), static_cast<unsigned int>(rewritten.size()), baseDir)) {
+    logger.Error(ConvertToCheString(err.c_str()));
+    return false;
+  }
+
+  // Embedded data uri buffers were decoded by tinygltf.
+  for (size_t i = 0; i < isMapped.size(); ++i) {
+    if (!isMapped[i]) {
+      document.Buffers[i] = {document.Model.buffers[i].data.data(), document.Model.buffers[i].data.size()};
+    }
+  }
+
+  if (binChunk.Data != nullptr) {
+    document.Mappings.push_back(std::move(file));
+  }
+  return true;
+}
+
+// An accessor resolved down to its first element, element stride and count.
+struct AccessorStream {
+  const Byte* Data = nullptr;
+  uint64 Stride    = 0;
+  uint64 Count     = 0;
+};
+
+bool IsValidIndex(int index, size_t size) { return index >= 0 && static_cast<size_t>(index) < size; }
+
+// Checks every index DecodeGLTF follows: node -> mesh -> primitive accessors -> bufferView -> buffer. tinygltf does not
+// range check them, and a malformed file would otherwise index past the end of the document arrays.
+bool ValidateDocument(const GLTFDocument& document, const CheString& fileName)
+{
+  const tinygltf::Model& gltfModel = document.Model;
+
+  for (const tinygltf::BufferView& view : gltfModel.bufferViews) {
+    if (!IsValidIndex(view.buffer, document.Buffers.size())) {
+      logger.Error(CTEXT("BufferView with out of range buffer ") + ConvertToCheString(view.buffer) + CTEXT(" in ") + fileName);
+      return false;
+    }
+  }
+
+  for (const tinygltf::Accessor& accessor : gltfModel.accessors) {
+    // Sparse only accessors have no bufferView, ResolveAccessor skips them.
+    if (accessor.bufferView != -1 && !IsValidIndex(accessor.bufferView, gltfModel.bufferViews.size())) {
+      logger.Error(CTEXT("Accessor with out of range bufferView ") + ConvertToCheString(accessor.bufferView) + CTEXT(" in ") + fileName);
+      return false;
+    }
+  }
+
+  for (const tinygltf::Node& node : gltfModel.nodes) {
+    if (node.mesh == -1) continue;
+    if (!IsValidIndex(node.mesh, gltfModel.meshes.size())) {
+      logger.Error(CTEXT("Node with out of range mesh ") + ConvertToCheString(node.mesh) + CTEXT(" in ") + fileName);
+      return false;
+    }
+  }
+
+  for (const tinygltf::Mesh& mesh : gltfModel.meshes) {
+    for (const tinygltf::Primitive& primitive : mesh.primitives) {
+      bool valid = primitive.indices == -1 || IsValidIndex(primitive.indices, gltfModel.accessors.size());
+      for (const auto& attribute : primitive.attributes) {
+        valid = valid && IsValidIndex(attribute.second, gltfModel.accessors.size());
+      }
+      if (!valid) {
+        logger.Error(CTEXT("Primitive with out of range accessor in ") + fileName);
+        return false;
+      }
+    }
+  }
+  return true;
+}
+
+bool ResolveAccessor(const GLTFDocument& document, int accessorIndex, uint64 elementSize, AccessorStream& stream)
+{
+  if (!IsValidIndex(accessorIndex, document.Model.accessors.size())) return false;
+
+  const tinygltf::Accessor& accessor = document.Model.accessors[accessorIndex];
+  if (!IsValidIndex(accessor.bufferView, document.Model.bufferViews.size())) return false;
+  const tinygltf::BufferView& view = document.Model.bufferViews[accessor.bufferView];
+  if (!IsValidIndex(view.buffer, document.Buffers.size())) return false;
+  const BufferSpan& buffer = document.Buffers[view.buffer];
+  if (buffer.Data == nullptr) return false;
+
+  // The caller reads elementSize bytes per element, another component type or count would be misread.
+  const int componentSize  = tinygltf::GetComponentSizeInBytes(static_cast<uint32_t>(accessor.componentType));
+  const int componentCount = tinygltf::GetNumComponentsInType(static_cast<uint32_t>(accessor.type));
+  if (componentSize <= 0 || componentCount <= 0 || static_cast<uint64>(componentSize) * componentCount != elementSize) return false;
+
+  stream.Stride = view.byteStride != 0 ? view.byteStride : elementSize;
+  stream.Count  = accessor.count;
+  if (stream.Stride < elementSize) return false;
+
+  // Reject accessors running past their view or the view past its buffer, mapped files are not validated by tinygltf.
+  // Every bound is checked by subtraction or division, the sizes of a malformed file can overflow a sum or a product.
+  const uint64 viewOffset = view.byteOffset;
+  const uint64 viewLength = view.byteLength;
+  if (viewOffset > buffer.Size || viewLength > buffer.Size - viewOffset) return false;
+  const uint64 accessorOffset = accessor.byteOffset;
+  if (accessorOffset > viewLength) return false;
+  const uint64 available = viewLength - accessorOffset;
+  if (stream.Count != 0 && (available < elementSize || stream.Count - 1 > (available - elementSize) / stream.Stride)) return false;
+
+  stream.Data = buffer.Data + viewOffset + accessorOffset;
+  return true;
+}
+
+int FindAttribute(const tinygltf::Primitive& primitive, const char* name)
+{
+  auto iter = primitive.attributes.find(name);
+  return iter == primitive.attributes.end() ? -1 : iter->second;
+}
+
+// Scatter one attribute stream into the interleaved vertex array.
+template <typename MemberType>
+void CopyStream(const AccessorStream& stream, std::vector<Vertex>& vertices, MemberType Vertex::*member)
+{
+  const uint64 count = stream.Count < vertices.size() ? stream.Count : vertices.size();
+  const Byte* src    = stream.Data;
+  for (uint64 i = 0; i < count; ++i, src += stream.Stride) {
+    memcpy(&(vertices[i].*member), src, sizeof(MemberType));
+  }
+}
+
+// Copies the indices, false if one is not below vertexCount. Checked on the source value, narrowing could wrap it into range.
+template <typename IndexType, typename SourceType>
+bool ReadIndices(const AccessorStream& stream, uint64 vertexCount, std::vector<IndexType>& indices)
+{
+  indices.resize(stream.Count);
+  if (sizeof(IndexType) == sizeof(SourceType) && stream.Stride == sizeof(SourceType)) {
+    memcpy(indices.data(), stream.Data, stream.Count * sizeof(IndexType));
+    return std::all_of(indices.begin(), indices.end(), [&](IndexType index) { return index < vertexCount; });
+  }
+
+  const Byte* src = stream.Data;
+  for (uint64 i = 0; i < stream.Count; ++i, src += stream.Stride) {
+    SourceType index;
+    memcpy(&index, src, sizeof(SourceType));
+    if (index >= vertexCount) return false;
+    indices[i] = static_cast<IndexType>(index);
+  }
+  return true;
+}
+
+// Null if the index accessor is out of range or references a vertex past the end.
+template <typename IndexType, typename SourceType>
+IMesh* DecodeIndexedMesh(const GLTFDocument& document, int indexAccessor, std::vector<Vertex>& vertices)
+{
+  AccessorStream stream;
+  if (!ResolveAccessor(document, indexAccessor, sizeof(SourceType), stream)) return nullptr;
+
+  std::vector<IndexType> indices;
+  if (!ReadIndices<IndexType, SourceType>(stream, vertices.size(), indices)) return nullptr;
+  return new Mesh<IndexType>(std::move(vertices), std::move(indices));
+}
+
+// Decode the geometry of one primitive. Touches no shared state, so primitives can be decoded in parallel.
+IMesh* DecodePrimitive(const GLTFDocument& document, const tinygltf::Primitive& primitive)
+{
+  AccessorStream positions;
+  if (!ResolveAccessor(document, FindAttribute(primitive, "POSITION"), sizeof(DirectX::XMFLOAT3), positions)) {
+    return nullptr;
+  }
+
+  std::vector<Vertex> vertices(positions.Count);
+  CopyStream(positions, vertices, &Vertex::Position);
+
+  AccessorStream stream;
+  if (ResolveAccessor(document, FindAttribute(primitive, "NORMAL"), sizeof(DirectX::XMFLOAT3), stream)) {
+    CopyStream(stream, vertices, &Vertex::Normal);
+  }
+  if (ResolveAccessor(document, FindAttribute(primitive, "TANGENT"), sizeof(DirectX::XMFLOAT4), stream)) {
+    CopyStream(stream, vertices, &Vertex::Tangent);
+  }
+  if (ResolveAccessor(document, FindAttribute(primitive, "TEXCOORD_0"), sizeof(DirectX::XMFLOAT2), stream)) {
+    CopyStream(stream, vertices, &Vertex::TexCoord);
+  }
+
+  if (!IsValidIndex(primitive.indices, document.Model.accessors.size())) return nullptr;
+  const int componentType = document.Model.accessors[primitive.indices].componentType;
+  switch (componentType) {
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_BYTE:
+      return DecodeIndexedMesh<uint16, uint8>(document, primitive.indices, vertices);
+    case TINYGLTF_COMPONENT_TYPE_UNSIGNED_SHORT:
+      return DecodeIndexedMesh<uint16, uint16>(document, primitive.indices, vertices);
+    default:
+      // Exporters often write 32 bit indices for small meshes, narrow them while copying.
+      if (vertices.size() <= VertexWelder::MAX_INDEX16_VERTICES) {
+        return DecodeIndexedMesh<uint16, uint32>(document, primitive.indices, vertices);
       }
+      return DecodeIndexedMesh<uint32, uint32>(document, primitive.indices, vertices);
+  }
+}
+
+double ElapsedMs(std::chrono::steady_clock::time_point start)
+{
+  return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
+
+CheString FormatFloat(float value)
+{
+  char buffer[32];
+  snprintf(buffer, sizeof(buffer), "%.3f", value);
+  return ConvertToCheString(buffer);
+}
+
+// Shader texture slots filled from a glTF material, in the order GetMaterialImages returns them.
+const char* TEXTURE_SLOT_NAMES[] = {"gAlbedoMap", "gNormalMap", "gORMMap"};
+const uint32 TEXTURE_SLOT_COUNT  = 3;
+
+void GetMaterialImages(tinygltf::Material& material, int images[TEXTURE_SLOT_COUNT])
+{
+  images[0] = material.values["baseColorTexture"].TextureIndex();
+  images[1] = material.additionalValues["normalTexture"].TextureIndex();
+  images[2] = material.values["metallicRoughnessTexture"].TextureIndex();
+}
+
+bool IsBlendMaterial(tinygltf::Material& material) { return material.additionalValues["alphaMode"].string_value == "BLEND"; }
+
+// Primitives without a material (-1) or with an out of range one get fallback, an opaque material without textures.
+tinygltf::Material& GetPrimitiveMaterial(tinygltf::Model& gltfModel, const tinygltf::Primitive& primitive, tinygltf::Material& fallback)
+{
+  if (primitive.material < 0 || primitive.material >= static_cast<int>(gltfModel.materials.size())) return fallback;
+  return gltfModel.materials[primitive.material];
+}
+
+bool IsValidImage(const tinygltf::Model& gltfModel, int imageIndex) { return IsValidIndex(imageIndex, gltfModel.images.size()); }
+
+// func(i) for every i in [0, count), on the pool or in order on the calling thread, see ModelLoadOptions::ParallelDecode.
+template <typename Func>
+void ForEachIndex(const ModelLoadOptions& options, uint32 count, const Func& func)
+{
+  if (options.ParallelDecode) {
+    ThreadPool::Get().ParallelFor(count, func);
+    return;
+  }
+  for (uint32 i = 0; i < count; ++i) func(i);
+}
+
+uint64 HashPixels(const tinygltf::Image& image)
+{
+  const uint64 FNV_PRIME = 1099511628211ull;
+  const Byte* pixels     = image.image.data();
+  const uint64 byteSize  = image.image.size();
+
+  // FNV-1a over 8 byte words, seeded with the dimensions so equal bytes in another layout do not match.
+  uint64 hash = 14695981039346656037ull;
+  hash        = (hash ^ ((static_cast<uint64>(image.width) << 32) | static_cast<uint32>(image.height))) * FNV_PRIME;
+  hash        = (hash ^ static_cast<uint32>(image.component)) * FNV_PRIME;
 
-      Material material;
-      // process texture
-      tinygltf::Material& gltfMaterial = gltfModel.materials[primitive.material];
-      if (gltfMaterial.additionalValues["alphaMode"].string_value == "BLEND") {
-        mesh->SetBlend(true);
+  uint64 offset = 0;
+  for (; offset + sizeof(uint64) <= byteSize; offset += sizeof(uint64)) {
+    uint64 word;
+    memcpy(&word, pixels + offset, sizeof(uint64));
+    hash = (hash ^ word) * FNV_PRIME;
+  }
+  for (; offset < byteSize; ++offset) {
+    hash = (hash ^ pixels[offset]) * FNV_PRIME;
+  }
+
+  // Word sized steps only mix upward, fold the high bits back down.
+  hash ^= hash >> 33;
+  hash *= 0xff51afd7ed558ccdull;
+  hash ^= hash >> 33;
+  return hash;
+}
+
+// Per glTF image, the first image with the same size and pixels, or its own index. Only those get a texture.
+// The hashes are computed on the pool, a hash hit is only taken when the pixels compare equal.
+std::vector<int> FindFirstEqualImages(const tinygltf::Model& gltfModel, const ModelLoadOptions& options)
+{
+  const uint32 imageCount = static_cast<uint32>(gltfModel.images.size());
+  std::vector<uint64> hashes(imageCount);
+  ForEachIndex(options, imageCount, [&](uint32 i) { hashes[i] = HashPixels(gltfModel.images[i]); });
+
+  std::vector<int> firstEqual(imageCount);
+  std::unordered_multimap<uint64, int> byHash;
+  for (uint32 i = 0; i < imageCount; ++i) {
+    const tinygltf::Image& image = gltfModel.images[i];
+    firstEqual[i]                = static_cast<int>(i);
+
+    auto range = byHash.equal_range(hashes[i]);
+    for (auto iter = range.first; iter != range.second; ++iter) {
+      const tinygltf::Image& other = gltfModel.images[iter->second];
+      if (other.width == image.width && other.height == image.height && other.component == image.component &&
+          other.image.size() == image.image.size() && memcmp(other.image.data(), image.image.data(), image.image.size()) == 0) {
+        firstEqual[i] = iter->second;
+        break;
       }
+    }
+    if (firstEqual[i] == static_cast<int>(i)) byHash.emplace(hashes[i], firstEqual[i]);
+  }
+  return firstEqual;
+}
 
-      tinygltf::Image& diffuseImage = gltfModel.images.at(gltfMaterial.values["baseColorTexture"].TextureIndex());
-      CreateTexture2D(device, cmdList, material.Textures[CTEXT("gAlbedoMap")], diffuseImage);
+void LogSharedTextures(uint32 sharedCount, uint64 bytesSaved)
+{
+  logger.Info(CTEXT("Textures: ") + ConvertToCheString(static_cast<int>(sharedCount)) + CTEXT(" shared, ") +
+              ConvertToCheString(static_cast<int>(bytesSaved / 1024)) + CTEXT("KB not uploaded"));
+}
 
-      tinygltf::Image& normalImage = gltfModel.images.at(gltfMaterial.additionalValues["normalTexture"].TextureIndex());
-      CreateTexture2D(device, cmdList, material.Textures[CTEXT("gNormalMap")], normalImage);
+// Parse the file and decode the geometry of every drawable primitive. meshes[i] belongs to primitives[i], and is null if it failed.
+bool DecodeGLTF(const CheString& fileName, const ModelLoadOptions& options, GLTFDocument& document,
+                std::vector<const tinygltf::Primitive*>& primitives, std::vector<IMesh*>& meshes)
+{
+  auto parseStart = std::chrono::steady_clock::now();
 
-      tinygltf::Image& ormImage = gltfModel.images.at(gltfMaterial.values["metallicRoughnessTexture"].TextureIndex());
-      CreateTexture2D(device, cmdList, material.Textures[CTEXT("gORMMap")], ormImage);
+  // Mapped buffers are read in place during decode, the document keeps the mappings alive until we are done.
+  bool res = options.MapBuffers ? LoadMappedDocument(fileName, document) : LoadDocument(fileName, document);
+  if (!res) {
+    logger.Error(CTEXT("Load") + fileName + CTEXT("Error"));
+    return false;
+  }
+  if (!ValidateDocument(document, fileName)) return false;
+  const double parseMs = ElapsedMs(parseStart);
+
+  // Gather primitives in node order, so the model layout does not depend on decode scheduling.
+  for (const tinygltf::Node& node : document.Model.nodes) {
+    if (node.mesh < 0) continue;
+    for (const tinygltf::Primitive& primitive : document.Model.meshes[node.mesh].primitives) {
+      if (primitive.attributes.size() == 3) continue;
+      if (primitive.indices < 0) continue;
+      primitives.push_back(&primitive);
+    }
+  }
+
+  auto decodeStart = std::chrono::steady_clock::now();
+  meshes.assign(primitives.size(), nullptr);
+  std::vector<VertexCacheStats> statsBefore(primitives.size());
+  std::vector<VertexCacheStats> statsAfter(primitives.size());
+  std::vector<WeldStats> weldStats(primitives.size());
+  std::vector<uint32> lodCounts(primitives.size(), 0);
+  ForEachIndex(options, static_cast<uint32>(primitives.size()), [&](uint32 i) {
+    meshes[i] = DecodePrimitive(document, *primitives[i]);
+    // Weld first, the optimizer works better on shared vertices.
+    if (options.WeldVertices && meshes[i] != nullptr) {
+      meshes[i] = VertexWelder::WeldAndNarrow(meshes[i], options.WeldEpsilon, &weldStats[i]);
+    }
+    if (options.OptimizeMeshes && meshes[i] != nullptr && !MeshOptimizerAdapter::Optimize(meshes[i], &statsBefore[i], &statsAfter[i])) {
+      delete meshes[i];
+      meshes[i] = nullptr;
+    }
+    // Last, the LOD ranges have to survive every other index rewrite.
+    if (options.GenerateLods && meshes[i] != nullptr) {
+      lodCounts[i] = MeshSimplifier::BuildLodChain(meshes[i], options.Lods);
+    }
+  });
+
+  logger.Info(CTEXT("Decode: ") + fileName + CTEXT(", parse ") + ConvertToCheString(static_cast<int>(parseMs)) + CTEXT("ms, decode ") +
+              ConvertToCheString(static_cast<int>(ElapsedMs(decodeStart))) + CTEXT("ms (") +
+              ConvertToCheString(static_cast<int>(primitives.size())) + CTEXT(" primitives)") +
+              (options.MapBuffers ? CTEXT(", mapped buffers") : CTEXT("")) + (options.ParallelDecode ? CTEXT("") : CTEXT(", serial")));
+
+  if (options.WeldVertices) {
+    uint32 verticesBefore = 0;
+    uint32 verticesAfter  = 0;
+    uint32 narrowedCount  = 0;
+    for (const WeldStats& stats : weldStats) {
+      verticesBefore += stats.VerticesBefore;
+      verticesAfter += stats.VerticesAfter;
+      narrowedCount += stats.IsNarrowed ? 1 : 0;
+    }
+    logger.Info(CTEXT("Weld: ") + ConvertToCheString(static_cast<int>(verticesBefore)) + CTEXT(" -> ") +
+                ConvertToCheString(static_cast<int>(verticesAfter)) + CTEXT(" vertices, ") + ConvertToCheString(static_cast<int>(narrowedCount)) +
+                CTEXT(" meshes narrowed to 16 bit indices"));
+  }
 
-      mesh->SetMaterial(material);
-      model.AddMesh(mesh);
+  if (options.OptimizeMeshes) {
+    VertexCacheStats totalBefore;
+    VertexCacheStats totalAfter;
+    for (uint32 i = 0; i < primitives.size(); ++i) {
+      totalBefore.Add(statsBefore[i]);
+      totalAfter.Add(statsAfter[i]);
     }
+    logger.Info(CTEXT("Optimize: ACMR ") + FormatFloat(totalBefore.GetAcmr()) + CTEXT(" -> ") + FormatFloat(totalAfter.GetAcmr()) +
+                CTEXT(", ATVR ") + FormatFloat(totalBefore.GetAtvr()) + CTEXT(" -> ") + FormatFloat(totalAfter.GetAtvr()));
   }
-  logger.Info(CTEXT("Load: ") + fileName + CTEXT(" Successed"));
+
+  if (options.GenerateLods) {
+    uint32 levelCount        = 0;
+    uint32 fullTriangles     = 0;
+    uint32 coarsestTriangles = 0;
+    for (uint32 i = 0; i < primitives.size(); ++i) {
+      if (meshes[i] == nullptr) continue;
+      levelCount += lodCounts[i];
+      fullTriangles += meshes[i]->GetLod(0).IndexCount / 3;
+      coarsestTriangles += meshes[i]->GetLod(meshes[i]->GetLodCount() - 1).IndexCount / 3;
+    }
+    logger.Info(CTEXT("LOD: ") + ConvertToCheString(static_cast<int>(levelCount)) + CTEXT(" levels, triangles ") +
+                ConvertToCheString(static_cast<int>(fullTriangles)) + CTEXT(" -> ") + ConvertToCheString(static_cast<int>(coarsestTriangles)) +
+                CTEXT(" at the coarsest level"));
+  }
+  return true;
+}
+}  // namespace
+
+void ModelLoader::LoadGLTF(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, const CheString& fileName, Model& model,
+                           const ModelLoadOptions& options)
+{
+  logger.Info(CTEXT("Loading model:") + fileName);
+  auto loadStart = std::chrono::steady_clock::now();
+
+  GLTFDocument document;
+  std::vector<const tinygltf::Primitive*> primitives;
+  std::vector<IMesh*> meshes;
+  if (!DecodeGLTF(fileName, options, document, primitives, meshes)) return;
+  tinygltf::Model& gltfModel = document.Model;
+
+  // Primitives sharing an image, and identical images under different indices, get one texture.
+  const std::vector<int> firstEqualImages = FindFirstEqualImages(gltfModel, options);
+  std::vector<Texture2D> textures(gltfModel.images.size());
+  uint32 sharedCount = 0;
+  uint64 bytesSaved  = 0;
+
+  // Texture creation records on the command list, keep it on the calling thread.
+  tinygltf::Material defaultMaterial;
+  for (uint32 i = 0; i < primitives.size(); ++i) {
+    IMesh* mesh = meshes[i];
+    if (mesh == nullptr) {
+      logger.Warning(CTEXT("Skip primitive without POSITION or with out of range accessors or indices in ") + fileName);
+      continue;
+    }
+
+    Material material;
+    // process texture
+    tinygltf::Material& gltfMaterial = GetPrimitiveMaterial(gltfModel, *primitives[i], defaultMaterial);
+    if (IsBlendMaterial(gltfMaterial)) {
+      mesh->SetBlend(true);
+    }
+
+    int images[TEXTURE_SLOT_COUNT];
+    GetMaterialImages(gltfMaterial, images);
+    for (uint32 slot = 0; slot < TEXTURE_SLOT_COUNT; ++slot) {
+      if (!IsValidImage(gltfModel, images[slot])) continue;
+      const int imageIndex         = firstEqualImages[images[slot]];
+      const tinygltf::Image& image = gltfModel.images[imageIndex];
+      Texture2D& texture           = textures[imageIndex];
+      if (texture.Resource == nullptr) {
+        CreateTexture2D(device, cmdList, texture, image);
+        // Materials copy the texture, the model keeps the only reference to the upload buffer.
+        model.AddUploadBuffer(std::move(texture.ResourceUpload));
+      } else {
+        sharedCount++;
+        bytesSaved += image.image.size();
+      }
+      material.Textures[ConvertToCheString(TEXTURE_SLOT_NAMES[slot])] = texture;
+    }
+
+    mesh->SetMaterial(material);
+    mesh->SetVertexFormat(options.Format);
+    model.AddMesh(mesh);
+  }
+
+  LogSharedTextures(sharedCount, bytesSaved);
+  logger.Info(CTEXT("Load: ") + fileName + CTEXT(" Successed, total ") + ConvertToCheString(static_cast<int>(ElapsedMs(loadStart))) +
+              CTEXT("ms"));
+}
+
+bool ModelLoader::DecodeModel(const CheString& fileName, DecodedModel& decoded, const ModelLoadOptions& options)
+{
+  GLTFDocument document;
+  std::vector<const tinygltf::Primitive*> primitives;
+  std::vector<IMesh*> meshes;
+  if (!DecodeGLTF(fileName, options, document, primitives, meshes)) return false;
+  tinygltf::Model& gltfModel = document.Model;
+
+  // Images with the same pixels are decoded once, the sink creates one texture for them.
+  const std::vector<int> firstEqualImages = FindFirstEqualImages(gltfModel, options);
+  uint32 sharedCount = 0;
+  uint64 bytesSaved  = 0;
+
+  tinygltf::Material defaultMaterial;
+  // glTF image index: decoded image index.
+  std::unordered_map<int, uint32> decodedImages;
+  auto findImage = [&](int imageIndex) {
+    imageIndex = firstEqualImages[imageIndex];
+    auto iter  = decodedImages.find(imageIndex);
+    if (iter != decodedImages.end()) {
+      sharedCount++;
+      bytesSaved += decoded.Images[iter->second].Pixels.size();
+      return iter->second;
+    }
+
+    // The document is dropped on return, take its pixels instead of copying them.
+    tinygltf::Image& image = gltfModel.images[imageIndex];
+    DecodedImage decodedImage;
+    decodedImage.Width     = image.width;
+    decodedImage.Height    = image.height;
+    decodedImage.Component = image.component;
+    decodedImage.Pixels    = std::move(image.image);
+    decoded.Images.push_back(std::move(decodedImage));
+    return decodedImages[imageIndex] = static_cast<uint32>(decoded.Images.size() - 1);
+  };
+
+  for (uint32 i = 0; i < primitives.size(); ++i) {
+    IMesh* mesh = meshes[i];
+    if (mesh == nullptr) {
+      logger.Warning(CTEXT("Skip primitive without POSITION or with out of range accessors or indices in ") + fileName);
+      continue;
+    }
+
+    tinygltf::Material& gltfMaterial = GetPrimitiveMaterial(gltfModel, *primitives[i], defaultMaterial);
+    mesh->SetBlend(IsBlendMaterial(gltfMaterial));
+    mesh->SetVertexFormat(options.Format);
+
+    int images[TEXTURE_SLOT_COUNT];
+    GetMaterialImages(gltfMaterial, images);
+
+    std::unordered_map<CheString, uint32> meshImages;
+    for (uint32 slot = 0; slot < TEXTURE_SLOT_COUNT; ++slot) {
+      if (!IsValidImage(gltfModel, images[slot])) continue;
+      meshImages[ConvertToCheString(TEXTURE_SLOT_NAMES[slot])] = findImage(images[slot]);
+    }
+
+    decoded.Meshes.push_back(mesh);
+    decoded.MeshImages.push_back(std::move(meshImages));
+  }
+  LogSharedTextures(sharedCount, bytesSaved);
+  return true;
+}
+
+bool ModelLoader::CookGLTF(const CheString& fileName, const CheString& cookedFileName, const ModelLoadOptions& options)
+{
+  logger.Info(CTEXT("Cooking model:") + fileName);
+  auto cookStart = std::chrono::steady_clock::now();
+
+  GLTFDocument document;
+  std::vector<const tinygltf::Primitive*> primitives;
+  std::vector<IMesh*> meshes;
+  if (!DecodeGLTF(fileName, options, document, primitives, meshes)) return false;
+  tinygltf::Model& gltfModel = document.Model;
+
+  CookedModelBuilder builder(sizeof(Vertex));
+  // glTF image index: cooked image index, materials sharing an image store its pixels once.
+  std::unordered_map<int, uint32> cookedImages;
+  tinygltf::Material defaultMaterial;
+
+  for (uint32 i = 0; i < primitives.size(); ++i) {
+    IMesh* mesh = meshes[i];
+    if (mesh == nullptr) {
+      logger.Warning(CTEXT("Skip primitive without POSITION or with out of range accessors or indices in ") + fileName);
+      continue;
+    }
+
+    tinygltf::Material& gltfMaterial = GetPrimitiveMaterial(gltfModel, *primitives[i], defaultMaterial);
+    int images[TEXTURE_SLOT_COUNT];
+    GetMaterialImages(gltfMaterial, images);
+
+    std::vector<std::pair<std::string, uint32>> bindings;
+    for (uint32 slot = 0; slot < TEXTURE_SLOT_COUNT; ++slot) {
+      if (!IsValidImage(gltfModel, images[slot])) continue;
+
+      auto iter = cookedImages.find(images[slot]);
+      if (iter == cookedImages.end()) {
+        const tinygltf::Image& image = gltfModel.images[images[slot]];
+        iter = cookedImages.emplace(images[slot], builder.AddImage(image.image.data(), image.width, image.height, image.component)).first;
+      }
+      bindings.emplace_back(TEXTURE_SLOT_NAMES[slot], iter->second);
+    }
+
+    CookedFormat::Lod lods[CookedFormat::MAX_LODS] = {};
+    for (uint32 lod = 0; lod < mesh->GetLodCount(); ++lod) {
+      const MeshLod meshLod = mesh->GetLod(lod);
+      lods[lod].StartIndex  = meshLod.StartIndex;
+      lods[lod].IndexCount  = meshLod.IndexCount;
+      lods[lod].Error       = meshLod.Error;
+    }
+
+    DirectX::XMFLOAT3 center;
+    float boundsRadius;
+    mesh->GetBoundingSphere(center, boundsRadius);
+    const float boundsCenter[3] = {center.x, center.y, center.z};
+
+    DirectX::XMFLOAT3 aabbMin;
+    DirectX::XMFLOAT3 aabbMax;
+    mesh->GetBoundingBox(aabbMin, aabbMax);
+    const float boundsMin[3] = {aabbMin.x, aabbMin.y, aabbMin.z};
+    const float boundsMax[3] = {aabbMax.x, aabbMax.y, aabbMax.z};
+
+    const uint32 indexSize = mesh->GetIndexFormat() == DXGI_FORMAT_R16_UINT ? sizeof(uint16) : sizeof(uint32);
+    builder.AddDraw(mesh->GetVertexByteData(), mesh->GetVertexCount(), mesh->GetIndexByteData(), mesh->GetIndexCount(), indexSize,
+                    IsBlendMaterial(gltfMaterial), bindings, boundsCenter, boundsRadius, boundsMin, boundsMax, lods, mesh->GetLodCount());
+  }
+
+  for (IMesh* mesh : meshes) {
+    delete mesh;
+  }
+
+  if (!builder.Save(cookedFileName)) return false;
+
+  logger.Info(CTEXT("Cooked: ") + cookedFileName + CTEXT(" in ") + ConvertToCheString(static_cast<int>(ElapsedMs(cookStart))) + CTEXT("ms"));
+  return true;
 }
 
 void ModelLoader::CreateTexture2D(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, Texture2D& texture, const tinygltf::Image& image)
 {
-  texture.Dimension = D3D12_SRV_DIMENSION_TEXTURE2D;
-
-  D3D12_RESOURCE_DESC textureDesc = {};
-  textureDesc.MipLevels           = 1;
-  textureDesc.Format              = DXGI_FORMAT_R8G8B8A8_UNORM;
-  textureDesc.Width               = image.width;
-  textureDesc.Height              = image.height;
-  textureDesc.Flags               = D3D12_RESOURCE_FLAG_NONE;
-  textureDesc.DepthOrArraySize    = 1;
-  textureDesc.SampleDesc.Count    = 1;
-  textureDesc.SampleDesc.Quality  = 0;
-  textureDesc.Dimension           = D3D12_RESOURCE_DIMENSION_TEXTURE2D;
-
-  TIFF(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_DEFAULT), D3D12_HEAP_FLAG_NONE, &textureDesc,
-                                       D3D12_RESOURCE_STATE_COPY_DEST, nullptr, IID_PPV_ARGS(&texture.Resource)));
-
-  TIFF(device->CreateCommittedResource(&CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD), D3D12_HEAP_FLAG_NONE,
-                                       &CD3DX12_RESOURCE_DESC::Buffer(image.image.size()), D3D12_RESOURCE_STATE_GENERIC_READ, nullptr,
-                                       IID_PPV_ARGS(&texture.ResourceUpload)));
-
-  D3D12_SUBRESOURCE_DATA textureData = {};
-  textureData.pData                  = image.image.data();
-  textureData.RowPitch               = image.width * image.component;
-  textureData.SlicePitch             = image.width * image.height * image.component;
-
-  UpdateSubresources(cmdList, texture.Resource.Get(), texture.ResourceUpload.Get(), 0, 0, 1, &textureData);
-  cmdList->ResourceBarrier(1, &CD3DX12_RESOURCE_BARRIER::Transition(texture.Resource.Get(), D3D12_RESOURCE_STATE_COPY_DEST,
-                                                                    D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE));
-}
\ No newline at end of file
+  D3DUtil::CreateTexture2DFromPixels(device, cmdList, image.image.data(), image.width, image.height, image.component, texture);
+}
@@ -1,14 +1,63 @@
 #ifndef MODEL_MODEL_LOADER_H
 #define MODEL_MODEL_LOADER_H
 #include "Common/TypeDef.h"
+#include <unordered_map>
+#include <vector>
 #include "tinygltf/tiny_gltf.h"
+#include "Model/MeshSimplifier.h"
 #include "Model/Model.h"
 
+struct ModelLoadOptions {
+  // Read .bin/.glb buffers straight from a file mapping instead of letting tinygltf copy them to the heap.
+  bool MapBuffers = false;
+  // Decode primitives and hash images on ThreadPool::Get(). When false they run one after the other on the calling thread,
+  // e.g. to measure what the pool gains.
+  bool ParallelDecode = true;
+  // Merge vertices closer than WeldEpsilon on every attribute, then move meshes that fit onto 16 bit indices.
+  bool WeldVertices = false;
+  float WeldEpsilon = 1e-6f;
+  // Reorder triangles and vertices for the post-transform cache, overdraw and vertex fetch.
+  bool OptimizeMeshes = false;
+  // Append a simplified LOD chain to every mesh, see MeshSimplifier::BuildLodChain.
+  bool GenerateLods = false;
+  LodChainOptions Lods;
+  // GPU vertex layout of the loaded meshes. Cooking always writes Vertex.
+  VertexFormat Format = VertexFormat::STANDARD;
+};
+
+// Decoded pixels of a texture image.
+struct DecodedImage {
+  uint32 Width;
+  uint32 Height;
+  uint32 Component;
+  std::vector<Byte> Pixels;
+};
+
+// CPU side result of a glTF load, ready to upload.
+struct DecodedModel {
+  // Materials are left empty, MeshImages says which image goes into which texture slot.
+  std::vector<IMesh*> Meshes;
+  // Images with identical pixels are kept once.
+  std::vector<DecodedImage> Images;
+  // Per mesh, texture slot name: index into Images.
+  std::vector<std::unordered_map<CheString, uint32>> MeshImages;
+};
+
 class ModelLoader
 {
  public:
-  static void LoadGLTF(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, const CheString& fileName, Model& model);
+  // Loads .gltf or .glb, picked by the file extension.
+  static void LoadGLTF(ID3D12Device* device, ID3D12GraphicsCommandList* cmdList, const CheString& fileName, Model& model,
+                       const ModelLoadOptions& options = ModelLoadOptions());
+
+  // The CPU half of LoadGLTF, safe to run on a worker thread.
+  // Primitives are decoded with ThreadPool::ParallelFor, which runs inline on pool workers: called from one, e.g. by ModelStreamer,
+  // a model decodes on that thread alone while other loads use the remaining workers.
+  static bool DecodeModel(const CheString& fileName, DecodedModel& decoded, const ModelLoadOptions& options = ModelLoadOptions());
+
+  // Decodes a glTF on the CPU and writes it as a cooked .chm, no device needed.
+  static bool CookGLTF(const CheString& fileName, const CheString& cookedFileName, const ModelLoadOptions& options = ModelLoadOptions());
 
   static void CreateTexture2D(ID3D12Device*, ID3D12GraphicsCommandList* cmdList, Texture2D& texture, const tinygltf::Image& image);
 };
-#endif  // MODEL_MODEL_LOADER_H
\ No newline at end of file
+#endif  // MODEL_MODEL_LOADER_H
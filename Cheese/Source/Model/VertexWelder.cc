@@ -0,0 +1,122 @@
+#include "VertexWelder.h"
+
+#include <emmintrin.h>
+
+namespace {
+const uint32 INVALID_INDEX = ~0u;
+
+// The vertex is loaded as three SSE registers.
+static_assert(sizeof(Vertex) == 12 * sizeof(float), "VertexWelder expects Vertex to be 12 tightly packed floats");
+
+uint32 HashKey(__m128i k0, __m128i k1, __m128i k2)
+{
+  // Rotate lanes before combining, so equal values in different attributes do not cancel out.
+  __m128i mixed = _mm_xor_si128(k0, _mm_shuffle_epi32(k1, _MM_SHUFFLE(0, 3, 2, 1)));
+  mixed         = _mm_add_epi32(mixed, _mm_shuffle_epi32(k2, _MM_SHUFFLE(1, 0, 3, 2)));
+  mixed         = _mm_xor_si128(mixed, _mm_srli_epi32(mixed, 15));
+
+  alignas(16) uint32 lanes[4];
+  _mm_store_si128(reinterpret_cast<__m128i*>(lanes), mixed);
+
+  uint64 hash = 14695981039346656037ull;
+  for (uint32 lane : lanes) {
+    hash = (hash ^ lane) * 1099511628211ull;
+  }
+  return static_cast<uint32>(hash ^ (hash >> 32));
+}
+}  // namespace
+
+uint32 VertexWelder::Weld(std::vector<Vertex>& vertices, std::vector<uint32>& indices, float epsilon)
+{
+  const uint32 vertexCount = static_cast<uint32>(vertices.size());
+  if (vertexCount == 0) return 0;
+
+  const bool isExact      = epsilon <= 0.0f;
+  const __m128 invEpsilon = _mm_set1_ps(isExact ? 0.0f : 1.0f / epsilon);
+  const __m128 maxDelta   = _mm_set1_ps(isExact ? 0.0f : epsilon);
+  const __m128 absMask    = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+
+  // Open addressing, at most half full.
+  uint32 capacity = 1;
+  while (capacity < vertexCount * 2) capacity <<= 1;
+  const uint32 mask = capacity - 1;
+  std::vector<uint32> table(capacity, INVALID_INDEX);
+
+  std::vector<uint32> remap(vertexCount);
+  std::vector<Vertex> welded;
+  welded.reserve(vertexCount);
+
+  const float* data = reinterpret_cast<const float*>(vertices.data());
+  for (uint32 v = 0; v < vertexCount; v++) {
+    const float* attributes = data + v * 12;
+    const __m128 a0         = _mm_loadu_ps(attributes);
+    const __m128 a1         = _mm_loadu_ps(attributes + 4);
+    const __m128 a2         = _mm_loadu_ps(attributes + 8);
+
+    // Exact welding hashes the raw bits, otherwise every attribute is snapped to an epsilon grid.
+    const uint32 hash = isExact ? HashKey(_mm_castps_si128(a0), _mm_castps_si128(a1), _mm_castps_si128(a2))
+                                : HashKey(_mm_cvtps_epi32(_mm_mul_ps(a0, invEpsilon)), _mm_cvtps_epi32(_mm_mul_ps(a1, invEpsilon)),
+                                          _mm_cvtps_epi32(_mm_mul_ps(a2, invEpsilon)));
+
+    for (uint32 slot = hash & mask;; slot = (slot + 1) & mask) {
+      const uint32 candidate = table[slot];
+      if (candidate == INVALID_INDEX) {
+        table[slot] = static_cast<uint32>(welded.size());
+        remap[v]    = static_cast<uint32>(welded.size());
+        welded.push_back(vertices[v]);
+        break;
+      }
+
+      // Hash hits are verified against the real values, the quantization saturates for large coordinates.
+      const float* other = reinterpret_cast<const float*>(&welded[candidate]);
+      const __m128 d0    = _mm_and_ps(_mm_sub_ps(a0, _mm_loadu_ps(other)), absMask);
+      const __m128 d1    = _mm_and_ps(_mm_sub_ps(a1, _mm_loadu_ps(other + 4)), absMask);
+      const __m128 d2    = _mm_and_ps(_mm_sub_ps(a2, _mm_loadu_ps(other + 8)), absMask);
+      const __m128 isNear =
+          _mm_and_ps(_mm_cmple_ps(d0, maxDelta), _mm_and_ps(_mm_cmple_ps(d1, maxDelta), _mm_cmple_ps(d2, maxDelta)));
+      if (_mm_movemask_ps(isNear) == 0xF) {
+        remap[v] = candidate;
+        break;
+      }
+    }
+  }
+
+  for (uint32& index : indices) {
+    index = remap[index];
+  }
+  vertices.swap(welded);
+  return static_cast<uint32>(vertices.size());
+}
+
+IMesh* VertexWelder::WeldAndNarrow(IMesh* mesh, float epsilon, WeldStats* stats)
+{
+  std::vector<uint32> indices;
+  mesh->GetIndices(indices);
+
+  const uint32 verticesBefore = mesh->GetVertexCount();
+  Weld(mesh->GetVertices(), indices, epsilon);
+
+  bool isNarrowed = false;
+  if (mesh->GetIndexFormat() == DXGI_FORMAT_R32_UINT && mesh->GetVertexCount() <= MAX_INDEX16_VERTICES) {
+    std::vector<uint16> indices16(indices.size());
+    for (size_t i = 0; i < indices.size(); i++) {
+      indices16[i] = static_cast<uint16>(indices[i]);
+    }
+
+    IMesh* narrowed = new Mesh<uint16>(std::move(mesh->GetVertices()), std::move(indices16));
+    narrowed->SetMaterial(mesh->GetMaterial());
+    narrowed->SetBlend(mesh->GetBlend());
+    delete mesh;
+    mesh       = narrowed;
+    isNarrowed = true;
+  } else {
+    mesh->SetIndices(indices);
+  }
+
+  if (stats != nullptr) {
+    stats->VerticesBefore = verticesBefore;
+    stats->VerticesAfter  = mesh->GetVertexCount();
+    stats->IsNarrowed     = isNarrowed;
+  }
+  return mesh;
+}
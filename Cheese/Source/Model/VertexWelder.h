@@ -0,0 +1,31 @@
+#ifndef MODEL_VERTEX_WELDER_H
+#define MODEL_VERTEX_WELDER_H
+#include <vector>
+#include "Common/TypeDef.h"
+#include "Mesh.h"
+
+struct WeldStats {
+  uint32 VerticesBefore = 0;
+  uint32 VerticesAfter  = 0;
+  // The mesh came in with 32 bit indices and was rebuilt as Mesh<uint16>.
+  bool IsNarrowed = false;
+};
+
+// Merges duplicate vertices and moves meshes that fit onto 16 bit indices.
+class VertexWelder
+{
+ public:
+  // Meshes with up to this many vertices can be indexed with uint16.
+  static const uint32 MAX_INDEX16_VERTICES = 65536;
+
+  // Merges vertices whose attributes all differ by at most epsilon, and rewrites the indices.
+  // Candidates are found through an SSE quantized hash, so vertices within epsilon that quantize
+  // into neighbouring cells may stay apart. epsilon <= 0 only merges bit-identical vertices.
+  // Returns the welded vertex count.
+  static uint32 Weld(std::vector<Vertex>& vertices, std::vector<uint32>& indices, float epsilon);
+
+  // Welds the mesh, then rebuilds a 32 bit mesh as Mesh<uint16> when its vertex count fits.
+  // Returns the mesh to use from now on; the passed mesh is deleted if it was replaced.
+  static IMesh* WeldAndNarrow(IMesh* mesh, float epsilon, WeldStats* stats = nullptr);
+};
+#endif  // MODEL_VERTEX_WELDER_H
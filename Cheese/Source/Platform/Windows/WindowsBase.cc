@@ -77,7 +77,8 @@ int WindowsMain(int argc, char** argv, CheeseApp* app)
   logger.Debug(CTEXT("Logger init!"));
   try {
     app->Init();
-    app->Load();
+    // Load logs what failed.
+    if (!app->Load()) return -1;
     app->Run();
   } catch (DxException& e) {
     logger.Error(e.ToString().c_str());
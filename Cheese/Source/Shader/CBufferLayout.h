@@ -0,0 +1,46 @@
+#ifndef SHADER_CBUFFER_LAYOUT_H
+#define SHADER_CBUFFER_LAYOUT_H
+
+#include "Common/TypeDef.h"
+#include "ConstantBuffer.h"
+
+// Layout of a C++ struct generated by CBufferGen from a cbuffer. Shader::ValidateCBufferLayout checks it against reflection,
+// a struct from stale shaders is reported at startup instead of writing constants to the wrong offsets.
+struct CBufferFieldLayout {
+  const CheChar* Name;
+  uint32 Offset;
+  uint32 Size;
+};
+
+struct CBufferLayout {
+  const CheChar* Name;
+  // Unpadded, the end of the last variable.
+  uint32 ByteSize;
+  const CBufferFieldLayout* Fields;
+  uint32 FieldCount;
+};
+
+// An HLSL cbuffer array of elements smaller than a register. Every element starts a 16 byte register, the last one is not padded
+// so the variables after the array can share its register.
+template <typename ElementType, uint32 COUNT>
+class CBufferArray
+{
+ public:
+  static const uint32 REGISTER_SIZE = 16;
+  static_assert(COUNT > 1 && sizeof(ElementType) % REGISTER_SIZE != 0, "Whole registers and single elements are plain arrays");
+
+  inline ElementType& operator[](uint32 index) { return index + 1 < COUNT ? mElements[index].Value : mLast; }
+  inline const ElementType& operator[](uint32 index) const { return index + 1 < COUNT ? mElements[index].Value : mLast; }
+
+ private:
+  struct PaddedElement {
+    ElementType Value;
+    Byte Padding[REGISTER_SIZE - sizeof(ElementType) % REGISTER_SIZE];
+  };
+
+ private:
+  PaddedElement mElements[COUNT - 1];
+  ElementType mLast;
+};
+
+#endif  // SHADER_CBUFFER_LAYOUT_H
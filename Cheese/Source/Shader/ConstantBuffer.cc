@@ -1,47 +1,50 @@
 #include "ConstantBuffer.h"
 
-#include "Graphics/D3DUtil.h"
 #include "Utils/Log/Logger.h"
-#include "d3dx12.h"
 
 using namespace std;
 
+const uint32 CBufferVarHandle::INVALID_BUFFER;
+
 std::unordered_map<CheString, CBufferType> CBufferManager::CBufferConfig{
     {CTEXT("cbPerObject"), CBufferType::PEROBJECT},
     {CTEXT("cbPass"), CBufferType::PASS},
+    {CTEXT("cbDraw"), CBufferType::DRAW},
+    {CTEXT("cbView"), CBufferType::VIEW},
 };
 
-HRESULT ConstantBuffer::CreateGPUResource(ID3D12Device* device) {
-  if (mUploadBuffer != nullptr) return S_OK;
-  if (mCbInfo.GetSlot() == UNINIT_SLOT_VALUE) {
-    logger.Error(CTEXT("Uninit cbuffer info"));
-    return E_FAIL;
+ConstantBuffer::ConstantBuffer(const CBufferInfo& cbInfo)
+    : mCbInfo(cbInfo),
+      mData(new Byte[cbInfo.GetByteSize()](), std::default_delete<Byte[]>()) {}
+
+void CBufferManager::AddCBuffer(const CheString& cbName,
+                                const CBufferInfo& cbInfo) {
+  if (mCBuffers.find(cbName) != mCBuffers.end()) return;
+
+  const ConstantBuffer& cbuffer =
+      mCBuffers.emplace(cbName, ConstantBuffer(cbInfo)).first->second;
+
+  const uint32 bufferIndex = static_cast<uint32>(mBufferData.size());
+  mBufferData.push_back(cbuffer.mData.get());
+  // The whole buffer, written by structs generated by CBufferGen.
+  mHandles[CBufferVarName::Hash(cbName.c_str())] = {bufferIndex, 0,
+                                                    cbInfo.GetByteSize()};
+  for (const auto& pair : cbInfo.GetVariables()) {
+    const CheString varName = cbName + CTEXT(".") + pair.first;
+    const uint32 hash       = CBufferVarName::Hash(varName.c_str());
+    if (mHandles.find(hash) != mHandles.end()) {
+      logger.Error(CTEXT("CBuffer variable name hash collision: ") + varName);
+      continue;
+    }
+    mHandles[hash] = {bufferIndex, pair.second.Offset, pair.second.Size};
   }
+}
 
-  CD3DX12_HEAP_PROPERTIES heapProps =
-      CD3DX12_HEAP_PROPERTIES(D3D12_HEAP_TYPE_UPLOAD);
-  CD3DX12_RESOURCE_DESC resDesc =
-      CD3DX12_RESOURCE_DESC::Buffer(mCbInfo.GetByteSize());
-
-  TIFF(device->CreateCommittedResource(&heapProps, D3D12_HEAP_FLAG_NONE,
-                                       &resDesc,
-                                       D3D12_RESOURCE_STATE_GENERIC_READ,
-                                       nullptr, IID_PPV_ARGS(&mUploadBuffer)));
-
-  mUploadBuffer->Map(0, nullptr, reinterpret_cast<void**>(&mData));
-  return S_OK;
+CBufferVarHandle CBufferManager::GetHandle(const CheString& varName) const {
+  return GetHandle(CBufferVarName(varName.c_str()));
 }
 
-void ConstantBuffer::SetRawData(const CheString& varName, const Byte* data,
-                                uint32 size) {
-  if (size > mCbInfo.GetByteSize()) {
-    return;
-  }
-  auto& variableOffsets = mCbInfo.GetVariableOffsets();
-  // if varName incorrect,do not set.
-  if (variableOffsets.find(varName) != variableOffsets.end()) {
-    uint32 offset = variableOffsets[varName];
-    Byte* dataStart = mData.get() + offset;
-    memcpy_s(dataStart, size, data, size);
-  }
-}
\ No newline at end of file
+CBufferVarHandle CBufferManager::GetHandle(CBufferVarName varName) const {
+  auto iter = mHandles.find(varName.GetHash());
+  return iter != mHandles.end() ? iter->second : CBufferVarHandle();
+}
@@ -3,7 +3,10 @@
 
 #include <strsafe.h>
 
+#include <cstring>
 #include <memory>
+#include <unordered_map>
+#include <vector>
 
 #include "Common/TypeDef.h"
 #include "Model/Mesh.h"
@@ -13,29 +16,59 @@
 enum class CBufferType : uint8 {
   PEROBJECT = 0,
   PASS      = 1,
+  // Root constants set per draw, e.g. by ExecuteIndirect. No buffer backs them.
+  DRAW = 2,
+  // Constants of the rendered view shared by all shaders, see ViewConstantBuffer. No shader owns a buffer.
+  VIEW = 3,
 };
 
-class ConstantBuffer
+// FNV-1a of a full variable name as "cbPass.gViewProj". A constexpr instance hashes a literal at compile time:
+//   constexpr CBufferVarName VIEW_PROJ(CTEXT("cbPass.gViewProj"));
+class CBufferVarName
 {
  public:
-  ConstantBuffer() : mCbInfo() {}
-  ConstantBuffer(const CBufferInfo& cbInfo) : mCbInfo(cbInfo) {}
+  constexpr explicit CBufferVarName(const CheChar* name) : mHash(Hash(name)) {}
 
-  HRESULT CreateGPUResource(ID3D12Device* device);
-
-  inline const CBufferInfo& GetCBufferInfo() const { return mCbInfo; }
-  inline ID3D12Resource* GetResource() const { return mUploadBuffer.Get(); }
+  constexpr uint32 GetHash() const { return mHash; }
 
-  friend class CBufferManager;
+  static constexpr uint32 Hash(const CheChar* name)
+  {
+    uint32 hash = 2166136261u;
+    for (; *name != 0; ++name) hash = (hash ^ static_cast<uint32>(*name)) * 16777619u;
+    return hash;
+  }
 
  private:
-  void SetRawData(const CheString& varName, const Byte* data, uint32 size);
+  uint32 mHash;
+};
+
+// A cbuffer variable resolved once by CBufferManager::GetHandle, writes through it do no name lookup.
+// Buffer indexes the buffers of the resolving manager, copies of the manager accept the handle as well.
+struct CBufferVarHandle {
+  static const uint32 INVALID_BUFFER = 0xffffffff;
+
+  uint32 Buffer = INVALID_BUFFER;
+  uint32 Offset = 0;
+  uint32 Size   = 0;
+
+  inline bool IsValid() const { return Buffer != INVALID_BUFFER; }
+};
+
+// Constants on the CPU, copied into an UploadRing every frame they are bound, see RenderData::UploadConstants.
+// Copies share the data.
+class ConstantBuffer
+{
+ public:
+  ConstantBuffer() : mCbInfo() {}
+  ConstantBuffer(const CBufferInfo& cbInfo);
+
+  inline const CBufferInfo& GetCBufferInfo() const { return mCbInfo; }
+  inline const Byte* GetData() const { return mData.get(); }
 
  public:
   CBufferInfo mCbInfo;
 
   std::shared_ptr<Byte> mData = nullptr;
-  ComPtr<ID3D12Resource> mUploadBuffer;
 };
 
 class CBufferManager
@@ -43,29 +76,34 @@ class CBufferManager
  public:
   CBufferManager() : mCBuffers() {}
 
-  inline void AddCBuffer(ID3D12Device* device, const CheString& cbName, const CBufferInfo& cbInfo)
+  void AddCBuffer(const CheString& cbName, const CBufferInfo& cbInfo);
+
+  // Resolves "cbuffer.variable", or "cbuffer" for the whole buffer. An unknown name gives an invalid handle. Resolve once and keep the handle.
+  CBufferVarHandle GetHandle(const CheString& varName) const;
+  CBufferVarHandle GetHandle(CBufferVarName varName) const;
+
+  // Invalid handles and values larger than the variable write nothing.
+  template <typename ValueType>
+  inline void SetValue(const CBufferVarHandle& handle, const ValueType& value)
   {
-    if (mCBuffers.find(cbName) == mCBuffers.end()) {
-      mCBuffers[cbName] = ConstantBuffer(cbInfo);
-      mCBuffers[cbName].CreateGPUResource(device);
-    }
+    if (!handle.IsValid() || sizeof(ValueType) > handle.Size) return;
+    memcpy(mBufferData[handle.Buffer] + handle.Offset, &value, sizeof(ValueType));
+  }
+  template <typename ValueType>
+  inline void SetValue(CBufferVarName varName, const ValueType& value)
+  {
+    SetValue(GetHandle(varName), value);
   }
-
   template <typename ValueType>
   inline void SetValue(const CheString& varName, const ValueType& value)
   {
-    uint64 splitPoint = varName.find(CheChar('.'));
-    CheChar cbufferName[64];
-    ZeroMemory(cbufferName, 64);
-    StringCchCopy(cbufferName, splitPoint + 1, varName.c_str());
-
-    if (mCBuffers.find(cbufferName) != mCBuffers.end()) {
-      CheChar cbufferVarName[64];
-      lstrcpyW(cbufferVarName, varName.c_str() + splitPoint + 1);
-      const Byte* byteData  = (Byte*)&value;
-      const uint32 dataSize = sizeof(value);
-      mCBuffers[cbufferName].SetRawData(cbufferVarName, byteData, dataSize);
-    }
+    SetValue(GetHandle(varName), value);
+  }
+  // Copies a struct generated by CBufferGen over its cbuffer with one memcpy, see CBufferLayout.h.
+  template <typename CBufferStruct>
+  inline void SetCBuffer(const CBufferStruct& data)
+  {
+    SetValue(GetHandle(CBufferStruct::Name()), data);
   }
 
   inline const std::unordered_map<CheString, ConstantBuffer>& GetCBuffers() const { return mCBuffers; }
@@ -74,6 +112,10 @@ class CBufferManager
 
  private:
   std::unordered_map<CheString, ConstantBuffer> mCBuffers;
+  // Data of the buffers in AddCBuffer order, CBufferVarHandle::Buffer indexes it.
+  std::vector<Byte*> mBufferData;
+  // Handles of all variables by CBufferVarName hash.
+  std::unordered_map<uint32, CBufferVarHandle> mHandles;
 };
 
 #endif  // SHADER_CONSTANT_BUFFER_H
\ No newline at end of file
@@ -1,8 +1,11 @@
 #include "Shader.h"
 
+#include <climits>
+#include <cstring>
 #include <vector>
 
 #include "Graphics/D3DUtil.h"
+#include "ShaderCache.h"
 #include "Utils/Log/Logger.h"
 
 using namespace std;
@@ -11,28 +14,61 @@ void Shader::AddShader(const CheString& fileName, ShaderType type)
 {
   switch (type) {
     case ShaderType::VERTEX_SHADER:
-      AddVS(D3DUtil::CompileShader(fileName, nullptr, CTEXT("VS"), CTEXT("vs_5_1")).Get());
-      GenerateShaderSettings(mVsByteCode.Get());
+      AddVS(CompileStage(fileName, CTEXT("VS"), CTEXT("vs_5_1")).Get());
       break;
     case ShaderType::HULL_SHADER:
-      AddHS(D3DUtil::CompileShader(fileName, nullptr, CTEXT("HS"), CTEXT("hs_5_1")).Get());
-      GenerateShaderSettings(mHsByteCode.Get());
+      AddHS(CompileStage(fileName, CTEXT("HS"), CTEXT("hs_5_1")).Get());
       break;
     case ShaderType::DOMAIN_SHADER:
-      AddDS(D3DUtil::CompileShader(fileName, nullptr, CTEXT("DS"), CTEXT("ds_5_1")).Get());
-      GenerateShaderSettings(mDsByteCode.Get());
+      AddDS(CompileStage(fileName, CTEXT("DS"), CTEXT("ds_5_1")).Get());
       break;
     case ShaderType::GEOMETRY_SHADER:
-      AddHS(D3DUtil::CompileShader(fileName, nullptr, CTEXT("GS"), CTEXT("hs_5_1")).Get());
-      GenerateShaderSettings(mGsByteCode.Get());
+      AddGS(CompileStage(fileName, CTEXT("GS"), CTEXT("gs_5_1")).Get());
       break;
     case ShaderType::PIXEL_SHADER:
-      AddPS(D3DUtil::CompileShader(fileName, nullptr, CTEXT("PS"), CTEXT("ps_5_1")).Get());
-      GenerateShaderSettings(mPsByteCode.Get());
+      AddPS(CompileStage(fileName, CTEXT("PS"), CTEXT("ps_5_1")).Get());
       break;
   }
 }
 
+void Shader::AddVSVariant(const CheString& fileName, const CheString& entryPoint)
+{
+  mVsVariants[entryPoint] = CompileStage(fileName, entryPoint, CTEXT("vs_5_1"));
+}
+
+ComPtr<ID3DBlob> Shader::CompileStage(const CheString& fileName, const CheString& entryPoint, const CheString& target)
+{
+  const ShaderCache& cache = ShaderCache::Get();
+  const uint64 key         = cache.MakeKey(fileName, nullptr, entryPoint, target, D3DUtil::GetShaderCompileFlags());
+
+  ShaderCache::Entry entry;
+  ComPtr<ID3DBlob> byteCode;
+  if (cache.Load(key, entry)) {
+    TIFF(D3DCreateBlob(entry.ByteCode.size(), byteCode.GetAddressOf()));
+    memcpy(byteCode->GetBufferPointer(), entry.ByteCode.data(), entry.ByteCode.size());
+  } else {
+    // A failed compile is not cached, the next run compiles it again.
+    const HRESULT hr = D3DUtil::TryCompileShader(fileName, nullptr, entryPoint, target, byteCode);
+    if (FAILED(hr) || byteCode == nullptr) {
+      logger.Error(mName + CTEXT(": ") + fileName + CTEXT(" ") + entryPoint + CTEXT(" failed to compile"));
+      return nullptr;
+    }
+    GenerateShaderSettings(byteCode.Get(), entry.Settings);
+    cache.Store(key, byteCode->GetBufferPointer(), byteCode->GetBufferSize(), entry.Settings);
+  }
+
+  // Stages share the settings, the first stage declaring a resource keeps it.
+  for (const auto& pair : entry.Settings.GetCBSetting()) mSettings.SetCBSettings(pair.first, pair.second);
+  for (const auto& pair : entry.Settings.GetSRVSetting()) mSettings.SetSRVSettings(pair.first, pair.second);
+  return byteCode;
+}
+
+ID3DBlob* Shader::GetVSVariant(const CheString& entryPoint) const
+{
+  auto iter = mVsVariants.find(entryPoint);
+  return iter != mVsVariants.end() ? iter->second.Get() : nullptr;
+}
+
 void Shader::AddVS(ID3DBlob* shaderByteCode) { mVsByteCode = shaderByteCode; }
 
 void Shader::AddPS(ID3DBlob* shaderByteCode) { mPsByteCode = shaderByteCode; }
@@ -43,7 +79,7 @@ void Shader::AddHS(ID3DBlob* shaderByteCode) { mHsByteCode = shaderByteCode; }
 
 void Shader::AddDS(ID3DBlob* shaderByteCode) { mDsByteCode = shaderByteCode; }
 
-void Shader::GenerateShaderSettings(ID3DBlob* shader)
+void Shader::GenerateShaderSettings(ID3DBlob* shader, ShaderSettings& settings)
 {
   ComPtr<ID3D12ShaderReflection> shaderReflection;
   TIFF(D3DReflect(shader->GetBufferPointer(), shader->GetBufferSize(), __uuidof(ID3D12ShaderReflection),
@@ -62,16 +98,17 @@ void Shader::GenerateShaderSettings(ID3DBlob* shader)
 
     // Process construct buffer build.
     if (shaderInputDesc.Type == D3D_SIT_CBUFFER) {
-      GenerateCBSettings(shaderInputDesc, shaderReflection->GetConstantBufferByName(shaderInputDesc.Name));
+      GenerateCBSettings(shaderInputDesc, shaderReflection->GetConstantBufferByName(shaderInputDesc.Name), settings);
     }
-    if (shaderInputDesc.Type == D3D_SIT_TEXTURE) {
-      mSettings.SetSRVSettings(ConvertToCheString(shaderInputDesc.Name),
-                               SRVInfo(shaderInputDesc.BindPoint, (D3D12_SRV_DIMENSION)shaderInputDesc.Dimension));
+    // Structured buffers keep D3D12_SRV_DIMENSION_BUFFER, CreateRootSignature binds them as root SRVs.
+    if (shaderInputDesc.Type == D3D_SIT_TEXTURE || shaderInputDesc.Type == D3D_SIT_STRUCTURED) {
+      settings.SetSRVSettings(ConvertToCheString(shaderInputDesc.Name),
+                              SRVInfo(shaderInputDesc.BindPoint, (D3D12_SRV_DIMENSION)shaderInputDesc.Dimension, shaderInputDesc.BindCount));
     }
   }
 }
 
-void Shader::GenerateCBSettings(D3D12_SHADER_INPUT_BIND_DESC bindDesc, ID3D12ShaderReflectionConstantBuffer* cbReflection)
+void Shader::GenerateCBSettings(D3D12_SHADER_INPUT_BIND_DESC bindDesc, ID3D12ShaderReflectionConstantBuffer* cbReflection, ShaderSettings& settings)
 {
   // Get the varible info in the cbuffer and create the mapping.
   D3D12_SHADER_BUFFER_DESC cbufferDescs{};
@@ -81,17 +118,43 @@ void Shader::GenerateCBSettings(D3D12_SHADER_INPUT_BIND_DESC bindDesc, ID3D12Sha
     TIFF(hr);
   }
 
-  std::unordered_map<CheString, uint32> varOffsets;
+  std::unordered_map<CheString, CBufferVariable> variables;
   for (uint32 j = 0; j < cbufferDescs.Variables; ++j) {
     ID3D12ShaderReflectionVariable* cbufferVar = cbReflection->GetVariableByIndex(j);
     D3D12_SHADER_VARIABLE_DESC varDesc;
     TIFF(cbufferVar->GetDesc(&varDesc));
-    CheString varName   = ConvertToCheString(varDesc.Name);
-    varOffsets[varName] = varDesc.StartOffset;
+    CheString varName  = ConvertToCheString(varDesc.Name);
+    variables[varName] = {varDesc.StartOffset, varDesc.Size};
   }
 
   CheString cbufferName = ConvertToCheString(bindDesc.Name);
-  mSettings.SetCBSettings(cbufferName, CBufferInfo(bindDesc.BindPoint, cbufferDescs.Size, std::move(varOffsets)));
+  settings.SetCBSettings(cbufferName, CBufferInfo(bindDesc.BindPoint, cbufferDescs.Size, std::move(variables)));
+}
+
+bool Shader::ValidateCBufferLayout(const CBufferLayout& layout) const
+{
+  const CheString cbufferName(layout.Name);
+  auto iter = mSettings.GetCBSetting().find(cbufferName);
+  if (iter == mSettings.GetCBSetting().end()) {
+    logger.Error(mName + CTEXT(" has no cbuffer ") + cbufferName);
+    return false;
+  }
+
+  const auto& variables = iter->second.GetVariables();
+  bool valid            = true;
+  if (layout.FieldCount != variables.size() || layout.ByteSize > iter->second.GetByteSize()) {
+    logger.Error(mName + CTEXT(": ") + cbufferName + CTEXT(" has other variables than its generated struct, regenerate it with CBufferGen"));
+    valid = false;
+  }
+  for (uint32 i = 0; i < layout.FieldCount; ++i) {
+    const CBufferFieldLayout& field = layout.Fields[i];
+    auto variable                   = variables.find(field.Name);
+    if (variable != variables.end() && variable->second.Offset == field.Offset && variable->second.Size == field.Size) continue;
+
+    logger.Error(mName + CTEXT(": ") + cbufferName + CTEXT(".") + field.Name + CTEXT(" does not match its generated struct, regenerate it with CBufferGen"));
+    valid = false;
+  }
+  return valid;
 }
 
 void Shader::CreateRootSignature(ID3D12Device* device)
@@ -101,14 +164,52 @@ void Shader::CreateRootSignature(ID3D12Device* device)
   const uint32 paramterCount = cbufferCount + srvCount;
   vector<CD3DX12_ROOT_PARAMETER> slotRootParameter(paramterCount);
 
-  // use root descriptor
+  // DRAW cbuffers become root constants, the others root descriptors.
+  // Their variables are 32 bit scalars, one root constant each. The byte size is padded for CBVs and would waste root signature space.
+  vector<uint32> rootConstantCounts(cbufferCount, 0);
+  for (const auto& pair : mSettings.GetCBSetting()) {
+    auto config = CBufferManager::CBufferConfig.find(pair.first);
+    if (config == CBufferManager::CBufferConfig.end() || config->second != CBufferType::DRAW) continue;
+    if (pair.second.GetSlot() < cbufferCount) rootConstantCounts[pair.second.GetSlot()] = static_cast<uint32>(pair.second.GetVariables().size());
+  }
+
   for (uint32 i = 0; i < cbufferCount; ++i) {
+    if (rootConstantCounts[i] != 0) {
+      slotRootParameter[i].InitAsConstants(rootConstantCounts[i], i);
+      continue;
+    }
     slotRootParameter[i].InitAsConstantBufferView(i);
   }
 
+  vector<D3D12_SRV_DIMENSION> srvDimensions(srvCount, D3D12_SRV_DIMENSION_TEXTURE2D);
+  vector<uint32> srvBindCounts(srvCount, 1);
+  vector<CheString> srvNames(srvCount);
+  for (const auto& pair : mSettings.GetSRVSetting()) {
+    if (pair.second.GetSlot() >= srvCount) continue;
+    srvDimensions[pair.second.GetSlot()] = pair.second.GetDimension();
+    srvBindCounts[pair.second.GetSlot()] = pair.second.GetBindCount();
+    srvNames[pair.second.GetSlot()]      = pair.first;
+  }
+
+  // Unbounded ranges need resource binding tier 2, tier 1 sees at most 128 SRVs per stage.
+  D3D12_FEATURE_DATA_D3D12_OPTIONS options = {};
+  const bool optionsQueried                = SUCCEEDED(device->CheckFeatureSupport(D3D12_FEATURE_D3D12_OPTIONS, &options, sizeof(options)));
+  const bool supportsUnboundedRange        = optionsQueried && options.ResourceBindingTier >= D3D12_RESOURCE_BINDING_TIER_2;
+
   vector<CD3DX12_DESCRIPTOR_RANGE> srvTable(srvCount);
   for (uint32 i = 0; i < srvCount; ++i) {
-    srvTable[i].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, 1, i);
+    // Structured buffers are bound by address and read by any stage, e.g. instance data in the vertex shader.
+    if (srvDimensions[i] == D3D12_SRV_DIMENSION_BUFFER) {
+      slotRootParameter[i + cbufferCount].InitAsShaderResourceView(i);
+      continue;
+    }
+    // Unbounded arrays get an unbounded range, it reaches from the table start to the end of the heap.
+    if (srvBindCounts[i] == 0 && !supportsUnboundedRange) {
+      logger.Error(mName + CTEXT(": ") + srvNames[i] + CTEXT(" is an unbounded array, bindless shaders need resource binding tier 2"));
+      throw DxException(DXGI_ERROR_UNSUPPORTED, CTEXT("Shader::CreateRootSignature"), ConvertToCheString(__FILE__), __LINE__);
+    }
+    const uint32 rangeSize = srvBindCounts[i] == 0 ? UINT_MAX : srvBindCounts[i];
+    srvTable[i].Init(D3D12_DESCRIPTOR_RANGE_TYPE_SRV, rangeSize, i);
     // offset cbuffer parameter index.
     slotRootParameter[i + cbufferCount].InitAsDescriptorTable(1, &srvTable[i], D3D12_SHADER_VISIBILITY_PIXEL);
   }
@@ -131,14 +232,14 @@ void Shader::CreateRootSignature(ID3D12Device* device)
                                    IID_PPV_ARGS(mRootSignature.GetAddressOf())));
 }
 
-void Shader::BuildPassCBuffer(ID3D12Device* device)
+void Shader::BuildPassCBuffer()
 {
   for (auto pair : mSettings.GetCBSetting()) {
     auto cbName = pair.first;
     auto cbInfo = pair.second;
     // Shader just save tag:PASS data.
     if (CBufferManager::CBufferConfig[cbName] == CBufferType::PASS) {
-      mCBManager.AddCBuffer(device, cbName, cbInfo);
+      mCBManager.AddCBuffer(cbName, cbInfo);
     }
   }
 }
@@ -2,11 +2,13 @@
 #define GRAPHICS_SHADER_H
 #include "Common/TypeDef.h"
 #include <array>
+#include <unordered_map>
 #include <d3d12.h>
 #include <d3dcompiler.h>
 #include "d3dx12.h"
 #include "ShaderHelper.h"
 #include "ConstantBuffer.h"
+#include "CBufferLayout.h"
 
 enum class ShaderType : uint8 {
   VERTEX_SHADER   = 0,
@@ -20,19 +22,26 @@ class Shader
 {
  public:
   Shader(const CheString& name) : mName(name) {}
+  // Stages come from ShaderCache when neither the source nor its includes changed since they were compiled.
   void AddShader(const CheString& fileName, ShaderType type);
-  ShaderSettings GetSettings() const { return mSettings; }
+  // Compiles another vertex shader entry point, e.g. for a different input layout.
+  // Variants share the root signature, add them before CreateRootSignature.
+  void AddVSVariant(const CheString& fileName, const CheString& entryPoint);
+  const ShaderSettings& GetSettings() const { return mSettings; }
+  // Logs every variable of the reflected cbuffer that the generated layout places differently, call it after the stages are added.
+  bool ValidateCBufferLayout(const CBufferLayout& layout) const;
 
   ID3DBlob* GetVS() const { return mVsByteCode.Get(); }
   ID3DBlob* GetPS() const { return mPsByteCode.Get(); }
   ID3DBlob* GetGS() const { return mGsByteCode.Get(); }
   ID3DBlob* GetHS() const { return mHsByteCode.Get(); }
   ID3DBlob* GetDS() const { return mDsByteCode.Get(); }
+  ID3DBlob* GetVSVariant(const CheString& entryPoint) const;
 
   const CheString& GetName() const { return mName; }
 
   void CreateRootSignature(ID3D12Device* device);
-  void BuildPassCBuffer(ID3D12Device* device);
+  void BuildPassCBuffer();
   inline ID3D12RootSignature* GetRootSignature() const { return mRootSignature.Get(); }
   inline CBufferManager& GetCBufferManager() { return mCBManager; }
 
@@ -43,8 +52,11 @@ class Shader
   void AddHS(ID3DBlob* shaderByteCode);
   void AddDS(ID3DBlob* shaderByteCode);
 
-  void GenerateShaderSettings(ID3DBlob* shader);
-  void GenerateCBSettings(D3D12_SHADER_INPUT_BIND_DESC bindDesc, ID3D12ShaderReflectionConstantBuffer* cbReflection);
+  // Loads the stage and its settings from ShaderCache, compiles and reflects it on a miss. The settings are added to mSettings.
+  // nullptr when the stage does not compile, the compiler errors are logged.
+  ComPtr<ID3DBlob> CompileStage(const CheString& fileName, const CheString& entryPoint, const CheString& target);
+  static void GenerateShaderSettings(ID3DBlob* shader, ShaderSettings& settings);
+  static void GenerateCBSettings(D3D12_SHADER_INPUT_BIND_DESC bindDesc, ID3D12ShaderReflectionConstantBuffer* cbReflection, ShaderSettings& settings);
 
   std::array<const CD3DX12_STATIC_SAMPLER_DESC, 7> GetStaticSamplers();
 
@@ -54,6 +66,8 @@ class Shader
   ComPtr<ID3DBlob> mGsByteCode = nullptr;
   ComPtr<ID3DBlob> mHsByteCode = nullptr;
   ComPtr<ID3DBlob> mDsByteCode = nullptr;
+  // Entry point: vertex shader variant.
+  std::unordered_map<CheString, ComPtr<ID3DBlob>> mVsVariants;
 
   CheString mName;
   ShaderSettings mSettings;
@@ -0,0 +1,288 @@
+#include "ShaderCache.h"
+
+#include <cstring>
+#include <fstream>
+#include <iterator>
+
+#include "Utils/Log/Logger.h"
+
+const uint32 ShaderCache::MAGIC;
+const uint32 ShaderCache::VERSION;
+const uint64 ShaderCache::INVALID_KEY;
+
+namespace {
+// 64 bit FNV-1a, fields are hashed with their length so their boundaries count.
+const uint64 FNV_OFFSET_BASIS = 14695981039346656037ull;
+const uint64 FNV_PRIME        = 1099511628211ull;
+
+struct EntryHeader {
+  uint32 Magic;
+  uint32 Version;
+  uint64 Key;
+  uint64 ByteCodeSize;
+  uint64 SettingsSize;
+};
+
+void HashBytes(uint64& hash, const void* data, uint64 size)
+{
+  const Byte* bytes = static_cast<const Byte*>(data);
+  for (uint64 i = 0; i < size; ++i) {
+    hash ^= bytes[i];
+    hash *= FNV_PRIME;
+  }
+}
+
+template <typename T>
+void HashValue(uint64& hash, const T& value)
+{
+  HashBytes(hash, &value, sizeof(T));
+}
+
+void HashString(uint64& hash, const std::string& str)
+{
+  HashValue(hash, static_cast<uint64>(str.size()));
+  HashBytes(hash, str.data(), str.size());
+}
+
+bool ReadFile(const CheString& fileName, std::string& content)
+{
+  std::ifstream fin(fileName, std::ios::binary);
+  if (!fin) return false;
+  content.assign(std::istreambuf_iterator<char>(fin), std::istreambuf_iterator<char>());
+  return true;
+}
+
+// Names of the #include directives of source in order, quoted and angled alike.
+void FindIncludes(const std::string& source, std::vector<std::string>& includes)
+{
+  const char* const SPACES = " \t";
+  size_t lineStart         = 0;
+  while (lineStart < source.size()) {
+    size_t lineEnd = source.find('\n', lineStart);
+    if (lineEnd == std::string::npos) lineEnd = source.size();
+
+    size_t pos = source.find_first_not_of(SPACES, lineStart);
+    if (pos < lineEnd && source[pos] == '#') {
+      pos = source.find_first_not_of(SPACES, pos + 1);
+      if (pos < lineEnd && source.compare(pos, 7, "include") == 0) {
+        pos = source.find_first_not_of(SPACES, pos + 7);
+        if (pos < lineEnd && (source[pos] == '"' || source[pos] == '<')) {
+          const size_t nameEnd = source.find(source[pos] == '"' ? '"' : '>', pos + 1);
+          if (nameEnd < lineEnd) includes.push_back(source.substr(pos + 1, nameEnd - pos - 1));
+        }
+      }
+    }
+    lineStart = lineEnd + 1;
+  }
+}
+
+// Hashes fileName and then the files it includes depth first, each file once.
+bool HashSource(uint64& hash, const CheString& fileName, std::vector<CheString>& visited)
+{
+  visited.push_back(fileName);
+  std::string source;
+  if (!ReadFile(fileName, source)) return false;
+  HashString(hash, ConvertToMultiByte(fileName));
+  HashString(hash, source);
+
+  std::vector<std::string> includes;
+  FindIncludes(source, includes);
+  const size_t dirEnd     = fileName.find_last_of(CTEXT("/\\"));
+  const CheString baseDir = dirEnd == CheString::npos ? CheString() : fileName.substr(0, dirEnd + 1);
+  for (const std::string& include : includes) {
+    const CheString includePath = baseDir + ConvertToCheString(include.c_str());
+    bool isVisited              = false;
+    for (const CheString& path : visited) isVisited |= path == includePath;
+    if (isVisited) continue;
+    if (!HashSource(hash, includePath, visited)) HashString(hash, include);
+  }
+  return true;
+}
+
+template <typename T>
+void Write(std::vector<Byte>& out, const T& value)
+{
+  const Byte* bytes = reinterpret_cast<const Byte*>(&value);
+  out.insert(out.end(), bytes, bytes + sizeof(T));
+}
+
+void WriteString(std::vector<Byte>& out, const CheString& str)
+{
+  const std::string multiByte = ConvertToMultiByte(str);
+  Write(out, static_cast<uint32>(multiByte.size()));
+  out.insert(out.end(), multiByte.begin(), multiByte.end());
+}
+
+// Reads values back in the order Write put them, fails instead of reading past the end.
+class Reader
+{
+ public:
+  Reader(const Byte* data, uint64 size) : mData(data), mSize(size) {}
+
+  template <typename T>
+  bool Read(T& value)
+  {
+    if (sizeof(T) > mSize - mOffset) return false;
+    memcpy(&value, mData + mOffset, sizeof(T));
+    mOffset += sizeof(T);
+    return true;
+  }
+
+  bool ReadString(CheString& str)
+  {
+    uint32 size = 0;
+    if (!Read(size) || size > mSize - mOffset) return false;
+    str = ConvertToCheString(std::string(reinterpret_cast<const char*>(mData + mOffset), size).c_str());
+    mOffset += size;
+    return true;
+  }
+
+  inline bool IsAtEnd() const { return mOffset == mSize; }
+
+ private:
+  const Byte* mData;
+  uint64 mSize;
+  uint64 mOffset = 0;
+};
+
+void SerializeSettings(const ShaderSettings& settings, std::vector<Byte>& out)
+{
+  Write(out, settings.GetCBSettingCount());
+  for (const auto& pair : settings.GetCBSetting()) {
+    WriteString(out, pair.first);
+    Write(out, pair.second.GetSlot());
+    Write(out, pair.second.GetByteSize());
+    Write(out, static_cast<uint32>(pair.second.GetVariables().size()));
+    for (const auto& variable : pair.second.GetVariables()) {
+      WriteString(out, variable.first);
+      Write(out, variable.second);
+    }
+  }
+  Write(out, settings.GetSRVSettingCount());
+  for (const auto& pair : settings.GetSRVSetting()) {
+    WriteString(out, pair.first);
+    Write(out, pair.second.GetSlot());
+    Write(out, static_cast<uint32>(pair.second.GetDimension()));
+    Write(out, pair.second.GetBindCount());
+  }
+}
+
+bool DeserializeSettings(Reader& reader, ShaderSettings& settings)
+{
+  std::unordered_map<CheString, CBufferInfo> cbSettings;
+  uint32 cbCount = 0;
+  if (!reader.Read(cbCount)) return false;
+  for (uint32 i = 0; i < cbCount; ++i) {
+    CheString name;
+    uint32 slot     = 0;
+    uint32 byteSize = 0;
+    uint32 varCount = 0;
+    if (!reader.ReadString(name) || !reader.Read(slot) || !reader.Read(byteSize) || !reader.Read(varCount)) return false;
+
+    std::unordered_map<CheString, CBufferVariable> variables;
+    for (uint32 j = 0; j < varCount; ++j) {
+      CheString varName;
+      CBufferVariable variable;
+      if (!reader.ReadString(varName) || !reader.Read(variable)) return false;
+      variables[varName] = variable;
+    }
+    cbSettings[name] = CBufferInfo(slot, byteSize, std::move(variables));
+  }
+
+  std::unordered_map<CheString, SRVInfo> srvSettings;
+  uint32 srvCount = 0;
+  if (!reader.Read(srvCount)) return false;
+  for (uint32 i = 0; i < srvCount; ++i) {
+    CheString name;
+    uint32 slot      = 0;
+    uint32 dimension = 0;
+    uint32 bindCount = 0;
+    if (!reader.ReadString(name) || !reader.Read(slot) || !reader.Read(dimension) || !reader.Read(bindCount)) return false;
+    srvSettings.emplace(name, SRVInfo(slot, static_cast<D3D12_SRV_DIMENSION>(dimension), bindCount));
+  }
+
+  settings = ShaderSettings(std::move(cbSettings), std::move(srvSettings));
+  return true;
+}
+}  // namespace
+
+ShaderCache& ShaderCache::Get()
+{
+  static ShaderCache cache(CTEXT("ShaderCache"));
+  return cache;
+}
+
+uint64 ShaderCache::MakeKey(const CheString& fileName, const D3D_SHADER_MACRO* defines, const CheString& entryPoint, const CheString& target,
+                            uint32 flags) const
+{
+  uint64 hash = FNV_OFFSET_BASIS;
+  HashValue(hash, VERSION);
+  HashValue(hash, static_cast<uint32>(D3D_COMPILER_VERSION));
+  HashValue(hash, flags);
+  HashString(hash, ConvertToMultiByte(entryPoint));
+  HashString(hash, ConvertToMultiByte(target));
+  for (const D3D_SHADER_MACRO* define = defines; define != nullptr && define->Name != nullptr; ++define) {
+    HashString(hash, define->Name);
+    HashString(hash, define->Definition != nullptr ? define->Definition : "");
+  }
+
+  std::vector<CheString> visited;
+  if (!HashSource(hash, fileName, visited)) return INVALID_KEY;
+  return hash != INVALID_KEY ? hash : hash + 1;
+}
+
+bool ShaderCache::Load(uint64 key, Entry& entry) const
+{
+  std::string content;
+  if (key == INVALID_KEY || !ReadFile(GetEntryPath(key), content)) return false;
+
+  EntryHeader header;
+  if (content.size() < sizeof(EntryHeader)) return false;
+  memcpy(&header, content.data(), sizeof(EntryHeader));
+  const uint64 payloadSize = content.size() - sizeof(EntryHeader);
+  if (header.Magic != MAGIC || header.Version != VERSION || header.Key != key || header.ByteCodeSize > payloadSize ||
+      header.SettingsSize != payloadSize - header.ByteCodeSize) {
+    return false;
+  }
+
+  const Byte* byteCode = reinterpret_cast<const Byte*>(content.data()) + sizeof(EntryHeader);
+  Reader reader(byteCode + header.ByteCodeSize, header.SettingsSize);
+  if (!DeserializeSettings(reader, entry.Settings) || !reader.IsAtEnd()) return false;
+  entry.ByteCode.assign(byteCode, byteCode + header.ByteCodeSize);
+  return true;
+}
+
+bool ShaderCache::Store(uint64 key, const void* byteCode, uint64 byteCodeSize, const ShaderSettings& settings) const
+{
+  if (key == INVALID_KEY) return false;
+
+  std::vector<Byte> serializedSettings;
+  SerializeSettings(settings, serializedSettings);
+  EntryHeader header  = {};
+  header.Magic        = MAGIC;
+  header.Version      = VERSION;
+  header.Key          = key;
+  header.ByteCodeSize = byteCodeSize;
+  header.SettingsSize = serializedSettings.size();
+
+  // Fails harmlessly when the directory is there. Entries cut short by a crash are rejected by Load and written again.
+  CreateDirectory(mDirectory.c_str(), nullptr);
+  const CheString path = GetEntryPath(key);
+  std::ofstream fout(path, std::ios::binary | std::ios::trunc);
+  fout.write(reinterpret_cast<const char*>(&header), sizeof(EntryHeader));
+  fout.write(static_cast<const char*>(byteCode), static_cast<std::streamsize>(byteCodeSize));
+  fout.write(reinterpret_cast<const char*>(serializedSettings.data()), static_cast<std::streamsize>(serializedSettings.size()));
+  if (!fout) {
+    logger.Error(CTEXT("Can't write shader cache entry: ") + path);
+    return false;
+  }
+  return true;
+}
+
+CheString ShaderCache::GetEntryPath(uint64 key) const
+{
+  const CheChar* const DIGITS = CTEXT("0123456789abcdef");
+  CheString name(16, DIGITS[0]);
+  for (uint32 i = 0; i < 16; ++i) name[15 - i] = DIGITS[(key >> (i * 4)) & 0xF];
+  return mDirectory + CTEXT("/") + name + CTEXT(".chs");
+}
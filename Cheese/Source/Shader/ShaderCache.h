@@ -0,0 +1,44 @@
+#ifndef SHADER_SHADER_CACHE_H
+#define SHADER_SHADER_CACHE_H
+#include <d3dcompiler.h>
+
+#include <vector>
+
+#include "Common/TypeDef.h"
+#include "Core/Helpers.h"
+#include "ShaderHelper.h"
+
+// Compiled shader stages on disk together with the ShaderSettings reflected from them, a warm start neither compiles nor reflects.
+// Entries are named by a hash of everything the compiler reads: the source and the files it includes, the defines, the entry point,
+// the target, the flags and the compiler version. Editing any of them misses, the stage is compiled again and stored next to the old entry.
+class ShaderCache
+{
+ public:
+  static const uint32 MAGIC       = 0x00435343;  // "CSC\0"
+  static const uint32 VERSION     = 1;
+  static const uint64 INVALID_KEY = 0;
+
+  struct Entry {
+    std::vector<Byte> ByteCode;
+    ShaderSettings Settings;
+  };
+
+  explicit ShaderCache(const CheString& directory) : mDirectory(directory) {}
+  NO_COPY(ShaderCache)
+
+  // Entries in ShaderCache/ under the working directory, next to Shaders/.
+  static ShaderCache& Get();
+
+  // INVALID_KEY when the source can't be read. Includes are resolved against the including file like D3D_COMPILE_STANDARD_FILE_INCLUDE,
+  // the ones that can't be read only add their name, e.g. includes of inactive #if blocks.
+  uint64 MakeKey(const CheString& fileName, const D3D_SHADER_MACRO* defines, const CheString& entryPoint, const CheString& target, uint32 flags) const;
+  // False on a miss and for entries that are truncated or written by another VERSION.
+  bool Load(uint64 key, Entry& entry) const;
+  bool Store(uint64 key, const void* byteCode, uint64 byteCodeSize, const ShaderSettings& settings) const;
+
+  CheString GetEntryPath(uint64 key) const;
+
+ private:
+  CheString mDirectory;
+};
+#endif  // SHADER_SHADER_CACHE_H
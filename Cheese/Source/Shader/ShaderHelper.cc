@@ -1,36 +1,36 @@
 #include "ShaderHelper.h"
 
-CBufferInfo::CBufferInfo() : CBufferInfo(UNINIT_SLOT_VALUE, 0, std::move(std::unordered_map<CheString, uint32>())) {}
+CBufferInfo::CBufferInfo() : CBufferInfo(UNINIT_SLOT_VALUE, 0, std::move(std::unordered_map<CheString, CBufferVariable>())) {}
 
-CBufferInfo::CBufferInfo(uint32 slot, uint32 byteSize, const std::unordered_map<CheString, uint32>& varOffsets)
-    : mSlot(slot), mByteSize(byteSize), mVariableOffsets(varOffsets)
+CBufferInfo::CBufferInfo(uint32 slot, uint32 byteSize, const std::unordered_map<CheString, CBufferVariable>& variables)
+    : mSlot(slot), mByteSize(byteSize), mVariables(variables)
 {
   mByteSize = CalcAlignBufferByteSize(mByteSize);
 }
 
-CBufferInfo::CBufferInfo(uint32 slot, uint32 byteSize, std::unordered_map<CheString, uint32>&& varOffsets)
-    : mSlot(slot), mByteSize(byteSize), mVariableOffsets(std::move(varOffsets))
+CBufferInfo::CBufferInfo(uint32 slot, uint32 byteSize, std::unordered_map<CheString, CBufferVariable>&& variables)
+    : mSlot(slot), mByteSize(byteSize), mVariables(std::move(variables))
 {
   mByteSize = CalcAlignBufferByteSize(mByteSize);
 }
 
-CBufferInfo::CBufferInfo(const CBufferInfo& rhs) : CBufferInfo(rhs.mSlot, rhs.mByteSize, rhs.mVariableOffsets) {}
+CBufferInfo::CBufferInfo(const CBufferInfo& rhs) : CBufferInfo(rhs.mSlot, rhs.mByteSize, rhs.mVariables) {}
 
-CBufferInfo::CBufferInfo(CBufferInfo&& rhs) noexcept : CBufferInfo(rhs.mSlot, rhs.mByteSize, std::move(rhs.mVariableOffsets)) {}
+CBufferInfo::CBufferInfo(CBufferInfo&& rhs) noexcept : CBufferInfo(rhs.mSlot, rhs.mByteSize, std::move(rhs.mVariables)) {}
 
 const CBufferInfo& CBufferInfo::operator=(CBufferInfo&& rhs) noexcept
 {
-  mSlot            = rhs.mSlot;
-  mByteSize        = rhs.mByteSize;
-  mVariableOffsets = std::move(rhs.mVariableOffsets);
+  mSlot      = rhs.mSlot;
+  mByteSize  = rhs.mByteSize;
+  mVariables = std::move(rhs.mVariables);
   return (*this);
 }
 
 const CBufferInfo& CBufferInfo::operator=(const CBufferInfo& rhs)
 {
-  mSlot            = rhs.mSlot;
-  mByteSize        = rhs.mByteSize;
-  mVariableOffsets = rhs.mVariableOffsets;
+  mSlot      = rhs.mSlot;
+  mByteSize  = rhs.mByteSize;
+  mVariables = rhs.mVariables;
   return (*this);
 }
 
@@ -38,7 +38,7 @@ uint32 CBufferInfo::CalcAlignBufferByteSize(uint32 byteSize, uint32 alignSize)
 {
   // Addition carry,clear low bit
   const uint32 clearBit = alignSize - 1;
-  return (byteSize + (clearBit - 1)) & ~(clearBit - 1);
+  return (byteSize + clearBit) & ~clearBit;
 }
 
 ShaderSettings::ShaderSettings() : mCBufferSettings(), mSRVSettings() {}
@@ -11,13 +11,19 @@
 #define UNINIT_SLOT_VALUE -1
 #define CONSTANT_BUFFER_ALIGN_SIZE 256
 
+// Byte range of a variable in its cbuffer, from reflection.
+struct CBufferVariable {
+  uint32 Offset;
+  uint32 Size;
+};
+
 class CBufferInfo {
  public:
   CBufferInfo();
   CBufferInfo(uint32 slot, uint32 byteSize,
-              const std::unordered_map<CheString, uint32>& varOffsets);
+              const std::unordered_map<CheString, CBufferVariable>& variables);
   CBufferInfo(uint32 slot, uint32 byteSize,
-              std::unordered_map<CheString, uint32>&& varOffsets);
+              std::unordered_map<CheString, CBufferVariable>&& variables);
   CBufferInfo(const CBufferInfo& rhs);
   CBufferInfo(CBufferInfo&& rhs) noexcept;
 
@@ -28,8 +34,9 @@ class CBufferInfo {
 
   inline uint32 GetSlot() const { return mSlot; }
   inline uint32 GetByteSize() const { return mByteSize; }
-  inline std::unordered_map<CheString, uint32> GetVariableOffsets() const {
-    return mVariableOffsets;
+  inline const std::unordered_map<CheString, CBufferVariable>& GetVariables()
+      const {
+    return mVariables;
   }
 
   inline static uint32 CalcAlignBufferByteSize(
@@ -38,24 +45,28 @@ class CBufferInfo {
  private:
   uint32 mSlot;
   uint32 mByteSize;
-  std::unordered_map<CheString, uint32> mVariableOffsets;
+  std::unordered_map<CheString, CBufferVariable> mVariables;
 };
 
 class SRVInfo {
  public:
   SRVInfo() : SRVInfo(UNINIT_SLOT_VALUE, D3D12_SRV_DIMENSION_TEXTURE2D) {}
-  SRVInfo(uint32 slot, D3D12_SRV_DIMENSION dimension)
-      : mSlot(slot), mDimension(dimension) {}
-  SRVInfo(const SRVInfo& rhs) : SRVInfo(rhs.mSlot, rhs.mDimension) {}
+  // bindCount is the array size, 0 for unbounded arrays.
+  SRVInfo(uint32 slot, D3D12_SRV_DIMENSION dimension, uint32 bindCount = 1)
+      : mSlot(slot), mDimension(dimension), mBindCount(bindCount) {}
+  SRVInfo(const SRVInfo& rhs)
+      : SRVInfo(rhs.mSlot, rhs.mDimension, rhs.mBindCount) {}
 
   ~SRVInfo() {}
 
   inline uint32 GetSlot() const { return mSlot; }
   inline D3D12_SRV_DIMENSION GetDimension() const { return mDimension; }
+  inline uint32 GetBindCount() const { return mBindCount; }
 
  private:
   uint32 mSlot;
   D3D12_SRV_DIMENSION mDimension;
+  uint32 mBindCount;
 };
 
 class ShaderSettings {
@@ -78,10 +89,11 @@ class ShaderSettings {
     return static_cast<uint32>(mSRVSettings.size());
   }
 
-  inline std::unordered_map<CheString, CBufferInfo> GetCBSetting() const {
+  inline const std::unordered_map<CheString, CBufferInfo>& GetCBSetting()
+      const {
     return mCBufferSettings;
   }
-  inline std::unordered_map<CheString, SRVInfo> GetSRVSetting() const {
+  inline const std::unordered_map<CheString, SRVInfo>& GetSRVSetting() const {
     return mSRVSettings;
   }
 
@@ -2,6 +2,8 @@
 #define SHADER_SHADER_RESOURCE_H
 #include <DirectXMath.h>
 
+#include "Common/TypeDef.h"
+
 struct PointLight {
   DirectX::XMFLOAT3 strength;
   float falloffStart;
@@ -24,4 +26,13 @@ struct MaterialDesc {
   float Roughness;
 };
 
+// Element of the per frame instance buffer, the matrices are transposed like the cbuffer ones.
+struct InstanceData {
+  DirectX::XMFLOAT4X4 World;
+  DirectX::XMFLOAT4X4 PrevWorld;
+  // Index into the material table of the RenderData.
+  uint32 MaterialIndex;
+  uint32 Pad[3];
+};
+
 #endif  // SHADER_SHADER_RESOURCE_H
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include "Utils/AllocationCounter.h"
+
+#include <atomic>
+#include <cstdlib>
+#include <new>
+
+namespace {
+// Constant initialized, so allocations during static initialization are counted too.
+std::atomic<uint64> sAllocationCount{0};
+}  // namespace
+
+uint64 AllocationCounter::GetAllocationCount() { return sAllocationCount.load(std::memory_order_relaxed); }
+
+// Replacements of the global operators. They live in the same object as GetAllocationCount,
+// so linking the counter from the static library also links them.
+void* operator new(size_t byteSize)
+{
+  sAllocationCount.fetch_add(1, std::memory_order_relaxed);
+  for (;;) {
+    if (void* ptr = malloc(byteSize != 0 ? byteSize : 1)) return ptr;
+    std::new_handler handler = std::get_new_handler();
+    if (handler == nullptr) throw std::bad_alloc();
+    handler();
+  }
+}
+
+void* operator new(size_t byteSize, const std::nothrow_t&) noexcept
+{
+  try {
+    return operator new(byteSize);
+  } catch (...) {
+    return nullptr;
+  }
+}
+
+void* operator new[](size_t byteSize) { return operator new(byteSize); }
+void* operator new[](size_t byteSize, const std::nothrow_t& tag) noexcept { return operator new(byteSize, tag); }
+
+void operator delete(void* ptr) noexcept { free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { free(ptr); }
+void operator delete(void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
+void operator delete[](void* ptr) noexcept { free(ptr); }
+void operator delete[](void* ptr, size_t) noexcept { free(ptr); }
+void operator delete[](void* ptr, const std::nothrow_t&) noexcept { free(ptr); }
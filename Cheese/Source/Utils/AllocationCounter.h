@@ -0,0 +1,27 @@
+#ifndef UTILS_ALLOCATION_COUNTER_H
+#define UTILS_ALLOCATION_COUNTER_H
+#include "Common/Types.h"
+#include "Core/Helpers.h"
+
+// Heap allocations made by the process, for checking that per frame loops do not allocate.
+// Every thread is counted, so work fanned out over the ThreadPool is included, and so is whatever runs in the background meanwhile.
+// The global operator new is replaced in every build, the count costs one relaxed atomic increment per allocation.
+class AllocationCounter
+{
+ public:
+  static uint64 GetAllocationCount();
+};
+
+// Counts the allocations of the process from construction on.
+class AllocationScope
+{
+ public:
+  AllocationScope() : mStart(AllocationCounter::GetAllocationCount()) {}
+  NO_COPY(AllocationScope)
+
+  inline uint64 GetCount() const { return AllocationCounter::GetAllocationCount() - mStart; }
+
+ private:
+  uint64 mStart;
+};
+#endif  // UTILS_ALLOCATION_COUNTER_H
@@ -0,0 +1,29 @@
+#include "Utils/CpuFeatures.h"
+
+#if defined(_MSC_VER)
+#include <immintrin.h>
+#include <intrin.h>
+#endif
+
+bool IsAvx2Supported()
+{
+  static const bool supported = []() {
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) return false;
+
+    // AVX and OSXSAVE, then the OS has to save the YMM registers on context switches.
+    __cpuid(info, 1);
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0) return false;
+    if ((_xgetbv(0) & 0x6) != 0x6) return false;
+
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    // Checks the OS support as well.
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+  }();
+  return supported;
+}
@@ -0,0 +1,23 @@
+#ifndef UTILS_CPU_FEATURES_H
+#define UTILS_CPU_FEATURES_H
+#include "Common/Types.h"
+
+// Code paths of the SIMD kernels, e.g. of FrustumCuller and OcclusionCuller.
+enum class SimdKernel : uint8 {
+  SCALAR,
+  // 4 lanes per step.
+  SSE,
+  // 8 lanes per step, only picked when the CPU and OS support AVX2.
+  AVX2,
+};
+
+// Whether the CPU has AVX2 and the OS saves the YMM registers on context switches. Checked once.
+bool IsAvx2Supported();
+
+// MSVC compiles AVX2 intrinsics in any function, GCC and Clang only in functions targeting AVX2.
+#if defined(__GNUC__)
+#define TARGET_AVX2 __attribute__((target("avx2")))
+#else
+#define TARGET_AVX2
+#endif
+#endif  // UTILS_CPU_FEATURES_H
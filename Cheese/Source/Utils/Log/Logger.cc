@@ -5,10 +5,26 @@ Logger logger;
 
 void Logger::SetLogDevice(ILogDevice* device) { logger.mDevice = device; }
 
-void Logger::Debug(const CheString& info) { mDevice->DebugMsg(info); }
+void Logger::Debug(const CheString& info)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mDevice->DebugMsg(info);
+}
 
-void Logger::Info(const CheString& info) { mDevice->InfoMsg(info); }
+void Logger::Info(const CheString& info)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mDevice->InfoMsg(info);
+}
 
-void Logger::Warning(const CheString& info) { mDevice->WarningMsg(info); }
+void Logger::Warning(const CheString& info)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mDevice->WarningMsg(info);
+}
 
-void Logger::Error(const CheString& info) { mDevice->ErrorMsg(info); }
+void Logger::Error(const CheString& info)
+{
+  std::lock_guard<std::mutex> lock(mMutex);
+  mDevice->ErrorMsg(info);
+}
@@ -2,8 +2,10 @@
 #define UTILS_LOG_LOGGER
 #include "ILogDevice.h"
 #include <memory>
+#include <mutex>
 #include "Common/TypeDef.h"
 
+// Messages may come from any thread, e.g. background model decoding.
 class Logger
 {
  public:
@@ -15,6 +17,7 @@ class Logger
 
  private:
   ILogDevice* mDevice = nullptr;
+  std::mutex mMutex;
 };
 
 extern Logger logger;
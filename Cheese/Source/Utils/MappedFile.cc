@@ -0,0 +1,81 @@
+#include "MappedFile.h"
+
+#include "Utils/Log/Logger.h"
+
+MappedFile::~MappedFile() { Close(); }
+
+MappedFile::MappedFile(MappedFile&& rhs) noexcept : mFile(rhs.mFile), mMapping(rhs.mMapping), mData(rhs.mData), mSize(rhs.mSize)
+{
+  rhs.mFile    = INVALID_HANDLE_VALUE;
+  rhs.mMapping = nullptr;
+  rhs.mData    = nullptr;
+  rhs.mSize    = 0;
+}
+
+MappedFile& MappedFile::operator=(MappedFile&& rhs) noexcept
+{
+  if (this != &rhs) {
+    Close();
+    mFile        = rhs.mFile;
+    mMapping     = rhs.mMapping;
+    mData        = rhs.mData;
+    mSize        = rhs.mSize;
+    rhs.mFile    = INVALID_HANDLE_VALUE;
+    rhs.mMapping = nullptr;
+    rhs.mData    = nullptr;
+    rhs.mSize    = 0;
+  }
+  return *this;
+}
+
+bool MappedFile::Open(const CheString& fileName)
+{
+  Close();
+
+  mFile = CreateFile(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+  if (mFile == INVALID_HANDLE_VALUE) {
+    logger.Error(CTEXT("Can't open file: ") + fileName);
+    return false;
+  }
+
+  LARGE_INTEGER fileSize;
+  if (!GetFileSizeEx(mFile, &fileSize) || fileSize.QuadPart == 0) {
+    // A zero-byte file can't be mapped.
+    logger.Error(CTEXT("Can't map empty file: ") + fileName);
+    Close();
+    return false;
+  }
+
+  mMapping = CreateFileMapping(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+  if (mMapping == nullptr) {
+    logger.Error(CTEXT("Can't create file mapping: ") + fileName);
+    Close();
+    return false;
+  }
+
+  mData = static_cast<const Byte*>(MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0));
+  if (mData == nullptr) {
+    logger.Error(CTEXT("Can't map view of file: ") + fileName);
+    Close();
+    return false;
+  }
+  mSize = static_cast<uint64>(fileSize.QuadPart);
+  return true;
+}
+
+void MappedFile::Close()
+{
+  if (mData != nullptr) {
+    UnmapViewOfFile(mData);
+    mData = nullptr;
+  }
+  if (mMapping != nullptr) {
+    CloseHandle(mMapping);
+    mMapping = nullptr;
+  }
+  if (mFile != INVALID_HANDLE_VALUE) {
+    CloseHandle(mFile);
+    mFile = INVALID_HANDLE_VALUE;
+  }
+  mSize = 0;
+}
@@ -0,0 +1,31 @@
+#ifndef UTILS_MAPPED_FILE_H
+#define UTILS_MAPPED_FILE_H
+#include "Common/TypeDef.h"
+#include "Core/Helpers.h"
+
+// Read-only view of a whole file mapped into the address space.
+class MappedFile
+{
+ public:
+  MappedFile() = default;
+  ~MappedFile();
+
+  MappedFile(MappedFile&& rhs) noexcept;
+  MappedFile& operator=(MappedFile&& rhs) noexcept;
+
+  NO_COPY(MappedFile)
+
+  bool Open(const CheString& fileName);
+  void Close();
+
+  inline bool IsOpen() const { return mData != nullptr; }
+  inline const Byte* GetData() const { return mData; }
+  inline uint64 GetSize() const { return mSize; }
+
+ private:
+  HANDLE mFile      = INVALID_HANDLE_VALUE;
+  HANDLE mMapping   = nullptr;
+  const Byte* mData = nullptr;
+  uint64 mSize      = 0;
+};
+#endif  // UTILS_MAPPED_FILE_H
@@ -0,0 +1,129 @@
+#include "ThreadPool.h"
+
+namespace {
+thread_local bool sIsWorkerThread = false;
+}
+
+ThreadPool::ThreadPool(uint32 threadCount)
+{
+  if (threadCount == 0) {
+    const uint32 hardwareThreads = std::thread::hardware_concurrency();
+    threadCount                  = hardwareThreads > 1 ? hardwareThreads - 1 : 1;
+  }
+
+  mWorkers.reserve(threadCount);
+  for (uint32 i = 0; i < threadCount; ++i) {
+    mWorkers.emplace_back(&ThreadPool::WorkerLoop, this);
+  }
+}
+
+ThreadPool::~ThreadPool()
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mStop = true;
+  }
+  mWakeCondition.notify_all();
+  for (std::thread& worker : mWorkers) {
+    worker.join();
+  }
+}
+
+ThreadPool& ThreadPool::Get()
+{
+  static ThreadPool pool;
+  return pool;
+}
+
+void ThreadPool::Submit(std::function<void()> job)
+{
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mJobs.push(std::move(job));
+  }
+  mWakeCondition.notify_one();
+}
+
+void ThreadPool::ParallelFor(uint32 count, RangeFunc func, const void* context)
+{
+  if (count == 0) return;
+
+  if (sIsWorkerThread || mWorkers.empty() || count == 1) {
+    for (uint32 i = 0; i < count; ++i) {
+      func(context, i);
+    }
+    return;
+  }
+
+  std::lock_guard<std::mutex> rangeLock(mRangeMutex);
+  {
+    std::lock_guard<std::mutex> lock(mMutex);
+    mRangeFunc    = func;
+    mRangeContext = context;
+    mRangeCount   = count;
+    mRangeNext.store(0);
+    mRangeDone.store(0);
+    ++mRangeGeneration;
+  }
+  mWakeCondition.notify_all();
+
+  // The calling thread works on the range too, so progress never depends on idle workers.
+  RunRange();
+
+  std::unique_lock<std::mutex> lock(mMutex);
+  mRangeDoneCondition.wait(lock, [this] { return mRangeDone.load() == mRangeCount && mRangeWorkers == 0; });
+  mRangeFunc    = nullptr;
+  mRangeContext = nullptr;
+}
+
+void ThreadPool::WorkerLoop()
+{
+  sIsWorkerThread = true;
+
+  uint64 seenGeneration = 0;
+  while (true) {
+    std::function<void()> job;
+    {
+      std::unique_lock<std::mutex> lock(mMutex);
+      mWakeCondition.wait(lock, [&] { return mStop || !mJobs.empty() || (mRangeFunc != nullptr && mRangeGeneration != seenGeneration); });
+
+      if (mRangeFunc != nullptr && mRangeGeneration != seenGeneration) {
+        seenGeneration = mRangeGeneration;
+        ++mRangeWorkers;
+      } else if (!mJobs.empty()) {
+        job = std::move(mJobs.front());
+        mJobs.pop();
+      } else {
+        // mStop with nothing left to do.
+        return;
+      }
+    }
+
+    if (job) {
+      job();
+      continue;
+    }
+
+    RunRange();
+    {
+      std::lock_guard<std::mutex> lock(mMutex);
+      --mRangeWorkers;
+    }
+    mRangeDoneCondition.notify_all();
+  }
+}
+
+void ThreadPool::RunRange()
+{
+  while (true) {
+    const uint32 index = mRangeNext.fetch_add(1);
+    if (index >= mRangeCount) break;
+
+    mRangeFunc(mRangeContext, index);
+
+    if (mRangeDone.fetch_add(1) + 1 == mRangeCount) {
+      std::lock_guard<std::mutex> lock(mMutex);
+      mRangeDoneCondition.notify_all();
+    }
+  }
+}
@@ -0,0 +1,72 @@
+#ifndef UTILS_THREAD_POOL_H
+#define UTILS_THREAD_POOL_H
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+#include "Common/TypeDef.h"
+#include "Core/Helpers.h"
+
+// A fixed set of worker threads.
+// Submit() queues fire-and-forget jobs, ParallelFor() fans an index range out
+// over the workers and the calling thread without allocating.
+class ThreadPool
+{
+ public:
+  using RangeFunc = void (*)(const void* context, uint32 index);
+
+  // threadCount == 0 uses one worker per hardware thread minus the caller.
+  explicit ThreadPool(uint32 threadCount = 0);
+  ~ThreadPool();
+
+  NO_COPY(ThreadPool)
+
+  void Submit(std::function<void()> job);
+
+  // Calls func(i) for every i in [0, count) and returns once all calls are done.
+  // Nested calls from a worker thread run inline.
+  template <typename Func>
+  inline void ParallelFor(uint32 count, const Func& func)
+  {
+    ParallelFor(count, &InvokeRange<Func>, &func);
+  }
+  void ParallelFor(uint32 count, RangeFunc func, const void* context);
+
+  inline uint32 GetThreadCount() const { return static_cast<uint32>(mWorkers.size()); }
+
+  static ThreadPool& Get();
+
+ private:
+  template <typename Func>
+  static void InvokeRange(const void* context, uint32 index)
+  {
+    (*static_cast<const Func*>(context))(index);
+  }
+
+  void WorkerLoop();
+  void RunRange();
+
+ private:
+  std::vector<std::thread> mWorkers;
+
+  std::mutex mMutex;
+  std::condition_variable mWakeCondition;
+  std::condition_variable mRangeDoneCondition;
+  std::queue<std::function<void()>> mJobs;
+  bool mStop = false;
+
+  // Only one ParallelFor range is in flight at a time.
+  std::mutex mRangeMutex;
+  RangeFunc mRangeFunc      = nullptr;
+  const void* mRangeContext = nullptr;
+  uint32 mRangeCount        = 0;
+  uint32 mRangeWorkers      = 0;
+  uint64 mRangeGeneration   = 0;
+  std::atomic<uint32> mRangeNext{0};
+  std::atomic<uint32> mRangeDone{0};
+};
+#endif  // UTILS_THREAD_POOL_H
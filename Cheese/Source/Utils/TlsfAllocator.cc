@@ -0,0 +1,296 @@
+#include "Utils/TlsfAllocator.h"
+
+#include <algorithm>
+
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace {
+// Index of the highest set bit, value must not be 0.
+inline uint32 HighestBit(uint64 value)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanReverse64(&index, value);
+  return index;
+#else
+  return 63 - __builtin_clzll(value);
+#endif
+}
+
+// Index of the lowest set bit, value must not be 0.
+inline uint32 LowestBit(uint32 value)
+{
+#if defined(_MSC_VER)
+  unsigned long index;
+  _BitScanForward(&index, value);
+  return index;
+#else
+  return __builtin_ctz(value);
+#endif
+}
+}  // namespace
+
+const uint32 TlsfAllocation::INVALID_NODE;
+const uint32 TlsfAllocator::SL_LOG2;
+const uint32 TlsfAllocator::SL_COUNT;
+const uint32 TlsfAllocator::FL_COUNT;
+
+TlsfAllocator::TlsfAllocator(uint32 size) : mSize(size) { Reset(); }
+
+void TlsfAllocator::Reset()
+{
+  mFreeSize        = 0;
+  mAllocationCount = 0;
+  mFlBitmap        = 0;
+  for (uint32 fl = 0; fl < FL_COUNT; fl++) {
+    mSlBitmaps[fl] = 0;
+    for (uint32 sl = 0; sl < SL_COUNT; sl++) mFreeHeads[fl][sl] = TlsfAllocation::INVALID_NODE;
+  }
+  mNodes.clear();
+  mUnusedNodes.clear();
+
+  if (mSize == 0) return;
+  InsertFree(NewNode(0, mSize, TlsfAllocation::INVALID_NODE, TlsfAllocation::INVALID_NODE));
+}
+
+void TlsfAllocator::MapInsert(uint32 size, uint32& fl, uint32& sl)
+{
+  // Sizes below SL_COUNT get one bin each.
+  if (size < SL_COUNT) {
+    fl = 0;
+    sl = size;
+    return;
+  }
+  const uint32 highBit = HighestBit(size);
+  fl                   = highBit - SL_LOG2 + 1;
+  sl                   = (size >> (highBit - SL_LOG2)) ^ SL_COUNT;
+}
+
+bool TlsfAllocator::MapSearch(uint32 size, uint32& fl, uint32& sl)
+{
+  if (size < SL_COUNT) {
+    fl = 0;
+    sl = size;
+    return true;
+  }
+  // Round up to the next bin boundary, so any block of the found bin is large enough.
+  const uint64 rounded = size + (1ull << (HighestBit(size) - SL_LOG2)) - 1;
+  const uint32 highBit = HighestBit(rounded);
+  fl                   = highBit - SL_LOG2 + 1;
+  sl                   = static_cast<uint32>(rounded >> (highBit - SL_LOG2)) ^ SL_COUNT;
+  return fl < FL_COUNT;
+}
+
+uint32 TlsfAllocator::NewNode(uint32 offset, uint32 size, uint32 prevPhysical, uint32 nextPhysical)
+{
+  uint32 node;
+  if (!mUnusedNodes.empty()) {
+    node = mUnusedNodes.back();
+    mUnusedNodes.pop_back();
+  } else {
+    node = static_cast<uint32>(mNodes.size());
+    mNodes.emplace_back();
+  }
+  mNodes[node] = {offset, size, prevPhysical, nextPhysical, TlsfAllocation::INVALID_NODE, TlsfAllocation::INVALID_NODE, false};
+  return node;
+}
+
+void TlsfAllocator::DeleteNode(uint32 node) { mUnusedNodes.push_back(node); }
+
+void TlsfAllocator::InsertFree(uint32 node)
+{
+  uint32 fl, sl;
+  MapInsert(mNodes[node].Size, fl, sl);
+
+  const uint32 head     = mFreeHeads[fl][sl];
+  mNodes[node].IsFree   = true;
+  mNodes[node].PrevFree = TlsfAllocation::INVALID_NODE;
+  mNodes[node].NextFree = head;
+  if (head != TlsfAllocation::INVALID_NODE) mNodes[head].PrevFree = node;
+  mFreeHeads[fl][sl] = node;
+
+  mSlBitmaps[fl] |= 1u << sl;
+  mFlBitmap |= 1u << fl;
+  mFreeSize += mNodes[node].Size;
+}
+
+void TlsfAllocator::RemoveFree(uint32 node)
+{
+  uint32 fl, sl;
+  MapInsert(mNodes[node].Size, fl, sl);
+
+  const Node& entry = mNodes[node];
+  if (entry.PrevFree != TlsfAllocation::INVALID_NODE) {
+    mNodes[entry.PrevFree].NextFree = entry.NextFree;
+  } else {
+    mFreeHeads[fl][sl] = entry.NextFree;
+  }
+  if (entry.NextFree != TlsfAllocation::INVALID_NODE) mNodes[entry.NextFree].PrevFree = entry.PrevFree;
+
+  if (mFreeHeads[fl][sl] == TlsfAllocation::INVALID_NODE) {
+    mSlBitmaps[fl] &= ~(1u << sl);
+    if (mSlBitmaps[fl] == 0) mFlBitmap &= ~(1u << fl);
+  }
+  mNodes[node].IsFree = false;
+  mFreeSize -= mNodes[node].Size;
+}
+
+uint32 TlsfAllocator::FindFree(uint32 fl, uint32 sl) const
+{
+  uint32 slMap = mSlBitmaps[fl] & (~0u << sl);
+  if (slMap == 0) {
+    // Nothing left in this power of two, take the smallest non empty one above it.
+    const uint32 flMap = fl + 1 < FL_COUNT ? mFlBitmap & (~0u << (fl + 1)) : 0;
+    if (flMap == 0) return TlsfAllocation::INVALID_NODE;
+    fl    = LowestBit(flMap);
+    slMap = mSlBitmaps[fl];
+  }
+  return mFreeHeads[fl][LowestBit(slMap)];
+}
+
+TlsfAllocation TlsfAllocator::Allocate(uint32 size, uint32 alignment)
+{
+  TlsfAllocation allocation;
+  if (size == 0) return allocation;
+
+  // Worst case padding, unless the block happens to start aligned.
+  const uint64 searchSize = static_cast<uint64>(size) + alignment - 1;
+  if (searchSize > mFreeSize) return allocation;
+
+  uint32 fl, sl;
+  uint32 node = TlsfAllocation::INVALID_NODE;
+  if (MapSearch(static_cast<uint32>(searchSize), fl, sl)) node = FindFree(fl, sl);
+  if (node == TlsfAllocation::INVALID_NODE) {
+    // The bins above the request are empty, the bin of the request itself may still hold a block that fits.
+    MapInsert(static_cast<uint32>(searchSize), fl, sl);
+    for (node = mFreeHeads[fl][sl]; node != TlsfAllocation::INVALID_NODE; node = mNodes[node].NextFree) {
+      if (mNodes[node].Size >= searchSize) break;
+    }
+    if (node == TlsfAllocation::INVALID_NODE) return allocation;
+  }
+  RemoveFree(node);
+
+  // Padding in front of the aligned offset goes back to the free lists. The block before is in use, free blocks are always merged.
+  const uint32 offset  = mNodes[node].Offset;
+  const uint32 padding = ((offset + alignment - 1) & ~(alignment - 1)) - offset;
+  if (padding != 0) {
+    const uint32 front = NewNode(offset, padding, mNodes[node].PrevPhysical, node);
+    if (mNodes[front].PrevPhysical != TlsfAllocation::INVALID_NODE) mNodes[mNodes[front].PrevPhysical].NextPhysical = front;
+    mNodes[node].PrevPhysical = front;
+    mNodes[node].Offset += padding;
+    mNodes[node].Size -= padding;
+    InsertFree(front);
+  }
+
+  if (mNodes[node].Size > size) {
+    const uint32 back = NewNode(mNodes[node].Offset + size, mNodes[node].Size - size, node, mNodes[node].NextPhysical);
+    if (mNodes[back].NextPhysical != TlsfAllocation::INVALID_NODE) mNodes[mNodes[back].NextPhysical].PrevPhysical = back;
+    mNodes[node].NextPhysical = back;
+    mNodes[node].Size         = size;
+    InsertFree(back);
+  }
+
+  mAllocationCount++;
+  allocation.Offset = mNodes[node].Offset;
+  allocation.Node   = node;
+  return allocation;
+}
+
+void TlsfAllocator::Free(const TlsfAllocation& allocation)
+{
+  if (!allocation.IsValid()) return;
+
+  uint32 node = allocation.Node;
+  mAllocationCount--;
+
+  // Merge with free neighbours, so no two free blocks are ever adjacent.
+  const uint32 prev = mNodes[node].PrevPhysical;
+  if (prev != TlsfAllocation::INVALID_NODE && mNodes[prev].IsFree) {
+    RemoveFree(prev);
+    mNodes[prev].Size += mNodes[node].Size;
+    mNodes[prev].NextPhysical = mNodes[node].NextPhysical;
+    if (mNodes[prev].NextPhysical != TlsfAllocation::INVALID_NODE) mNodes[mNodes[prev].NextPhysical].PrevPhysical = prev;
+    DeleteNode(node);
+    node = prev;
+  }
+
+  const uint32 next = mNodes[node].NextPhysical;
+  if (next != TlsfAllocation::INVALID_NODE && mNodes[next].IsFree) {
+    RemoveFree(next);
+    mNodes[node].Size += mNodes[next].Size;
+    mNodes[node].NextPhysical = mNodes[next].NextPhysical;
+    if (mNodes[node].NextPhysical != TlsfAllocation::INVALID_NODE) mNodes[mNodes[node].NextPhysical].PrevPhysical = node;
+    DeleteNode(next);
+  }
+
+  InsertFree(node);
+}
+
+uint32 TlsfAllocator::GetLargestFreeBlock() const
+{
+  if (mFlBitmap == 0) return 0;
+
+  // Only the highest non empty bin can hold the largest block.
+  const uint32 fl = HighestBit(mFlBitmap);
+  const uint32 sl = HighestBit(mSlBitmaps[fl]);
+
+  uint32 largest = 0;
+  for (uint32 node = mFreeHeads[fl][sl]; node != TlsfAllocation::INVALID_NODE; node = mNodes[node].NextFree) {
+    largest = std::max<uint32>(largest, mNodes[node].Size);
+  }
+  return largest;
+}
+
+bool TlsfAllocator::CheckConsistency() const
+{
+  std::vector<bool> unused(mNodes.size(), false);
+  for (uint32 node : mUnusedNodes) unused[node] = true;
+
+  // The physical chain starts at offset 0 and covers [0, mSize) without gaps or two free blocks in a row.
+  uint32 first = TlsfAllocation::INVALID_NODE;
+  for (uint32 node = 0; node < mNodes.size(); node++) {
+    if (!unused[node] && mNodes[node].PrevPhysical == TlsfAllocation::INVALID_NODE) {
+      if (first != TlsfAllocation::INVALID_NODE) return false;
+      first = node;
+    }
+  }
+  if (mSize == 0) return first == TlsfAllocation::INVALID_NODE && mFreeSize == 0 && mAllocationCount == 0;
+
+  uint32 end             = 0;
+  uint32 freeSize        = 0;
+  uint32 freeCount       = 0;
+  uint32 allocationCount = 0;
+  uint32 blockCount      = 0;
+  for (uint32 node = first, prev = TlsfAllocation::INVALID_NODE; node != TlsfAllocation::INVALID_NODE; prev = node, node = mNodes[node].NextPhysical) {
+    const Node& entry = mNodes[node];
+    if (unused[node] || entry.PrevPhysical != prev || entry.Offset != end || entry.Size == 0) return false;
+    if (entry.IsFree && prev != TlsfAllocation::INVALID_NODE && mNodes[prev].IsFree) return false;
+    end += entry.Size;
+    freeSize += entry.IsFree ? entry.Size : 0;
+    freeCount += entry.IsFree ? 1 : 0;
+    allocationCount += entry.IsFree ? 0 : 1;
+    blockCount++;
+  }
+  if (end != mSize || freeSize != mFreeSize || allocationCount != mAllocationCount) return false;
+  if (blockCount + mUnusedNodes.size() != mNodes.size()) return false;
+
+  // Every free block sits in the list of its bin, and a bitmap bit is set exactly when its list is not empty.
+  uint32 listedCount = 0;
+  for (uint32 fl = 0; fl < FL_COUNT; fl++) {
+    if (((mFlBitmap >> fl) & 1) != (mSlBitmaps[fl] != 0 ? 1u : 0u)) return false;
+    for (uint32 sl = 0; sl < SL_COUNT; sl++) {
+      const uint32 head = mFreeHeads[fl][sl];
+      if (((mSlBitmaps[fl] >> sl) & 1) != (head != TlsfAllocation::INVALID_NODE ? 1u : 0u)) return false;
+
+      for (uint32 node = head, prev = TlsfAllocation::INVALID_NODE; node != TlsfAllocation::INVALID_NODE; prev = node, node = mNodes[node].NextFree) {
+        uint32 nodeFl, nodeSl;
+        MapInsert(mNodes[node].Size, nodeFl, nodeSl);
+        if (unused[node] || !mNodes[node].IsFree || mNodes[node].PrevFree != prev || nodeFl != fl || nodeSl != sl) return false;
+        if (++listedCount > freeCount) return false;
+      }
+    }
+  }
+  return listedCount == freeCount;
+}
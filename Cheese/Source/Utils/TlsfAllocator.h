@@ -0,0 +1,82 @@
+#ifndef UTILS_TLSF_ALLOCATOR_H
+#define UTILS_TLSF_ALLOCATOR_H
+#include <vector>
+
+#include "Common/Types.h"
+
+// A range handed out by TlsfAllocator. Node is the bookkeeping entry Free needs.
+struct TlsfAllocation {
+  static const uint32 INVALID_NODE = 0xFFFFFFFF;
+
+  uint32 Offset = 0;
+  uint32 Node   = INVALID_NODE;
+
+  inline bool IsValid() const { return Node != INVALID_NODE; }
+};
+
+// Two level segregated fit allocator over the offsets [0, size), it never touches the memory it manages.
+// Free blocks are binned by size: the first level is the highest bit, the second level splits that power of two into 16 bins.
+// Allocate and Free are O(1), neighbouring free blocks are merged at once. Units are up to the caller, e.g. vertices or bytes.
+class TlsfAllocator
+{
+ public:
+  static const uint32 SL_LOG2  = 4;
+  static const uint32 SL_COUNT = 1 << SL_LOG2;
+  static const uint32 FL_COUNT = 32 - SL_LOG2 + 1;
+
+  explicit TlsfAllocator(uint32 size = 0);
+
+  // alignment has to be a power of two. Returns an invalid allocation when no free block is large enough.
+  TlsfAllocation Allocate(uint32 size, uint32 alignment = 1);
+  void Free(const TlsfAllocation& allocation);
+  // Frees every allocation at once.
+  void Reset();
+
+  inline uint32 GetSize() const { return mSize; }
+  inline uint32 GetFreeSize() const { return mFreeSize; }
+  inline uint32 GetAllocationCount() const { return mAllocationCount; }
+  // Size of the allocation behind a valid handle.
+  inline uint32 GetAllocationSize(const TlsfAllocation& allocation) const { return mNodes[allocation.Node].Size; }
+  // Largest block Allocate can return without alignment, walks the bins.
+  uint32 GetLargestFreeBlock() const;
+  // Walks every block and bin, false when the physical chain, the free lists, the bitmaps or the counters disagree. For tests.
+  bool CheckConsistency() const;
+
+ private:
+  struct Node {
+    uint32 Offset;
+    uint32 Size;
+    // Physical neighbours and free list links, INVALID_NODE at the ends.
+    uint32 PrevPhysical;
+    uint32 NextPhysical;
+    uint32 PrevFree;
+    uint32 NextFree;
+    bool IsFree;
+  };
+
+  // Bin holding blocks of size, sizes within a bin round down to its lower bound.
+  static void MapInsert(uint32 size, uint32& fl, uint32& sl);
+  // First bin whose every block holds size, false when size is beyond the largest bin.
+  static bool MapSearch(uint32 size, uint32& fl, uint32& sl);
+
+  uint32 NewNode(uint32 offset, uint32 size, uint32 prevPhysical, uint32 nextPhysical);
+  void DeleteNode(uint32 node);
+  void InsertFree(uint32 node);
+  void RemoveFree(uint32 node);
+  // A non empty bin at or above (fl, sl), INVALID_NODE when there is none.
+  uint32 FindFree(uint32 fl, uint32 sl) const;
+
+ private:
+  uint32 mSize            = 0;
+  uint32 mFreeSize        = 0;
+  uint32 mAllocationCount = 0;
+
+  // Bit fl is set when mSlBitmaps[fl] is not zero, bit sl of mSlBitmaps[fl] when mFreeHeads[fl][sl] holds a block.
+  uint32 mFlBitmap = 0;
+  uint32 mSlBitmaps[FL_COUNT];
+  uint32 mFreeHeads[FL_COUNT][SL_COUNT];
+
+  std::vector<Node> mNodes;
+  std::vector<uint32> mUnusedNodes;
+};
+#endif  // UTILS_TLSF_ALLOCATOR_H
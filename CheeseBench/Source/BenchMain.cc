@@ -0,0 +1,27 @@
+// CPU benchmarks for the engine's hot paths.
+// Usage: CheeseBench [name filter]. Run from the FinalProject directory so the sample models resolve.
+#include <cstdio>
+#include <cstring>
+#include "Benchmark.h"
+#include "Utils/Log/ConsoleLogDevice.h"
+#include "Utils/Log/Logger.h"
+
+std::vector<BenchmarkCase>& GetBenchmarks()
+{
+  static std::vector<BenchmarkCase> benchmarks;
+  return benchmarks;
+}
+
+int main(int argc, char** argv)
+{
+  logger.SetLogDevice(new ConsoleLogDevice());
+
+  const char* filter = argc > 1 ? argv[1] : nullptr;
+  for (const BenchmarkCase& benchmark : GetBenchmarks()) {
+    if (filter != nullptr && strstr(benchmark.Name, filter) == nullptr) continue;
+
+    printf("%s\n", benchmark.Name);
+    benchmark.Run();
+  }
+  return 0;
+}
@@ -0,0 +1,51 @@
+// Minimal benchmark registry for CheeseBench. Each BENCHMARK body times its own work with MeasureMs and prints
+// the numbers through Report, so a case can report several variants, e.g. 10k, 100k and 1M draws.
+#ifndef CHEESE_BENCH_BENCHMARK_H
+#define CHEESE_BENCH_BENCHMARK_H
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <vector>
+#include "Common/Types.h"
+
+struct BenchmarkCase {
+  const char* Name;
+  void (*Run)();
+};
+
+std::vector<BenchmarkCase>& GetBenchmarks();
+
+struct BenchmarkRegistrar {
+  BenchmarkRegistrar(const char* name, void (*run)()) { GetBenchmarks().push_back({name, run}); }
+};
+
+#define BENCHMARK(name)                                                           \
+  static void Benchmark_##name();                                                 \
+  static BenchmarkRegistrar sBenchmarkRegistrar_##name(#name, &Benchmark_##name); \
+  static void Benchmark_##name()
+
+// Best of repeats runs of func, in milliseconds. The best run is the one least disturbed by the rest of the system.
+template <typename Func>
+double MeasureMs(uint32 repeats, const Func& func)
+{
+  double best = 0.0;
+  for (uint32 i = 0; i < repeats; ++i) {
+    const auto start = std::chrono::high_resolution_clock::now();
+    func();
+    const auto end     = std::chrono::high_resolution_clock::now();
+    const double ms    = std::chrono::duration<double, std::milli>(end - start).count();
+    best               = i == 0 ? ms : std::min(best, ms);
+  }
+  return best;
+}
+
+inline void Report(const char* label, double value, const char* unit) { printf("  %-48s %12.3f %s\n", label, value, unit); }
+
+// Keeps the optimizer from dropping work whose result is otherwise unused.
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+  static volatile const void* sSink;
+  sSink = &value;
+}
+#endif  // CHEESE_BENCH_BENCHMARK_H
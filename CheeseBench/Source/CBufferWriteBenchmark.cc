@@ -0,0 +1,83 @@
+// Nanoseconds per cbuffer variable write through a CBufferVarHandle, a compile time CBufferVarName, a CheString,
+// and the two string map lookups of cbuffer and variable name that writes did before handles.
+#include <cstring>
+#include "Benchmark.h"
+#include "Shader/ConstantBuffer.h"
+
+using namespace DirectX;
+
+namespace {
+const uint32 WRITE_REPEATS = 10;
+const uint32 WRITE_COUNT   = 1000000;
+// A cbPass sized like the one of PBR.hlsl, matrices first, then vectors.
+const uint32 MATRIX_COUNT = 8;
+const uint32 VECTOR_COUNT = 24;
+
+void AddPassBuffer(CBufferManager& manager)
+{
+  std::unordered_map<CheString, CBufferVariable> variables;
+  uint32 offset = 0;
+  for (uint32 i = 0; i < MATRIX_COUNT; ++i, offset += sizeof(XMFLOAT4X4)) {
+    variables[CTEXT("gMatrix") + ConvertToCheString(static_cast<int>(i))] = {offset, sizeof(XMFLOAT4X4)};
+  }
+  for (uint32 i = 0; i < VECTOR_COUNT; ++i, offset += sizeof(XMFLOAT4)) {
+    variables[CTEXT("gVector") + ConvertToCheString(static_cast<int>(i))] = {offset, sizeof(XMFLOAT4)};
+  }
+  manager.AddCBuffer(CTEXT("cbPass"), CBufferInfo(0, offset, std::move(variables)));
+}
+}  // namespace
+
+BENCHMARK(CBufferWrite)
+{
+  CBufferManager manager;
+  AddPassBuffer(manager);
+
+  const CheString cbufferName(CTEXT("cbPass"));
+  const CheString variableName(CTEXT("gVector7"));
+  const CheString fullName = cbufferName + CTEXT(".") + variableName;
+  constexpr CBufferVarName VECTOR7(CTEXT("cbPass.gVector7"));
+  const CBufferVarHandle handle = manager.GetHandle(VECTOR7);
+  if (!handle.IsValid()) {
+    printf("  cbPass.gVector7 did not resolve\n");
+    return;
+  }
+
+  // The value changes every write, so no write is hoisted out of the loop.
+  XMFLOAT4 value(0.0f, 1.0f, 2.0f, 3.0f);
+  const double handleMs = MeasureMs(WRITE_REPEATS, [&] {
+    for (uint32 i = 0; i < WRITE_COUNT; ++i) {
+      value.x = static_cast<float>(i);
+      manager.SetValue(handle, value);
+    }
+  });
+  Report("handle", handleMs * 1e6 / WRITE_COUNT, "ns/write");
+
+  const double nameMs = MeasureMs(WRITE_REPEATS, [&] {
+    for (uint32 i = 0; i < WRITE_COUNT; ++i) {
+      value.x = static_cast<float>(i);
+      manager.SetValue(VECTOR7, value);
+    }
+  });
+  Report("CBufferVarName", nameMs * 1e6 / WRITE_COUNT, "ns/write");
+
+  const double stringMs = MeasureMs(WRITE_REPEATS, [&] {
+    for (uint32 i = 0; i < WRITE_COUNT; ++i) {
+      value.x = static_cast<float>(i);
+      manager.SetValue(fullName, value);
+    }
+  });
+  Report("CheString, hashed every write", stringMs * 1e6 / WRITE_COUNT, "ns/write");
+
+  // Before handles a write found the cbuffer by name, then the variable in the reflected variables by name.
+  const double lookupMs = MeasureMs(WRITE_REPEATS, [&] {
+    for (uint32 i = 0; i < WRITE_COUNT; ++i) {
+      value.x                        = static_cast<float>(i);
+      const ConstantBuffer& cbuffer  = manager.GetCBuffers().find(cbufferName)->second;
+      const CBufferVariable variable = cbuffer.GetCBufferInfo().GetVariables().find(variableName)->second;
+      memcpy(cbuffer.mData.get() + variable.Offset, &value, sizeof(value));
+    }
+  });
+  Report("cbuffer and variable name lookup", lookupMs * 1e6 / WRITE_COUNT, "ns/write");
+
+  DoNotOptimize(manager.GetCBuffers().begin()->second.GetData()[0]);
+}
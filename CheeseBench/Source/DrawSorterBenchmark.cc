@@ -0,0 +1,59 @@
+// DrawSorter::Sort against std::stable_sort on the same keys, for frame sized and very large draw counts.
+#include <random>
+#include "Benchmark.h"
+#include "Graphics/DrawSorter.h"
+
+namespace {
+const uint32 SORT_REPEATS = 10;
+
+// Keys of a frame: a few passes and pipelines, many materials and depths all over the range.
+void MakeCommands(uint32 count, std::vector<DrawCommand>& commands)
+{
+  std::mt19937 random(count);
+  std::uniform_int_distribution<uint32> pass(0, 2);
+  std::uniform_int_distribution<uint32> pipeline(0, 3);
+  std::uniform_int_distribution<uint32> material(0, 511);
+  std::uniform_real_distribution<float> depth(0.0f, 1.0f);
+
+  commands.resize(count);
+  for (uint32 i = 0; i < count; ++i) {
+    const bool indices32  = (random() & 1) != 0;
+    commands[i].Key       = DrawSorter::MakeOpaqueKey(pass(random), pipeline(random), material(random), indices32, depth(random));
+    commands[i].ItemIndex = i;
+    commands[i].ArgIndex  = 0;
+  }
+}
+}  // namespace
+
+BENCHMARK(DrawSort)
+{
+  std::vector<DrawCommand> source;
+  std::vector<DrawCommand> commands;
+  std::vector<DrawCommand> scratch;
+
+  for (uint32 count : {10000u, 100000u, 1000000u}) {
+    MakeCommands(count, source);
+    char label[128];
+
+    // Every run sorts the same unsorted keys, the copy is part of both measurements.
+    const double radixMs = MeasureMs(SORT_REPEATS, [&] {
+      commands = source;
+      DrawSorter::Sort(commands, scratch);
+      DoNotOptimize(commands.front());
+    });
+    sprintf_s(label, "%u draws, radix", count);
+    Report(label, radixMs, "ms");
+    sprintf_s(label, "%u draws, radix per draw", count);
+    Report(label, radixMs * 1e6 / count, "ns");
+
+    const double stableMs = MeasureMs(SORT_REPEATS, [&] {
+      commands = source;
+      std::stable_sort(commands.begin(), commands.end(), [](const DrawCommand& a, const DrawCommand& b) { return a.Key < b.Key; });
+      DoNotOptimize(commands.front());
+    });
+    sprintf_s(label, "%u draws, std::stable_sort", count);
+    Report(label, stableMs, "ms");
+    sprintf_s(label, "%u draws, std::stable_sort per draw", count);
+    Report(label, stableMs * 1e6 / count, "ns");
+  }
+}
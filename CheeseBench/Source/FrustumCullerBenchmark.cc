@@ -0,0 +1,62 @@
+// Boxes per nanosecond of the frustum cull kernels on one thread, and of FrustumCuller::Cull across the thread pool.
+#include <random>
+#include "Benchmark.h"
+#include "Graphics/FrustumCuller.h"
+
+using namespace DirectX;
+
+namespace {
+const uint32 CULL_REPEATS = 20;
+const uint32 BOX_COUNT    = 1000000;
+
+// 90 degree frustum at the origin looking down +z, from 1 to 100. The normals point inwards.
+const float HALF_SQRT2   = 0.70710678f;
+const XMFLOAT4 PLANES[6] = {
+    {HALF_SQRT2, 0.0f, HALF_SQRT2, 0.0f}, {-HALF_SQRT2, 0.0f, HALF_SQRT2, 0.0f}, {0.0f, HALF_SQRT2, HALF_SQRT2, 0.0f},
+    {0.0f, -HALF_SQRT2, HALF_SQRT2, 0.0f}, {0.0f, 0.0f, 1.0f, -1.0f},            {0.0f, 0.0f, -1.0f, 100.0f},
+};
+}  // namespace
+
+BENCHMARK(FrustumCull)
+{
+  // Spread around the camera so roughly a sixth of the boxes are visible, the branches of the kernels get no easy pattern.
+  std::mt19937 random(BOX_COUNT);
+  std::uniform_real_distribution<float> position(-120.0f, 120.0f);
+  std::uniform_real_distribution<float> extent(0.1f, 10.0f);
+  CullBoxes boxes;
+  boxes.Reserve(BOX_COUNT);
+  for (uint32 i = 0; i < BOX_COUNT; ++i) {
+    boxes.Add({position(random), position(random), position(random)}, {extent(random), extent(random), extent(random)});
+  }
+
+  struct {
+    const char* Name;
+    FrustumCuller::Kernel Kernel;
+  } const kernels[] = {
+      {"scalar", FrustumCuller::Kernel::SCALAR},
+      {"SSE", FrustumCuller::Kernel::SSE},
+      {"AVX2", FrustumCuller::Kernel::AVX2},
+  };
+
+  std::vector<uint32> visible(BOX_COUNT);
+  char label[128];
+  for (const auto& kernel : kernels) {
+    if (kernel.Kernel == FrustumCuller::Kernel::AVX2 && !IsAvx2Supported()) {
+      printf("  %-48s not supported\n", "AVX2");
+      continue;
+    }
+
+    uint32 visibleCount = 0;
+    const double ms     = MeasureMs(CULL_REPEATS, [&] { visibleCount = FrustumCuller::CullRange(kernel.Kernel, boxes, PLANES, 0, BOX_COUNT, visible.data()); });
+    DoNotOptimize(visibleCount);
+    sprintf_s(label, "%s, one thread", kernel.Name);
+    Report(label, BOX_COUNT / (ms * 1e6), "boxes/ns");
+
+    FrustumCuller culler;
+    culler.SetKernel(kernel.Kernel);
+    const double parallelMs = MeasureMs(CULL_REPEATS, [&] { visibleCount = culler.Cull(boxes, PLANES, visible); });
+    DoNotOptimize(visibleCount);
+    sprintf_s(label, "%s, thread pool", kernel.Name);
+    Report(label, BOX_COUNT / (parallelMs * 1e6), "boxes/ns");
+  }
+}
@@ -0,0 +1,76 @@
+// glTF decode time for the sample models: serial against the thread pool, with and without mapped buffers and with the full mesh pipeline.
+#include "Benchmark.h"
+#include "Model/ModelLoader.h"
+#include "Utils/ThreadPool.h"
+
+namespace {
+const uint32 LOAD_REPEATS = 5;
+
+// Reports and returns the best load time, 0 when the load failed.
+double MeasureLoad(const char* label, const CheString& fileName, const ModelLoadOptions& options)
+{
+  bool loaded     = true;
+  const double ms = MeasureMs(LOAD_REPEATS, [&] {
+    DecodedModel decoded;
+    loaded = ModelLoader::DecodeModel(fileName, decoded, options) && loaded;
+    for (IMesh* mesh : decoded.Meshes) {
+      delete mesh;
+    }
+  });
+
+  if (!loaded) {
+    printf("  %-48s failed\n", label);
+    return 0.0;
+  }
+  Report(label, ms, "ms");
+  return ms;
+}
+}  // namespace
+
+BENCHMARK(GLTFLoad)
+{
+  struct {
+    const char* Name;
+    const CheString FileName;
+  } const models[] = {
+      {"FlightHelmet", CTEXT("Resource/Model/FlightHelmet/FlightHelmet.gltf")},
+      {"BoomBox", CTEXT("Resource/Model/BoomBox/BoomBox.gltf")},
+  };
+
+  for (const auto& model : models) {
+    ModelLoadOptions options;
+    char label[128];
+
+    options.ParallelDecode = false;
+    sprintf_s(label, "%s, copied buffers, serial", model.Name);
+    const double serialMs = MeasureLoad(label, model.FileName, options);
+
+    options.ParallelDecode = true;
+    sprintf_s(label, "%s, copied buffers, %u pool threads", model.Name, ThreadPool::Get().GetThreadCount());
+    const double parallelMs = MeasureLoad(label, model.FileName, options);
+    if (serialMs > 0.0 && parallelMs > 0.0) {
+      sprintf_s(label, "%s, pool speedup", model.Name);
+      Report(label, serialMs / parallelMs, "x");
+    }
+
+    options.MapBuffers = true;
+    sprintf_s(label, "%s, mapped buffers", model.Name);
+    MeasureLoad(label, model.FileName, options);
+
+    options.WeldVertices   = true;
+    options.OptimizeMeshes = true;
+    options.GenerateLods   = true;
+    options.Format         = VertexFormat::COMPACT;
+    sprintf_s(label, "%s, weld + optimize + lods", model.Name);
+    const double pipelineMs = MeasureLoad(label, model.FileName, options);
+
+    // The mesh passes are most of the decode work, this is where the pool pays off.
+    options.ParallelDecode = false;
+    sprintf_s(label, "%s, weld + optimize + lods, serial", model.Name);
+    const double serialPipelineMs = MeasureLoad(label, model.FileName, options);
+    if (serialPipelineMs > 0.0 && pipelineMs > 0.0) {
+      sprintf_s(label, "%s, weld + optimize + lods, pool speedup", model.Name);
+      Report(label, serialPipelineMs / pipelineMs, "x");
+    }
+  }
+}
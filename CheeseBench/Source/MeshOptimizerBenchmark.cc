@@ -0,0 +1,87 @@
+// MeshOptimizer passes on grids whose triangles come in random order, with the ACMR and ATVR they reach.
+#include <algorithm>
+#include <random>
+#include "Benchmark.h"
+#include "Model/MeshOptimizer.h"
+
+namespace {
+const uint32 OPTIMIZE_REPEATS = 5;
+
+// size x size quads in the z = 0 plane, two triangles each, shuffled.
+void BuildShuffledGrid(uint32 size, std::vector<Float3>& positions, std::vector<uint32>& indices)
+{
+  positions.clear();
+  for (uint32 y = 0; y <= size; y++) {
+    for (uint32 x = 0; x <= size; x++) positions.push_back({static_cast<float>(x), static_cast<float>(y), 0.0f});
+  }
+
+  std::vector<uint32> quads(size * size);
+  for (uint32 q = 0; q < quads.size(); q++) quads[q] = q;
+  std::shuffle(quads.begin(), quads.end(), std::mt19937(size));
+
+  indices.clear();
+  for (uint32 q : quads) {
+    const uint32 a = q / size * (size + 1) + q % size;
+    const uint32 c = a + size + 1;
+    indices.insert(indices.end(), {a, a + 1, c, a + 1, c + 1, c});
+  }
+}
+}  // namespace
+
+BENCHMARK(MeshOptimize)
+{
+  std::vector<Float3> positions;
+  std::vector<uint32> source;
+  std::vector<uint32> indices;
+  std::vector<uint32> remap;
+
+  for (uint32 size : {64u, 256u, 512u}) {
+    BuildShuffledGrid(size, positions, source);
+    const uint32 vertexCount = static_cast<uint32>(positions.size());
+
+    PositionStream stream;
+    stream.Data   = reinterpret_cast<const Byte*>(positions.data());
+    stream.Stride = sizeof(Float3);
+    stream.Count  = vertexCount;
+
+    char label[128];
+    const uint32 triangleCount = size * size * 2;
+
+    // Every run starts from the shuffled indices, the copy is part of each measurement.
+    const double cacheMs = MeasureMs(OPTIMIZE_REPEATS, [&] {
+      indices = source;
+      MeshOptimizer::OptimizeVertexCache(indices, vertexCount);
+      DoNotOptimize(indices.front());
+    });
+    sprintf_s(label, "%u triangles, vertex cache", triangleCount);
+    Report(label, cacheMs, "ms");
+
+    const std::vector<uint32> cacheOptimized = indices;
+    const double overdrawMs                  = MeasureMs(OPTIMIZE_REPEATS, [&] {
+      indices = cacheOptimized;
+      MeshOptimizer::OptimizeOverdraw(indices, stream);
+      DoNotOptimize(indices.front());
+    });
+    sprintf_s(label, "%u triangles, overdraw", triangleCount);
+    Report(label, overdrawMs, "ms");
+
+    const std::vector<uint32> overdrawOptimized = indices;
+    const double fetchMs                        = MeasureMs(OPTIMIZE_REPEATS, [&] {
+      indices = overdrawOptimized;
+      DoNotOptimize(MeshOptimizer::OptimizeVertexFetch(indices, vertexCount, remap));
+    });
+    sprintf_s(label, "%u triangles, vertex fetch", triangleCount);
+    Report(label, fetchMs, "ms");
+
+    const VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(source, vertexCount);
+    const VertexCacheStats after  = MeshOptimizer::AnalyzeVertexCache(overdrawOptimized, vertexCount);
+    sprintf_s(label, "%u triangles, ACMR before", triangleCount);
+    Report(label, before.GetAcmr(), "");
+    sprintf_s(label, "%u triangles, ACMR after", triangleCount);
+    Report(label, after.GetAcmr(), "");
+    sprintf_s(label, "%u triangles, ATVR before", triangleCount);
+    Report(label, before.GetAtvr(), "");
+    sprintf_s(label, "%u triangles, ATVR after", triangleCount);
+    Report(label, after.GetAtvr(), "");
+  }
+}
@@ -0,0 +1,74 @@
+// Milliseconds to rasterize box occluders into the default depth buffer per kernel, and boxes per nanosecond tested against the pyramid.
+#include <cmath>
+#include <random>
+#include "Benchmark.h"
+#include "Graphics/OcclusionCuller.h"
+
+namespace {
+const uint32 RENDER_REPEATS = 50;
+const uint32 CULL_REPEATS   = 20;
+const uint32 BOX_COUNT      = 100000;
+}  // namespace
+
+BENCHMARK(OcclusionCull)
+{
+  // Camera at the origin looking down +z, occluders in a band from 5 to 30 in front of it.
+  const Float4x4 viewProj = PerspectiveFovLH(4.0f * atanf(1.0f) / 3.0f, 16.0f / 9.0f, 0.5f, 1000.0f);
+  std::mt19937 random(BOX_COUNT);
+  std::uniform_real_distribution<float> lateral(-10.0f, 10.0f);
+  std::uniform_real_distribution<float> occluderDepth(5.0f, 30.0f);
+  std::uniform_real_distribution<float> occluderSize(0.5f, 4.0f);
+
+  // Boxes behind and among the occluders, some hidden and some not.
+  std::uniform_real_distribution<float> boxDepth(5.0f, 100.0f);
+  std::uniform_real_distribution<float> boxExtent(0.1f, 2.0f);
+  CullBoxes boxes;
+  boxes.Reserve(BOX_COUNT);
+  for (uint32 i = 0; i < BOX_COUNT; ++i) {
+    const float z = boxDepth(random);
+    boxes.Add({lateral(random) * z / 10.0f, lateral(random) * z / 20.0f, z}, {boxExtent(random), boxExtent(random), boxExtent(random)});
+  }
+  std::vector<uint32> allBoxes(BOX_COUNT);
+  for (uint32 i = 0; i < BOX_COUNT; ++i) allBoxes[i] = i;
+
+  struct {
+    const char* Name;
+    OcclusionCuller::Kernel Kernel;
+  } const kernels[] = {
+      {"scalar", OcclusionCuller::Kernel::SCALAR},
+      {"SSE", OcclusionCuller::Kernel::SSE},
+      {"AVX2", OcclusionCuller::Kernel::AVX2},
+  };
+
+  char label[128];
+  for (uint32 occluderCount : {16u, 64u, 256u}) {
+    OcclusionCuller culler;
+    for (uint32 i = 0; i < occluderCount; ++i) {
+      const Float3 center = {lateral(random), lateral(random) * 0.5f, occluderDepth(random)};
+      const Float3 extent = {occluderSize(random), occluderSize(random), occluderSize(random) * 0.25f};
+      culler.AddBoxOccluder(Sub(center, extent), Add(center, extent));
+    }
+
+    for (const auto& kernel : kernels) {
+      if (kernel.Kernel == OcclusionCuller::Kernel::AVX2 && !IsAvx2Supported()) {
+        printf("  %-48s not supported\n", "AVX2");
+        continue;
+      }
+      culler.SetKernel(kernel.Kernel);
+      const double ms = MeasureMs(RENDER_REPEATS, [&] { culler.Render(viewProj); });
+      snprintf(label, sizeof(label), "Render %u box occluders, %s", occluderCount, kernel.Name);
+      Report(label, ms, "ms");
+    }
+
+    // Cull does not depend on the kernel, only on how much the occluders cover.
+    std::vector<uint32> visible;
+    uint32 visibleCount = 0;
+    const double ms     = MeasureMs(CULL_REPEATS, [&] {
+      visible      = allBoxes;
+      visibleCount = culler.Cull(boxes, visible);
+    });
+    DoNotOptimize(visibleCount);
+    snprintf(label, sizeof(label), "Cull behind %u box occluders, %u%% hidden", occluderCount, (BOX_COUNT - visibleCount) * 100 / BOX_COUNT);
+    Report(label, BOX_COUNT / (ms * 1e6), "boxes/ns");
+  }
+}
@@ -0,0 +1,254 @@
+// CBufferGen on a DXC listing of PBR.hlsl VS, the buffer definitions as "dxc -T vs_6_0 -E VS -Fc" prints them.
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "CBufferGen.h"
+#include "Test.h"
+
+namespace {
+const char* LISTING_FILE = "CBufferGenPBR.VS.lst";
+
+// DXC pads the declarations to a column, a name running past it is directly followed by the offset comment.
+const char* PBR_VS_LISTING = R"(;
+; Note: shader requires additional functionality:
+;       Raw and Structured buffers
+;
+;
+; Input signature:
+;
+; Name                 Index   Mask Register SysValue  Format   Used
+; -------------------- ----- ------ -------- -------- ------- ------
+; POSITION                 0   xyz         0     NONE   float   xyz
+; NORMAL                   0   xyz         1     NONE   float   xyz
+; TEXCOORD                 0   xy          2     NONE   float   xy
+; TANGENT                  0   xyz         3     NONE   float   xyz
+; SV_InstanceID            0   x           4   INSTID    uint   x
+;
+;
+; Output signature:
+;
+; Name                 Index   Mask Register SysValue  Format   Used
+; -------------------- ----- ------ -------- -------- ------- ------
+; SV_Position              0   xyzw        0      POS   float   xyzw
+;
+; Pipeline Runtime Information:
+;
+; Vertex Shader
+; OutputPositionPresent=1
+;
+;
+; Buffer Definitions:
+;
+; cbuffer cbPerObject
+; {
+;
+;   struct hostlayout.cbPerObject
+;   {
+;
+;       float4 gPositionOffset;                       ; Offset:    0
+;       float4 gPositionScale;                        ; Offset:   16
+;
+;   } cbPerObject;                                    ; Offset:    0 Size:    32
+;
+; }
+;
+; cbuffer cbView
+; {
+;
+;   struct hostlayout.cbView
+;   {
+;
+;       column_major float4x4 gViewProj;              ; Offset:    0
+;       column_major float4x4 PrevViewProjectionMatrix;; Offset:   64
+;       float2 PrevJitter;                            ; Offset:  128
+;       float2 CurrJitter;                            ; Offset:  136
+;       column_major float4x4 gShadowTransform;       ; Offset:  144
+;
+;       struct hostlayout.struct.PointLight
+;       {
+;
+;           float3 Strength;                          ; Offset:  208
+;           float FalloffStart;                       ; Offset:  220
+;           float3 Direction;                         ; Offset:  224
+;           float FalloffEnd;                         ; Offset:  236
+;           float3 Position;                          ; Offset:  240
+;           float SpotPower;                          ; Offset:  252
+;
+;       } gLight;                                     ; Offset:  208
+;
+;       float3 gEyePosW;                              ; Offset:  256
+;
+;   } cbView;                                         ; Offset:    0 Size:   268
+;
+; }
+;
+; cbuffer cbDraw
+; {
+;
+;   struct cbDraw
+;   {
+;
+;       uint gObjectIndex;                            ; Offset:    0
+;       uint gMaterialId;                             ; Offset:    4
+;
+;   } cbDraw;                                         ; Offset:    0 Size:     8
+;
+; }
+;
+; Resource bind info for gInstances
+; {
+;
+;   struct struct.InstanceData
+;   {
+;
+;       column_major float4x4 World;                  ; Offset:    0
+;       column_major float4x4 PrevWorld;              ; Offset:   64
+;       uint MaterialIndex;                           ; Offset:  128
+;       uint3 Pad;                                    ; Offset:  132
+;
+;   } $Element;                                       ; Offset:    0 Size:   144
+;
+; }
+;
+;
+; Resource Bindings:
+;
+; Name                                 Type  Format         Dim      ID      HLSL Bind  Count
+; ------------------------------ ---------- ------- ----------- ------- -------------- ------
+; cbPerObject                       cbuffer      NA          NA     CB0            cb0     1
+; cbView                            cbuffer      NA          NA     CB1            cb1     1
+; cbDraw                            cbuffer      NA          NA     CB2            cb2     1
+; gInstances                            texture  struct         r/o      T0             t1     1
+;
+;
+target datalayout = "e-m:e-p:32:32-i1:32-i8:32-i16:32-i32:32-i64:64-f16:32-f32:32-f64:64-n8:16:32:64"
+target triple = "dxil-ms-dx"
+
+%dx.types.Handle = type { i8* }
+)";
+
+// Writes listing and loads it with only the cbuffers of only, all when empty, and without those of skipped.
+bool Load(CBufferGen::Generator& generator, const std::string& listing, const char* only = nullptr, const char* skipped = nullptr)
+{
+  std::ofstream(LISTING_FILE) << listing;
+  CBufferGen::Options options;
+  options.Namespace = "ViewConstants";
+  options.Listings.push_back(LISTING_FILE);
+  options.MappedTypes["PointLight"] = "PointLight";
+  if (only != nullptr) options.OnlyCBuffers.insert(only);
+  if (skipped != nullptr) options.SkippedCBuffers.insert(skipped);
+  const bool loaded = generator.Load(options);
+  remove(LISTING_FILE);
+  return loaded;
+}
+
+// The listing with the one occurrence of from replaced.
+std::string Replace(std::string text, const std::string& from, const std::string& to) { return text.replace(text.find(from), from.size(), to); }
+}  // namespace
+
+TEST(CBufferGenParsesDxcListing)
+{
+  CBufferGen::Generator generator;
+  CHECK(Load(generator, PBR_VS_LISTING));
+
+  // The structured buffer block is not a cbuffer, InstanceData stays out.
+  const std::vector<std::string> cbuffers = {"cbPerObject", "cbView", "cbDraw"};
+  CHECK(cbuffers == generator.GetCBufferOrder());
+  CHECK(generator.FindStruct("InstanceData") == nullptr);
+  CHECK(generator.GetStructOrder() == std::vector<std::string>{"PointLight"});
+
+  const CBufferGen::StructDef* view = generator.FindCBuffer("cbView");
+  CHECK(view != nullptr);
+  CHECK_EQ(268, view->Size);
+  CHECK_EQ(268, view->ListedSize);
+  struct {
+    const char* Name;
+    uint32_t Offset;
+    uint32_t Size;
+  } const expected[] = {
+      {"gViewProj", 0, 64}, {"PrevViewProjectionMatrix", 64, 64}, {"PrevJitter", 128, 8}, {"CurrJitter", 136, 8},
+      {"gShadowTransform", 144, 64}, {"gLight", 208, 48}, {"gEyePosW", 256, 12},
+  };
+  CHECK_EQ(sizeof(expected) / sizeof(expected[0]), view->Fields.size());
+  for (size_t i = 0; i < view->Fields.size(); ++i) {
+    const CBufferGen::Field& field = view->Fields[i];
+    CHECK(field.Name == expected[i].Name);
+    CHECK_EQ(expected[i].Offset, field.Offset);
+    CHECK_EQ(expected[i].Offset, field.ListedOffset);
+    CHECK_EQ(expected[i].Size, field.Size);
+  }
+
+  const CBufferGen::Field& viewProj = view->Fields[0];
+  CHECK(viewProj.FieldType.Kind == CBufferGen::TypeKind::MATRIX);
+  CHECK(!viewProj.FieldType.RowMajor);
+  CHECK_EQ(4, viewProj.FieldType.Rows);
+
+  // gLight keeps the members at the offsets listed for this use, the struct definition starts at 0.
+  const CBufferGen::Field& light = view->Fields[5];
+  CHECK(light.FieldType.Kind == CBufferGen::TypeKind::STRUCT);
+  CHECK(light.FieldType.Name == "PointLight");
+  CHECK_EQ(6, light.Members.size());
+  CHECK(light.Members[2].Name == "Direction");
+  CHECK_EQ(224, light.Members[2].ListedOffset);
+  CHECK_EQ(252, light.Members[5].ListedOffset);
+  const CBufferGen::StructDef* pointLight = generator.FindStruct("PointLight");
+  CHECK(pointLight != nullptr);
+  CHECK_EQ(48, pointLight->Size);
+  CHECK_EQ(16, pointLight->Fields[2].Offset);
+
+  const CBufferGen::StructDef* draw = generator.FindCBuffer("cbDraw");
+  CHECK(draw != nullptr);
+  CHECK_EQ(8, draw->Size);
+  CHECK(draw->Fields[1].FieldType.Name == "uint");
+  CHECK_EQ(4, draw->Fields[1].Offset);
+}
+
+TEST(CBufferGenFiltersSharedBlocks)
+{
+  // As GenerateConstants.sh splits cbView off into ViewConstants.h.
+  CBufferGen::Generator view;
+  CHECK(Load(view, PBR_VS_LISTING, "cbView"));
+  CHECK(view.GetCBufferOrder() == std::vector<std::string>{"cbView"});
+  CHECK(view.FindStruct("PointLight") != nullptr);
+
+  CBufferGen::Generator pbr;
+  CHECK(Load(pbr, PBR_VS_LISTING, nullptr, "cbView"));
+  CHECK(pbr.GetCBufferOrder() == (std::vector<std::string>{"cbPerObject", "cbDraw"}));
+  CHECK(pbr.FindCBuffer("cbView") == nullptr);
+  // Only cbView uses PointLight.
+  CHECK(pbr.GetStructOrder().empty());
+}
+
+TEST(CBufferGenRejectsListingsOffTheRules)
+{
+  CBufferGen::Generator moved;
+  CHECK(!Load(moved, Replace(PBR_VS_LISTING, "Offset:  256", "Offset:  260")));
+
+  CBufferGen::Generator resized;
+  CHECK(!Load(resized, Replace(PBR_VS_LISTING, "Size:     8", "Size:    16")));
+
+  // A member of a struct use is checked against the listing as well.
+  CBufferGen::Generator member;
+  CHECK(!Load(member, Replace(PBR_VS_LISTING, "Offset:  236", "Offset:  240")));
+
+  CBufferGen::Generator unsupported;
+  CHECK(!Load(unsupported, Replace(PBR_VS_LISTING, "float2 PrevJitter;", "double2 PrevJitter;")));
+}
+
+TEST(CBufferGenWritesHeader)
+{
+  CBufferGen::Generator generator;
+  CHECK(Load(generator, PBR_VS_LISTING, "cbView"));
+  std::ostringstream header;
+  generator.WriteHeader(header);
+  const std::string text = header.str();
+
+  // The lines ViewConstants.h has for this listing.
+  for (const char* line : {"#ifndef GENERATED_VIEW_CONSTANTS_H\n", "static_assert(sizeof(PointLight) == 48, \"PointLight does not match the HLSL PointLight\");\n",
+                           "  DirectX::XMFLOAT4X4 PrevViewProjectionMatrix;  // column_major, store the transpose.\n", "  PointLight gLight;\n",
+                           "static_assert(offsetof(cbView, gEyePosW) == 256, \"cbView.gEyePosW offset\");\n",
+                           "static_assert(sizeof(cbView) == 268, \"cbView size\");\n", "      {CTEXT(\"gLight\"), 208, 48},\n",
+                           "  static const CBufferLayout LAYOUT = {CTEXT(\"cbView\"), 268, FIELDS, 7};\n"}) {
+    CHECK(text.find(line) != std::string::npos);
+  }
+}
@@ -0,0 +1,281 @@
+// CommandRecorder against a mock command list that logs the calls it receives, in order.
+#include <string>
+#include <vector>
+#include "Graphics/CommandRecorder.h"
+#include "Test.h"
+
+namespace {
+struct MockPipelineState {};
+struct MockRootSignature {};
+struct MockDescriptorHeap {};
+struct MockDescriptorHandle {
+  uint64 ptr;
+};
+struct MockVertexBufferView {
+  uint64 BufferLocation;
+  uint32 SizeInBytes;
+  uint32 StrideInBytes;
+};
+struct MockIndexBufferView {
+  uint64 BufferLocation;
+  uint32 SizeInBytes;
+  uint32 Format;
+};
+enum MockTopology { MOCK_TOPOLOGY_UNDEFINED = 0, MOCK_TOPOLOGY_TRIANGLELIST = 4, MOCK_TOPOLOGY_LINELIST = 2 };
+
+// Every call is logged as "Method:argument", so a test compares the whole stream the list received.
+class MockCommandList
+{
+ public:
+  void SetPipelineState(MockPipelineState* pipelineState) { Log("PSO", pipelineState); }
+  void SetGraphicsRootSignature(MockRootSignature* rootSignature) { Log("RootSignature", rootSignature); }
+  void SetDescriptorHeaps(uint32 count, MockDescriptorHeap* const* heaps) { Log("Heaps", count > 0 ? heaps[0] : nullptr); }
+  void SetGraphicsRootConstantBufferView(uint32 rootIndex, uint64 address) { Log("CBV" + std::to_string(rootIndex), address); }
+  void SetGraphicsRootShaderResourceView(uint32 rootIndex, uint64 address) { Log("SRV" + std::to_string(rootIndex), address); }
+  void SetGraphicsRootDescriptorTable(uint32 rootIndex, MockDescriptorHandle handle) { Log("Table" + std::to_string(rootIndex), handle.ptr); }
+  void IASetVertexBuffers(uint32 startSlot, uint32 count, const MockVertexBufferView* views)
+  {
+    Log("VB" + std::to_string(startSlot) + "x" + std::to_string(count), views != nullptr ? views[0].BufferLocation : 0);
+  }
+  void IASetIndexBuffer(const MockIndexBufferView* view) { Log("IB", view != nullptr ? view->BufferLocation : 0); }
+  void IASetPrimitiveTopology(MockTopology topology) { Log("Topology", static_cast<uint64>(topology)); }
+
+  // Returns the calls since the last TakeCalls.
+  std::vector<std::string> TakeCalls()
+  {
+    std::vector<std::string> calls;
+    calls.swap(mCalls);
+    return calls;
+  }
+
+ private:
+  void Log(const std::string& method, const void* pointer) { Log(method, reinterpret_cast<uint64>(pointer)); }
+  void Log(const std::string& method, uint64 value) { mCalls.push_back(method + ":" + std::to_string(value)); }
+
+ private:
+  std::vector<std::string> mCalls;
+};
+}  // namespace
+
+template <>
+struct CommandListTraits<MockCommandList> {
+  using PipelineState     = MockPipelineState;
+  using RootSignature     = MockRootSignature;
+  using DescriptorHeap    = MockDescriptorHeap;
+  using GpuAddress        = uint64;
+  using DescriptorHandle  = MockDescriptorHandle;
+  using VertexBufferView  = MockVertexBufferView;
+  using IndexBufferView   = MockIndexBufferView;
+  using PrimitiveTopology = MockTopology;
+};
+
+namespace {
+using Recorder = CommandRecorder<MockCommandList>;
+
+template <typename T>
+std::string Call(const std::string& method, const T* pointer)
+{
+  return method + ":" + std::to_string(reinterpret_cast<uint64>(pointer));
+}
+std::string Call(const std::string& method, uint64 value) { return method + ":" + std::to_string(value); }
+}  // namespace
+
+TEST(CommandRecorderPassesCallsInOrder)
+{
+  MockCommandList list;
+  Recorder recorder;
+  recorder.Begin(&list);
+
+  MockPipelineState pso;
+  MockRootSignature rootSignature;
+  MockDescriptorHeap heap;
+  MockDescriptorHeap* heaps[] = {&heap};
+  const MockVertexBufferView vertexBuffer = {0x1000, 64, 16};
+  const MockIndexBufferView indexBuffer   = {0x2000, 32, 42};
+
+  recorder.SetPipelineState(&pso);
+  recorder.SetGraphicsRootSignature(&rootSignature);
+  recorder.SetDescriptorHeaps(1, heaps);
+  recorder.SetGraphicsRootDescriptorTable(3, {0x300});
+  recorder.SetGraphicsRootConstantBufferView(0, 0x100);
+  recorder.SetGraphicsRootShaderResourceView(1, 0x200);
+  recorder.IASetVertexBuffers(0, 1, &vertexBuffer);
+  recorder.IASetIndexBuffer(&indexBuffer);
+  recorder.IASetPrimitiveTopology(MOCK_TOPOLOGY_TRIANGLELIST);
+
+  const std::vector<std::string> expected = {Call("PSO", &pso),   Call("RootSignature", &rootSignature), Call("Heaps", &heap), Call("Table3", 0x300),
+                                            Call("CBV0", 0x100), Call("SRV1", 0x200), Call("VB0x1", 0x1000), Call("IB", 0x2000), Call("Topology", 4)};
+  CHECK(expected == list.TakeCalls());
+  CHECK_EQ(9, recorder.GetIssuedCount());
+  CHECK_EQ(0, recorder.GetFilteredCount());
+}
+
+TEST(CommandRecorderDropsRepeatedState)
+{
+  MockCommandList list;
+  Recorder recorder;
+  recorder.Begin(&list);
+
+  MockPipelineState opaque;
+  MockPipelineState transparent;
+  MockRootSignature rootSignature;
+  const MockVertexBufferView vertexBuffer = {0x1000, 64, 16};
+  const MockIndexBufferView indexBuffer   = {0x2000, 32, 42};
+
+  // A draw loop sets everything for every draw, only the changes reach the list.
+  for (uint32 draw = 0; draw < 4; ++draw) {
+    recorder.SetPipelineState(draw < 2 ? &opaque : &transparent);
+    recorder.SetGraphicsRootSignature(&rootSignature);
+    recorder.IASetPrimitiveTopology(MOCK_TOPOLOGY_TRIANGLELIST);
+    recorder.IASetVertexBuffers(0, 1, &vertexBuffer);
+    recorder.IASetIndexBuffer(&indexBuffer);
+    recorder.SetGraphicsRootConstantBufferView(0, 0x100 + draw);
+    recorder.SetGraphicsRootShaderResourceView(1, 0x200);
+  }
+
+  const std::vector<std::string> expected = {Call("PSO", &opaque), Call("RootSignature", &rootSignature), Call("Topology", 4), Call("VB0x1", 0x1000),
+                                            Call("IB", 0x2000),    Call("CBV0", 0x100), Call("SRV1", 0x200), Call("CBV0", 0x101), Call("PSO", &transparent),
+                                            Call("CBV0", 0x102),   Call("CBV0", 0x103)};
+  CHECK(expected == list.TakeCalls());
+  CHECK_EQ(11, recorder.GetIssuedCount());
+  CHECK_EQ(28 - 11, recorder.GetFilteredCount());
+
+  // The counters restart, the bound state stays.
+  recorder.ResetCounters();
+  recorder.SetPipelineState(&transparent);
+  CHECK_EQ(0, recorder.GetIssuedCount());
+  CHECK_EQ(1, recorder.GetFilteredCount());
+  CHECK(list.TakeCalls().empty());
+}
+
+TEST(CommandRecorderRootSignatureDropsRootArguments)
+{
+  MockCommandList list;
+  Recorder recorder;
+  recorder.Begin(&list);
+
+  MockRootSignature first;
+  MockRootSignature second;
+  recorder.SetGraphicsRootSignature(&first);
+  recorder.SetGraphicsRootConstantBufferView(0, 0x100);
+  recorder.SetGraphicsRootDescriptorTable(2, {0x300});
+  list.TakeCalls();
+
+  // The same root signature again keeps the arguments.
+  recorder.SetGraphicsRootSignature(&first);
+  recorder.SetGraphicsRootConstantBufferView(0, 0x100);
+  CHECK(list.TakeCalls().empty());
+
+  // A new one drops them, the same values are set again.
+  recorder.SetGraphicsRootSignature(&second);
+  recorder.SetGraphicsRootConstantBufferView(0, 0x100);
+  recorder.SetGraphicsRootDescriptorTable(2, {0x300});
+  const std::vector<std::string> expected = {Call("RootSignature", &second), Call("CBV0", 0x100), Call("Table2", 0x300)};
+  CHECK(expected == list.TakeCalls());
+}
+
+TEST(CommandRecorderHeapsDropTablesOnly)
+{
+  MockCommandList list;
+  Recorder recorder;
+  recorder.Begin(&list);
+
+  MockDescriptorHeap first;
+  MockDescriptorHeap second;
+  MockDescriptorHeap* firstHeaps[]  = {&first};
+  MockDescriptorHeap* secondHeaps[] = {&second};
+  recorder.SetDescriptorHeaps(1, firstHeaps);
+  recorder.SetGraphicsRootDescriptorTable(2, {0x300});
+  recorder.SetGraphicsRootConstantBufferView(0, 0x100);
+  recorder.SetDescriptorHeaps(1, firstHeaps);
+  list.TakeCalls();
+
+  // New heaps drop the tables that point into the old ones, root descriptors stay.
+  recorder.SetDescriptorHeaps(1, secondHeaps);
+  recorder.SetGraphicsRootDescriptorTable(2, {0x300});
+  recorder.SetGraphicsRootConstantBufferView(0, 0x100);
+  const std::vector<std::string> expected = {Call("Heaps", &second), Call("Table2", 0x300)};
+  CHECK(expected == list.TakeCalls());
+
+  // A table that became a root CBV of the same value is no table anymore, new heaps keep it.
+  recorder.SetGraphicsRootConstantBufferView(2, 0x400);
+  recorder.SetDescriptorHeaps(1, firstHeaps);
+  recorder.SetGraphicsRootConstantBufferView(2, 0x400);
+  const std::vector<std::string> heapsOnly = {Call("CBV2", 0x400), Call("Heaps", &first)};
+  CHECK(heapsOnly == list.TakeCalls());
+}
+
+TEST(CommandRecorderInvalidate)
+{
+  MockCommandList list;
+  Recorder recorder;
+  recorder.Begin(&list);
+
+  MockPipelineState pso;
+  recorder.SetPipelineState(&pso);
+  recorder.SetGraphicsRootConstantBufferView(0, 0x100);
+  recorder.SetGraphicsRootConstantBufferView(1, 0x200);
+  recorder.IASetPrimitiveTopology(MOCK_TOPOLOGY_LINELIST);
+  list.TakeCalls();
+
+  // One root argument, e.g. the object CBV after ExecuteIndirect.
+  recorder.InvalidateRootArgument(1);
+  recorder.SetGraphicsRootConstantBufferView(0, 0x100);
+  recorder.SetGraphicsRootConstantBufferView(1, 0x200);
+  const std::vector<std::string> oneArgument = {Call("CBV1", 0x200)};
+  CHECK(oneArgument == list.TakeCalls());
+
+  // Everything, after recording on the list behind the recorder, and at Begin.
+  recorder.Invalidate();
+  recorder.SetPipelineState(&pso);
+  recorder.IASetPrimitiveTopology(MOCK_TOPOLOGY_LINELIST);
+  const std::vector<std::string> everything = {Call("PSO", &pso), Call("Topology", 2)};
+  CHECK(everything == list.TakeCalls());
+
+  MockCommandList nextFrame;
+  recorder.Begin(&nextFrame);
+  recorder.SetPipelineState(&pso);
+  CHECK_EQ(1, nextFrame.TakeCalls().size());
+  CHECK(list.TakeCalls().empty());
+
+  // Root indices past the cache are passed every time.
+  recorder.SetGraphicsRootConstantBufferView(Recorder::MAX_ROOT_PARAMETERS, 0x100);
+  recorder.SetGraphicsRootConstantBufferView(Recorder::MAX_ROOT_PARAMETERS, 0x100);
+  CHECK_EQ(2, nextFrame.TakeCalls().size());
+}
+
+TEST(CommandRecorderVertexAndIndexBuffers)
+{
+  MockCommandList list;
+  Recorder recorder;
+  recorder.Begin(&list);
+
+  const MockVertexBufferView views[2] = {{0x1000, 64, 16}, {0x2000, 64, 8}};
+  recorder.IASetVertexBuffers(0, 2, views);
+  // A sub range of what is bound is filtered, a different stride is not.
+  recorder.IASetVertexBuffers(1, 1, &views[1]);
+  const MockVertexBufferView otherStride = {0x2000, 64, 12};
+  recorder.IASetVertexBuffers(1, 1, &otherStride);
+  const std::vector<std::string> expected = {Call("VB0x2", 0x1000), Call("VB1x1", 0x2000)};
+  CHECK(expected == list.TakeCalls());
+
+  // Unbinding forgets the slots, binding the old views again is passed on.
+  recorder.IASetVertexBuffers(0, 2, nullptr);
+  recorder.IASetVertexBuffers(0, 2, views);
+  const std::vector<std::string> rebound = {Call("VB0x2", 0), Call("VB0x2", 0x1000)};
+  CHECK(rebound == list.TakeCalls());
+
+  // Slots past MAX_VERTEX_BUFFERS are never cached.
+  recorder.IASetVertexBuffers(Recorder::MAX_VERTEX_BUFFERS, 1, views);
+  recorder.IASetVertexBuffers(Recorder::MAX_VERTEX_BUFFERS, 1, views);
+  CHECK_EQ(2, list.TakeCalls().size());
+
+  const MockIndexBufferView indexBuffer = {0x3000, 32, 42};
+  recorder.IASetIndexBuffer(&indexBuffer);
+  recorder.IASetIndexBuffer(&indexBuffer);
+  recorder.IASetIndexBuffer(nullptr);
+  recorder.IASetIndexBuffer(nullptr);
+  recorder.IASetIndexBuffer(&indexBuffer);
+  const std::vector<std::string> indexCalls = {Call("IB", 0x3000), Call("IB", 0), Call("IB", 0), Call("IB", 0x3000)};
+  CHECK(indexCalls == list.TakeCalls());
+}
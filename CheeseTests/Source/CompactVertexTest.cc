@@ -0,0 +1,122 @@
+// VertexCompressor round trips against the error bounds it advertises, on random vertices and every half float.
+#include <algorithm>
+#include <cmath>
+#include <random>
+#include <vector>
+#include "Model/CompactVertex.h"
+#include "Model/Mesh.h"
+#include "Test.h"
+
+namespace {
+DirectX::XMFLOAT3 RandomUnitVector(std::mt19937& random)
+{
+  std::normal_distribution<float> axis(0.0f, 1.0f);
+  float x, y, z, length;
+  do {
+    x      = axis(random);
+    y      = axis(random);
+    z      = axis(random);
+    length = sqrtf(x * x + y * y + z * z);
+  } while (length < 1e-3f);
+  return {x / length, y / length, z / length};
+}
+
+float AngleBetween(const DirectX::XMFLOAT3& a, const DirectX::XMFLOAT3& b)
+{
+  const float cosine = a.x * b.x + a.y * b.y + a.z * b.z;
+  const float sine   = sqrtf((a.y * b.z - a.z * b.y) * (a.y * b.z - a.z * b.y) + (a.z * b.x - a.x * b.z) * (a.z * b.x - a.x * b.z) +
+                             (a.x * b.y - a.y * b.x) * (a.x * b.y - a.y * b.x));
+  return atan2f(sine, cosine);
+}
+
+// Random vertices in a box from (-3, 0, 10) to (5, 0.5, 10.25), with unit normals and tangents and normal range UVs.
+std::vector<Vertex> MakeVertices(uint32 count)
+{
+  std::mt19937 random(count);
+  std::uniform_real_distribution<float> unit(0.0f, 1.0f);
+  std::uniform_real_distribution<float> texCoord(-4.0f, 4.0f);
+
+  std::vector<Vertex> vertices(count);
+  for (Vertex& vertex : vertices) {
+    vertex.Position                   = {-3.0f + 8.0f * unit(random), 0.5f * unit(random), 10.0f + 0.25f * unit(random)};
+    vertex.Normal                     = RandomUnitVector(random);
+    const DirectX::XMFLOAT3 direction = RandomUnitVector(random);
+    vertex.Tangent                    = {direction.x, direction.y, direction.z, unit(random) < 0.5f ? -1.0f : 1.0f};
+    vertex.TexCoord                   = {texCoord(random), texCoord(random)};
+  }
+
+  // The poles and the folded edges of the octahedron.
+  const DirectX::XMFLOAT3 axes[] = {{1.0f, 0.0f, 0.0f}, {-1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}, {0.0f, -1.0f, 0.0f}, {0.0f, 0.0f, 1.0f},
+                                    {0.0f, 0.0f, -1.0f}, {0.70710678f, 0.0f, -0.70710678f}, {0.0f, -0.70710678f, -0.70710678f}};
+  for (uint32 i = 0; i < 8; i++) vertices[i].Normal = axes[i];
+  return vertices;
+}
+
+float RelativeError(float value, float decoded) { return fabsf(decoded - value) / fabsf(value); }
+}  // namespace
+
+TEST(CompactVertexUnitVectorsWithinAngleError)
+{
+  const std::vector<Vertex> vertices = MakeVertices(100000);
+  std::vector<CompactVertex> compact(vertices.size());
+  const VertexQuantization quantization = VertexCompressor::ComputeQuantization(vertices);
+  VertexCompressor::Encode(vertices.data(), static_cast<uint32>(vertices.size()), quantization, compact.data());
+
+  float worstError = 0.0f;
+  for (uint32 i = 0; i < vertices.size(); i++) {
+    const Vertex decoded = VertexCompressor::Decode(compact[i], quantization);
+    const DirectX::XMFLOAT3 tangent(vertices[i].Tangent.x, vertices[i].Tangent.y, vertices[i].Tangent.z);
+    const DirectX::XMFLOAT3 decodedTangent(decoded.Tangent.x, decoded.Tangent.y, decoded.Tangent.z);
+    worstError = std::max<float>(worstError, AngleBetween(vertices[i].Normal, decoded.Normal));
+    worstError = std::max<float>(worstError, AngleBetween(tangent, decodedTangent));
+    CHECK_EQ(vertices[i].Tangent.w, decoded.Tangent.w);
+  }
+  CHECK(worstError <= VertexCompressor::OCT_MAX_ANGLE_ERROR);
+}
+
+TEST(CompactVertexPositionsWithinErrorBound)
+{
+  const std::vector<Vertex> vertices = MakeVertices(100000);
+  std::vector<CompactVertex> compact(vertices.size());
+  const VertexQuantization quantization = VertexCompressor::ComputeQuantization(vertices);
+  VertexCompressor::Encode(vertices.data(), static_cast<uint32>(vertices.size()), quantization, compact.data());
+
+  const DirectX::XMFLOAT3 bound = VertexCompressor::GetPositionErrorBound(quantization);
+  for (uint32 i = 0; i < vertices.size(); i++) {
+    const Vertex decoded = VertexCompressor::Decode(compact[i], quantization);
+    CHECK(fabsf(decoded.Position.x - vertices[i].Position.x) <= bound.x);
+    CHECK(fabsf(decoded.Position.y - vertices[i].Position.y) <= bound.y);
+    CHECK(fabsf(decoded.Position.z - vertices[i].Position.z) <= bound.z);
+  }
+}
+
+TEST(CompactVertexTexCoordsWithinHalfError)
+{
+  const std::vector<Vertex> vertices = MakeVertices(100000);
+  std::vector<CompactVertex> compact(vertices.size());
+  const VertexQuantization quantization = VertexCompressor::ComputeQuantization(vertices);
+  VertexCompressor::Encode(vertices.data(), static_cast<uint32>(vertices.size()), quantization, compact.data());
+
+  float worstError = 0.0f;
+  for (uint32 i = 0; i < vertices.size(); i++) {
+    const Vertex decoded = VertexCompressor::Decode(compact[i], quantization);
+    // Half floats are normal from 2^-14 on, below it the relative error grows.
+    if (fabsf(vertices[i].TexCoord.x) >= 1.0f / 16384.0f) worstError = std::max<float>(worstError, RelativeError(vertices[i].TexCoord.x, decoded.TexCoord.x));
+    if (fabsf(vertices[i].TexCoord.y) >= 1.0f / 16384.0f) worstError = std::max<float>(worstError, RelativeError(vertices[i].TexCoord.y, decoded.TexCoord.y));
+  }
+  CHECK(worstError <= VertexCompressor::HALF_MAX_RELATIVE_ERROR);
+}
+
+TEST(CompactVertexHalfRoundTripIsExact)
+{
+  for (uint32 half = 0; half <= 0xFFFF; half++) {
+    const float value = VertexCompressor::HalfToFloat(static_cast<uint16>(half));
+    if (value != value) {
+      // NaNs stay quiet NaNs of the same sign, their payload is not kept.
+      const uint16 nan = VertexCompressor::FloatToHalf(value);
+      CHECK((nan & 0x7C00) == 0x7C00 && (nan & 0x03FF) != 0 && (nan & 0x8000) == (half & 0x8000));
+      continue;
+    }
+    CHECK_EQ(half, VertexCompressor::FloatToHalf(value));
+  }
+}
@@ -0,0 +1,203 @@
+// CookedFormat::Validate on hand built .chm images, and the RGBA expansion done at cook time.
+#include <cstring>
+#include "Model/CookedFormat.h"
+#include "Test.h"
+
+using namespace CookedFormat;
+
+namespace {
+const uint32 VERTEX_STRIDE = 12;
+const uint32 VERTEX_COUNT  = 3;
+const uint32 INDEX_COUNT   = 3;
+const uint32 IMAGE_SIZE    = 2;
+
+uint64 AlignUp(uint64 value) { return (value + SECTION_ALIGN - 1) & ~static_cast<uint64>(SECTION_ALIGN - 1); }
+
+// One triangle with one LOD, one binding and one 2x2 RGBA image, laid out the way CookedModelBuilder::Save writes it.
+struct CookedFile {
+  std::vector<Byte> Data;
+
+  Header& GetHeader() { return *reinterpret_cast<Header*>(Data.data()); }
+  Draw& GetDraw() { return *reinterpret_cast<Draw*>(Data.data() + GetHeader().DrawOffset); }
+  Binding& GetBinding() { return *reinterpret_cast<Binding*>(Data.data() + GetHeader().BindingOffset); }
+  Image& GetImage() { return *reinterpret_cast<Image*>(Data.data() + GetHeader().ImageOffset); }
+  bool Validate() const { return CookedFormat::Validate(Data.data(), Data.size()); }
+};
+
+CookedFile MakeCookedFile()
+{
+  Header header        = {};
+  header.Magic         = MAGIC;
+  header.Version       = VERSION;
+  header.VertexStride  = VERTEX_STRIDE;
+  header.DrawCount     = 1;
+  header.BindingCount  = 1;
+  header.ImageCount    = 1;
+  header.VertexCount   = VERTEX_COUNT;
+  header.IndexCount16  = INDEX_COUNT;
+  header.DrawOffset    = AlignUp(sizeof(Header));
+  header.BindingOffset = AlignUp(header.DrawOffset + sizeof(Draw));
+  header.ImageOffset   = AlignUp(header.BindingOffset + sizeof(Binding));
+  header.VertexOffset  = AlignUp(header.ImageOffset + sizeof(Image));
+  header.Index16Offset = AlignUp(header.VertexOffset + VERTEX_COUNT * VERTEX_STRIDE);
+  header.Index32Offset = AlignUp(header.Index16Offset + INDEX_COUNT * sizeof(uint16));
+  const uint64 pixels  = header.Index32Offset;
+  header.FileSize      = pixels + IMAGE_SIZE * IMAGE_SIZE * IMAGE_COMPONENT;
+
+  CookedFile file;
+  file.Data.resize(header.FileSize);
+  file.GetHeader() = header;
+
+  Draw& draw              = file.GetDraw();
+  draw.IndexCount         = INDEX_COUNT;
+  draw.IndexSize          = sizeof(uint16);
+  draw.BindingCount       = 1;
+  draw.LodCount           = 1;
+  draw.Lods[0].IndexCount = INDEX_COUNT;
+
+  strcpy(file.GetBinding().Name, "gAlbedoMap");
+
+  Image& image      = file.GetImage();
+  image.Width       = IMAGE_SIZE;
+  image.Height      = IMAGE_SIZE;
+  image.Component   = IMAGE_COMPONENT;
+  image.PixelOffset = pixels;
+  image.PixelSize   = IMAGE_SIZE * IMAGE_SIZE * IMAGE_COMPONENT;
+
+  const uint16 indices[INDEX_COUNT] = {0, 1, 2};
+  memcpy(file.Data.data() + header.Index16Offset, indices, sizeof(indices));
+  return file;
+}
+}  // namespace
+
+TEST(CookedFormatAcceptsWellFormedFile)
+{
+  CookedFile file = MakeCookedFile();
+  CHECK(file.Validate());
+}
+
+TEST(CookedFormatRejectsBadHeader)
+{
+  CookedFile file = MakeCookedFile();
+  CHECK(!CookedFormat::Validate(nullptr, 0));
+  CHECK(!CookedFormat::Validate(file.Data.data(), sizeof(Header) - 1));
+
+  file.GetHeader().Magic = 0;
+  CHECK(!file.Validate());
+
+  file                     = MakeCookedFile();
+  file.GetHeader().Version = VERSION - 1;
+  CHECK(!file.Validate());
+
+  file                          = MakeCookedFile();
+  file.GetHeader().VertexStride = 0;
+  CHECK(!file.Validate());
+}
+
+TEST(CookedFormatRejectsTruncatedFile)
+{
+  CookedFile file = MakeCookedFile();
+  file.Data.pop_back();
+  CHECK(!file.Validate());
+
+  // A consistent FileSize does not help when the sections no longer fit.
+  file.GetHeader().FileSize = file.Data.size();
+  CHECK(!file.Validate());
+}
+
+TEST(CookedFormatRejectsBadSections)
+{
+  CookedFile file             = MakeCookedFile();
+  file.GetHeader().DrawOffset += 4;
+  CHECK(!file.Validate());
+
+  file                         = MakeCookedFile();
+  file.GetHeader().VertexCount = 1 << 20;
+  CHECK(!file.Validate());
+
+  file                          = MakeCookedFile();
+  file.GetHeader().IndexCount32 = 1 << 20;
+  CHECK(!file.Validate());
+}
+
+TEST(CookedFormatRejectsBadDraws)
+{
+  CookedFile file          = MakeCookedFile();
+  file.GetDraw().IndexSize = 1;
+  CHECK(!file.Validate());
+
+  file                              = MakeCookedFile();
+  file.GetDraw().StartIndexLocation = 1;
+  CHECK(!file.Validate());
+
+  file                        = MakeCookedFile();
+  file.GetDraw().BindingCount = 2;
+  CHECK(!file.Validate());
+
+  file                    = MakeCookedFile();
+  file.GetDraw().LodCount = 0;
+  CHECK(!file.Validate());
+
+  file                    = MakeCookedFile();
+  file.GetDraw().LodCount = MAX_LODS + 1;
+  CHECK(!file.Validate());
+
+  file                              = MakeCookedFile();
+  file.GetDraw().Lods[0].StartIndex = 1;
+  CHECK(!file.Validate());
+}
+
+TEST(CookedFormatRejectsBadBindings)
+{
+  CookedFile file              = MakeCookedFile();
+  file.GetBinding().ImageIndex = 1;
+  CHECK(!file.Validate());
+
+  file = MakeCookedFile();
+  memset(file.GetBinding().Name, 'a', BINDING_NAME_LEN);
+  CHECK(!file.Validate());
+}
+
+TEST(CookedFormatRejectsBadImages)
+{
+  // Loaders upload every cooked image as R8G8B8A8, anything else would be read with the wrong row pitch.
+  CookedFile file           = MakeCookedFile();
+  file.GetImage().Component = 3;
+  file.GetImage().PixelSize = IMAGE_SIZE * IMAGE_SIZE * 3;
+  CHECK(!file.Validate());
+
+  file                      = MakeCookedFile();
+  file.GetImage().PixelSize = 1;
+  CHECK(!file.Validate());
+
+  file                        = MakeCookedFile();
+  file.GetImage().PixelOffset = file.Data.size() - 1;
+  CHECK(!file.Validate());
+}
+
+TEST(CookedFormatExpandsToRgba)
+{
+  const Byte grey[]      = {10, 20};
+  const Byte greyAlpha[] = {10, 1, 20, 2};
+  const Byte rgb[]       = {1, 2, 3, 4, 5, 6};
+  const Byte rgba[]      = {1, 2, 3, 4, 5, 6, 7, 8};
+
+  Byte out[8];
+  CHECK(ExpandToRgba(grey, 2, 1, out));
+  const Byte expectedGrey[] = {10, 10, 10, 255, 20, 20, 20, 255};
+  CHECK(memcmp(out, expectedGrey, sizeof(out)) == 0);
+
+  CHECK(ExpandToRgba(greyAlpha, 2, 2, out));
+  const Byte expectedGreyAlpha[] = {10, 10, 10, 1, 20, 20, 20, 2};
+  CHECK(memcmp(out, expectedGreyAlpha, sizeof(out)) == 0);
+
+  CHECK(ExpandToRgba(rgb, 2, 3, out));
+  const Byte expectedRgb[] = {1, 2, 3, 255, 4, 5, 6, 255};
+  CHECK(memcmp(out, expectedRgb, sizeof(out)) == 0);
+
+  CHECK(ExpandToRgba(rgba, 2, 4, out));
+  CHECK(memcmp(out, rgba, sizeof(out)) == 0);
+
+  CHECK(!ExpandToRgba(rgba, 2, 0, out));
+  CHECK(!ExpandToRgba(rgba, 2, 5, out));
+}
@@ -0,0 +1,198 @@
+// The per frame draw path of RenderExample, batching, cluster culling and recording on the thread pool into a stub command list,
+// must not allocate once its buffers have grown. RenderData needs a device, the draws here stand in for its items.
+#include <thread>
+#include <vector>
+#include "Graphics/CommandRecorder.h"
+#include "Graphics/InstanceBatcher.h"
+#include "Model/Mesh.h"
+#include "Model/Meshlet.h"
+#include "Utils/AllocationCounter.h"
+#include "Utils/ThreadPool.h"
+#include "Test.h"
+
+namespace {
+struct StubPipelineState {};
+struct StubRootSignature {};
+struct StubDescriptorHeap {};
+struct StubDescriptorHandle {
+  uint64 ptr;
+};
+struct StubVertexBufferView {
+  uint64 BufferLocation;
+};
+struct StubIndexBufferView {
+  uint64 BufferLocation;
+};
+enum StubTopology { STUB_TOPOLOGY_UNDEFINED = 0, STUB_TOPOLOGY_TRIANGLELIST = 4 };
+
+// Counts what it receives and keeps nothing else.
+class StubCommandList
+{
+ public:
+  void SetPipelineState(StubPipelineState*) { mCallCount++; }
+  void SetGraphicsRootSignature(StubRootSignature*) { mCallCount++; }
+  void SetDescriptorHeaps(uint32, StubDescriptorHeap* const*) { mCallCount++; }
+  void SetGraphicsRootConstantBufferView(uint32, uint64) { mCallCount++; }
+  void SetGraphicsRootShaderResourceView(uint32, uint64) { mCallCount++; }
+  void SetGraphicsRootDescriptorTable(uint32, StubDescriptorHandle) { mCallCount++; }
+  void IASetVertexBuffers(uint32, uint32, const StubVertexBufferView*) { mCallCount++; }
+  void IASetIndexBuffer(const StubIndexBufferView*) { mCallCount++; }
+  void IASetPrimitiveTopology(StubTopology) { mCallCount++; }
+  void DrawIndexedInstanced(uint32 indexCount, uint32 instanceCount, uint32, int32, uint32) { mIndexCount += static_cast<uint64>(indexCount) * instanceCount; }
+
+  uint32 mCallCount  = 0;
+  uint64 mIndexCount = 0;
+};
+}  // namespace
+
+template <>
+struct CommandListTraits<StubCommandList> {
+  using PipelineState     = StubPipelineState;
+  using RootSignature     = StubRootSignature;
+  using DescriptorHeap    = StubDescriptorHeap;
+  using GpuAddress        = uint64;
+  using DescriptorHandle  = StubDescriptorHandle;
+  using VertexBufferView  = StubVertexBufferView;
+  using IndexBufferView   = StubIndexBufferView;
+  using PrimitiveTopology = StubTopology;
+};
+
+namespace {
+const uint32 GEOMETRY_COUNT = 16;
+const uint32 DRAW_COUNT     = 2048;
+const uint32 LIST_COUNT     = 4;
+
+// What RenderExample keeps per recording thread.
+struct RecordContext {
+  StubCommandList List;
+  CommandRecorder<StubCommandList> Recorder;
+  std::vector<ClusterDrawRange> ClusterRanges;
+};
+
+// Draws of GEOMETRY_COUNT meshlet grids, instanced where they share a geometry, as DrawRenderItem and RecordBatches do it.
+class DrawFrame
+{
+ public:
+  DrawFrame() : mContexts(LIST_COUNT)
+  {
+    std::vector<Vertex> vertices;
+    std::vector<uint32> indices;
+    for (uint32 y = 0; y <= 16; y++) {
+      for (uint32 x = 0; x <= 16; x++) {
+        Vertex vertex   = {};
+        vertex.Position = {static_cast<float>(x), static_cast<float>(y), 0.0f};
+        vertices.push_back(vertex);
+      }
+    }
+    for (uint32 y = 0; y < 16; y++) {
+      for (uint32 x = 0; x < 16; x++) {
+        const uint32 a = y * 17 + x;
+        indices.insert(indices.end(), {a, a + 1, a + 17, a + 1, a + 18, a + 17});
+      }
+    }
+    MeshletBuilder::Build(vertices, indices, mMeshlets);
+    // As RenderExample does once the scene is loaded. DrawSorter swaps the sorted and the scratch buffers,
+    // without the reserve their capacities would keep moving between the sorts of a frame.
+    mBatcher.Reserve(DRAW_COUNT);
+
+    for (DirectX::XMFLOAT4& plane : mView.Planes) plane = {0.0f, 0.0f, 0.0f, 1.0f};
+    // Keep y >= 4, the meshlets below are culled.
+    mView.Planes[0]      = {0.0f, 1.0f, 0.0f, -4.0f};
+    mView.CameraPosition = {8.0f, 8.0f, 10.0f};
+  }
+
+  // One pass: batch and sort the draws, then record the batches over the thread pool. Returns the indices drawn.
+  uint64 Run()
+  {
+    mBatcher.Clear();
+    for (uint32 draw = 0; draw < DRAW_COUNT; ++draw) {
+      const uint32 geometry = draw % GEOMETRY_COUNT;
+      const uint64 sortKey  = DrawSorter::MakeOpaqueKey(0, geometry % 2, geometry, false, static_cast<float>(draw) / DRAW_COUNT);
+      // Every fourth draw is a single, like a draw of a blended material.
+      const uint64 batchKey = draw % 4 == 0 ? InstanceBatcher::MakeSingleKey(draw) : InstanceBatcher::MakeKey(geometry, 0, 0);
+      mBatcher.Add(batchKey, sortKey, draw, 0);
+    }
+    mBatcher.Build();
+
+    const uint32 batchCount = static_cast<uint32>(mBatcher.GetBatches().size());
+    ThreadPool::Get().ParallelFor(LIST_COUNT, [&](uint32 listIndex) {
+      RecordContext& context = mContexts[listIndex];
+      context.List           = StubCommandList();
+      context.Recorder.Begin(&context.List);
+      Record(context, batchCount * listIndex / LIST_COUNT, batchCount * (listIndex + 1) / LIST_COUNT);
+    });
+
+    uint64 indexCount = 0;
+    for (const RecordContext& context : mContexts) indexCount += context.List.mIndexCount;
+    return indexCount;
+  }
+
+ private:
+  void Record(RecordContext& context, uint32 begin, uint32 end)
+  {
+    CommandRecorder<StubCommandList>& recorder = context.Recorder;
+    recorder.SetGraphicsRootSignature(&mRootSignature);
+    recorder.IASetPrimitiveTopology(STUB_TOPOLOGY_TRIANGLELIST);
+    recorder.SetGraphicsRootConstantBufferView(0, 0x1000);
+
+    for (uint32 batchIndex = begin; batchIndex < end; ++batchIndex) {
+      const InstanceBatch& batch              = mBatcher.GetBatches()[batchIndex];
+      const uint32 geometry                   = batch.ItemIndex % GEOMETRY_COUNT;
+      const StubVertexBufferView vertexBuffer = {0x10000ull * (geometry + 1)};
+      const StubIndexBufferView indexBuffer   = {0x20000ull * (geometry + 1)};
+
+      recorder.SetPipelineState(&mPipelines[geometry % 2]);
+      recorder.IASetVertexBuffers(0, 1, &vertexBuffer);
+      recorder.IASetIndexBuffer(&indexBuffer);
+      recorder.SetGraphicsRootConstantBufferView(1, 0x100ull * batch.ItemIndex);
+
+      if (batch.InstanceCount == 1) {
+        ClusterCuller::Cull(mMeshlets, mView, context.ClusterRanges);
+        for (const ClusterDrawRange& range : context.ClusterRanges) context.List.DrawIndexedInstanced(range.IndexCount, 1, range.StartIndex, 0, 0);
+      } else {
+        context.List.DrawIndexedInstanced(static_cast<uint32>(mMeshlets.Triangles.size()), batch.InstanceCount, 0, 0, batch.FirstInstance);
+      }
+    }
+  }
+
+ private:
+  MeshletData mMeshlets;
+  ClusterCullView mView;
+  StubRootSignature mRootSignature;
+  StubPipelineState mPipelines[2];
+  InstanceBatcher mBatcher;
+  std::vector<RecordContext> mContexts;
+};
+}  // namespace
+
+TEST(AllocationCounterCountsOtherThreads)
+{
+  // ParallelFor may run every index on the calling thread, a thread of its own is sure to allocate elsewhere.
+  std::vector<int*> values(256, nullptr);
+  AllocationScope allocations;
+  std::thread worker([&] {
+    for (uint32 i = 0; i < values.size(); ++i) values[i] = new int(static_cast<int>(i));
+  });
+  worker.join();
+  CHECK(allocations.GetCount() >= values.size());
+
+  int sum = 0;
+  for (int* value : values) {
+    sum += *value;
+    delete value;
+  }
+  CHECK_EQ(255 * 256 / 2, sum);
+}
+
+TEST(DrawPathDoesNotAllocate)
+{
+  DrawFrame frame;
+  // The first frame grows the cluster ranges of every context to the size of the meshlets.
+  const uint64 firstIndexCount = frame.Run();
+  CHECK(firstIndexCount > 0);
+
+  AllocationScope allocations;
+  const uint64 secondIndexCount = frame.Run();
+  CHECK_EQ(0, allocations.GetCount());
+  CHECK_EQ(firstIndexCount, secondIndexCount);
+}
@@ -0,0 +1,89 @@
+// The SIMD cull kernels against the scalar one, and the scalar one against boxes with a known answer.
+#include <random>
+#include "Graphics/FrustumCuller.h"
+#include "Test.h"
+
+using namespace DirectX;
+
+namespace {
+// 90 degree frustum at the origin looking down +z, from 1 to 100. The normals point inwards.
+const float HALF_SQRT2   = 0.70710678f;
+const XMFLOAT4 PLANES[6] = {
+    {HALF_SQRT2, 0.0f, HALF_SQRT2, 0.0f}, {-HALF_SQRT2, 0.0f, HALF_SQRT2, 0.0f}, {0.0f, HALF_SQRT2, HALF_SQRT2, 0.0f},
+    {0.0f, -HALF_SQRT2, HALF_SQRT2, 0.0f}, {0.0f, 0.0f, 1.0f, -1.0f},            {0.0f, 0.0f, -1.0f, 100.0f},
+};
+
+// Boxes all around the frustum, so every plane rejects some of them.
+void MakeBoxes(uint32 count, CullBoxes& boxes)
+{
+  std::mt19937 random(count);
+  std::uniform_real_distribution<float> position(-120.0f, 120.0f);
+  std::uniform_real_distribution<float> extent(0.1f, 10.0f);
+
+  boxes.Clear();
+  for (uint32 i = 0; i < count; ++i) {
+    boxes.Add({position(random), position(random), position(random)}, {extent(random), extent(random), extent(random)});
+  }
+}
+
+std::vector<uint32> CullRange(FrustumCuller::Kernel kernel, const CullBoxes& boxes, uint32 first, uint32 count)
+{
+  std::vector<uint32> visible(count);
+  visible.resize(FrustumCuller::CullRange(kernel, boxes, PLANES, first, count, visible.data()));
+  return visible;
+}
+}  // namespace
+
+TEST(FrustumCullerScalarKnownBoxes)
+{
+  CullBoxes boxes;
+  boxes.Add({0.0f, 0.0f, 50.0f}, {1.0f, 1.0f, 1.0f});    // inside
+  boxes.Add({0.0f, 0.0f, -50.0f}, {1.0f, 1.0f, 1.0f});   // behind the near plane
+  boxes.Add({0.0f, 0.0f, 200.0f}, {1.0f, 1.0f, 1.0f});   // beyond the far plane
+  boxes.Add({60.0f, 0.0f, 50.0f}, {1.0f, 1.0f, 1.0f});   // right of the frustum
+  boxes.Add({0.0f, 0.0f, 100.5f}, {1.0f, 1.0f, 1.0f});   // straddles the far plane
+  boxes.Add({50.0f, 0.0f, 50.0f}, {0.5f, 0.5f, 0.5f});   // straddles the right plane
+  boxes.Add({0.0f, -30.0f, 20.0f}, {1.0f, 1.0f, 1.0f});  // below the frustum
+
+  const std::vector<uint32> visible = CullRange(FrustumCuller::Kernel::SCALAR, boxes, 0, boxes.GetCount());
+  CHECK_EQ(3, visible.size());
+  CHECK_EQ(0, visible[0]);
+  CHECK_EQ(4, visible[1]);
+  CHECK_EQ(5, visible[2]);
+}
+
+TEST(FrustumCullerKernelsMatchScalar)
+{
+  CullBoxes boxes;
+  MakeBoxes(1003, boxes);
+
+  std::vector<FrustumCuller::Kernel> kernels = {FrustumCuller::Kernel::SSE};
+  if (IsAvx2Supported()) kernels.push_back(FrustumCuller::Kernel::AVX2);
+
+  // Ranges that start and end off the 4 and 8 box steps exercise the tails.
+  const uint32 ranges[][2] = {{0, 1003}, {0, 3}, {1, 7}, {5, 64}, {13, 990}, {1000, 3}};
+  for (FrustumCuller::Kernel kernel : kernels) {
+    for (const auto& range : ranges) {
+      const std::vector<uint32> expected = CullRange(FrustumCuller::Kernel::SCALAR, boxes, range[0], range[1]);
+      const std::vector<uint32> actual   = CullRange(kernel, boxes, range[0], range[1]);
+      CHECK_EQ(expected.size(), actual.size());
+      CHECK(expected == actual);
+    }
+  }
+}
+
+TEST(FrustumCullerParallelMatchesScalar)
+{
+  CullBoxes boxes;
+  MakeBoxes(FrustumCuller::CHUNK_SIZE * 3 + 17, boxes);
+  const std::vector<uint32> expected = CullRange(FrustumCuller::Kernel::SCALAR, boxes, 0, boxes.GetCount());
+  CHECK(!expected.empty());
+
+  FrustumCuller culler;
+  std::vector<uint32> visible;
+  for (FrustumCuller::Kernel kernel : {FrustumCuller::Kernel::SCALAR, FrustumCuller::Kernel::SSE, FrustumCuller::Kernel::AVX2}) {
+    culler.SetKernel(kernel);
+    CHECK_EQ(expected.size(), culler.Cull(boxes, PLANES, visible));
+    CHECK(expected == visible);
+  }
+}
@@ -0,0 +1,69 @@
+// IndirectDrawCommand written the way IndirectDrawBuffer::Write writes it, read back argument by argument with Decode.
+#include <cstring>
+#include "Graphics/IndirectDrawBuffer.h"
+#include "Test.h"
+
+namespace {
+// Every field distinct and with bits set in every byte, so a shifted argument can not decode to the same value.
+IndirectDrawCommand MakeCommand(uint32 i)
+{
+  IndirectDrawCommand command;
+  command.ObjectCbv                  = 0x0123456789AB0000ull + i * 256;
+  command.ObjectIndex                = 0x01010101u * (i + 1);
+  command.MaterialId                 = 0x10203040u + i;
+  command.Draw.IndexCountPerInstance = 0x11000000u + i * 3;
+  command.Draw.InstanceCount         = 1 + i % 7;
+  command.Draw.StartIndexLocation    = 0x22000000u + i * 5;
+  command.Draw.BaseVertexLocation    = -static_cast<int32>(i * 11);
+  command.Draw.StartInstanceLocation = 0x33000000u + i;
+  return command;
+}
+
+// Write copies whole commands into the mapped buffer, the encode here is the same copy.
+std::vector<Byte> Encode(const std::vector<IndirectDrawCommand>& commands)
+{
+  std::vector<Byte> data(commands.size() * sizeof(IndirectDrawCommand));
+  for (size_t i = 0; i < commands.size(); ++i) {
+    IndirectDrawCommand command = commands[i];
+    memcpy(data.data() + i * sizeof(IndirectDrawCommand), &command, sizeof(IndirectDrawCommand));
+  }
+  return data;
+}
+
+bool SameCommand(const IndirectDrawCommand& a, const IndirectDrawCommand& b)
+{
+  return a.ObjectCbv == b.ObjectCbv && a.ObjectIndex == b.ObjectIndex && a.MaterialId == b.MaterialId &&
+         a.Draw.IndexCountPerInstance == b.Draw.IndexCountPerInstance && a.Draw.InstanceCount == b.Draw.InstanceCount &&
+         a.Draw.StartIndexLocation == b.Draw.StartIndexLocation && a.Draw.BaseVertexLocation == b.Draw.BaseVertexLocation &&
+         a.Draw.StartInstanceLocation == b.Draw.StartInstanceLocation;
+}
+}  // namespace
+
+TEST(IndirectDrawBufferDecodesOneCommand)
+{
+  const std::vector<IndirectDrawCommand> commands = {MakeCommand(0)};
+  const std::vector<Byte> data                    = Encode(commands);
+
+  std::vector<IndirectDrawCommand> decoded;
+  IndirectDrawBuffer::Decode(data.data(), 1, decoded);
+  CHECK_EQ(1, decoded.size());
+  CHECK(SameCommand(commands[0], decoded[0]));
+}
+
+TEST(IndirectDrawBufferDecodesEveryStride)
+{
+  // Enough commands for the stride to be off by a full command before the last ones, if the signature and the struct disagreed.
+  std::vector<IndirectDrawCommand> commands;
+  for (uint32 i = 0; i < 37; ++i) commands.push_back(MakeCommand(i));
+  const std::vector<Byte> data = Encode(commands);
+
+  std::vector<IndirectDrawCommand> decoded;
+  IndirectDrawBuffer::Decode(data.data(), static_cast<uint32>(commands.size()), decoded);
+  CHECK_EQ(commands.size(), decoded.size());
+  for (size_t i = 0; i < commands.size(); ++i) CHECK(SameCommand(commands[i], decoded[i]));
+
+  // A shorter count reads only the front and resizes the output down.
+  IndirectDrawBuffer::Decode(data.data(), 3, decoded);
+  CHECK_EQ(3, decoded.size());
+  CHECK(SameCommand(commands[2], decoded[2]));
+}
@@ -0,0 +1,147 @@
+// InstanceBatcher grouping, ordering and batch sizes, with sort keys built the way RenderExample builds them.
+#include <algorithm>
+#include "Graphics/InstanceBatcher.h"
+#include "Test.h"
+
+namespace {
+const uint32 PASS     = 1;
+const uint32 PIPELINE = 0;
+
+uint64 MakeSortKey(uint32 material, float depth) { return DrawSorter::MakeOpaqueKey(PASS, PIPELINE, material, false, depth); }
+
+// Checks that every instance of every batch was added with the key of the batch.
+bool InstancesMatchBatches(const InstanceBatcher& batcher, const std::vector<uint32>& geometryOfItem)
+{
+  uint32 instanceCount = 0;
+  for (const InstanceBatch& batch : batcher.GetBatches()) {
+    for (uint32 i = batch.FirstInstance; i < batch.FirstInstance + batch.InstanceCount; ++i) {
+      if (geometryOfItem[batcher.GetInstanceItems()[i]] != geometryOfItem[batch.ItemIndex]) return false;
+    }
+    instanceCount += batch.InstanceCount;
+  }
+  return instanceCount == batcher.GetInstanceItems().size();
+}
+}  // namespace
+
+TEST(InstanceBatcherGroupsByGeometryAndArg)
+{
+  // Items 0, 2 and 4 share geometry 7, items 1 and 3 geometry 9. Every item has draw args 0 and 1 with their own materials.
+  const std::vector<uint32> geometryOfItem = {7, 9, 7, 9, 7};
+
+  InstanceBatcher batcher;
+  for (uint32 item = 0; item < geometryOfItem.size(); ++item) {
+    for (uint32 arg = 0; arg < 2; ++arg) {
+      batcher.Add(InstanceBatcher::MakeKey(geometryOfItem[item], arg, 0), MakeSortKey(geometryOfItem[item] * 2 + arg, 0.5f), item, arg);
+    }
+  }
+  batcher.Build();
+
+  CHECK_EQ(10, batcher.GetDrawCount());
+  CHECK_EQ(4, batcher.GetBatches().size());
+  CHECK_EQ(10, batcher.GetInstanceItems().size());
+  for (const InstanceBatch& batch : batcher.GetBatches()) {
+    CHECK_EQ(geometryOfItem[batch.ItemIndex] == 7 ? 3 : 2, batch.InstanceCount);
+  }
+
+  // Draw args of one item never share a batch.
+  std::vector<uint32> argOfBatch;
+  for (const InstanceBatch& batch : batcher.GetBatches()) argOfBatch.push_back(batch.ArgIndex);
+  CHECK_EQ(2, std::count(argOfBatch.begin(), argOfBatch.end(), 0u));
+  CHECK(InstancesMatchBatches(batcher, geometryOfItem));
+}
+
+TEST(InstanceBatcherSplitsLods)
+{
+  InstanceBatcher batcher;
+  batcher.Add(InstanceBatcher::MakeKey(3, 0, 0), MakeSortKey(1, 0.1f), 0, 0);
+  batcher.Add(InstanceBatcher::MakeKey(3, 0, 1), MakeSortKey(1, 0.9f), 1, 0);
+  batcher.Add(InstanceBatcher::MakeKey(3, 0, 0), MakeSortKey(1, 0.2f), 2, 0);
+  batcher.Build();
+
+  CHECK_EQ(2, batcher.GetBatches().size());
+  CHECK_EQ(2, batcher.GetBatches()[0].InstanceCount);
+  CHECK_EQ(1, batcher.GetBatches()[1].InstanceCount);
+  CHECK_EQ(1, batcher.GetBatches()[1].ItemIndex);
+}
+
+TEST(InstanceBatcherKeepsAddOrderWithinBatch)
+{
+  InstanceBatcher batcher;
+  const uint32 items[] = {5, 2, 8, 0, 3};
+  for (uint32 item : items) batcher.Add(InstanceBatcher::MakeKey(1, 0, 0), MakeSortKey(0, 0.5f), item, 0);
+  batcher.Build();
+
+  CHECK_EQ(1, batcher.GetBatches().size());
+  const InstanceBatch& batch = batcher.GetBatches()[0];
+  CHECK_EQ(5, batch.ItemIndex);
+  CHECK_EQ(0, batch.FirstInstance);
+  CHECK_EQ(5, batch.InstanceCount);
+  for (uint32 i = 0; i < 5; ++i) CHECK_EQ(items[i], batcher.GetInstanceItems()[i]);
+}
+
+TEST(InstanceBatcherOrdersBatchesBySortKey)
+{
+  // Batch keys in the opposite order of the sort keys, a near draw of a far batch does not move the batch.
+  InstanceBatcher batcher;
+  batcher.Add(InstanceBatcher::MakeKey(0, 0, 0), MakeSortKey(0, 0.9f), 0, 0);
+  batcher.Add(InstanceBatcher::MakeKey(1, 0, 0), MakeSortKey(0, 0.5f), 1, 0);
+  batcher.Add(InstanceBatcher::MakeKey(2, 0, 0), MakeSortKey(0, 0.1f), 2, 0);
+  batcher.Add(InstanceBatcher::MakeKey(0, 0, 0), MakeSortKey(0, 0.0f), 3, 0);
+  // Equal sort keys keep the batch key order.
+  batcher.Add(InstanceBatcher::MakeKey(4, 0, 0), MakeSortKey(0, 0.3f), 4, 0);
+  batcher.Add(InstanceBatcher::MakeKey(3, 0, 0), MakeSortKey(0, 0.3f), 5, 0);
+  batcher.Build();
+
+  const std::vector<InstanceBatch>& batches = batcher.GetBatches();
+  CHECK_EQ(5, batches.size());
+  CHECK_EQ(2, batches[0].ItemIndex);
+  CHECK_EQ(5, batches[1].ItemIndex);
+  CHECK_EQ(4, batches[2].ItemIndex);
+  CHECK_EQ(1, batches[3].ItemIndex);
+  CHECK_EQ(0, batches[4].ItemIndex);
+  CHECK_EQ(2, batches[4].InstanceCount);
+
+  // The instance ranges are in batch key order, whatever the submission order.
+  CHECK_EQ(0, batches[4].FirstInstance);
+  CHECK_EQ(3, batcher.GetInstanceItems()[1]);
+}
+
+TEST(InstanceBatcherSingleKeysNeverMerge)
+{
+  InstanceBatcher batcher;
+  for (uint32 i = 0; i < 4; ++i) batcher.Add(InstanceBatcher::MakeSingleKey(i), MakeSortKey(0, 1.0f - i * 0.25f), 0, 0);
+  batcher.Build();
+
+  CHECK_EQ(4, batcher.GetBatches().size());
+  for (const InstanceBatch& batch : batcher.GetBatches()) CHECK_EQ(1, batch.InstanceCount);
+
+  // No MakeKey result collides with a single key, even with every field at its maximum.
+  const uint64 largestKey = InstanceBatcher::MakeKey(0xFFFFFFFF, (1u << InstanceBatcher::ARG_BITS) - 1, (1u << InstanceBatcher::LOD_BITS) - 1);
+  CHECK((largestKey >> 63) == 0);
+  CHECK(InstanceBatcher::MakeSingleKey(0) != InstanceBatcher::MakeKey(0, 0, 0));
+}
+
+TEST(InstanceBatcherInstanceCounts)
+{
+  InstanceBatcher batcher;
+  batcher.Build();
+  CHECK_EQ(0, batcher.GetBatches().size());
+  CHECK_EQ(0, batcher.GetInstanceItems().size());
+
+  // One batch takes any number of instances, the instance buffer is what limits them, see RenderData::ReserveInstances.
+  const uint32 instanceCount = 100000;
+  batcher.Reserve(instanceCount);
+  for (uint32 i = 0; i < instanceCount; ++i) batcher.Add(InstanceBatcher::MakeKey(2, 1, 0), MakeSortKey(0, 0.5f), i, 1);
+  batcher.Build();
+  CHECK_EQ(1, batcher.GetBatches().size());
+  CHECK_EQ(instanceCount, batcher.GetBatches()[0].InstanceCount);
+  CHECK_EQ(instanceCount - 1, batcher.GetInstanceItems().back());
+
+  // Clear starts the next frame from nothing.
+  batcher.Clear();
+  batcher.Add(InstanceBatcher::MakeKey(2, 1, 0), MakeSortKey(0, 0.5f), 7, 1);
+  batcher.Build();
+  CHECK_EQ(1, batcher.GetBatches().size());
+  CHECK_EQ(1, batcher.GetBatches()[0].InstanceCount);
+  CHECK_EQ(7, batcher.GetInstanceItems()[0]);
+}
@@ -0,0 +1,88 @@
+// LodSelector around the distance where a LOD's error reaches the pixel threshold, coming from either side.
+#include <cmath>
+#include "Core/Camera.h"
+#include "Graphics/LodSelector.h"
+#include "Test.h"
+
+namespace {
+// A 1000 pixel high viewport whose vertical field spans one unit at distance one: one unit covers 1000 pixels there.
+Camera MakeCamera()
+{
+  Camera camera;
+  camera.SetPosition(0.0f, 0.0f, 0.0f);
+  camera.SetFrustum(2.0f * atanf(0.5f), 1.0f, 0.1f, 1000.0f);
+  camera.SetViewPort(0.0f, 0.0f, 1000.0f, 1000.0f);
+  return camera;
+}
+
+// LOD 1 has an error of 0.01 units, 10 pixels at distance 1 and one pixel at distance 10.
+DrawArg MakeArg(uint32 currentLod)
+{
+  DrawArg arg    = {};
+  arg.LodCount   = 3;
+  arg.Lods[1]    = {0, 0, 0.01f};
+  arg.Lods[2]    = {0, 0, 0.1f};
+  arg.CurrentLod = currentLod;
+  return arg;
+}
+
+uint32 SelectAt(const LodSelector& selector, uint32 currentLod, float distance)
+{
+  return selector.Select(MakeArg(currentLod), {0.0f, 0.0f, distance}, 0.0f, 1.0f);
+}
+}  // namespace
+
+TEST(LodSelectorProjectsErrors)
+{
+  LodSelector selector;
+  selector.SetView(MakeCamera());
+  CHECK(fabsf(selector.ProjectError(0.01f, 10.0f) - 1.0f) < 1e-4f);
+  CHECK(fabsf(selector.ProjectError(0.01f, 1.0f) - 10.0f) < 1e-3f);
+}
+
+TEST(LodSelectorHoldsLodWithinHysteresisBand)
+{
+  // Threshold one pixel, hysteresis 0.25: LOD 1 is taken once its error is below 0.75 pixels, beyond a distance of 13.3,
+  // and given up once it exceeds 1.25 pixels, closer than 8.
+  LodSelector selector(1.0f, 0.25f);
+  selector.SetView(MakeCamera());
+
+  for (float distance : {8.5f, 10.0f, 12.0f, 13.0f}) {
+    CHECK_EQ(0, SelectAt(selector, 0, distance));
+    CHECK_EQ(1, SelectAt(selector, 1, distance));
+  }
+
+  // Past the band, both sides agree.
+  CHECK_EQ(0, SelectAt(selector, 1, 7.5f));
+  CHECK_EQ(1, SelectAt(selector, 0, 14.0f));
+
+  // Moving out and back in only switches at the far and near ends of the band.
+  uint32 lod = 0;
+  for (float distance = 6.0f; distance <= 16.0f; distance += 0.5f) {
+    lod = selector.Select(MakeArg(lod), {0.0f, 0.0f, distance}, 0.0f, 1.0f);
+    CHECK_EQ(distance > 13.4f ? 1 : 0, lod);
+  }
+  for (float distance = 16.0f; distance >= 6.0f; distance -= 0.5f) {
+    lod = selector.Select(MakeArg(lod), {0.0f, 0.0f, distance}, 0.0f, 1.0f);
+    CHECK_EQ(distance < 7.9f ? 0 : 1, lod);
+  }
+}
+
+TEST(LodSelectorSkipsLevels)
+{
+  LodSelector selector(1.0f, 0.25f);
+  selector.SetView(MakeCamera());
+
+  // LOD 2 projects to under 0.75 pixels beyond 133, LOD 1 to over 1.25 pixels closer than 8.
+  CHECK_EQ(2, SelectAt(selector, 0, 200.0f));
+  CHECK_EQ(0, SelectAt(selector, 2, 5.0f));
+
+  // The radius brings the surface closer, the scale makes the errors larger.
+  CHECK_EQ(0, selector.Select(MakeArg(1), {0.0f, 0.0f, 10.0f}, 3.0f, 1.0f));
+  CHECK_EQ(0, selector.Select(MakeArg(1), {0.0f, 0.0f, 10.0f}, 0.0f, 2.0f));
+
+  // A draw without LODs always stays at LOD 0.
+  DrawArg single  = MakeArg(0);
+  single.LodCount = 1;
+  CHECK_EQ(0, selector.Select(single, {0.0f, 0.0f, 1000.0f}, 0.0f, 1.0f));
+}
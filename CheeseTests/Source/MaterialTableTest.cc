@@ -0,0 +1,130 @@
+// MaterialTable dedup, reference counts and row reuse, checked against a map of the rows in use.
+#include <algorithm>
+#include <map>
+#include <random>
+#include "Graphics/MaterialTable.h"
+#include "Test.h"
+
+namespace {
+const uint32 TEXTURE_COUNT = 3;
+
+struct Row {
+  uint32 Textures[TEXTURE_COUNT];
+};
+
+bool RowIs(const MaterialTable& table, uint32 materialId, const Row& row)
+{
+  for (uint32 i = 0; i < TEXTURE_COUNT; ++i) {
+    if (table.GetTextures(materialId)[i] != row.Textures[i]) return false;
+  }
+  return true;
+}
+}  // namespace
+
+TEST(MaterialTableSharesEqualRows)
+{
+  MaterialTable table(TEXTURE_COUNT);
+  const Row brick = {{4, 5, 6}};
+  const Row stone = {{4, 5, 7}};
+
+  const uint32 first  = table.Acquire(brick.Textures);
+  const uint32 second = table.Acquire(stone.Textures);
+  const uint32 third  = table.Acquire(brick.Textures);
+  CHECK_EQ(0, first);
+  CHECK_EQ(1, second);
+  CHECK_EQ(first, third);
+  CHECK_EQ(2, table.GetReferenceCount(first));
+  CHECK_EQ(1, table.GetReferenceCount(second));
+  CHECK_EQ(2, table.GetMaterialCount());
+
+  // The data is the rows back to back, the layout of gMaterialTextures.
+  CHECK_EQ(2 * TEXTURE_COUNT, table.GetData().size());
+  CHECK_EQ(7, table.GetData()[TEXTURE_COUNT + 2]);
+  CHECK(RowIs(table, first, brick));
+  CHECK(RowIs(table, second, stone));
+}
+
+TEST(MaterialTableReusesReleasedRows)
+{
+  MaterialTable table(TEXTURE_COUNT);
+  const Row a = {{1, 2, 3}};
+  const Row b = {{10, 20, 30}};
+  const Row c = {{100, 200, 300}};
+
+  const uint32 idA = table.Acquire(a.Textures);
+  const uint32 idB = table.Acquire(b.Textures);
+  table.Acquire(a.Textures);
+
+  // One reference left, the row stays.
+  table.Release(idA);
+  CHECK_EQ(1, table.GetReferenceCount(idA));
+  CHECK_EQ(2, table.GetMaterialCount());
+
+  // Released rows keep their indices for draws still in flight, and a new row takes the released id.
+  table.Release(idA);
+  CHECK_EQ(0, table.GetReferenceCount(idA));
+  CHECK_EQ(1, table.GetMaterialCount());
+  CHECK(RowIs(table, idA, a));
+
+  const uint32 idC = table.Acquire(c.Textures);
+  CHECK_EQ(idA, idC);
+  CHECK_EQ(2, table.GetRowCount());
+  CHECK(RowIs(table, idC, c));
+  CHECK(RowIs(table, idB, b));
+
+  // The released row is no longer found, acquiring it again makes a new row.
+  const uint32 idA2 = table.Acquire(a.Textures);
+  CHECK(idA2 != idC);
+  CHECK_EQ(3, table.GetRowCount());
+
+  // Releasing a free or unknown id changes nothing.
+  table.Release(idA2);
+  table.Release(idA2);
+  table.Release(99);
+  CHECK_EQ(2, table.GetMaterialCount());
+  CHECK_EQ(1, table.GetReferenceCount(idC));
+}
+
+TEST(MaterialTableRandomChurn)
+{
+  MaterialTable table(TEXTURE_COUNT);
+  // Acquired ids, once per reference, and the row of each id in use.
+  std::vector<uint32> references;
+  std::map<uint32, Row> rows;
+
+  std::mt19937 random(7);
+  std::uniform_int_distribution<uint32> texture(0, 3);
+  for (uint32 step = 0; step < 50000; ++step) {
+    if (references.empty() || random() % 100 < 55) {
+      // Few distinct rows, so most acquires hit a row in use.
+      const Row row           = {{texture(random), texture(random), texture(random)}};
+      const uint32 materialId = table.Acquire(row.Textures);
+      // An id in use always holds the same row.
+      auto iter = rows.find(materialId);
+      if (iter != rows.end()) CHECK(RowIs(table, materialId, iter->second));
+      CHECK(RowIs(table, materialId, row));
+      rows[materialId] = row;
+      references.push_back(materialId);
+    } else {
+      const uint32 index      = random() % references.size();
+      const uint32 materialId = references[index];
+      references[index]       = references.back();
+      references.pop_back();
+      table.Release(materialId);
+      if (table.GetReferenceCount(materialId) == 0) rows.erase(materialId);
+    }
+
+    if (step % 256 == 0) {
+      CHECK_EQ(rows.size(), table.GetMaterialCount());
+      for (const auto& pair : rows) {
+        CHECK(RowIs(table, pair.first, pair.second));
+        CHECK_EQ(std::count(references.begin(), references.end(), pair.first), table.GetReferenceCount(pair.first));
+      }
+    }
+  }
+
+  // Never more rows than distinct texture sets.
+  CHECK(table.GetRowCount() <= 4 * 4 * 4);
+  for (uint32 materialId : references) table.Release(materialId);
+  CHECK_EQ(0, table.GetMaterialCount());
+}
@@ -0,0 +1,119 @@
+// MeshOptimizer passes on a grid whose triangles come in random order, measured with AnalyzeVertexCache.
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "Model/MeshOptimizer.h"
+#include "Test.h"
+
+namespace {
+// size x size quads in the z = 0 plane, two triangles each, in a shuffled but fixed order.
+void BuildShuffledGrid(uint32 size, std::vector<Float3>& positions, std::vector<uint32>& indices)
+{
+  positions.clear();
+  for (uint32 y = 0; y <= size; y++) {
+    for (uint32 x = 0; x <= size; x++) positions.push_back({static_cast<float>(x), static_cast<float>(y), 0.0f});
+  }
+
+  std::vector<uint32> triangles;
+  for (uint32 y = 0; y < size; y++) {
+    for (uint32 x = 0; x < size; x++) {
+      const uint32 a = y * (size + 1) + x;
+      const uint32 c = a + size + 1;
+      triangles.insert(triangles.end(), {a, a + 1, c, a + 1, c + 1, c});
+    }
+  }
+
+  std::vector<uint32> order(triangles.size() / 3);
+  for (uint32 t = 0; t < order.size(); t++) order[t] = t;
+  std::shuffle(order.begin(), order.end(), std::mt19937(size));
+
+  indices.clear();
+  for (uint32 t : order) indices.insert(indices.end(), {triangles[t * 3], triangles[t * 3 + 1], triangles[t * 3 + 2]});
+}
+
+PositionStream GetPositions(const std::vector<Float3>& positions)
+{
+  PositionStream stream;
+  stream.Data   = reinterpret_cast<const Byte*>(positions.data());
+  stream.Stride = sizeof(Float3);
+  stream.Count  = static_cast<uint32>(positions.size());
+  return stream;
+}
+
+// Triangles as sorted corner triples, with the winding rotated to start at the smallest corner.
+std::vector<std::vector<uint32>> GetTriangleSet(const std::vector<uint32>& indices)
+{
+  std::vector<std::vector<uint32>> triangles;
+  for (uint32 t = 0; t < indices.size() / 3; t++) {
+    std::vector<uint32> corners(indices.begin() + t * 3, indices.begin() + t * 3 + 3);
+    std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+    triangles.push_back(corners);
+  }
+  std::sort(triangles.begin(), triangles.end());
+  return triangles;
+}
+}  // namespace
+
+TEST(MeshOptimizerAnalyzesVertexCache)
+{
+  // Every corner of a lone triangle misses once.
+  const VertexCacheStats single = MeshOptimizer::AnalyzeVertexCache({0, 1, 2}, 3);
+  CHECK_EQ(1, single.TriangleCount);
+  CHECK_EQ(3, single.VertexCount);
+  CHECK_EQ(3, single.Misses);
+  CHECK(single.GetAcmr() == 3.0f);
+  CHECK(single.GetAtvr() == 1.0f);
+
+  // The second triangle of a quad only misses its new corner.
+  const VertexCacheStats quad = MeshOptimizer::AnalyzeVertexCache({0, 1, 2, 1, 3, 2}, 4);
+  CHECK_EQ(4, quad.Misses);
+  CHECK(quad.GetAtvr() == 1.0f);
+}
+
+TEST(MeshOptimizerImprovesVertexCache)
+{
+  std::vector<Float3> positions;
+  std::vector<uint32> indices;
+  BuildShuffledGrid(64, positions, indices);
+  const uint32 vertexCount = static_cast<uint32>(positions.size());
+  const auto triangles     = GetTriangleSet(indices);
+
+  // Shuffled, almost every corner misses: about 3.0 ACMR and 5.8 ATVR. Optimized it measures 0.68 and 1.31.
+  const VertexCacheStats before = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount);
+  CHECK(before.GetAcmr() > 2.5f);
+  CHECK(before.GetAtvr() > 4.0f);
+
+  MeshOptimizer::OptimizeVertexCache(indices, vertexCount);
+  const VertexCacheStats after = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount);
+  CHECK(after.GetAcmr() < 0.75f);
+  CHECK(after.GetAtvr() < 1.4f);
+  CHECK(GetTriangleSet(indices) == triangles);
+
+  // Overdraw order may give back a little of the cache efficiency, within its threshold.
+  MeshOptimizer::OptimizeOverdraw(indices, GetPositions(positions));
+  const VertexCacheStats overdraw = MeshOptimizer::AnalyzeVertexCache(indices, vertexCount);
+  CHECK(overdraw.GetAcmr() <= after.GetAcmr() * 1.05f + 1e-4f);
+  CHECK(GetTriangleSet(indices) == triangles);
+}
+
+TEST(MeshOptimizerRejectsOutOfRangeIndices)
+{
+  std::vector<uint32> indices = {0, 1, 2, 2, 1, 3};
+  CHECK(MeshOptimizer::ValidateIndices(indices, 4));
+  CHECK(!MeshOptimizer::ValidateIndices(indices, 3));
+
+  // The pass would index past its per vertex arrays, it leaves the indices as they are.
+  const std::vector<uint32> original = indices;
+  MeshOptimizer::OptimizeVertexCache(indices, 3);
+  CHECK(indices == original);
+}
+
+TEST(MeshOptimizerRemapsVerticesByFirstUse)
+{
+  // Vertices 0 and 5 are unused, the others come back in the order the triangles use them.
+  std::vector<uint32> indices = {4, 2, 3, 3, 2, 1};
+  std::vector<uint32> remap;
+  CHECK_EQ(4, MeshOptimizer::OptimizeVertexFetch(indices, 6, remap));
+  CHECK(indices == std::vector<uint32>({0, 1, 2, 2, 1, 3}));
+  CHECK(remap == std::vector<uint32>({MeshOptimizer::UNUSED_VERTEX, 3, 1, 2, 0, MeshOptimizer::UNUSED_VERTEX}));
+}
@@ -0,0 +1,123 @@
+// MeshSimplifier on flat grids: the interior collapses for free, borders and attribute seams stay where they are.
+#include <algorithm>
+#include <cmath>
+#include <vector>
+#include "Model/MeshSimplifier.h"
+#include "Test.h"
+
+namespace {
+// size x size quads of unit size in the z = 0 plane, facing +z. With seamColumn < size, the quads right of that
+// column use copies of its vertices with other texture coordinates, like a UV seam running along y.
+void BuildGrid(uint32 size, uint32 seamColumn, std::vector<Vertex>& vertices, std::vector<uint32>& indices)
+{
+  vertices.clear();
+  indices.clear();
+  auto addVertex = [&](uint32 x, uint32 y, float u) {
+    Vertex vertex   = {};
+    vertex.Position = {static_cast<float>(x), static_cast<float>(y), 0.0f};
+    vertex.Normal   = {0.0f, 0.0f, 1.0f};
+    vertex.TexCoord = {u, static_cast<float>(y)};
+    vertices.push_back(vertex);
+    return static_cast<uint32>(vertices.size() - 1);
+  };
+
+  // Vertices of the quads left and right of the seam, the same away from it.
+  std::vector<uint32> left((size + 1) * (size + 1));
+  std::vector<uint32> right((size + 1) * (size + 1));
+  for (uint32 y = 0; y <= size; y++) {
+    for (uint32 x = 0; x <= size; x++) {
+      const uint32 v = y * (size + 1) + x;
+      left[v] = right[v] = addVertex(x, y, static_cast<float>(x));
+      if (x == seamColumn) right[v] = addVertex(x, y, static_cast<float>(x) + 100.0f);
+    }
+  }
+  for (uint32 y = 0; y < size; y++) {
+    for (uint32 x = 0; x < size; x++) {
+      const std::vector<uint32>& corner = x < seamColumn ? left : right;
+      const uint32 a                    = y * (size + 1) + x;
+      const uint32 c                    = a + size + 1;
+      indices.insert(indices.end(), {corner[a], corner[a + 1], corner[c], corner[a + 1], corner[c + 1], corner[c]});
+    }
+  }
+}
+
+// Summed signed area of the triangles seen from +z. Equal to the grid area as long as nothing folds over.
+float GetFacingArea(const std::vector<Vertex>& vertices, const std::vector<uint32>& indices)
+{
+  float area = 0.0f;
+  for (size_t i = 0; i < indices.size(); i += 3) {
+    const DirectX::XMFLOAT3& p0 = vertices[indices[i]].Position;
+    const DirectX::XMFLOAT3& p1 = vertices[indices[i + 1]].Position;
+    const DirectX::XMFLOAT3& p2 = vertices[indices[i + 2]].Position;
+    area += 0.5f * ((p1.x - p0.x) * (p2.y - p0.y) - (p1.y - p0.y) * (p2.x - p0.x));
+  }
+  return area;
+}
+
+bool IsReferenced(const std::vector<uint32>& indices, uint32 vertex)
+{
+  return std::find(indices.begin(), indices.end(), vertex) != indices.end();
+}
+}  // namespace
+
+TEST(MeshSimplifierCollapsesFlatGrid)
+{
+  std::vector<Vertex> vertices;
+  std::vector<uint32> indices;
+  BuildGrid(16, ~0u, vertices, indices);
+
+  // Every interior vertex lies in the plane of all its triangles, removing it costs nothing.
+  std::vector<uint32> result;
+  const float error = MeshSimplifier::Simplify(vertices, indices, 0, 1e-3f, result);
+  CHECK(error < 1e-5f);
+  CHECK(result.size() % 3 == 0);
+  CHECK(result.size() < indices.size() / 4);
+  CHECK(fabsf(GetFacingArea(vertices, result) - 256.0f) < 1e-2f);
+
+  // A target above the index count keeps the mesh as it is.
+  CHECK_EQ(0, MeshSimplifier::Simplify(vertices, indices, static_cast<uint32>(indices.size()), 1e-3f, result));
+  CHECK(result == indices);
+}
+
+TEST(MeshSimplifierKeepsBorderVertices)
+{
+  std::vector<Vertex> vertices;
+  std::vector<uint32> indices;
+  BuildGrid(16, ~0u, vertices, indices);
+  std::vector<uint32> result;
+  MeshSimplifier::Simplify(vertices, indices, 0, 1e-3f, result);
+
+  for (uint32 v = 0; v < vertices.size(); v++) {
+    const DirectX::XMFLOAT3& p = vertices[v].Position;
+    const bool isBorder        = p.x == 0.0f || p.y == 0.0f || p.x == 16.0f || p.y == 16.0f;
+    if (isBorder) CHECK(IsReferenced(result, v));
+  }
+}
+
+TEST(MeshSimplifierKeepsSeamVertices)
+{
+  std::vector<Vertex> vertices;
+  std::vector<uint32> indices;
+  BuildGrid(16, 8, vertices, indices);
+  std::vector<uint32> result;
+  const float error = MeshSimplifier::Simplify(vertices, indices, 0, 1e-3f, result);
+  CHECK(error < 1e-5f);
+  CHECK(result.size() < indices.size() / 2);
+  CHECK(fabsf(GetFacingArea(vertices, result) - 256.0f) < 1e-2f);
+
+  // Both copies of every seam position stay, so the two UV islands still meet along the whole seam.
+  uint32 seamVertexCount = 0;
+  for (uint32 v = 0; v < vertices.size(); v++) {
+    if (vertices[v].Position.x != 8.0f) continue;
+    CHECK(IsReferenced(result, v));
+    seamVertexCount++;
+  }
+  CHECK_EQ(2 * 17, seamVertexCount);
+
+  // No triangle spans the seam: each uses texture coordinates of one side only.
+  for (size_t i = 0; i < result.size(); i += 3) {
+    const bool isRight0 = vertices[result[i]].TexCoord.x > 8.0f;
+    CHECK_EQ(isRight0, vertices[result[i + 1]].TexCoord.x > 8.0f);
+    CHECK_EQ(isRight0, vertices[result[i + 2]].TexCoord.x > 8.0f);
+  }
+}
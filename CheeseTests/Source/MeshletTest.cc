@@ -0,0 +1,187 @@
+// MeshletBuilder on a grid in the z = 0 plane facing +z, and ClusterCuller on the meshlets it builds.
+#include <algorithm>
+#include <vector>
+#include "Model/Mesh.h"
+#include "Model/Meshlet.h"
+#include "Test.h"
+
+namespace {
+// size x size quads of unit size, two triangles each, wound so the normals point to +z.
+void BuildGrid(uint32 size, std::vector<Vertex>& vertices, std::vector<uint32>& indices)
+{
+  vertices.clear();
+  indices.clear();
+  for (uint32 y = 0; y <= size; y++) {
+    for (uint32 x = 0; x <= size; x++) {
+      Vertex vertex   = {};
+      vertex.Position = {static_cast<float>(x), static_cast<float>(y), 0.0f};
+      vertices.push_back(vertex);
+    }
+  }
+  for (uint32 y = 0; y < size; y++) {
+    for (uint32 x = 0; x < size; x++) {
+      const uint32 a = y * (size + 1) + x;
+      const uint32 c = a + size + 1;
+      indices.insert(indices.end(), {a, a + 1, c, a + 1, c + 1, c});
+    }
+  }
+}
+
+// Every plane passes everything.
+ClusterCullView MakeOpenView(float cameraZ)
+{
+  ClusterCullView view;
+  for (DirectX::XMFLOAT4& plane : view.Planes) plane = {0.0f, 0.0f, 0.0f, 1.0f};
+  view.CameraPosition = {16.0f, 16.0f, cameraZ};
+  return view;
+}
+
+// Meshlets stay within both limits, cover the triangles in order, and their local triangles name the source corners.
+bool FollowsLimits(const std::vector<uint32>& indices, const MeshletData& meshlets, uint32 maxVertices, uint32 maxTriangles)
+{
+  if (meshlets.Meshlets.size() != meshlets.Bounds.size() || meshlets.Triangles.size() != indices.size()) return false;
+
+  uint32 nextTriangle = 0;
+  for (const Meshlet& meshlet : meshlets.Meshlets) {
+    if (meshlet.VertexCount > maxVertices || meshlet.TriangleCount == 0 || meshlet.TriangleCount > maxTriangles) return false;
+    if (meshlet.TriangleOffset != nextTriangle) return false;
+    nextTriangle += meshlet.TriangleCount;
+
+    for (uint32 i = 0; i < meshlet.TriangleCount * 3; i++) {
+      const uint8 local = meshlets.Triangles[meshlet.TriangleOffset * 3 + i];
+      if (local >= meshlet.VertexCount || meshlets.Vertices[meshlet.VertexOffset + local] != indices[meshlet.TriangleOffset * 3 + i]) return false;
+    }
+  }
+  return nextTriangle == indices.size() / 3;
+}
+}  // namespace
+
+TEST(MeshletBuilderRespectsLimits)
+{
+  std::vector<Vertex> vertices;
+  std::vector<uint32> indices;
+  BuildGrid(32, vertices, indices);
+
+  MeshletData meshlets;
+  MeshletBuilder::Build(vertices, indices, meshlets);
+  CHECK(FollowsLimits(indices, meshlets, MeshletBuilder::DEFAULT_MAX_VERTICES, MeshletBuilder::DEFAULT_MAX_TRIANGLES));
+  // 2048 triangles at no more than 124 each.
+  CHECK(meshlets.GetMeshletCount() >= 17);
+
+  // The vertex limit closes meshlets long before the triangle limit here.
+  MeshletBuilder::Build(vertices, indices, meshlets, 10, 100);
+  CHECK(FollowsLimits(indices, meshlets, 10, 100));
+  MeshletBuilder::Build(vertices, indices, meshlets, 200, 7);
+  CHECK(FollowsLimits(indices, meshlets, 200, 7));
+
+  // Limits are clamped: at least one triangle, local indices in 8 bits.
+  MeshletBuilder::Build(vertices, indices, meshlets, 0, 0);
+  CHECK(FollowsLimits(indices, meshlets, 3, 1));
+  CHECK_EQ(indices.size() / 3, meshlets.GetMeshletCount());
+  MeshletBuilder::Build(vertices, indices, meshlets, 100000, 100000);
+  CHECK(FollowsLimits(indices, meshlets, MeshletBuilder::MAX_VERTICES_LIMIT, MeshletBuilder::MAX_TRIANGLES_LIMIT));
+}
+
+TEST(MeshletBoundsContainTheirTriangles)
+{
+  std::vector<Vertex> vertices;
+  std::vector<uint32> indices;
+  BuildGrid(32, vertices, indices);
+  MeshletData meshlets;
+  MeshletBuilder::Build(vertices, indices, meshlets);
+
+  const float epsilon = 1e-4f;
+  for (uint32 m = 0; m < meshlets.GetMeshletCount(); m++) {
+    const Meshlet& meshlet      = meshlets.Meshlets[m];
+    const MeshletBounds& bounds = meshlets.Bounds[m];
+    for (uint32 i = 0; i < meshlet.TriangleCount * 3; i++) {
+      const DirectX::XMFLOAT3& p = vertices[indices[meshlet.TriangleOffset * 3 + i]].Position;
+      CHECK(p.x >= bounds.AabbMin.x - epsilon && p.x <= bounds.AabbMax.x + epsilon);
+      CHECK(p.y >= bounds.AabbMin.y - epsilon && p.y <= bounds.AabbMax.y + epsilon);
+      CHECK(p.z >= bounds.AabbMin.z - epsilon && p.z <= bounds.AabbMax.z + epsilon);
+
+      const float dx = p.x - bounds.Center.x;
+      const float dy = p.y - bounds.Center.y;
+      const float dz = p.z - bounds.Center.z;
+      CHECK(dx * dx + dy * dy + dz * dz <= (bounds.Radius + epsilon) * (bounds.Radius + epsilon));
+    }
+
+    // A flat patch has a tight cone around its normal.
+    CHECK(bounds.ConeAxis.z > 0.999f);
+    CHECK(bounds.ConeCutoff < 0.01f);
+  }
+}
+
+TEST(ClusterCullerRejectsOutsideTheFrustum)
+{
+  std::vector<Vertex> vertices;
+  std::vector<uint32> indices;
+  BuildGrid(32, vertices, indices);
+  MeshletData meshlets;
+  MeshletBuilder::Build(vertices, indices, meshlets);
+
+  std::vector<ClusterDrawRange> ranges;
+  ClusterCullView view = MakeOpenView(10.0f);
+  ClusterCullStats stats;
+  CHECK_EQ(meshlets.GetMeshletCount(), ClusterCuller::Cull(meshlets, view, ranges, &stats));
+  // Neighbouring meshlets merge into one range.
+  CHECK_EQ(1, ranges.size());
+  CHECK_EQ(0, ranges[0].StartIndex);
+  CHECK_EQ(indices.size(), ranges[0].IndexCount);
+  CHECK_EQ(0, stats.FrustumCulled + stats.BackfaceCulled);
+
+  // Keep y >= 20, meshlets are runs of rows. One survives only if its sphere reaches past the plane.
+  view.Planes[0] = {0.0f, 1.0f, 0.0f, -20.0f};
+  stats          = ClusterCullStats();
+
+  const uint32 visible = ClusterCuller::Cull(meshlets, view, ranges, &stats);
+  CHECK(visible > 0 && visible < meshlets.GetMeshletCount());
+  CHECK_EQ(meshlets.GetMeshletCount(), stats.Total);
+  CHECK_EQ(meshlets.GetMeshletCount() - visible, stats.FrustumCulled);
+  for (uint32 m = 0; m < meshlets.GetMeshletCount(); m++) {
+    const MeshletBounds& bounds = meshlets.Bounds[m];
+    CHECK_EQ(bounds.Center.y + bounds.Radius >= 20.0f, ClusterCuller::IsVisible(bounds, view));
+  }
+
+  uint32 rangeIndexCount = 0;
+  for (const ClusterDrawRange& range : ranges) rangeIndexCount += range.IndexCount;
+  uint32 visibleIndexCount = 0;
+  for (uint32 m = 0; m < meshlets.GetMeshletCount(); m++) {
+    if (ClusterCuller::IsVisible(meshlets.Bounds[m], view)) visibleIndexCount += meshlets.Meshlets[m].TriangleCount * 3;
+  }
+  CHECK_EQ(visibleIndexCount, rangeIndexCount);
+
+  // Keep z >= 100, further than any bounding sphere reaches from the grid.
+  view.Planes[1] = {0.0f, 0.0f, 1.0f, -100.0f};
+  CHECK_EQ(0, ClusterCuller::Cull(meshlets, view, ranges));
+  CHECK(ranges.empty());
+}
+
+TEST(ClusterCullerRejectsBackfaces)
+{
+  std::vector<Vertex> vertices;
+  std::vector<uint32> indices;
+  BuildGrid(32, vertices, indices);
+  MeshletData meshlets;
+  MeshletBuilder::Build(vertices, indices, meshlets);
+  std::vector<ClusterDrawRange> ranges;
+
+  // In front of the grid every meshlet faces the camera.
+  ClusterCullStats stats;
+  CHECK_EQ(meshlets.GetMeshletCount(), ClusterCuller::Cull(meshlets, MakeOpenView(100.0f), ranges, &stats));
+  CHECK_EQ(0, stats.BackfaceCulled);
+
+  // Behind it, far enough that every cone test clears the radius, only back faces are seen.
+  stats = ClusterCullStats();
+  CHECK_EQ(0, ClusterCuller::Cull(meshlets, MakeOpenView(-100.0f), ranges, &stats));
+  CHECK_EQ(meshlets.GetMeshletCount(), stats.BackfaceCulled);
+  CHECK_EQ(0, stats.FrustumCulled);
+
+  // Double sided geometry is never rejected for its facing.
+  ClusterCullView doubleSided = MakeOpenView(-100.0f);
+  doubleSided.CullBackfaces   = false;
+  CHECK_EQ(meshlets.GetMeshletCount(), ClusterCuller::Cull(meshlets, doubleSided, ranges));
+
+  // Just above the plane, the front faces of every meshlet are still in view.
+  CHECK_EQ(meshlets.GetMeshletCount(), ClusterCuller::Cull(meshlets, MakeOpenView(0.5f), ranges));
+}
@@ -0,0 +1,65 @@
+// ModelLoader::DecodeModel on a one triangle glTF whose accessors are made malformed one at a time.
+#include <cstdio>
+#include <fstream>
+#include <string>
+#include "Model/ModelLoader.h"
+#include "Test.h"
+
+namespace {
+const char* TRIANGLE_FILE = "LoaderTriangle.gltf";
+
+// Positions in view 0 (36 bytes), 16 bit indices in view 1 (6 bytes), the buffer has 2 bytes of padding after them.
+const char* TRIANGLE_HEAD = R"({
+  "asset": {"version": "2.0"},
+  "scenes": [{"nodes": [0]}],
+  "nodes": [{"mesh": 0}],
+  "meshes": [{"primitives": [{"attributes": {"POSITION": 0}, "indices": 1}]}],
+  "buffers": [{"byteLength": 44, "uri": "data:application/octet-stream;base64,AAAAAAAAAAAAAAAAAACAPwAAAAAAAAAAAAAAAAAAgD8AAAAAAAABAAIAAAA="}],
+  "bufferViews": [{"buffer": 0, "byteOffset": 0, "byteLength": 36}, {"buffer": 0, "byteOffset": 36, "byteLength": 6}],
+  "accessors": [
+)";
+
+const char* VALID_POSITIONS = R"({"bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3", "min": [0, 0, 0], "max": [1, 1, 0]})";
+const char* VALID_INDICES   = R"({"bufferView": 1, "componentType": 5123, "count": 3, "type": "SCALAR"})";
+
+// Meshes DecodeModel keeps from the triangle with the given accessors, none when tinygltf already refuses the file.
+int DecodeTriangle(const std::string& positions, const std::string& indices = VALID_INDICES)
+{
+  std::ofstream(TRIANGLE_FILE) << TRIANGLE_HEAD << "    " << positions << ",\n    " << indices << "\n  ]\n}\n";
+
+  DecodedModel decoded;
+  ModelLoader::DecodeModel(ConvertToCheString(TRIANGLE_FILE), decoded);
+  remove(TRIANGLE_FILE);
+  const int meshCount = static_cast<int>(decoded.Meshes.size());
+  for (IMesh* mesh : decoded.Meshes) delete mesh;
+  return meshCount;
+}
+}  // namespace
+
+TEST(ModelLoaderDecodesTriangle)
+{
+  CHECK_EQ(1, DecodeTriangle(VALID_POSITIONS));
+}
+
+TEST(ModelLoaderRejectsAccessorCountOverflow)
+{
+  // (count - 1) * 12 wraps to 0 in 64 bits, the end offset of the accessor would look like 12.
+  CHECK_EQ(0, DecodeTriangle(R"({"bufferView": 0, "componentType": 5126, "count": 4611686018427387905, "type": "VEC3"})"));
+  CHECK_EQ(0, DecodeTriangle(VALID_POSITIONS, R"({"bufferView": 1, "componentType": 5123, "count": 9223372036854775809, "type": "SCALAR"})"));
+}
+
+TEST(ModelLoaderRejectsAccessorPastItsView)
+{
+  // A fourth position would still be inside the buffer, but past the 36 bytes of its view.
+  CHECK_EQ(0, DecodeTriangle(R"({"bufferView": 0, "componentType": 5126, "count": 4, "type": "VEC3"})"));
+  CHECK_EQ(0, DecodeTriangle(R"({"bufferView": 0, "byteOffset": 4, "componentType": 5126, "count": 3, "type": "VEC3"})"));
+  CHECK_EQ(0, DecodeTriangle(VALID_POSITIONS, R"({"bufferView": 1, "byteOffset": 2, "componentType": 5123, "count": 3, "type": "SCALAR"})"));
+}
+
+TEST(ModelLoaderRejectsAccessorOfAnotherType)
+{
+  // The positions are read as float3, 16 bit or two component positions would be misread.
+  CHECK_EQ(0, DecodeTriangle(R"({"bufferView": 0, "componentType": 5123, "count": 3, "type": "VEC3"})"));
+  CHECK_EQ(0, DecodeTriangle(R"({"bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC2"})"));
+  CHECK_EQ(0, DecodeTriangle(VALID_POSITIONS, R"({"bufferView": 1, "componentType": 5123, "count": 1, "type": "VEC3"})"));
+}
@@ -0,0 +1,126 @@
+// ModelStreamer driven headless through NullUploadSink, the fence only completes when the test says so.
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <thread>
+#include "Graphics/ModelStreamer.h"
+#include "Test.h"
+
+namespace {
+const char* TRIANGLE_FILE = "StreamerTriangle.gltf";
+
+// One triangle, positions then 16 bit indices in an embedded buffer.
+const char* TRIANGLE_GLTF = R"({
+  "asset": {"version": "2.0"},
+  "scenes": [{"nodes": [0]}],
+  "nodes": [{"mesh": 0}],
+  "meshes": [{"primitives": [{"attributes": {"POSITION": 0}, "indices": 1}]}],
+  "buffers": [{"byteLength": 44, "uri": "data:application/octet-stream;base64,AAAAAAAAAAAAAAAAAACAPwAAAAAAAAAAAAAAAAAAgD8AAAAAAAABAAIAAAA="}],
+  "bufferViews": [{"buffer": 0, "byteOffset": 0, "byteLength": 36}, {"buffer": 0, "byteOffset": 36, "byteLength": 6}],
+  "accessors": [
+    {"bufferView": 0, "componentType": 5126, "count": 3, "type": "VEC3", "min": [0, 0, 0], "max": [1, 1, 0]},
+    {"bufferView": 1, "componentType": 5123, "count": 3, "type": "SCALAR"}
+  ]
+})";
+
+// Updates until the load leaves DECODING, the decode runs on the thread pool.
+StreamState WaitDecoded(ModelStreamer& streamer, StreamHandle handle)
+{
+  const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+  while (streamer.GetState(handle) == StreamState::DECODING && std::chrono::steady_clock::now() < deadline) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    streamer.Update();
+  }
+  return streamer.GetState(handle);
+}
+}  // namespace
+
+TEST(ModelStreamerUploadsWithinBudget)
+{
+  std::ofstream(TRIANGLE_FILE) << TRIANGLE_GLTF;
+
+  NullUploadSink sink(false);
+  // A few bytes per frame, so the triangle takes several frames.
+  const uint64 frameBudget = 16;
+  ModelStreamer streamer(&sink, frameBudget);
+  const StreamHandle handle = streamer.LoadAsync(ConvertToCheString(TRIANGLE_FILE));
+  CHECK(handle != INVALID_STREAM_HANDLE);
+
+  const StreamState decodedState = WaitDecoded(streamer, handle);
+  remove(TRIANGLE_FILE);
+  CHECK(decodedState == StreamState::UPLOADING || decodedState == StreamState::WAITING_GPU);
+
+  uint32 frames = 0;
+  while (streamer.GetState(handle) == StreamState::UPLOADING) {
+    streamer.Update();
+    ++frames;
+    CHECK(frames < 1000);
+    CHECK(streamer.GetFrameBytes() <= frameBudget);
+  }
+  CHECK(frames > 1);
+  CHECK(streamer.GetPeakFrameBytes() <= frameBudget);
+
+  // Everything is written, but the GPU has not caught up.
+  CHECK(streamer.GetState(handle) == StreamState::WAITING_GPU);
+  CHECK(streamer.GetModel(handle) == nullptr);
+  streamer.Update();
+  CHECK(streamer.GetState(handle) == StreamState::WAITING_GPU);
+
+  sink.Complete(sink.GetSubmittedFence());
+  streamer.Update();
+  CHECK(streamer.GetState(handle) == StreamState::READY);
+
+  StreamedModel* model = streamer.GetModel(handle);
+  CHECK(model != nullptr);
+  CHECK_EQ(1, model->CpuModel.GetMeshes().size());
+  CHECK_EQ(3, model->CpuModel.GetMeshes()[0]->GetVertexCount());
+  CHECK(model->VertexBuffer != INVALID_UPLOAD_RESOURCE);
+  CHECK(model->IndexBuffer16 != INVALID_UPLOAD_RESOURCE);
+  CHECK(model->IndexBuffer32 == INVALID_UPLOAD_RESOURCE);
+  // CPU copies are dropped once the upload completed.
+  CHECK(model->Geometry.Vertices.empty());
+  CHECK(model->Geometry.Indices16.empty());
+
+  CHECK_EQ(sink.GetResourceCount(), sink.GetFinishedCount());
+  CHECK_EQ(sink.GetWrittenBytes(), streamer.GetTotalBytes());
+}
+
+TEST(ModelStreamerFailsMissingFile)
+{
+  NullUploadSink sink;
+  ModelStreamer streamer(&sink);
+  const StreamHandle handle = streamer.LoadAsync(CTEXT("DoesNotExist.gltf"));
+
+  CHECK(WaitDecoded(streamer, handle) == StreamState::FAILED);
+  CHECK(streamer.GetModel(handle) == nullptr);
+  CHECK_EQ(0, sink.GetResourceCount());
+
+  streamer.Release(handle);
+  CHECK(streamer.GetState(handle) == StreamState::FAILED);
+}
+
+TEST(ModelStreamerReleasesMidUpload)
+{
+  std::ofstream(TRIANGLE_FILE) << TRIANGLE_GLTF;
+
+  NullUploadSink sink(false);
+  ModelStreamer streamer(&sink, 16);
+  const StreamHandle handle = streamer.LoadAsync(ConvertToCheString(TRIANGLE_FILE));
+  const StreamState decodedState = WaitDecoded(streamer, handle);
+  remove(TRIANGLE_FILE);
+  CHECK(decodedState == StreamState::UPLOADING);
+  CHECK(sink.GetResourceCount() > 0);
+
+  // Part of the vertices went out with a submit the GPU has not finished.
+  streamer.Release(handle);
+  CHECK(streamer.GetState(handle) == StreamState::FAILED);
+  CHECK_EQ(sink.GetResourceCount(), sink.GetLiveResourceCount());
+
+  // Nothing more is written for the load.
+  const uint64 writtenBytes = sink.GetWrittenBytes();
+  streamer.Update();
+  CHECK_EQ(writtenBytes, sink.GetWrittenBytes());
+
+  sink.Complete(sink.GetSubmittedFence());
+  CHECK_EQ(0, sink.GetLiveResourceCount());
+}
@@ -0,0 +1,155 @@
+// OcclusionCuller against scenes with a known answer: box occluders in front of a camera at the origin looking down +z.
+#include <cmath>
+#include <vector>
+#include "Graphics/OcclusionCuller.h"
+#include "Test.h"
+
+namespace {
+const float NEAR_Z = 1.0f;
+const float FAR_Z  = 100.0f;
+
+// 90 degree square frustum, the view is the identity.
+Float4x4 ViewProj() { return PerspectiveFovLH(2.0f * atanf(1.0f), 1.0f, NEAR_Z, FAR_Z); }
+
+// A wall of 10 x 10 facing the camera, its front face at z = 10.
+uint32 AddWall(OcclusionCuller& culler) { return culler.AddBoxOccluder({-5.0f, -5.0f, 10.0f}, {5.0f, 5.0f, 11.0f}); }
+
+// Clip z / w of a point at view depth z.
+float DepthAt(float z) { return FAR_Z / (FAR_Z - NEAR_Z) * (1.0f - NEAR_Z / z); }
+
+std::vector<OcclusionCuller::Kernel> GetKernels()
+{
+  std::vector<OcclusionCuller::Kernel> kernels = {OcclusionCuller::Kernel::SCALAR, OcclusionCuller::Kernel::SSE};
+  if (IsAvx2Supported()) kernels.push_back(OcclusionCuller::Kernel::AVX2);
+  return kernels;
+}
+}  // namespace
+
+TEST(OcclusionCullerWallDepth)
+{
+  OcclusionCuller culler(64, 64);
+  AddWall(culler);
+  for (OcclusionCuller::Kernel kernel : GetKernels()) {
+    culler.SetKernel(kernel);
+    culler.Render(ViewProj());
+
+    // The wall covers the middle of the screen at the depth of its front face, the corners stay cleared.
+    const float* depth = culler.GetDepth();
+    CHECK(fabsf(depth[32 * 64 + 32] - DepthAt(10.0f)) < 1e-4f);
+    CHECK(fabsf(depth[20 * 64 + 40] - DepthAt(10.0f)) < 1e-4f);
+    CHECK_EQ(1, depth[0]);
+    CHECK_EQ(1, depth[63 * 64 + 63]);
+
+    // Every pyramid texel holds the farthest depth below it, the top one sees the cleared corners.
+    CHECK_EQ(7, culler.GetLevelCount());
+    CHECK_EQ(1, culler.GetWidth(6));
+    CHECK_EQ(1, *culler.GetDepth(6));
+    CHECK(fabsf(culler.GetDepth(3)[4 * 8 + 4] - DepthAt(10.0f)) < 1e-4f);
+  }
+}
+
+TEST(OcclusionCullerWallGolden)
+{
+  OcclusionCuller culler(64, 64);
+  AddWall(culler);
+
+  struct {
+    Float3 Center;
+    Float3 Extent;
+    bool Occluded;
+  } const golden[] = {
+      {{0.0f, 0.0f, 20.0f}, {1.0f, 1.0f, 1.0f}, true},       // 0: right behind the wall
+      {{2.0f, -3.0f, 50.0f}, {4.0f, 4.0f, 4.0f}, true},      // 1: far behind the wall, larger than a pyramid texel
+      {{0.0f, 0.0f, 5.0f}, {1.0f, 1.0f, 1.0f}, false},       // 2: in front of the wall
+      {{15.0f, 0.0f, 20.0f}, {1.0f, 1.0f, 1.0f}, false},     // 3: behind the wall plane, beside the wall
+      {{9.5f, 0.0f, 20.0f}, {1.0f, 1.0f, 1.0f}, false},      // 4: straddles the edge of the wall
+      {{0.0f, 0.0f, 10.5f}, {0.5f, 0.5f, 0.5f}, false},      // 5: inside the wall, its front face on the wall
+      {{0.0f, 0.0f, 0.0f}, {2.0f, 2.0f, 2.0f}, false},       // 6: around the camera
+      {{0.0f, 0.0f, -20.0f}, {1.0f, 1.0f, 1.0f}, false},     // 7: behind the camera
+      {{0.0f, 0.0f, 10.0f}, {100.0f, 100.0f, 1.0f}, false},  // 8: larger than the screen, crossing the wall
+      {{-3.0f, 3.0f, 30.0f}, {0.5f, 0.5f, 0.5f}, true},      // 9: behind the wall near its corner
+  };
+  CullBoxes boxes;
+  for (const auto& box : golden) boxes.Add(box.Center, box.Extent);
+
+  for (OcclusionCuller::Kernel kernel : GetKernels()) {
+    culler.SetKernel(kernel);
+    culler.Render(ViewProj());
+    for (const auto& box : golden) CHECK_EQ(box.Occluded, culler.IsOccluded(box.Center, box.Extent));
+
+    // Cull drops the occluded boxes and keeps the order of the others.
+    std::vector<uint32> visible = {9, 8, 6, 4, 3, 2, 1, 0};
+    CHECK_EQ(5, culler.Cull(boxes, visible));
+    const std::vector<uint32> expected = {8, 6, 4, 3, 2};
+    CHECK(expected == visible);
+  }
+}
+
+TEST(OcclusionCullerBackFacesDoNotOcclude)
+{
+  // A single quad at z = 10, once clockwise and once counter clockwise as seen from the camera.
+  const Float3 quad[4]         = {{-5.0f, -5.0f, 10.0f}, {-5.0f, 5.0f, 10.0f}, {5.0f, 5.0f, 10.0f}, {5.0f, -5.0f, 10.0f}};
+  const uint32 frontIndices[6] = {0, 1, 2, 0, 2, 3};
+  const uint32 backIndices[6]  = {0, 2, 1, 0, 3, 2};
+  const Float3 center = {0.0f, 0.0f, 20.0f};
+  const Float3 extent = {1.0f, 1.0f, 1.0f};
+
+  OcclusionCuller front(64, 64);
+  front.AddOccluder(quad, 4, frontIndices, 6);
+  front.Render(ViewProj());
+  CHECK(front.IsOccluded(center, extent));
+
+  OcclusionCuller back(64, 64);
+  back.AddOccluder(quad, 4, backIndices, 6);
+  back.Render(ViewProj());
+  CHECK(!back.IsOccluded(center, extent));
+  CHECK_EQ(1, back.GetDepth()[32 * 64 + 32]);
+}
+
+TEST(OcclusionCullerOccluderTransform)
+{
+  OcclusionCuller culler(64, 64);
+  const uint32 wall = AddWall(culler);
+  const Float3 center = {0.0f, 0.0f, 20.0f};
+  const Float3 extent = {1.0f, 1.0f, 1.0f};
+
+  culler.Render(ViewProj());
+  CHECK(culler.IsOccluded(center, extent));
+
+  // Moved aside, the wall no longer covers the box.
+  culler.SetOccluderTransform(wall, Translation(30.0f, 0.0f, 0.0f));
+  culler.Render(ViewProj());
+  CHECK(!culler.IsOccluded(center, extent));
+
+  // Moved behind the box, the box is in front of it.
+  culler.SetOccluderTransform(wall, Translation(0.0f, 0.0f, 20.0f));
+  culler.Render(ViewProj());
+  CHECK(!culler.IsOccluded(center, extent));
+  CHECK(culler.IsOccluded({0.0f, 0.0f, 40.0f}, extent));
+}
+
+TEST(OcclusionCullerKernelsMatchScalar)
+{
+  // Many small boxes at odd positions and depths, so spans start and end off the 4 and 8 pixel steps.
+  OcclusionCuller culler(100, 60);
+  for (uint32 i = 0; i < 40; ++i) {
+    const float x = -12.0f + 0.61f * i;
+    const float y = -6.0f + 0.37f * static_cast<float>((i * 7) % 40);
+    const float z = 8.0f + 0.53f * static_cast<float>((i * 13) % 40);
+    culler.AddBoxOccluder({x, y, z}, {x + 1.3f, y + 0.9f, z + 0.7f});
+  }
+
+  culler.SetKernel(OcclusionCuller::Kernel::SCALAR);
+  culler.Render(ViewProj());
+  const std::vector<float> expected(culler.GetDepth(), culler.GetDepth() + culler.GetWidth() * culler.GetHeight());
+
+  for (OcclusionCuller::Kernel kernel : GetKernels()) {
+    culler.SetKernel(kernel);
+    culler.Render(ViewProj());
+    uint32 mismatches = 0;
+    for (uint32 i = 0; i < expected.size(); ++i) {
+      if (fabsf(expected[i] - culler.GetDepth()[i]) > 1e-6f) mismatches++;
+    }
+    CHECK_EQ(0, mismatches);
+  }
+}
@@ -0,0 +1,41 @@
+// Minimal unit test registry for CheeseTests. A failed CHECK reports and ends its test, the runner carries on with the next one.
+#ifndef CHEESE_TESTS_TEST_H
+#define CHEESE_TESTS_TEST_H
+#include <cstdio>
+#include <vector>
+
+struct TestCase {
+  const char* Name;
+  void (*Run)(bool& failed);
+};
+
+std::vector<TestCase>& GetTests();
+
+struct TestRegistrar {
+  TestRegistrar(const char* name, void (*run)(bool&)) { GetTests().push_back({name, run}); }
+};
+
+#define TEST(name)                                                 \
+  static void Test_##name(bool& testFailed);                       \
+  static TestRegistrar sTestRegistrar_##name(#name, &Test_##name); \
+  static void Test_##name(bool& testFailed)
+
+#define CHECK(condition)                                                      \
+  do {                                                                        \
+    if (!(condition)) {                                                       \
+      printf("  %s(%d): CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+      testFailed = true;                                                      \
+      return;                                                                 \
+    }                                                                         \
+  } while (0)
+
+#define CHECK_EQ(expected, actual)                                                                        \
+  do {                                                                                                    \
+    if (!((expected) == (actual))) {                                                                      \
+      printf("  %s(%d): CHECK_EQ(%s, %s) failed: %lld != %lld\n", __FILE__, __LINE__, #expected, #actual, \
+             static_cast<long long>(expected), static_cast<long long>(actual));                           \
+      testFailed = true;                                                                                  \
+      return;                                                                                             \
+    }                                                                                                     \
+  } while (0)
+#endif  // CHEESE_TESTS_TEST_H
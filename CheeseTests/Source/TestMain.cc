@@ -0,0 +1,35 @@
+// Unit tests for the engine code that runs without a device.
+// Usage: CheeseTests [name filter]. Returns non-zero if any test failed.
+#include <cstdio>
+#include <cstring>
+#include "Test.h"
+#include "Utils/Log/ConsoleLogDevice.h"
+#include "Utils/Log/Logger.h"
+
+std::vector<TestCase>& GetTests()
+{
+  static std::vector<TestCase> tests;
+  return tests;
+}
+
+int main(int argc, char** argv)
+{
+  logger.SetLogDevice(new ConsoleLogDevice());
+
+  const char* filter = argc > 1 ? argv[1] : nullptr;
+
+  int runCount    = 0;
+  int failedCount = 0;
+  for (const TestCase& test : GetTests()) {
+    if (filter != nullptr && strstr(test.Name, filter) == nullptr) continue;
+
+    bool failed = false;
+    test.Run(failed);
+    printf("[%s] %s\n", failed ? "FAILED" : "    OK", test.Name);
+    ++runCount;
+    failedCount += failed ? 1 : 0;
+  }
+
+  printf("%d tests, %d failed\n", runCount, failedCount);
+  return failedCount == 0 ? 0 : 1;
+}
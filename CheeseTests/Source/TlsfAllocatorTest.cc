@@ -0,0 +1,188 @@
+// TlsfAllocator against a plain list of the live ranges with the bookkeeping checked after every step, and as the descriptor slot allocator.
+#include <algorithm>
+#include <random>
+#include "Test.h"
+#include "Utils/TlsfAllocator.h"
+
+namespace {
+struct LiveRange {
+  TlsfAllocation Allocation;
+  uint32 Size;
+};
+
+// Live ranges must not overlap and the free space between them is merged, so the largest gap is the largest free block.
+bool MatchesLiveRanges(const TlsfAllocator& allocator, std::vector<LiveRange> live)
+{
+  std::sort(live.begin(), live.end(), [](const LiveRange& a, const LiveRange& b) { return a.Allocation.Offset < b.Allocation.Offset; });
+
+  uint32 end        = 0;
+  uint32 usedSize   = 0;
+  uint32 largestGap = 0;
+  for (const LiveRange& range : live) {
+    if (range.Allocation.Offset < end || allocator.GetAllocationSize(range.Allocation) != range.Size) return false;
+    largestGap = std::max<uint32>(largestGap, range.Allocation.Offset - end);
+    end        = range.Allocation.Offset + range.Size;
+    usedSize += range.Size;
+  }
+  if (end > allocator.GetSize()) return false;
+  largestGap = std::max<uint32>(largestGap, allocator.GetSize() - end);
+
+  return allocator.GetFreeSize() == allocator.GetSize() - usedSize && allocator.GetAllocationCount() == live.size() &&
+         allocator.GetLargestFreeBlock() == largestGap;
+}
+}  // namespace
+
+TEST(TlsfAllocatorAllocatesWholeRange)
+{
+  TlsfAllocator allocator(1000);
+  CHECK(allocator.CheckConsistency());
+  CHECK_EQ(1000, allocator.GetLargestFreeBlock());
+
+  const TlsfAllocation all = allocator.Allocate(1000);
+  CHECK(all.IsValid());
+  CHECK_EQ(0, all.Offset);
+  CHECK_EQ(0, allocator.GetFreeSize());
+  CHECK_EQ(0, allocator.GetLargestFreeBlock());
+  CHECK(!allocator.Allocate(1).IsValid());
+  CHECK(allocator.CheckConsistency());
+
+  allocator.Free(all);
+  CHECK_EQ(1000, allocator.GetFreeSize());
+  CHECK(allocator.CheckConsistency());
+
+  CHECK(!allocator.Allocate(0).IsValid());
+  CHECK(!allocator.Allocate(1001).IsValid());
+  CHECK(allocator.CheckConsistency());
+}
+
+TEST(TlsfAllocatorCoalescesNeighbours)
+{
+  TlsfAllocator allocator(300);
+  const TlsfAllocation a = allocator.Allocate(100);
+  const TlsfAllocation b = allocator.Allocate(100);
+  const TlsfAllocation c = allocator.Allocate(100);
+  CHECK(a.IsValid() && b.IsValid() && c.IsValid());
+
+  // Freed ranges with a used one between them stay apart.
+  allocator.Free(a);
+  allocator.Free(c);
+  CHECK(allocator.CheckConsistency());
+  CHECK_EQ(200, allocator.GetFreeSize());
+  CHECK_EQ(100, allocator.GetLargestFreeBlock());
+  CHECK(!allocator.Allocate(150).IsValid());
+
+  // Freeing the middle merges all three.
+  allocator.Free(b);
+  CHECK(allocator.CheckConsistency());
+  CHECK_EQ(300, allocator.GetLargestFreeBlock());
+  const TlsfAllocation all = allocator.Allocate(300);
+  CHECK(all.IsValid());
+  CHECK_EQ(0, all.Offset);
+}
+
+TEST(TlsfAllocatorAlignsOffsets)
+{
+  TlsfAllocator allocator(1024);
+  const TlsfAllocation odd = allocator.Allocate(3);
+  CHECK(odd.IsValid());
+
+  for (uint32 alignment : {2u, 16u, 256u}) {
+    const TlsfAllocation aligned = allocator.Allocate(10, alignment);
+    CHECK(aligned.IsValid());
+    CHECK_EQ(0, aligned.Offset % alignment);
+    CHECK_EQ(10, allocator.GetAllocationSize(aligned));
+    CHECK(allocator.CheckConsistency());
+  }
+
+  // The padding went back to the free lists, Reset then leaves a single block.
+  allocator.Reset();
+  CHECK(allocator.CheckConsistency());
+  CHECK_EQ(1024, allocator.GetLargestFreeBlock());
+  CHECK_EQ(0, allocator.GetAllocationCount());
+}
+
+TEST(TlsfAllocatorRandomChurn)
+{
+  const uint32 size = 1 << 20;
+  TlsfAllocator allocator(size);
+  std::vector<LiveRange> live;
+
+  std::mt19937 random(42);
+  std::uniform_int_distribution<uint32> smallSize(1, 64);
+  std::uniform_int_distribution<uint32> largeSize(1, 16384);
+  std::uniform_int_distribution<uint32> alignmentLog2(0, 6);
+
+  for (uint32 step = 0; step < 20000; ++step) {
+    // Grow for the first half, then shrink, so the allocator sees both a filling and an emptying heap.
+    const uint32 allocatePercent = step < 10000 ? 60 : 40;
+    if (live.empty() || random() % 100 < allocatePercent) {
+      const uint32 allocationSize     = random() % 4 == 0 ? largeSize(random) : smallSize(random);
+      const uint32 alignment          = 1u << alignmentLog2(random);
+      const TlsfAllocation allocation = allocator.Allocate(allocationSize, alignment);
+      if (!allocation.IsValid()) {
+        // Only a heap without any block that fits the request with worst case padding may refuse it.
+        CHECK(allocator.GetLargestFreeBlock() < allocationSize + alignment - 1);
+        continue;
+      }
+      CHECK_EQ(0, allocation.Offset % alignment);
+      live.push_back({allocation, allocationSize});
+    } else {
+      const uint32 index = random() % live.size();
+      allocator.Free(live[index].Allocation);
+      live[index] = live.back();
+      live.pop_back();
+    }
+
+    if (step % 64 == 0) {
+      CHECK(allocator.CheckConsistency());
+      CHECK(MatchesLiveRanges(allocator, live));
+    }
+  }
+  CHECK(allocator.CheckConsistency());
+  CHECK(MatchesLiveRanges(allocator, live));
+
+  // Everything merges back into one block.
+  for (const LiveRange& range : live) allocator.Free(range.Allocation);
+  CHECK(allocator.CheckConsistency());
+  CHECK_EQ(0, allocator.GetAllocationCount());
+  CHECK_EQ(size, allocator.GetFreeSize());
+  CHECK_EQ(size, allocator.GetLargestFreeBlock());
+}
+
+TEST(TlsfAllocatorDescriptorSlots)
+{
+  // The way RenderData takes slots of a DescriptorHeap: two reserved slots per RenderData, then a range per geometry.
+  TlsfAllocator slots(1 << 16);
+  const TlsfAllocation reserved = slots.Allocate(2);
+  CHECK_EQ(0, reserved.Offset);
+
+  std::vector<TlsfAllocation> geometries;
+  for (uint32 i = 0; i < 100; ++i) geometries.push_back(slots.Allocate(1 + i % 5));
+
+  // Removing geometries leaves the slots of the others where they are, bindless indices stay valid.
+  std::vector<uint32> offsets;
+  for (const TlsfAllocation& allocation : geometries) offsets.push_back(allocation.Offset);
+  for (uint32 i = 0; i < 100; i += 2) {
+    slots.Free(geometries[i]);
+    geometries[i] = TlsfAllocation();
+  }
+  for (uint32 i = 1; i < 100; i += 2) {
+    CHECK_EQ(offsets[i], geometries[i].Offset);
+    CHECK_EQ(1 + i % 5, slots.GetAllocationSize(geometries[i]));
+  }
+
+  // Freeing an empty slot range, e.g. of a geometry without textures, is a no-op.
+  slots.Free(geometries[0]);
+  CHECK(slots.CheckConsistency());
+
+  // A full heap refuses the range instead of handing out slots in use.
+  const TlsfAllocation rest = slots.Allocate(slots.GetLargestFreeBlock());
+  CHECK(rest.IsValid());
+  while (slots.GetLargestFreeBlock() != 0) slots.Allocate(slots.GetLargestFreeBlock());
+  CHECK(!slots.Allocate(1).IsValid());
+  CHECK_EQ(0, slots.GetFreeSize());
+
+  slots.Free(reserved);
+  CHECK_EQ(2, slots.GetLargestFreeBlock());
+  CHECK(slots.CheckConsistency());
+}
@@ -0,0 +1,221 @@
+// UploadRingAllocator driven by a simulated queue whose fences complete some frames after they were signaled.
+#include <algorithm>
+#include <random>
+#include "Graphics/UploadRing.h"
+#include "Test.h"
+
+namespace {
+// Fence values as a D3D12 queue signals them: one per frame, completed in order, behind the CPU by the frames in flight.
+class SimulatedQueue
+{
+ public:
+  inline uint64 Signal() { return ++mSignaled; }
+  // The GPU finishes every frame up to fence.
+  inline void Complete(uint64 fence) { mCompleted = std::max<uint64>(mCompleted, std::min<uint64>(fence, mSignaled)); }
+  inline uint64 GetCompleted() const { return mCompleted; }
+  inline uint64 GetSignaled() const { return mSignaled; }
+
+ private:
+  uint64 mSignaled  = 0;
+  uint64 mCompleted = 0;
+};
+
+struct LiveAllocation {
+  uint64 Offset;
+  uint64 Size;
+  // The frame reading it, 0 while the frame is still being recorded.
+  uint64 Fence;
+};
+
+// Allocations the GPU may still read must never share a byte.
+bool NoOverlap(std::vector<LiveAllocation> live)
+{
+  std::sort(live.begin(), live.end(), [](const LiveAllocation& a, const LiveAllocation& b) { return a.Offset < b.Offset; });
+  for (size_t i = 1; i < live.size(); ++i) {
+    if (live[i - 1].Offset + live[i - 1].Size > live[i].Offset) return false;
+  }
+  return true;
+}
+}  // namespace
+
+TEST(UploadRingAllocatorAligns)
+{
+  UploadRingAllocator ring(1024);
+  CHECK_EQ(0, ring.Allocate(3, 1));
+  CHECK_EQ(16, ring.Allocate(10, 16));
+  CHECK_EQ(256, ring.Allocate(1, 256));
+  CHECK_EQ(257, ring.Allocate(7, 1));
+  // The padding before an aligned allocation is used until its frame retires.
+  CHECK_EQ(264, ring.GetUsedSize());
+
+  CHECK_EQ(UploadRingAllocator::INVALID_OFFSET, ring.Allocate(0, 1));
+  CHECK_EQ(UploadRingAllocator::INVALID_OFFSET, ring.Allocate(1025, 1));
+  CHECK_EQ(264, ring.GetUsedSize());
+}
+
+TEST(UploadRingAllocatorRetiresOnlyCompletedFrames)
+{
+  SimulatedQueue queue;
+  UploadRingAllocator ring(1000);
+
+  CHECK_EQ(0, ring.Allocate(600, 1));
+  ring.EndFrame(queue.Signal());
+  CHECK_EQ(600, ring.Allocate(400, 1));
+  ring.EndFrame(queue.Signal());
+  CHECK_EQ(2, ring.GetFramesInFlight());
+  CHECK_EQ(UploadRingAllocator::INVALID_OFFSET, ring.Allocate(1, 1));
+
+  // Nothing completed, nothing comes back.
+  ring.Reclaim(queue.GetCompleted());
+  CHECK_EQ(1000, ring.GetUsedSize());
+  CHECK_EQ(UploadRingAllocator::INVALID_OFFSET, ring.Allocate(1, 1));
+
+  // Frame 1 completes, only its 600 bytes come back.
+  queue.Complete(1);
+  ring.Reclaim(queue.GetCompleted());
+  CHECK_EQ(1, ring.GetFramesInFlight());
+  CHECK_EQ(400, ring.GetUsedSize());
+  CHECK_EQ(UploadRingAllocator::INVALID_OFFSET, ring.Allocate(601, 1));
+  CHECK_EQ(0, ring.Allocate(600, 1));
+
+  // A frame without allocations adds no mark, the open allocation stays with the next frame that ends.
+  ring.EndFrame(queue.Signal());
+  ring.EndFrame(queue.Signal());
+  CHECK_EQ(2, ring.GetFramesInFlight());
+
+  queue.Complete(queue.GetSignaled());
+  ring.Reclaim(queue.GetCompleted());
+  CHECK_EQ(0, ring.GetFramesInFlight());
+  CHECK_EQ(0, ring.GetUsedSize());
+}
+
+TEST(UploadRingAllocatorSkipsTheEndInsteadOfStraddling)
+{
+  SimulatedQueue queue;
+  UploadRingAllocator ring(1000);
+
+  CHECK_EQ(0, ring.Allocate(300, 1));
+  ring.EndFrame(queue.Signal());
+  CHECK_EQ(300, ring.Allocate(500, 1));
+  ring.EndFrame(queue.Signal());
+
+  queue.Complete(1);
+  ring.Reclaim(queue.GetCompleted());
+
+  // 200 bytes are left before the end and 300 at the start. 250 bytes do not fit before the end, they go to offset 0.
+  CHECK_EQ(0, ring.Allocate(250, 1));
+  // The skipped end counts as used until the frame that skipped it retires.
+  CHECK_EQ(950, ring.GetUsedSize());
+  CHECK_EQ(250, ring.Allocate(50, 1));
+  CHECK_EQ(UploadRingAllocator::INVALID_OFFSET, ring.Allocate(1, 1));
+  ring.EndFrame(queue.Signal());
+
+  // An aligned start past the end wraps as well, offset 0 satisfies any alignment.
+  queue.Complete(2);
+  ring.Reclaim(queue.GetCompleted());
+  CHECK_EQ(300, ring.Allocate(500, 1));
+  CHECK_EQ(UploadRingAllocator::INVALID_OFFSET, ring.Allocate(200, 256));
+  ring.EndFrame(queue.Signal());
+  queue.Complete(queue.GetSignaled());
+  ring.Reclaim(queue.GetCompleted());
+  CHECK_EQ(0, ring.Allocate(200, 256));
+}
+
+TEST(UploadRingAllocatorFramesInFlight)
+{
+  // Three frames in flight: the CPU records frame n while the GPU works on n - 1 and n - 2.
+  const uint64 capacity       = 64 * 1024;
+  const uint32 framesInFlight = 3;
+  SimulatedQueue queue;
+  UploadRingAllocator ring(capacity);
+  std::vector<LiveAllocation> live;
+
+  std::mt19937 random(22);
+  std::uniform_int_distribution<uint32> allocationSize(1, 2048);
+  std::uniform_int_distribution<uint32> alignmentLog2(0, 8);
+  std::uniform_int_distribution<uint32> allocationCount(1, 12);
+
+  uint32 wraps      = 0;
+  uint64 lastOffset = 0;
+  for (uint32 frame = 0; frame < 2000; ++frame) {
+    // Wait for the frame that used this slot of the swap chain, as the renderer does before recording.
+    if (queue.GetSignaled() >= framesInFlight) queue.Complete(queue.GetSignaled() - framesInFlight + 1);
+    ring.Reclaim(queue.GetCompleted());
+    live.erase(std::remove_if(live.begin(), live.end(), [&](const LiveAllocation& a) { return a.Fence <= queue.GetCompleted(); }), live.end());
+
+    const uint32 count = allocationCount(random);
+    for (uint32 i = 0; i < count; ++i) {
+      const uint64 size      = allocationSize(random);
+      const uint64 alignment = 1ull << alignmentLog2(random);
+      const uint64 offset    = ring.Allocate(size, alignment);
+      // Twelve allocations of at most 2KB and their padding fit in a third of the ring.
+      CHECK(offset != UploadRingAllocator::INVALID_OFFSET);
+      if (offset == UploadRingAllocator::INVALID_OFFSET) continue;
+
+      CHECK_EQ(0, offset % alignment);
+      CHECK(offset + size <= capacity);
+      if (offset < lastOffset) wraps++;
+      lastOffset = offset;
+      live.push_back({offset, size, 0});
+    }
+
+    const uint64 fence = queue.Signal();
+    for (LiveAllocation& allocation : live) {
+      if (allocation.Fence == 0) allocation.Fence = fence;
+    }
+    ring.EndFrame(fence);
+
+    CHECK(ring.GetFramesInFlight() <= framesInFlight);
+    CHECK(ring.GetUsedSize() <= capacity);
+    CHECK(NoOverlap(live));
+  }
+  // About 13KB a frame over 2000 frames goes around the ring hundreds of times.
+  CHECK(wraps > 100);
+
+  queue.Complete(queue.GetSignaled());
+  ring.Reclaim(queue.GetCompleted());
+  CHECK_EQ(0, ring.GetUsedSize());
+  CHECK_EQ(0, ring.GetFramesInFlight());
+}
+
+TEST(UploadRingAllocatorFullRingWaitsForTheGpu)
+{
+  // A slow GPU: the CPU allocates until the ring is full, then frames complete one at a time.
+  const uint64 capacity = 4096;
+  SimulatedQueue queue;
+  UploadRingAllocator ring(capacity);
+  std::vector<LiveAllocation> live;
+
+  std::mt19937 random(5);
+  std::uniform_int_distribution<uint32> allocationSize(1, 700);
+  uint32 refused = 0;
+  for (uint32 step = 0; step < 5000; ++step) {
+    const uint64 size   = allocationSize(random);
+    const uint64 offset = ring.Allocate(size, 16);
+    if (offset == UploadRingAllocator::INVALID_OFFSET) {
+      refused++;
+      // Only refused while frames hold the ring, retiring the oldest one frees room for the next try.
+      CHECK(ring.GetFramesInFlight() > 0 || ring.GetUsedSize() > 0);
+      const uint64 fence = queue.Signal();
+      for (LiveAllocation& allocation : live) {
+        if (allocation.Fence == 0) allocation.Fence = fence;
+      }
+      ring.EndFrame(fence);
+      queue.Complete(queue.GetCompleted() + 1);
+      ring.Reclaim(queue.GetCompleted());
+      live.erase(std::remove_if(live.begin(), live.end(), [&](const LiveAllocation& a) { return a.Fence <= queue.GetCompleted(); }), live.end());
+      continue;
+    }
+
+    live.push_back({offset, size, 0});
+    CHECK(NoOverlap(live));
+    if (step % 3 == 0) {
+      const uint64 fence = queue.Signal();
+      for (LiveAllocation& allocation : live) {
+        if (allocation.Fence == 0) allocation.Fence = fence;
+      }
+      ring.EndFrame(fence);
+    }
+  }
+  CHECK(refused > 0);
+}
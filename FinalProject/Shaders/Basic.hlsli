@@ -28,6 +28,14 @@ struct MaterialDesc {
   float Roughness;
 };
 
+// Matches InstanceData in ShaderResource.h.
+struct InstanceData {
+  float4x4 World;
+  float4x4 PrevWorld;
+  uint MaterialIndex;
+  uint3 Pad;
+};
+
 float3 NormalSampleToWorldSpace(float3 normal_map_sample, float3 unit_normalW, float3 tangentW)
 {
   float3 normalT = 2.0f * normal_map_sample - 1.0f;
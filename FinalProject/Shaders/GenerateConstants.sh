@@ -0,0 +1,28 @@
+#!/bin/sh
+# Regenerates the cbuffer structs in Source/Generated from the shaders, run it after changing a cbuffer.
+# Needs dxc on the path and a CBufferGen build, e.g. g++ -std=c++14 -O2 -o CBufferGen CBufferGen/Source/*.cc
+# Usage: GenerateConstants.sh [path to CBufferGen]
+set -e
+
+GENERATOR=$(command -v "${1:-CBufferGen}")
+cd "$(dirname "$0")"
+OUTPUT=../Source/Generated
+LISTINGS=$(mktemp -d)
+trap 'rm -rf "$LISTINGS"' EXIT
+
+# listing <shader> <name> <entry> <target>: DXC lays cbuffers out like the engine's vs_5_1 and ps_5_1 compiles.
+listing()
+{
+  dxc -T "$4" -E "$3" -Fc "$LISTINGS/$2.$3.lst" "$1" > /dev/null
+  echo "$LISTINGS/$2.$3.lst"
+}
+
+PBR="$(listing PBR/PBR.hlsl PBR VS vs_6_0) $(listing PBR/PBR.hlsl PBR VSCompact vs_6_0) $(listing PBR/PBR.hlsl PBR PS ps_6_0)"
+SKYBOX="$(listing Skybox/Skybox.hlsl Skybox VS vs_6_0) $(listing Skybox/Skybox.hlsl Skybox PS ps_6_0)"
+SHADOW="$(listing Shadow/Shadow.hlsl Shadow VS vs_6_0) $(listing Shadow/Shadow.hlsl Shadow VSCompact vs_6_0) $(listing Shadow/Shadow.hlsl Shadow PS ps_6_0)"
+
+# cbView of View.hlsli is shared, it gets a header of its own.
+"$GENERATOR" -t PointLight=PointLight -i Shader/ShaderResource.h -c cbView ViewConstants "$OUTPUT/ViewConstants.h" $PBR
+"$GENERATOR" -x cbView PBRConstants "$OUTPUT/PBRConstants.h" $PBR
+"$GENERATOR" -x cbView SkyboxConstants "$OUTPUT/SkyboxConstants.h" $SKYBOX
+"$GENERATOR" -x cbView ShadowConstants "$OUTPUT/ShadowConstants.h" $SHADOW
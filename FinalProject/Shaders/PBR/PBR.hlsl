@@ -1,38 +1,41 @@
 #include "PBR.hlsli"
+#include "../View.hlsli"
 
+// Transforms and materials are per instance, see gInstances.
 cbuffer cbPerObject : register(b0)
 {
-  matrix gWorld;
-  matrix PrevWorldTransform;
-  MaterialDesc gMatDesc;
+  // Dequantization of compact vertices, see RenderItem::GetVertexQuantization.
+  float4 gPositionOffset;
+  float4 gPositionScale;
 };
 
-cbuffer cbPass : register(b1)
+// Root constants of the draw, see IndirectDrawCommand. gObjectIndex is the first instance of the draw in gInstances.
+cbuffer cbDraw : register(b2)
 {
-  matrix gViewProj;
-  matrix PrevViewProjectionMatrix;
-  float2 PrevJitter;
-  float2 CurrJitter;
-  matrix gShadowTransform;
-  PointLight gLight;
-  float3 gEyePosW;
+  uint gObjectIndex;
+  uint gMaterialId;
 };
 
+// gTextures index of a texture of the draw material. It is the same for the whole draw, no NonUniformResourceIndex needed.
+uint MaterialTexture(uint texture) { return gMaterialTextures[gMaterialId * MATERIAL_TEXTURE_COUNT + texture]; }
+
 struct GBuffer {
   float4 colors : SV_Target0;
   float2 MotionVectors : SV_Target1;
 };
 
-VertexOut VS(VertexIn vin)
+VertexOut TransformVertex(VertexIn vin, uint instanceID)
 {
-  VertexOut vout = (VertexOut)0.0f;
+  VertexOut vout        = (VertexOut)0.0f;
+  InstanceData instance = gInstances[gObjectIndex + instanceID];
+  vout.MaterialIndex    = instance.MaterialIndex;
 
-  float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
+  float4 posW = mul(float4(vin.PosL, 1.0f), instance.World);
   vout.PosW   = posW.xyz;
 
   // transform normal and save tangent,texcoord data.
-  vout.NormalW  = mul(vin.NormalL, (float3x3)gWorld);
-  vout.TangentW = mul(vin.Tangent, (float3x3)gWorld);
+  vout.NormalW  = mul(vin.NormalL, (float3x3)instance.World);
+  vout.TangentW = mul(vin.Tangent, (float3x3)instance.World);
   vout.Texcoord = vin.Texcoord;
 
   // multiple view & proj.
@@ -40,37 +43,51 @@ VertexOut VS(VertexIn vin)
 
   // for motion vector
   vout.CurPosition = vout.PosH;
-  const float4 worldPrevPos = mul(float4(vin.PosL, 1.0f), PrevWorldTransform);
+  const float4 worldPrevPos = mul(float4(vin.PosL, 1.0f), instance.PrevWorld);
   vout.PrevPosition = mul(worldPrevPos, PrevViewProjectionMatrix);
 
   vout.ShadowPosH = mul(posW, gShadowTransform);
   return vout;
 }
 
+VertexOut VS(VertexIn vin, uint instanceID : SV_InstanceID) { return TransformVertex(vin, instanceID); }
+
+VertexOut VSCompact(VertexCompactIn vin, uint instanceID : SV_InstanceID)
+{
+  VertexIn decoded;
+  decoded.PosL     = DequantizePosition(vin.PosQ, gPositionOffset, gPositionScale);
+  decoded.NormalL  = OctDecode(vin.NormalOct);
+  decoded.Tangent  = OctDecode(vin.TangentOct);
+  decoded.Texcoord = vin.Texcoord;
+  return TransformVertex(decoded, instanceID);
+}
+
 GBuffer PS(VertexOut pin)
 {
   GBuffer output;
-  float3 gamma = 2.2f;
+  float3 gamma         = 2.2f;
+  MaterialDesc matDesc = gMaterials[pin.MaterialIndex];
 
   // normalize normal & tangent to calculate lighting.
   float3 normal  = normalize(pin.NormalW);
   float3 tangent = normalize(pin.TangentW);
 
-  float4 diffuseAlbedo = gAlbedoMap.Sample(gLinearWrap, pin.Texcoord);
+  float4 diffuseAlbedo = gTextures[MaterialTexture(ALBEDO_TEXTURE)].Sample(gLinearWrap, pin.Texcoord);
   float3 albedo        = pow(abs(diffuseAlbedo.rgb), gamma.x);
 
-  float3 normalSample = gNormalMap.Sample(gLinearWrap, pin.Texcoord).xyz;
+  float3 normalSample = gTextures[MaterialTexture(NORMAL_TEXTURE)].Sample(gLinearWrap, pin.Texcoord).xyz;
   float3 bumpedNormal = NormalSampleToWorldSpace(normalSample, normal, tangent);
 
   float3 orm = 0.0f;
 
+  const uint ormTexture = MaterialTexture(ORM_TEXTURE);
   uint texWidth = 0, texHeight = 0;
-  gORMMap.GetDimensions(texWidth, texHeight);
-  [flatten] if (texWidth != 4 && texHeight != 4) { orm = gORMMap.Sample(gLinearWrap, pin.Texcoord).rgb; }
+  gTextures[ormTexture].GetDimensions(texWidth, texHeight);
+  [flatten] if (texWidth != 4 && texHeight != 4) { orm = gTextures[ormTexture].Sample(gLinearWrap, pin.Texcoord).rgb; }
   else
   {
     orm.r = 0.3f;
-    orm.g = gMatDesc.Roughness;
+    orm.g = matDesc.Roughness;
     orm.b = 0.02f;
   }
 
@@ -79,7 +96,7 @@ GBuffer PS(VertexOut pin)
   float roughness = orm.g;
   float metallic  = orm.b;
 
-  float3 FresnelR0 = gMatDesc.FresnelR0;
+  float3 FresnelR0 = matDesc.FresnelR0;
   float3 F0        = lerp(FresnelR0, albedo, metallic);
 
   // calculate one dir light source.
@@ -1,10 +1,22 @@
 #include "../Basic.hlsli"
 #include "../LightHelper.hlsli"
-
-Texture2D gAlbedoMap : register(t0);
-Texture2D gNormalMap : register(t1);
-Texture2D gORMMap : register(t2);
-Texture2D gShadowMap : register(t3);
+#include "../VertexCompression.hlsli"
+
+Texture2D gShadowMap : register(t0);
+// Instances of all draws of the pass, a draw starts at gObjectIndex.
+StructuredBuffer<InstanceData> gInstances : register(t1);
+StructuredBuffer<MaterialDesc> gMaterials : register(t2);
+// MATERIAL_TEXTURE_COUNT gTextures indices per material, see MaterialTable.
+StructuredBuffer<uint> gMaterialTextures : register(t3);
+// The whole descriptor heap through an unbounded range, resource binding tier 2 and up. It takes every register after t4,
+// so it has to stay the last one.
+Texture2D gTextures[] : register(t4);
+
+// Columns of gMaterialTextures, see RenderData::MATERIAL_TEXTURE_NAMES.
+#define ALBEDO_TEXTURE 0
+#define NORMAL_TEXTURE 1
+#define ORM_TEXTURE 2
+#define MATERIAL_TEXTURE_COUNT 3
 
 struct VertexIn {
   float3 PosL : POSITION;
@@ -22,6 +34,7 @@ struct VertexOut {
   float3 NormalW : NORMAL;
   float3 TangentW : TANGENT;
   float2 Texcoord : TEXCOORD;
+  nointerpolation uint MaterialIndex : MATERIAL;
 };
 
 float CalcShadowFactor(float4 shadowPosH)
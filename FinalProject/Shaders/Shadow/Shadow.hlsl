@@ -1,3 +1,7 @@
+#include "../Basic.hlsli"
+#include "../VertexCompression.hlsli"
+#include "../View.hlsli"
+
 struct VertexIn {
   float3 PosL : POSITION;
 };
@@ -6,17 +10,35 @@ struct VertexOut {
   float4 PosH : SV_POSITION;
 };
 
-cbuffer cbPerObject : register(b0){ matrix gWorld; };
+cbuffer cbPerObject : register(b0)
+{
+  float4 gPositionOffset;
+  float4 gPositionScale;
+};
 
-cbuffer cbPass : register(b1){ matrix gViewProj; };
+// Root constants of the draw, see IndirectDrawCommand. gObjectIndex is the first instance of the draw in gInstances.
+cbuffer cbDraw : register(b2)
+{
+  uint gObjectIndex;
+  uint gMaterialId;
+};
 
-VertexOut VS(VertexIn vin)
+StructuredBuffer<InstanceData> gInstances : register(t0);
+
+VertexOut VS(VertexIn vin, uint instanceID : SV_InstanceID)
 {
   VertexOut vout = (VertexOut)0.0f;
-  float4 posW = mul(float4(vin.PosL, 1.0f), gWorld);
+  float4 posW = mul(float4(vin.PosL, 1.0f), gInstances[gObjectIndex + instanceID].World);
   vout.PosH   = mul(posW, gViewProj);
 
   return vout;
 }
 
+VertexOut VSCompact(VertexCompactIn vin, uint instanceID : SV_InstanceID)
+{
+  VertexIn decoded;
+  decoded.PosL = DequantizePosition(vin.PosQ, gPositionOffset, gPositionScale);
+  return VS(decoded, instanceID);
+}
+
 void PS(VertexOut pin) {}
\ No newline at end of file
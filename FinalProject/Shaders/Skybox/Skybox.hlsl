@@ -1,15 +1,10 @@
 #include "../Basic.hlsli"
+#include "../View.hlsli"
 
 TextureCube gCubeMap : register(t0);
 
 cbuffer cbPerObject : register(b0) { float4x4 gWorld; };
 
-cbuffer cbPass : register(b1)
-{
-  matrix gViewProj;
-  float3 gEyePosW;
-};
-
 struct VertexIn {
   float3 PosL : POSITION;
   float3 NormalL : NORMAL;
@@ -0,0 +1,18 @@
+// Input of CompactVertex, the input assembler already expands UNORM, SNORM and half floats.
+struct VertexCompactIn {
+  // xyz in the quantization box, w holds the tangent handedness as 0 or 1.
+  float4 PosQ : POSITION;
+  float2 NormalOct : NORMAL;
+  float2 TangentOct : TANGENT;
+  float2 Texcoord : TEXCOORD;
+};
+
+float3 OctDecode(float2 e)
+{
+  float3 n = float3(e.xy, 1.0f - abs(e.x) - abs(e.y));
+  float t  = saturate(-n.z);
+  n.xy += n.xy >= 0.0f ? -t : t;
+  return normalize(n);
+}
+
+float3 DequantizePosition(float4 posQ, float4 offset, float4 scale) { return offset.xyz + posQ.xyz * scale.xyz; }
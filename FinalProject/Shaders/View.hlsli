@@ -0,0 +1,12 @@
+// Constants of the view a pass renders, e.g. the camera or the shadow map light. Every shader including this binds the same copy,
+// written once per view and frame by ViewConstantBuffer. Needs PointLight from Basic.hlsli.
+cbuffer cbView : register(b1)
+{
+  matrix gViewProj;
+  matrix PrevViewProjectionMatrix;
+  float2 PrevJitter;
+  float2 CurrJitter;
+  matrix gShadowTransform;
+  PointLight gLight;
+  float3 gEyePosW;
+};
@@ -0,0 +1,55 @@
+// Generated by CBufferGen from Shadow.VS.lst Shadow.VSCompact.lst Shadow.PS.lst, do not edit.
+#ifndef GENERATED_SHADOW_CONSTANTS_H
+#define GENERATED_SHADOW_CONSTANTS_H
+#include <DirectXMath.h>
+
+#include <cstddef>
+
+#include "Shader/CBufferLayout.h"
+
+namespace ShadowConstants {
+
+struct cbDraw {
+  uint32 gObjectIndex;
+  uint32 gMaterialId;
+
+  static constexpr CBufferVarName Name() { return CBufferVarName(CTEXT("cbDraw")); }
+  static const CBufferLayout& Layout();
+};
+static_assert(offsetof(cbDraw, gObjectIndex) == 0, "cbDraw.gObjectIndex offset");
+static_assert(offsetof(cbDraw, gMaterialId) == 4, "cbDraw.gMaterialId offset");
+static_assert(sizeof(cbDraw) == 8, "cbDraw size");
+
+inline const CBufferLayout& cbDraw::Layout()
+{
+  static const CBufferFieldLayout FIELDS[] = {
+      {CTEXT("gObjectIndex"), 0, 4},
+      {CTEXT("gMaterialId"), 4, 4},
+  };
+  static const CBufferLayout LAYOUT = {CTEXT("cbDraw"), 8, FIELDS, 2};
+  return LAYOUT;
+}
+
+struct cbPerObject {
+  DirectX::XMFLOAT4 gPositionOffset;
+  DirectX::XMFLOAT4 gPositionScale;
+
+  static constexpr CBufferVarName Name() { return CBufferVarName(CTEXT("cbPerObject")); }
+  static const CBufferLayout& Layout();
+};
+static_assert(offsetof(cbPerObject, gPositionOffset) == 0, "cbPerObject.gPositionOffset offset");
+static_assert(offsetof(cbPerObject, gPositionScale) == 16, "cbPerObject.gPositionScale offset");
+static_assert(sizeof(cbPerObject) == 32, "cbPerObject size");
+
+inline const CBufferLayout& cbPerObject::Layout()
+{
+  static const CBufferFieldLayout FIELDS[] = {
+      {CTEXT("gPositionOffset"), 0, 16},
+      {CTEXT("gPositionScale"), 16, 16},
+  };
+  static const CBufferLayout LAYOUT = {CTEXT("cbPerObject"), 32, FIELDS, 2};
+  return LAYOUT;
+}
+
+}  // namespace ShadowConstants
+#endif  // GENERATED_SHADOW_CONSTANTS_H
@@ -0,0 +1,31 @@
+// Generated by CBufferGen from Skybox.VS.lst Skybox.PS.lst, do not edit.
+#ifndef GENERATED_SKYBOX_CONSTANTS_H
+#define GENERATED_SKYBOX_CONSTANTS_H
+#include <DirectXMath.h>
+
+#include <cstddef>
+
+#include "Shader/CBufferLayout.h"
+
+namespace SkyboxConstants {
+
+struct cbPerObject {
+  DirectX::XMFLOAT4X4 gWorld;  // column_major, store the transpose.
+
+  static constexpr CBufferVarName Name() { return CBufferVarName(CTEXT("cbPerObject")); }
+  static const CBufferLayout& Layout();
+};
+static_assert(offsetof(cbPerObject, gWorld) == 0, "cbPerObject.gWorld offset");
+static_assert(sizeof(cbPerObject) == 64, "cbPerObject size");
+
+inline const CBufferLayout& cbPerObject::Layout()
+{
+  static const CBufferFieldLayout FIELDS[] = {
+      {CTEXT("gWorld"), 0, 64},
+  };
+  static const CBufferLayout LAYOUT = {CTEXT("cbPerObject"), 64, FIELDS, 1};
+  return LAYOUT;
+}
+
+}  // namespace SkyboxConstants
+#endif  // GENERATED_SKYBOX_CONSTANTS_H
@@ -0,0 +1,52 @@
+// Generated by CBufferGen from PBR.VS.lst PBR.VSCompact.lst PBR.PS.lst, do not edit.
+#ifndef GENERATED_VIEW_CONSTANTS_H
+#define GENERATED_VIEW_CONSTANTS_H
+#include <DirectXMath.h>
+
+#include <cstddef>
+
+#include "Shader/CBufferLayout.h"
+#include "Shader/ShaderResource.h"
+
+namespace ViewConstants {
+
+static_assert(sizeof(PointLight) == 48, "PointLight does not match the HLSL PointLight");
+
+struct cbView {
+  DirectX::XMFLOAT4X4 gViewProj;                 // column_major, store the transpose.
+  DirectX::XMFLOAT4X4 PrevViewProjectionMatrix;  // column_major, store the transpose.
+  DirectX::XMFLOAT2 PrevJitter;
+  DirectX::XMFLOAT2 CurrJitter;
+  DirectX::XMFLOAT4X4 gShadowTransform;          // column_major, store the transpose.
+  PointLight gLight;
+  DirectX::XMFLOAT3 gEyePosW;
+
+  static constexpr CBufferVarName Name() { return CBufferVarName(CTEXT("cbView")); }
+  static const CBufferLayout& Layout();
+};
+static_assert(offsetof(cbView, gViewProj) == 0, "cbView.gViewProj offset");
+static_assert(offsetof(cbView, PrevViewProjectionMatrix) == 64, "cbView.PrevViewProjectionMatrix offset");
+static_assert(offsetof(cbView, PrevJitter) == 128, "cbView.PrevJitter offset");
+static_assert(offsetof(cbView, CurrJitter) == 136, "cbView.CurrJitter offset");
+static_assert(offsetof(cbView, gShadowTransform) == 144, "cbView.gShadowTransform offset");
+static_assert(offsetof(cbView, gLight) == 208, "cbView.gLight offset");
+static_assert(offsetof(cbView, gEyePosW) == 256, "cbView.gEyePosW offset");
+static_assert(sizeof(cbView) == 268, "cbView size");
+
+inline const CBufferLayout& cbView::Layout()
+{
+  static const CBufferFieldLayout FIELDS[] = {
+      {CTEXT("gViewProj"), 0, 64},
+      {CTEXT("PrevViewProjectionMatrix"), 64, 64},
+      {CTEXT("PrevJitter"), 128, 8},
+      {CTEXT("CurrJitter"), 136, 8},
+      {CTEXT("gShadowTransform"), 144, 64},
+      {CTEXT("gLight"), 208, 48},
+      {CTEXT("gEyePosW"), 256, 12},
+  };
+  static const CBufferLayout LAYOUT = {CTEXT("cbView"), 268, FIELDS, 7};
+  return LAYOUT;
+}
+
+}  // namespace ViewConstants
+#endif  // GENERATED_VIEW_CONSTANTS_H
@@ -9,33 +9,117 @@
 
 #include <Core/CheeseApp.h>
 #include <Core/Camera.h>
+#include <Utils/AllocationCounter.h>
 #include <Utils/GameTimer.h>
 #include <Utils/Log/Logger.h>
+#include <Utils/ThreadPool.h>
 #include <Input/InputConponent.h>
 #include <Graphics/IGraphics.h>
+#include <Graphics/D3D12CommandRecorder.h>
 #include <Graphics/D3DUtil.h>
+#include <Graphics/D3D12UploadSink.h>
+#include <Graphics/DrawSorter.h>
+#include <Graphics/FrustumCuller.h>
+#include <Graphics/IndirectDrawBuffer.h>
+#include <Graphics/InstanceBatcher.h>
 #include <Graphics/RenderData.h>
+#include <Graphics/LodSelector.h>
+#include <Graphics/ModelStreamer.h>
+#include <Graphics/XMOcclusionCuller.h>
 #include <Graphics/ShadowMap.h>
+#include <Graphics/ViewConstantBuffer.h>
 #include <Graphics/Fsr2RenderModule.h>
 #include <Shader/Shader.h>
 #include <Shader/ShaderResource.h>
 #include <Model/ModelLoader.h>
+#include <Model/CookedModel.h>
 #include <Model/Model.h>
 #include <Model/Geometry.h>
+#include <Model/MeshOptimizerAdapter.h>
+#include <Model/Meshlet.h>
 
 #include <FidelityFX/host/ffx_fsr2.h>
 
+#include "Generated/PBRConstants.h"
+#include "Generated/ShadowConstants.h"
+#include "Generated/SkyboxConstants.h"
+#include "Generated/ViewConstants.h"
+
 using namespace DirectX;
 using namespace std;
 
 const float Pi = 3.1415926f;
+// Passes with fewer batches per list stay on the frame list, a list of its own costs a submission and the pass setup.
+const uint32 MIN_BATCHES_PER_LIST = 128;
+
+// Occluder of a model item, a box in model space authored inside the mesh, so it never hides what the model would not.
+// The meshes themselves have tens of thousands of triangles, too many to rasterize on the CPU every frame.
+struct OccluderProxy {
+  const CheChar* ItemName;
+  XMFLOAT3 BoxMin;
+  XMFLOAT3 BoxMax;
+};
+const OccluderProxy OCCLUDER_PROXIES[] = {
+    // The body, 80% of the bounds, inside the rounded edges and the speaker grilles.
+    {CTEXT("BoomBox"), {-0.0079f, -0.0078f, -0.008f}, {0.0079f, 0.0078f, 0.008f}},
+    // The wooden base of the stand. The helmet above it is open and thin, it has no box inside it worth drawing.
+    {CTEXT("FlightHelmet"), {-0.15f, 0.0f, -0.16f}, {0.15f, 0.08f, 0.19f}},
+};
+
+// Shader and pipelines of one DrawRenderItem call, resolved in BuildPSO so drawing needs no name lookups.
+struct DrawPass {
+  // Top bits of the draw sort keys.
+  uint32 Id          = 0;
+  Shader* PassShader = nullptr;
+  // Indexed by VertexFormat.
+  ID3D12PipelineState* Pipelines[2] = {};
+  // Set for passes submitted with ExecuteIndirect, see IndirectDrawBuffer.
+  ComPtr<ID3D12CommandSignature> CommandSignature = nullptr;
+};
+
+// Viewport and targets of a pass. Lists recording a part of the pass start without state and bind them first.
+struct PassTargets {
+  D3D12_VIEWPORT Viewport                      = {};
+  D3D12_RECT ScissorRect                       = {};
+  uint32 RenderTargetCount                     = 0;
+  D3D12_CPU_DESCRIPTOR_HANDLE RenderTargets[2] = {};
+  D3D12_CPU_DESCRIPTOR_HANDLE DepthStencil     = {};
+
+  void Bind(ID3D12GraphicsCommandList* cmdList) const
+  {
+    cmdList->RSSetViewports(1, &Viewport);
+    cmdList->RSSetScissorRects(1, &ScissorRect);
+    cmdList->OMSetRenderTargets(RenderTargetCount, RenderTargets, false, &DepthStencil);
+  }
+};
+
+// Per thread state for recording batches into one command list.
+struct RecordContext {
+  CommandRecorder<ID3D12GraphicsCommandList> Recorder;
+  vector<ClusterDrawRange> ClusterRanges;
+};
+
+// What DrawRenderItem prepared for a pass, all lists recording its batches read it.
+struct PreparedPass {
+  RenderData* Data                          = nullptr;
+  const DrawPass* Pass                      = nullptr;
+  uint32 ShaderIndex                        = 0;
+  bool Instancing                           = false;
+  bool Indirect                             = false;
+  bool Bindless                             = false;
+  bool CullClusters                         = false;
+  D3D12_GPU_VIRTUAL_ADDRESS InstanceAddress = 0;
+  D3D12_GPU_VIRTUAL_ADDRESS ViewAddress     = 0;
+  // Command of the first batch in mIndirectDraws.
+  uint32 FirstCommand = 0;
+};
 
 class RenderExample : public CheeseApp
 {
   Fsr2RenderModule m_Fsr2RenderModule;
 
  public:
-  RenderExample() : mWindow(new CheeseWindow(1280, 720)), mGraphics(new Graphics()), mLight() {}
+  RenderExample() : mWindow(new CheeseWindow(1280, 720)), mGraphics(new Graphics()), mLight(), mViewConstants(sizeof(ViewConstants::cbView)) {}
 
   virtual ~RenderExample() {}
 
@@ -71,9 +155,32 @@ class RenderExample : public CheeseApp
   virtual void Run() override;
   virtual void Update(float dt) override;
   void Draw();
-  void DrawRenderItem(RenderData& renderData, Shader* shader, bool drawBlend = false);
+  // Draws are sorted by state, opaque ones front to back and blended ones back to front from cullCamera.
+  // Shaders reading cbView get the constants of view, an index into mViewConstants.
+  // Items with meshlets only submit the clusters cullCamera can see, nullptr draws everything in state order.
+  // visibleDraws holds the renderData draw indices that passed frustum culling, nullptr submits all draws.
+  // Draws of compact vertices switch to the COMPACT pipeline of the pass.
+  // When the pass shader reads gInstances, opaque draws of instances of the same geometry go out as one instanced draw.
+  // Passes with a command signature write their draws to mIndirectDraws and submit runs of equal state with ExecuteIndirect,
+  // their meshlets are not culled.
+  // Sorting and batching run on the calling thread. Passes of many batches are then recorded into pooled lists on the thread pool,
+  // which are submitted in batch order between the parts of the frame list. Every list starts by binding targets.
+  void DrawRenderItem(RenderData& renderData, const DrawPass& pass, const PassTargets& targets, uint32 view, bool drawBlend = false, const Camera* cullCamera = nullptr,
+                      const vector<uint32>* visibleDraws = nullptr);
+  // Records batches [begin, end) of mInstanceBatcher into the list of context, safe to run on several threads with their own contexts.
+  void RecordBatches(const PreparedPass& prepared, RecordContext& context, uint32 begin, uint32 end);
 
   void BuildPSO();
+  // Uses the psoName + "Compact" pipeline for compact vertices when there is one, psoName otherwise.
+  // indirect passes get a command signature when the shader of mRenderData has the per object CBV and the cbDraw root constants.
+  DrawPass MakeDrawPass(uint32 id, Shader* shader, const CheString& psoName, bool indirect = false);
+  // Sizes the per frame vectors for the loaded items, so drawing never grows them.
+  void ReserveFrameScratch();
+  // Cooked models are added at once, glTF models are streamed and show up in a later Update.
+  void AddModelItem(const CheString& name, const CheString& modelPath);
+  void AddStreamedItems();
+  void InitItemConstants(const CheString& itemName);
+  void PlaceModelItem(const CheString& itemName);
 
   inline CheeseWindow* GetWindow() const override { return mWindow; }
   inline CheString GetName() const override { return mProgramName; }
@@ -94,6 +201,10 @@ class RenderExample : public CheeseApp
   Shader* mShadowShader;
 
   unordered_map<CheString, ComPtr<ID3D12PipelineState>> mPSOs;
+  DrawPass mShadowPass;
+  DrawPass mOpaquePass;
+  DrawPass mSkyboxPass;
+  DrawPass mTransparentPass;
 
   BoundingSphere mSceneBounds;
 
@@ -105,11 +216,38 @@ class RenderExample : public CheeseApp
   XMMATRIX mPrevViewProjectionMatrix = Identity4Mat();
   XMFLOAT2 mPrevJitter;
 
+  // Shared by both render datas, a frame binds a single heap.
+  unique_ptr<DescriptorHeap> mDescriptorHeap;
   RenderData* mRenderData;
   RenderData* mSkyboxRenderData;
+  unique_ptr<D3D12UploadSink> mUploadSink;
+  unique_ptr<ModelStreamer> mStreamer;
+  // Item name and the load it waits for.
+  vector<pair<CheString, StreamHandle>> mPendingModels;
+  FrustumCuller mFrustumCuller;
+  XMOcclusionCuller mOcclusionCuller;
+  // Draws of mRenderData inside the camera and the shadow frustum, culled in Update. Camera draws hidden by the occluders are dropped too.
+  vector<uint32> mVisibleDraws;
+  vector<uint32> mShadowVisibleDraws;
+  // Reused by every DrawRenderItem call.
+  InstanceBatcher mInstanceBatcher;
+  IndirectDrawBuffer mIndirectDraws;
+  // [0] records the frame list, the others the pooled lists of split passes. The recorder counters cover the current frame.
+  vector<RecordContext> mRecordContexts;
+  // Pooled lists of the pass being split, in batch order.
+  vector<ID3D12GraphicsCommandList*> mPassLists;
+  vector<ClusterCullView> mCullViews;
+  LodSelector mLodSelector;
   PointLight mLight;
+  uint32 mModelMaterial = 0;
+  // cbView of the camera and the shadow light, written once per frame in Update and shared by every shader.
+  ViewConstantBuffer mViewConstants;
+  uint32 mCameraView = 0;
+  uint32 mShadowView = 0;
 
   bool mIsMovingMouse = false;
+  // Draw allocations are only reported once.
+  bool mDrawAllocationsReported = false;
 };
 
 bool RenderExample::Init()
@@ -143,8 +281,6 @@ void RenderExample::OnResize(uint32 width, uint32 height)
   m_Fsr2RenderModule.OnResize(m_Resolution);
   mCamera.SetFrustum(XM_PI / 3, mWindow->GetAspectRatio(), 0.5f, 1000.0f);
   mCamera.SetViewPort(0.0f, 0.0f, (float)m_Resolution.RenderWidth, (float)m_Resolution.RenderHeight);
-
-  mPBRShader->GetCBufferManager().SetValue(CTEXT("cbPass.gViewProj"), XMMatrixTranspose(mCamera.GetLocalToWorldMatrixXM()));
 }
 
 bool RenderExample::Load()
@@ -155,29 +291,54 @@ bool RenderExample::Load()
   mPBRShader = new Shader(CTEXT("PBRShader"));
   mPBRShader->AddShader(CTEXT("Shaders/PBR/PBR.hlsl"), ShaderType::VERTEX_SHADER);
   mPBRShader->AddShader(CTEXT("Shaders/PBR/PBR.hlsl"), ShaderType::PIXEL_SHADER);
+  mPBRShader->AddVSVariant(CTEXT("Shaders/PBR/PBR.hlsl"), CTEXT("VSCompact"));
   mPBRShader->CreateRootSignature(mGraphics->mD3dDevice.Get());
-  mPBRShader->BuildPassCBuffer(mGraphics->mD3dDevice.Get());
+  mPBRShader->BuildPassCBuffer();
 
   logger.Info(CTEXT("Build skybox shader..."));
   mSkyboxShader = new Shader(CTEXT("SkyboxShader"));
   mSkyboxShader->AddShader(CTEXT("Shaders/Skybox/Skybox.hlsl"), ShaderType::VERTEX_SHADER);
   mSkyboxShader->AddShader(CTEXT("Shaders/Skybox/Skybox.hlsl"), ShaderType::PIXEL_SHADER);
   mSkyboxShader->CreateRootSignature(mGraphics->mD3dDevice.Get());
-  mSkyboxShader->BuildPassCBuffer(mGraphics->mD3dDevice.Get());
+  mSkyboxShader->BuildPassCBuffer();
 
   logger.Info(CTEXT("Build shadow shader..."));
   mShadowShader = new Shader(CTEXT("ShadowShader"));
   mShadowShader->AddShader(CTEXT("Shaders/Shadow/Shadow.hlsl"), ShaderType::VERTEX_SHADER);
   mShadowShader->AddShader(CTEXT("Shaders/Shadow/Shadow.hlsl"), ShaderType::PIXEL_SHADER);
+  mShadowShader->AddVSVariant(CTEXT("Shaders/Shadow/Shadow.hlsl"), CTEXT("VSCompact"));
   mShadowShader->CreateRootSignature(mGraphics->mD3dDevice.Get());
-  mShadowShader->BuildPassCBuffer(mGraphics->mD3dDevice.Get());
-
-  mSkyboxRenderData = new RenderData(mGraphics->mD3dDevice, mGraphics->mCommandList);
-  mRenderData       = new RenderData(mGraphics->mD3dDevice, mGraphics->mCommandList);
+  mShadowShader->BuildPassCBuffer();
+
+  // Structs generated from older shaders would write the constants to the wrong offsets.
+  const pair<const Shader*, const CBufferLayout*> layouts[] = {
+      {mPBRShader, &PBRConstants::cbPerObject::Layout()},
+      {mPBRShader, &PBRConstants::cbDraw::Layout()},
+      {mPBRShader, &ViewConstants::cbView::Layout()},
+      {mSkyboxShader, &SkyboxConstants::cbPerObject::Layout()},
+      {mSkyboxShader, &ViewConstants::cbView::Layout()},
+      {mShadowShader, &ShadowConstants::cbPerObject::Layout()},
+      {mShadowShader, &ShadowConstants::cbDraw::Layout()},
+      {mShadowShader, &ViewConstants::cbView::Layout()},
+  };
+  bool layoutsValid = true;
+  for (const auto& layout : layouts) layoutsValid &= layout.first->ValidateCBufferLayout(*layout.second);
+  if (!layoutsValid) return false;
+  mCameraView = mViewConstants.AddView();
+  mShadowView = mViewConstants.AddView();
+
+  // The skybox is a single box, its geometry pages can be small.
+  mDescriptorHeap   = std::make_unique<DescriptorHeap>(mGraphics->mD3dDevice.Get());
+  mSkyboxRenderData = new RenderData(mGraphics->mD3dDevice, mGraphics->mCommandList, 64ull << 10, mDescriptorHeap.get());
+  mRenderData       = new RenderData(mGraphics->mD3dDevice, mGraphics->mCommandList, GeometryHeap::DEFAULT_PAGE_SIZE, mDescriptorHeap.get());
   mSkyboxRenderData->AddShader(mSkyboxShader);
   mRenderData->AddShader(mPBRShader);
   mRenderData->AddShader(mShadowShader);
 
+  // Copies go on the graphics queue ahead of the frame, at most 8MB of them per frame.
+  mUploadSink = std::make_unique<D3D12UploadSink>(mGraphics->mD3dDevice.Get(), mGraphics->mCommandQueue.Get());
+  mStreamer   = std::make_unique<ModelStreamer>(mUploadSink.get(), 8ull << 20);
+
   IMesh* skyboxMesh = Geometry::GenerateBox(1, 1, 1);
   Material skyboxMat;
   TIFF(D3DUtil::CreateTexture2DFromDDS(mGraphics->mD3dDevice.Get(), mGraphics->mCommandList.Get(), CTEXT("Resource/Texture/grasscube1024.dds"),
@@ -188,10 +349,12 @@ bool RenderExample::Load()
   mSkyboxRenderData->AddRenderItem(CTEXT("Skybox"), skybox);
   mSkyboxRenderData->BuildRenderData();
 
-  XMMATRIX world = XMLoadFloat4x4(&Identity4x4());
-  mSkyboxRenderData->GetItem(CTEXT("Skybox")).GetPerObjectCBuffer(mSkyboxShader->GetName()).SetValue(CTEXT("cbPerObject.gWorld"), XMMatrixTranspose(world));
+  SkyboxConstants::cbPerObject skyboxObject;
+  XMStoreFloat4x4(&skyboxObject.gWorld, XMMatrixTranspose(XMLoadFloat4x4(&Identity4x4())));
+  mSkyboxRenderData->GetItemPerObjectCB(CTEXT("Skybox"), mSkyboxShader).SetCBuffer(skyboxObject);
 
   IMesh* planeMesh = Geometry::GeneratePlane(5.0f, 5.0f);
+  MeshOptimizerAdapter::Optimize(planeMesh);
   Material planeMaterial;
   TIFF(
       D3DUtil::CreateTexture2DFromDDS(mGraphics->mD3dDevice.Get(), mGraphics->mCommandList.Get(), CTEXT("Resource/Texture/tile.dds"), planeMaterial.Textures[CTEXT("gAlbedoMap")]));
@@ -205,52 +368,42 @@ bool RenderExample::Load()
   plane->AddMesh(planeMesh);
   mRenderData->AddRenderItem(CTEXT("Plane"), plane);
 
-  Model* flightHelmet = new Model();
-  Model* boomBox      = new Model();
-  ModelLoader::LoadGLTF(mGraphics->mD3dDevice.Get(), mGraphics->mCommandList.Get(), CTEXT("Resource/Model/FlightHelmet/FlightHelmet.gltf"), *flightHelmet);
-  ModelLoader::LoadGLTF(mGraphics->mD3dDevice.Get(), mGraphics->mCommandList.Get(), CTEXT("Resource/Model/BoomBox/BoomBox.gltf"), *boomBox);
-
-  mRenderData->AddRenderItem(CTEXT("FlightHelmet"), flightHelmet);
-  mRenderData->AddRenderItem(CTEXT("BoomBox"), boomBox);
+  // The ground hides what lies below it, the models add their proxies in PlaceModelItem. The item keeps its identity world.
+  vector<Float3> occluderPositions;
+  for (const Vertex& vertex : planeMesh->GetVertices()) {
+    occluderPositions.push_back(ToFloat3(vertex.Position));
+  }
+  vector<uint32> occluderIndices;
+  planeMesh->GetIndices(occluderIndices);
+  mOcclusionCuller.AddOccluder(occluderPositions.data(), static_cast<uint32>(occluderPositions.size()), occluderIndices.data(),
+                               static_cast<uint32>(occluderIndices.size()));
+
+  MaterialDesc planeMatDesc;
+  planeMatDesc.DiffuseAlbedo = {1.0f, 1.0f, 1.0f, 1.0f};
+  planeMatDesc.FresnelR0     = {0.0f, 0.0f, 0.0f};
+  planeMatDesc.Roughness     = 0.3f;
+  mRenderData->SetMaterialIndex(mRenderData->FindItem(CTEXT("Plane")), mRenderData->AddMaterial(planeMatDesc));
+
+  MaterialDesc modelMatDesc;
+  modelMatDesc.DiffuseAlbedo = {1.0f, 1.0f, 1.0f, 1.0f};
+  modelMatDesc.FresnelR0     = {0.16f, 0.16f, 0.16f};
+  modelMatDesc.Roughness     = 0.3f;
+  mModelMaterial             = mRenderData->AddMaterial(modelMatDesc);
+
+  AddModelItem(CTEXT("FlightHelmet"), CTEXT("Resource/Model/FlightHelmet/FlightHelmet"));
+  AddModelItem(CTEXT("BoomBox"), CTEXT("Resource/Model/BoomBox/BoomBox"));
 
   mRenderData->BuildRenderData();
   mShadowMap->CreateShadowMapSrv(mRenderData->GetShadowMapHandleCPU());
 
-  for (auto pair : mRenderData->GetRenderItems()) {
-    auto itemName = pair.first;
-    auto& ri      = mRenderData->GetItem(itemName);
-    ri.GetPerObjectCBuffer(mPBRShader->GetName()).SetValue(CTEXT("cbPerObject.gWorld"), XMMatrixTranspose(world));
-    ri.GetPerObjectCBuffer(mPBRShader->GetName()).SetValue(CTEXT("cbPerObject.PrevWorldTransform"), XMMatrixTranspose(world));
-    ri.GetPerObjectCBuffer(mShadowShader->GetName()).SetValue(CTEXT("cbPerObject.gWorld"), XMMatrixTranspose(world));
+  for (uint32 i = 0; i < mRenderData->GetItemCount(); ++i) {
+    InitItemConstants(mRenderData->GetItemName(i));
   }
 
-  MaterialDesc matDesc;
-  matDesc.DiffuseAlbedo = {1.0f, 1.0f, 1.0f, 1.0f};
-  matDesc.FresnelR0     = {0.0f, 0.0f, 0.0f};
-  matDesc.Roughness     = 0.3f;
-  mRenderData->GetItemPerObjectCB(CTEXT("Plane"), mPBRShader->GetName()).SetValue(CTEXT("cbPerObject.gMatDesc"), matDesc);
-
-  matDesc.FresnelR0 = {0.16f, 0.16f, 0.16f};
-  mRenderData->GetItemPerObjectCB(CTEXT("FlightHelmet"), mPBRShader->GetName()).SetValue(CTEXT("cbPerObject.gMatDesc"), matDesc);
-
-  mRenderData->GetItem(CTEXT("FlightHelmet")).SetPosition(1.0f, 0.0f, 0.0f);
-  mRenderData->GetItem(CTEXT("FlightHelmet")).SetScale(1.5f, 1.5f, 1.5f);
-  XMMATRIX trans = XMLoadFloat4x4(&Identity4x4());
-
-  mRenderData->GetItem(CTEXT("FlightHelmet")).GetPerObjectCBuffer(mPBRShader->GetName()).SetValue(CTEXT("cbPerObject.gWorld"), XMMatrixTranspose(trans));
-  mRenderData->GetItem(CTEXT("FlightHelmet")).GetPerObjectCBuffer(mPBRShader->GetName()).SetValue(CTEXT("cbPerObject.PrevWorldTransform"), XMMatrixTranspose(trans));
-
-  mRenderData->SetCBValueWithItemTrans(CTEXT("FlightHelmet"), mPBRShader->GetName(), CTEXT("cbPerObject.gWorld"));
-  mRenderData->SetCBValueWithItemTrans(CTEXT("FlightHelmet"), mPBRShader->GetName(), CTEXT("cbPerObject.PrevWorldTransform"));
-  mRenderData->SetCBValueWithItemTrans(CTEXT("FlightHelmet"), mShadowShader->GetName(), CTEXT("cbPerObject.gWorld"));
-
-  matDesc.FresnelR0 = {0.16f, 0.16f, 0.16f};
-  mRenderData->GetItemPerObjectCB(CTEXT("BoomBox"), mPBRShader->GetName()).SetValue(CTEXT("cbPerObject.gMatDesc"), matDesc);
-  mRenderData->GetItem(CTEXT("BoomBox")).SetPosition(-1.0f, 0.5f, 0.0f);
-  mRenderData->GetItem(CTEXT("BoomBox")).SetScale(30.0f, 30.0f, 30.0f);
-  mRenderData->SetCBValueWithItemTrans(CTEXT("BoomBox"), mPBRShader->GetName(), CTEXT("cbPerObject.gWorld"));
-  mRenderData->SetCBValueWithItemTrans(CTEXT("BoomBox"), mPBRShader->GetName(), CTEXT("cbPerObject.PrevWorldTransform"));
-  mRenderData->SetCBValueWithItemTrans(CTEXT("BoomBox"), mShadowShader->GetName(), CTEXT("cbPerObject.gWorld"));
+  // Only cooked models are there yet.
+  for (const CheString& itemName : {CheString(CTEXT("FlightHelmet")), CheString(CTEXT("BoomBox"))}) {
+    if (mRenderData->FindItem(itemName).IsValid()) PlaceModelItem(itemName);
+  }
 
   mLight.strength     = {3.0f, 3.0f, 3.0f};
   mLight.falloffStart = 1.0f;
@@ -260,6 +413,11 @@ bool RenderExample::Load()
   mLight.SpotPower    = 64.0f;
 
   BuildPSO();
+  // The frame list, then one list per pool thread and the caller.
+  mRecordContexts = vector<RecordContext>(ThreadPool::Get().GetThreadCount() + 2);
+  mPassLists.reserve(mRecordContexts.size() - 1);
+  mGraphics->mCommandListPool.Reserve(mGraphics->mD3dDevice.Get(), static_cast<uint32>(mRecordContexts.size()) - 1);
+  ReserveFrameScratch();
 
   mGraphics->ExecuteCommandList();
   mGraphics->FlushCommandQueue();
@@ -269,8 +427,6 @@ bool RenderExample::Load()
   mCamera.SetViewPort(0.0f, 0.0f, (float)m_Resolution.RenderWidth, (float)m_Resolution.RenderHeight);
 
   mPrevViewProjectionMatrix = mCamera.GetViewProjMatrixXM();
-  mPBRShader->GetCBufferManager().SetValue(CTEXT("cbPass.gViewProj"), XMMatrixTranspose(mCamera.GetViewProjMatrixXM()));
-  mPBRShader->GetCBufferManager().SetValue(CTEXT("cbPass.PrevViewProjectionMatrix"), XMMatrixTranspose(mPrevViewProjectionMatrix));
 
   mSceneBounds.Center = XMFLOAT3(0.0f, 0.0f, 0.0f);
   mSceneBounds.Radius = sqrtf(10.0f * 10.0f + 15.0f * 15.0f);
@@ -282,25 +438,40 @@ void RenderExample::Draw()
 {
   TIFF(mGraphics->mDirectCmdListAlloc->Reset());
   TIFF(mGraphics->mCommandList->Reset(mGraphics->mDirectCmdListAlloc.Get(), nullptr));
-
-  mGraphics->mCommandList->RSSetViewports(1, &mShadowMap->GetViewport());
-  mGraphics->mCommandList->RSSetScissorRects(1, &mShadowMap->GetScissorRect());
+  mGraphics->mCommandListPool.Reset();
+  for (RecordContext& context : mRecordContexts) context.Recorder.ResetCounters();
+  mRecordContexts[0].Recorder.Begin(mGraphics->mCommandList.Get());
+
+  // The previous frame was waited for, its instance data and draw arguments can be overwritten and its uploads are done.
+  mRenderData->ResetInstances();
+  mIndirectDraws.Reset();
+  mRenderData->ReleaseUploadBuffers();
+  mSkyboxRenderData->ReleaseUploadBuffers();
+  // Constants of finished frames are free again, this frame gets a copy of what Update wrote.
+  mGraphics->mUploadRing.Reclaim(mGraphics->mFence->GetCompletedValue());
+  mRenderData->UploadConstants(mGraphics->mUploadRing);
+  mSkyboxRenderData->UploadConstants(mGraphics->mUploadRing);
+  mViewConstants.Upload(mGraphics->mD3dDevice.Get(), mGraphics->mUploadRing);
+  // Streamed items reach the geometry heaps ahead of the first draw.
+  mRenderData->RecordGeometryCopies();
 
   // Draw shadow map.
   mGraphics->mCommandList->ResourceBarrier(1,
                                            &CD3DX12_RESOURCE_BARRIER::Transition(mShadowMap->GetResource(), D3D12_RESOURCE_STATE_GENERIC_READ, D3D12_RESOURCE_STATE_DEPTH_WRITE));
   mGraphics->mCommandList->ClearDepthStencilView(mShadowMap->GetDsv(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
-  mGraphics->mCommandList->OMSetRenderTargets(0, nullptr, false, &mShadowMap->GetDsv());
+  PassTargets shadowTargets;
+  shadowTargets.Viewport     = mShadowMap->GetViewport();
+  shadowTargets.ScissorRect  = mShadowMap->GetScissorRect();
+  shadowTargets.DepthStencil = mShadowMap->GetDsv();
+  shadowTargets.Bind(mGraphics->mCommandList.Get());
 
-  mGraphics->mCommandList->SetPipelineState(mPSOs[CTEXT("ShadowPSO")].Get());
-  DrawRenderItem(*mRenderData, mShadowShader);
+  // The draw loops run on prebuilt bindings and must not touch the heap once the scene is loaded.
+  AllocationScope drawAllocations;
+  DrawRenderItem(*mRenderData, mShadowPass, shadowTargets, mShadowView, false, nullptr, &mShadowVisibleDraws);
 
   mGraphics->mCommandList->ResourceBarrier(1,
                                            &CD3DX12_RESOURCE_BARRIER::Transition(mShadowMap->GetResource(), D3D12_RESOURCE_STATE_DEPTH_WRITE, D3D12_RESOURCE_STATE_GENERIC_READ));
 
-  mGraphics->mCommandList->RSSetViewports(1, &mGraphics->mScreenViewport);
-  mGraphics->mCommandList->RSSetScissorRects(1, &mGraphics->mScissorRect);
-
   // CD3DX12_RESOURCE_BARRIER backBufferBarrier =
   //     CD3DX12_RESOURCE_BARRIER::Transition(mGraphics->CurrentBackBuffer(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
   // mGraphics->mCommandList->ResourceBarrier(1, &backBufferBarrier);
@@ -313,23 +484,28 @@ void RenderExample::Draw()
   mGraphics->mCommandList->ClearDepthStencilView(mGraphics->ColorDepthBufferView(), D3D12_CLEAR_FLAG_DEPTH | D3D12_CLEAR_FLAG_STENCIL, 1.0f, 0, 0, nullptr);
 
   // Specify the buffers we are going to render to.
-  D3D12_CPU_DESCRIPTOR_HANDLE colorBufferView        = mGraphics->ColorTargetBufferView();
-  D3D12_CPU_DESCRIPTOR_HANDLE motionVectorBufferView = mGraphics->MotionVectorBufferView();
-  D3D12_CPU_DESCRIPTOR_HANDLE colorDepthBufferView   = mGraphics->ColorDepthBufferView();
-  D3D12_CPU_DESCRIPTOR_HANDLE rts[2]                 = {colorBufferView, motionVectorBufferView};
-  mGraphics->mCommandList->OMSetRenderTargets(2, rts, false, &colorDepthBufferView);
-
-  mGraphics->mCommandList->SetPipelineState(mPSOs[CTEXT("StandardPSO")].Get());
-  DrawRenderItem(*mRenderData, mPBRShader);
-
-  mGraphics->mCommandList->SetPipelineState(mPSOs[CTEXT("SkyboxPSO")].Get());
-  DrawRenderItem(*mSkyboxRenderData, mSkyboxShader);
-
-  mGraphics->mCommandList->SetPipelineState(mPSOs[CTEXT("TransparentPSO")].Get());
-  DrawRenderItem(*mRenderData, mPBRShader, true);
+  PassTargets sceneTargets;
+  sceneTargets.Viewport          = mGraphics->mScreenViewport;
+  sceneTargets.ScissorRect       = mGraphics->mScissorRect;
+  sceneTargets.RenderTargetCount = 2;
+  sceneTargets.RenderTargets[0]  = mGraphics->ColorTargetBufferView();
+  sceneTargets.RenderTargets[1]  = mGraphics->MotionVectorBufferView();
+  sceneTargets.DepthStencil      = mGraphics->ColorDepthBufferView();
+  sceneTargets.Bind(mGraphics->mCommandList.Get());
+
+  DrawRenderItem(*mRenderData, mOpaquePass, sceneTargets, mCameraView, false, &mCamera, &mVisibleDraws);
+  DrawRenderItem(*mSkyboxRenderData, mSkyboxPass, sceneTargets, mCameraView);
+  DrawRenderItem(*mRenderData, mTransparentPass, sceneTargets, mCameraView, true, &mCamera, &mVisibleDraws);
+
+  // The count is process wide, streamed loads decoding on the pool meanwhile would show up in it.
+  if (drawAllocations.GetCount() != 0 && mPendingModels.empty() && !mDrawAllocationsReported) {
+    logger.Warning(CTEXT("Draw loops allocated ") + ConvertToCheString(static_cast<int>(drawAllocations.GetCount())) + CTEXT(" times in a frame."));
+    mDrawAllocationsReported = true;
+  }
 
   m_Fsr2RenderModule.Execute(mTimer.DeltaTime(), mGraphics->mCommandList.Get(), mGraphics->RenderTargetBuffer(), mGraphics->ColorTargetBuffer(), mGraphics->ColorDepthBuffer(),
                              mGraphics->MotionVectorBuffer(), mCamera);
+  mRecordContexts[0].Recorder.Invalidate();
 
   CD3DX12_RESOURCE_BARRIER copyBackBarrierBegin =
       CD3DX12_RESOURCE_BARRIER::Transition(mGraphics->CurrentBackBuffer(), D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_COPY_SOURCE);
@@ -353,74 +529,260 @@ void RenderExample::Draw()
   // so we do not have to wait per frame.
   mGraphics->ExecuteCommandList();
   mGraphics->FlushCommandQueue();
+  mGraphics->mUploadRing.EndFrame(mGraphics->mCurrentFence);
 
   // swap the back and front buffers
   TIFF(mGraphics->mSwapChain->Present(0, 0));
   mGraphics->mCurrBackBuffer = (mGraphics->mCurrBackBuffer + 1) % mGraphics->SwapChainBufferCount;
 }
 
-void RenderExample::DrawRenderItem(RenderData& renderData, Shader* shader, bool drawBlend)
+void RenderExample::DrawRenderItem(RenderData& renderData, const DrawPass& pass, const PassTargets& targets, uint32 view, bool drawBlend, const Camera* cullCamera,
+                                   const vector<uint32>* visibleDraws)
 {
-  mGraphics->mCommandList->SetGraphicsRootSignature(shader->GetRootSignature());
-
-  // Bind shader pass cbuffer.
-  for (const auto& pair : shader->GetCBufferManager().GetCBuffers()) {
-    auto cbuffer = pair.second;
-    auto cbInfo  = cbuffer.GetCBufferInfo();
-    mGraphics->mCommandList->SetGraphicsRootConstantBufferView(cbInfo.GetSlot(), cbuffer.GetResource()->GetGPUVirtualAddress());
+  const uint32 shaderIndex = renderData.GetShaderIndex(pass.PassShader);
+  if (shaderIndex == RenderData::INVALID_INDEX) return;
+  const ShaderBinding& binding = renderData.GetShaderBinding(shaderIndex);
+  const bool instancing        = binding.InstanceRootIndex != RenderData::INVALID_INDEX && binding.DrawConstantsRootIndex != RenderData::INVALID_INDEX;
+  const bool indirect          = instancing && pass.CommandSignature != nullptr;
+  const bool bindless          = binding.TextureTableRootIndex != RenderData::INVALID_INDEX;
+
+  // Depth along the view direction, 0 at the near plane and 1 at the far plane.
+  XMVECTOR eyePosition = XMVectorZero();
+  XMVECTOR lookAxis    = XMVectorZero();
+  float nearZ          = 0.0f;
+  float depthScale     = 0.0f;
+  if (cullCamera != nullptr) {
+    eyePosition = cullCamera->GetPositionXM();
+    lookAxis    = cullCamera->GetLookAxisXM();
+    nearZ       = cullCamera->GetNearZ();
+    depthScale  = 1.0f / (cullCamera->GetFarZ() - cullCamera->GetNearZ());
   }
 
-  for (auto pair : renderData.GetRenderItems()) {
-    auto itemName = pair.first;
-    auto& item    = renderData.GetRenderItems()[itemName];
-
-    ID3D12DescriptorHeap* descriptorHeaps[] = {renderData.GetSrvDescriptorHeap()};
-    mGraphics->mCommandList->SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+  // Draw refs are item major and visibleDraws is sorted, so the draws of an item come in one run.
+  const uint32 drawCount = visibleDraws != nullptr ? static_cast<uint32>(visibleDraws->size()) : renderData.GetDrawCount();
+  uint32 viewItem        = RenderData::INVALID_INDEX;
+  XMMATRIX world         = XMMatrixIdentity();
+
+  mInstanceBatcher.Clear();
+  for (uint32 i = 0; i < drawCount; ++i) {
+    const uint32 drawIndex = visibleDraws != nullptr ? (*visibleDraws)[i] : i;
+    const DrawRef& ref     = renderData.GetDrawRef(drawIndex);
+    RenderItem& item       = renderData.GetItemAt(ref.ItemIndex);
+    const DrawArg& arg     = item.GetDrawArgs()[ref.ArgIndex];
+    if (arg.IsBlend != drawBlend) continue;
+
+    if (ref.ItemIndex != viewItem) {
+      viewItem = ref.ItemIndex;
+      world    = renderData.GetItemWorld(ref.ItemIndex);
+      // Blend materials are often double sided, only reject their clusters against the frustum.
+      if (cullCamera != nullptr && item.HasMeshlets()) {
+        mCullViews[ref.ItemIndex] = ClusterCuller::MakeView(*cullCamera, world, !drawBlend);
+      }
+    }
 
-    for (const auto& pair : renderData.GetItemPerObjectCB(itemName, shader->GetName()).GetCBuffers()) {
-      auto cbuffer = pair.second;
-      auto cbInfo  = cbuffer.GetCBufferInfo();
-      mGraphics->mCommandList->SetGraphicsRootConstantBufferView(cbInfo.GetSlot(), cbuffer.GetResource()->GetGPUVirtualAddress());
+    float depth = 0.0f;
+    if (cullCamera != nullptr) {
+      const XMVECTOR center = XMVector3TransformCoord(XMLoadFloat3(&arg.BoundsCenter), world);
+      depth                 = (XMVectorGetX(XMVector3Dot(center - eyePosition, lookAxis)) - nearZ) * depthScale;
     }
 
-    D3D12_VERTEX_BUFFER_VIEW vBufferView = item.GetVertexBufferView();
-    mGraphics->mCommandList->IASetVertexBuffers(0, 1, &vBufferView);
-    mGraphics->mCommandList->IASetPrimitiveTopology(D3D11_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+    const uint32 pipeline = static_cast<uint32>(arg.Format);
+    // Bindless shaders only switch textures through the draw constants, sorting by them keeps draws of a material together.
+    const uint32 material = bindless ? renderData.GetDrawMaterialId(drawIndex) : binding.DrawMaterialIds[drawIndex];
+    const bool indices32  = arg.IndexFormat == DXGI_FORMAT_R32_UINT;
 
-    D3D12_INDEX_BUFFER_VIEW iBufferView16 = item.GetIndexBufferView16();
-    D3D12_INDEX_BUFFER_VIEW iBufferView32 = item.GetIndexBufferView32();
+    const uint64 sortKey  = drawBlend ? DrawSorter::MakeBlendKey(pass.Id, pipeline, material, indices32, depth)
+                                      : DrawSorter::MakeOpaqueKey(pass.Id, pipeline, material, indices32, depth);
+    const uint64 batchKey = instancing && !drawBlend ? InstanceBatcher::MakeKey(item.GetGeometryId(), ref.ArgIndex, arg.CurrentLod)
+                                                     : InstanceBatcher::MakeSingleKey(i);
+    mInstanceBatcher.Add(batchKey, sortKey, ref.ItemIndex, ref.ArgIndex);
+  }
+  mInstanceBatcher.Build();
+
+  D3D12_GPU_VIRTUAL_ADDRESS instanceAddress = 0;
+  if (instancing && mInstanceBatcher.GetDrawCount() != 0) {
+    instanceAddress = renderData.WriteInstances(mInstanceBatcher.GetInstanceItems());
+    if (instanceAddress == 0) {
+      logger.Error(CTEXT("Instance buffer is full, skip the pass."));
+      return;
+    }
+  }
 
-    for (auto arg : item.GetDrawArgs()) {
-      if (arg.IsBlend != drawBlend) continue;
-      D3D12_INDEX_BUFFER_VIEW iBufferView(arg.IndexFormat == DXGI_FORMAT_R16_UINT ? iBufferView16 : iBufferView32);
-      mGraphics->mCommandList->IASetIndexBuffer(&iBufferView);
+  // One command per batch, in batch order. The object CBV is the only per object cbuffer of the shader, see MakeDrawPass.
+  const vector<InstanceBatch>& batches = mInstanceBatcher.GetBatches();
+  uint32 firstCommand                  = 0;
+  if (indirect) {
+    firstCommand = mIndirectDraws.Write(static_cast<uint32>(batches.size()), [&](uint32 batchIndex, IndirectDrawCommand& command) {
+      const InstanceBatch& batch           = batches[batchIndex];
+      const DrawArg& arg                   = renderData.GetItemAt(batch.ItemIndex).GetDrawArgs()[batch.ArgIndex];
+      const ItemShaderBinding& itemBinding = renderData.GetItemBinding(batch.ItemIndex, shaderIndex);
+      const DrawLod& lod                   = arg.Lods[arg.CurrentLod];
+      command.ObjectCbv                    = renderData.GetObjectCbv(itemBinding.FirstObjectCbv).Address;
+      command.ObjectIndex                  = batch.FirstInstance;
+      command.MaterialId                   = renderData.GetDrawMaterialId(renderData.GetDrawIndex(batch.ItemIndex, batch.ArgIndex));
+      command.Draw                         = {lod.IndexCount, batch.InstanceCount, lod.StartIndexLocation, static_cast<int32>(arg.BaseVertexLocation), 0};
+    });
+    if (firstCommand == IndirectDrawBuffer::INVALID_INDEX) {
+      logger.Error(CTEXT("Indirect draw buffer is full, skip the pass."));
+      return;
+    }
+  }
 
-      for (auto pair : shader->GetSettings().GetSRVSetting()) {
-        auto srvName    = pair.first;
-        auto srvSetting = pair.second;
+  PreparedPass prepared;
+  prepared.Data            = &renderData;
+  prepared.Pass            = &pass;
+  prepared.ShaderIndex     = shaderIndex;
+  prepared.Instancing      = instancing;
+  prepared.Indirect        = indirect;
+  prepared.Bindless        = bindless;
+  prepared.CullClusters    = cullCamera != nullptr;
+  prepared.InstanceAddress = instanceAddress;
+  prepared.ViewAddress     = mViewConstants.GetAddress(view);
+  prepared.FirstCommand    = firstCommand;
+
+  const uint32 batchCount = static_cast<uint32>(batches.size());
+  const uint32 listCount  = std::min<uint32>(static_cast<uint32>(mRecordContexts.size()) - 1, batchCount / MIN_BATCHES_PER_LIST);
+  if (listCount <= 1) {
+    RecordBatches(prepared, mRecordContexts[0], 0, batchCount);
+    return;
+  }
 
-        // offset cbuffer parameter index.
-        uint32 paramIndex = srvSetting.GetSlot() + shader->GetSettings().GetCBSettingCount();
-        if (srvName == CTEXT("gShadowMap")) {
-          mGraphics->mCommandList->SetGraphicsRootDescriptorTable(paramIndex, mRenderData->GetShadowMapHandleGPU());
-          continue;
-        }
+  // The frame list so far runs first, then the pass lists in batch order, then the rest of the frame list.
+  mGraphics->ExecuteCommandList();
+  mPassLists.clear();
+  for (uint32 i = 0; i < listCount; ++i) mPassLists.push_back(mGraphics->mCommandListPool.Acquire(mGraphics->mD3dDevice.Get()));
+  ThreadPool::Get().ParallelFor(listCount, [&](uint32 listIndex) {
+    RecordContext& context = mRecordContexts[listIndex + 1];
+    context.Recorder.Begin(mPassLists[listIndex]);
+    targets.Bind(mPassLists[listIndex]);
+    RecordBatches(prepared, context, batchCount * listIndex / listCount, batchCount * (listIndex + 1) / listCount);
+  });
+  mGraphics->mCommandListPool.Submit(mGraphics->mCommandQueue.Get());
+
+  // The allocator is only reset once the GPU finished the frame, the list can go on recording into it.
+  TIFF(mGraphics->mCommandList->Reset(mGraphics->mDirectCmdListAlloc.Get(), nullptr));
+  mRecordContexts[0].Recorder.Begin(mGraphics->mCommandList.Get());
+  targets.Bind(mGraphics->mCommandList.Get());
+}
 
-        // Default bind null srv.
-        uint32 srvIndex = mRenderData->GetNullSrvIndex();
+void RenderExample::RecordBatches(const PreparedPass& prepared, RecordContext& context, uint32 begin, uint32 end)
+{
+  RenderData& renderData                               = *prepared.Data;
+  const DrawPass& pass                                 = *prepared.Pass;
+  const ShaderBinding& binding                         = renderData.GetShaderBinding(prepared.ShaderIndex);
+  const vector<InstanceBatch>& batches                 = mInstanceBatcher.GetBatches();
+  CommandRecorder<ID3D12GraphicsCommandList>& recorder = context.Recorder;
+  ID3D12GraphicsCommandList* cmdList                   = recorder.GetCommandList();
+
+  // Passes share the heap and often the root signature, the recorder drops what the previous pass bound already.
+  recorder.SetGraphicsRootSignature(pass.PassShader->GetRootSignature());
+  ID3D12DescriptorHeap* descriptorHeaps[] = {renderData.GetSrvDescriptorHeap()};
+  recorder.SetDescriptorHeaps(_countof(descriptorHeaps), descriptorHeaps);
+  const CD3DX12_GPU_DESCRIPTOR_HANDLE heapStart(renderData.GetSrvDescriptorHeap()->GetGPUDescriptorHandleForHeapStart());
+  recorder.IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
 
-        if (arg.DrawSrvs.find(srvName) != arg.DrawSrvs.end()) {
-          srvIndex = arg.DrawSrvs[srvName].SrvIndex + item.GetSrvDescriptorOffset();
-        }
+  // Bind shader pass cbuffer.
+  for (const RootCbv& cbv : binding.PassCbvs) {
+    recorder.SetGraphicsRootConstantBufferView(cbv.Slot, cbv.Address);
+  }
+  // Every pass of a view binds the same CBV.
+  if (binding.ViewCbvRootIndex != RenderData::INVALID_INDEX) {
+    recorder.SetGraphicsRootConstantBufferView(binding.ViewCbvRootIndex, prepared.ViewAddress);
+  }
+  if (binding.MaterialRootIndex != RenderData::INVALID_INDEX) {
+    recorder.SetGraphicsRootShaderResourceView(binding.MaterialRootIndex, renderData.GetMaterialBufferAddress());
+  }
+  // Draws pick their instances through gObjectIndex.
+  if (prepared.Instancing) {
+    recorder.SetGraphicsRootShaderResourceView(binding.InstanceRootIndex, prepared.InstanceAddress);
+  }
+  // Draws pick their textures through gMaterialId.
+  if (binding.MaterialTextureRootIndex != RenderData::INVALID_INDEX) {
+    recorder.SetGraphicsRootShaderResourceView(binding.MaterialTextureRootIndex, renderData.GetMaterialTextureBufferAddress());
+  }
+  if (prepared.Bindless) {
+    recorder.SetGraphicsRootDescriptorTable(binding.TextureTableRootIndex, heapStart);
+  }
 
-        CD3DX12_GPU_DESCRIPTOR_HANDLE tex(renderData.GetSrvDescriptorHeap()->GetGPUDescriptorHandleForHeapStart());
-        tex.Offset(srvIndex, mGraphics->mCbvSrvUavDescriptorSize);
-        mGraphics->mCommandList->SetGraphicsRootDescriptorTable(paramIndex, tex);
+  // State of the previous batch, an indirect run ends where it changes.
+  // Items share the geometry heap pages, so the buffers only change with the format or the page.
+  VertexFormat pipelineFormat                 = VertexFormat::STANDARD;
+  uint32 boundMaterial                        = RenderData::INVALID_INDEX;
+  D3D12_GPU_VIRTUAL_ADDRESS boundVertexBuffer = 0;
+  D3D12_GPU_VIRTUAL_ADDRESS boundIndexBuffer  = 0;
+  DXGI_FORMAT indexFormat                     = DXGI_FORMAT_UNKNOWN;
+  // Commands of the batches since the last state change, not submitted yet.
+  uint32 runStart = begin;
+  // The commands set the object CBV, it is unknown afterwards.
+  auto executeRun = [&](uint32 runEnd) {
+    cmdList->ExecuteIndirect(pass.CommandSignature.Get(), runEnd - runStart, mIndirectDraws.GetBuffer(), mIndirectDraws.GetOffset(prepared.FirstCommand + runStart), nullptr,
+                             0);
+    recorder.InvalidateRootArgument(binding.ObjectCbvRootIndex);
+    runStart = runEnd;
+  };
+
+  for (uint32 batchIndex = begin; batchIndex < end; ++batchIndex) {
+    const InstanceBatch& batch           = batches[batchIndex];
+    RenderItem& item                     = renderData.GetItemAt(batch.ItemIndex);
+    const DrawArg& arg                   = item.GetDrawArgs()[batch.ArgIndex];
+    const ItemShaderBinding& itemBinding = renderData.GetItemBinding(batch.ItemIndex, prepared.ShaderIndex);
+    const uint32 drawIndex               = renderData.GetDrawIndex(batch.ItemIndex, batch.ArgIndex);
+
+    // Meshlets only cover LOD 0, coarser levels are cheap enough to draw whole.
+    // Clusters are culled for one transform, batches of several instances are drawn whole as well.
+    const bool drawClusters = !prepared.Indirect && prepared.CullClusters && item.HasMeshlets() && arg.CurrentLod == 0 && batch.InstanceCount == 1;
+    if (drawClusters && ClusterCuller::Cull(item.GetMeshlets(batch.ArgIndex), mCullViews[batch.ItemIndex], context.ClusterRanges) == 0) continue;
+
+    D3D12_VERTEX_BUFFER_VIEW vBufferView = item.GetVertexBufferView(arg.Format);
+    // Both index formats may view the same page.
+    D3D12_INDEX_BUFFER_VIEW iBufferView(arg.IndexFormat == DXGI_FORMAT_R16_UINT ? item.GetIndexBufferView16() : item.GetIndexBufferView32());
+    const uint32 materialId = binding.DrawMaterialIds[drawIndex];
+
+    if (prepared.Indirect) {
+      const bool stateChanged = arg.Format != pipelineFormat || vBufferView.BufferLocation != boundVertexBuffer || iBufferView.BufferLocation != boundIndexBuffer ||
+                                arg.IndexFormat != indexFormat || materialId != boundMaterial;
+      if (stateChanged && batchIndex != runStart) executeRun(batchIndex);
+      pipelineFormat    = arg.Format;
+      boundMaterial     = materialId;
+      boundVertexBuffer = vBufferView.BufferLocation;
+      boundIndexBuffer  = iBufferView.BufferLocation;
+      indexFormat       = arg.IndexFormat;
+    } else {
+      for (uint32 cbvIndex = itemBinding.FirstObjectCbv; cbvIndex < itemBinding.FirstObjectCbv + itemBinding.ObjectCbvCount; ++cbvIndex) {
+        const RootCbv& cbv = renderData.GetObjectCbv(cbvIndex);
+        recorder.SetGraphicsRootConstantBufferView(cbv.Slot, cbv.Address);
       }
+    }
+
+    recorder.SetPipelineState(pass.Pipelines[static_cast<uint32>(arg.Format)]);
+    recorder.IASetVertexBuffers(0, 1, &vBufferView);
+    recorder.IASetIndexBuffer(&iBufferView);
+
+    const uint32* srvIndices = binding.DrawSrvIndices.data() + drawIndex * binding.SrvParams.size();
+    for (uint32 paramIndex = 0; paramIndex < binding.SrvParams.size(); ++paramIndex) {
+      CD3DX12_GPU_DESCRIPTOR_HANDLE tex(heapStart, srvIndices[paramIndex], mGraphics->mCbvSrvUavDescriptorSize);
+      recorder.SetGraphicsRootDescriptorTable(binding.SrvParams[paramIndex].RootIndex, tex);
+    }
+
+    if (prepared.Indirect) continue;
 
-      mGraphics->mCommandList->DrawIndexedInstanced(arg.IndexCount, 1, arg.StartIndexLocation, arg.BaseVertexLocation, 0);
+    // SV_InstanceID starts at 0 whatever the start instance, gObjectIndex points at the first instance of the batch instead.
+    if (prepared.Instancing) {
+      const uint32 drawConstants[] = {batch.FirstInstance, renderData.GetDrawMaterialId(drawIndex)};
+      cmdList->SetGraphicsRoot32BitConstants(binding.DrawConstantsRootIndex, _countof(drawConstants), drawConstants, 0);
+    }
+
+    if (!drawClusters) {
+      const DrawLod& lod = arg.Lods[arg.CurrentLod];
+      cmdList->DrawIndexedInstanced(lod.IndexCount, batch.InstanceCount, lod.StartIndexLocation, arg.BaseVertexLocation, 0);
+      continue;
+    }
+    for (const ClusterDrawRange& range : context.ClusterRanges) {
+      cmdList->DrawIndexedInstanced(range.IndexCount, 1, arg.StartIndexLocation + range.StartIndex, arg.BaseVertexLocation, 0);
     }
   }
+
+  if (prepared.Indirect && runStart != end) executeRun(end);
 }
 
 void RenderExample::Run()
@@ -496,28 +858,139 @@ void RenderExample::Update(float dt)
   XMMATRIX lightViewProj   = lightView * lightProj;
   XMMATRIX shadowTransform = lightView * lightProj * texTrans;
 
-  mRenderData->SetCBValueWithItemTrans(CTEXT("BoomBox"), mPBRShader->GetName(), CTEXT("cbPerObject.PrevWorldTransform"));
+  AddStreamedItems();
 
-  auto bboxPos = mRenderData->GetItem(CTEXT("BoomBox")).GetPosition();
-  float scale  = 0.5f;
-  bboxPos.y    = 1.5 + sin(rotTime * scale);
-  mRenderData->GetItem(CTEXT("BoomBox")).SetPosition(bboxPos.x, bboxPos.y, bboxPos.z);
-  mRenderData->SetCBValueWithItemTrans(CTEXT("BoomBox"), mPBRShader->GetName(), CTEXT("cbPerObject.gWorld"));
+  // The BoomBox is missing while it is still streaming.
+  if (mRenderData->FindItem(CTEXT("BoomBox")).IsValid()) {
+    auto bboxPos = mRenderData->GetItem(CTEXT("BoomBox")).GetPosition();
+    float scale  = 0.5f;
+    bboxPos.y    = 1.5 + sin(rotTime * scale);
+    mRenderData->GetItem(CTEXT("BoomBox")).SetPosition(bboxPos.x, bboxPos.y, bboxPos.z);
+  }
 
   XMVECTOR Pos = {1, 1, 1, 1};
 
-  mPBRShader->GetCBufferManager().SetValue(CTEXT("cbPass.CurrJitter"), mCamera.GetJitterValues());
-  mPBRShader->GetCBufferManager().SetValue(CTEXT("cbPass.gViewProj"), XMMatrixTranspose(mCamera.GetViewProjJitteredMatrixXM()));
-  mPBRShader->GetCBufferManager().SetValue(CTEXT("cbPass.PrevJitter"), mPrevJitter);
-  mPBRShader->GetCBufferManager().SetValue(CTEXT("cbPass.PrevViewProjectionMatrix"), XMMatrixTranspose(mPrevViewProjectionMatrix));
+  // One cbView per view whatever the number of shaders, every variable is filled and each view is written with one copy.
+  // The skybox renders with the jittered camera like the scene around it, FSR2 expects every pass to match.
+  ViewConstants::cbView cameraView;
+  XMStoreFloat4x4(&cameraView.gViewProj, XMMatrixTranspose(mCamera.GetViewProjJitteredMatrixXM()));
+  XMStoreFloat4x4(&cameraView.PrevViewProjectionMatrix, XMMatrixTranspose(mPrevViewProjectionMatrix));
+  cameraView.PrevJitter = mPrevJitter;
+  cameraView.CurrJitter = mCamera.GetJitterValues();
+  XMStoreFloat4x4(&cameraView.gShadowTransform, XMMatrixTranspose(shadowTransform));
+  cameraView.gLight   = mLight;
+  cameraView.gEyePosW = mCamera.GetPostion();
+  mViewConstants.SetView(mCameraView, cameraView);
   mPrevViewProjectionMatrix = mCamera.GetViewProjJitteredMatrixXM();
   mPrevJitter               = mCamera.GetJitterValues();
-  mPBRShader->GetCBufferManager().SetValue(CTEXT("cbPass.gShadowTransform"), XMMatrixTranspose(shadowTransform));
-  mPBRShader->GetCBufferManager().SetValue(CTEXT("cbPass.gLight"), mLight);
-  mPBRShader->GetCBufferManager().SetValue(CTEXT("cbPass.gEyePosW"), mCamera.GetPostion());
-  mShadowShader->GetCBufferManager().SetValue(CTEXT("cbPass.gViewProj"), XMMatrixTranspose(lightViewProj));
-  mSkyboxShader->GetCBufferManager().SetValue(CTEXT("cbPass.gViewProj"), XMMatrixTranspose(mCamera.GetViewProjMatrixXM()));
-  mSkyboxShader->GetCBufferManager().SetValue(CTEXT("cbPass.gEyePosW"), mCamera.GetPostion());
+
+  // Only the shadow shader renders the light view, it reads the view projection alone.
+  ViewConstants::cbView shadowView = cameraView;
+  XMStoreFloat4x4(&shadowView.gViewProj, XMMatrixTranspose(lightViewProj));
+  mViewConstants.SetView(mShadowView, shadowView);
+
+  mLodSelector.SetView(mCamera);
+  for (uint32 i = 0; i < mRenderData->GetItemCount(); ++i) {
+    mRenderData->GetItemAt(i).SelectLods(mLodSelector);
+  }
+
+  // Instance transforms and boxes follow the items moved above.
+  mRenderData->UpdateInstanceData();
+  mRenderData->UpdateDrawBounds();
+  XMFLOAT4 frustumPlanes[6];
+  mCamera.GetFrustumPlanes(frustumPlanes);
+  mFrustumCuller.Cull(mRenderData->GetDrawBounds(), frustumPlanes, mVisibleDraws);
+  mOcclusionCuller.Render(mCamera);
+  mOcclusionCuller.Cull(mRenderData->GetDrawBounds(), mVisibleDraws);
+  Camera::ExtractFrustumPlanes(lightViewProj, frustumPlanes);
+  mFrustumCuller.Cull(mRenderData->GetDrawBounds(), frustumPlanes, mShadowVisibleDraws);
+}
+
+// Prefers the cooked .chm written by MeshCooker, falls back to decoding the .gltf.
+void RenderExample::AddModelItem(const CheString& name, const CheString& modelPath)
+{
+  const CheString cookedPath = modelPath + CTEXT(".chm");
+  if (GetFileAttributes(cookedPath.c_str()) != INVALID_FILE_ATTRIBUTES) {
+    CookedModel cookedModel;
+    if (cookedModel.Open(cookedPath)) {
+      logger.Info(CTEXT("Loading cooked model:") + cookedPath);
+      mRenderData->AddRenderItem(name, cookedModel);
+      return;
+    }
+  }
+
+  ModelLoadOptions loadOptions;
+  loadOptions.MapBuffers     = true;
+  loadOptions.WeldVertices   = true;
+  loadOptions.OptimizeMeshes = true;
+  loadOptions.GenerateLods   = true;
+  loadOptions.Format         = VertexFormat::COMPACT;
+
+  mPendingModels.push_back(make_pair(name, mStreamer->LoadAsync(modelPath + CTEXT(".gltf"), loadOptions)));
+}
+
+// Moves finished loads into the render data. The material texture buffer is rebuilt in place,
+// which relies on Draw waiting for the GPU at the end of every frame.
+void RenderExample::AddStreamedItems()
+{
+  mStreamer->Update();
+
+  bool added = false;
+  for (auto iter = mPendingModels.begin(); iter != mPendingModels.end();) {
+    const StreamState state = mStreamer->GetState(iter->second);
+    if (state == StreamState::READY) {
+      mRenderData->AddRenderItem(iter->first, *mStreamer->GetModel(iter->second), *mUploadSink);
+      InitItemConstants(iter->first);
+      PlaceModelItem(iter->first);
+      added = true;
+    } else if (state != StreamState::FAILED) {
+      ++iter;
+      continue;
+    }
+    mStreamer->Release(iter->second);
+    iter = mPendingModels.erase(iter);
+  }
+
+  if (added) {
+    mRenderData->BuildRenderData();
+    ReserveFrameScratch();
+  }
+}
+
+void RenderExample::InitItemConstants(const CheString& itemName)
+{
+  auto& ri = mRenderData->GetItem(itemName);
+
+  // Transforms and materials go through the instance buffer, the cbuffer only holds what instances share.
+  const VertexQuantization& quantization = ri.GetVertexQuantization();
+  PBRConstants::cbPerObject pbrObject;
+  pbrObject.gPositionOffset = XMFLOAT4(quantization.Offset.x, quantization.Offset.y, quantization.Offset.z, 0.0f);
+  pbrObject.gPositionScale  = XMFLOAT4(quantization.Scale.x, quantization.Scale.y, quantization.Scale.z, 0.0f);
+  mRenderData->GetItemPerObjectCB(itemName, mPBRShader).SetCBuffer(pbrObject);
+
+  ShadowConstants::cbPerObject shadowObject;
+  shadowObject.gPositionOffset = pbrObject.gPositionOffset;
+  shadowObject.gPositionScale  = pbrObject.gPositionScale;
+  mRenderData->GetItemPerObjectCB(itemName, mShadowShader).SetCBuffer(shadowObject);
+}
+
+void RenderExample::PlaceModelItem(const CheString& itemName)
+{
+  mRenderData->SetMaterialIndex(mRenderData->FindItem(itemName), mModelMaterial);
+
+  if (itemName == CTEXT("FlightHelmet")) {
+    mRenderData->GetItem(itemName).SetPosition(1.0f, 0.0f, 0.0f);
+    mRenderData->GetItem(itemName).SetScale(1.5f, 1.5f, 1.5f);
+  } else if (itemName == CTEXT("BoomBox")) {
+    mRenderData->GetItem(itemName).SetPosition(-1.0f, 0.5f, 0.0f);
+    mRenderData->GetItem(itemName).SetScale(30.0f, 30.0f, 30.0f);
+  }
+
+  for (const OccluderProxy& proxy : OCCLUDER_PROXIES) {
+    if (itemName != proxy.ItemName) continue;
+    const uint32 occluder = mOcclusionCuller.AddBoxOccluder(proxy.BoxMin, proxy.BoxMax);
+    mOcclusionCuller.SetOccluderTransform(occluder, mRenderData->GetItem(itemName).GetTransMatrix());
+  }
 }
 
 void RenderExample::BuildPSO()
@@ -583,6 +1056,82 @@ void RenderExample::BuildPSO()
 
   transparentPsoDesc.BlendState.RenderTarget[0] = transparencyBlendDesc;
   TIFF(mGraphics->mD3dDevice->CreateGraphicsPipelineState(&transparentPsoDesc, IID_PPV_ARGS(&mPSOs[CTEXT("TransparentPSO")])));
+
+  // The same pipelines fed by CompactVertex.
+  ID3DBlob* pbrCompactVS    = mPBRShader->GetVSVariant(CTEXT("VSCompact"));
+  ID3DBlob* shadowCompactVS = mShadowShader->GetVSVariant(CTEXT("VSCompact"));
+
+  const std::vector<D3D12_INPUT_ELEMENT_DESC>& compactLayout = GetInputLayout(VertexFormat::COMPACT);
+  const D3D12_INPUT_LAYOUT_DESC compactInputLayout            = {compactLayout.data(), (UINT)compactLayout.size()};
+
+  D3D12_GRAPHICS_PIPELINE_STATE_DESC standardCompactPsoDesc = standardPsoDesc;
+  standardCompactPsoDesc.InputLayout                        = compactInputLayout;
+  standardCompactPsoDesc.VS                                 = {reinterpret_cast<BYTE*>(pbrCompactVS->GetBufferPointer()), pbrCompactVS->GetBufferSize()};
+  TIFF(mGraphics->mD3dDevice->CreateGraphicsPipelineState(&standardCompactPsoDesc, IID_PPV_ARGS(&mPSOs[CTEXT("StandardPSOCompact")])));
+
+  D3D12_GRAPHICS_PIPELINE_STATE_DESC shadowCompactPsoDesc = shadowPsoDesc;
+  shadowCompactPsoDesc.InputLayout                        = compactInputLayout;
+  shadowCompactPsoDesc.VS                                 = {reinterpret_cast<BYTE*>(shadowCompactVS->GetBufferPointer()), shadowCompactVS->GetBufferSize()};
+  TIFF(mGraphics->mD3dDevice->CreateGraphicsPipelineState(&shadowCompactPsoDesc, IID_PPV_ARGS(&mPSOs[CTEXT("ShadowPSOCompact")])));
+
+  D3D12_GRAPHICS_PIPELINE_STATE_DESC transparentCompactPsoDesc = transparentPsoDesc;
+  transparentCompactPsoDesc.InputLayout                        = compactInputLayout;
+  transparentCompactPsoDesc.VS                                 = standardCompactPsoDesc.VS;
+  TIFF(mGraphics->mD3dDevice->CreateGraphicsPipelineState(&transparentCompactPsoDesc, IID_PPV_ARGS(&mPSOs[CTEXT("TransparentPSOCompact")])));
+
+  // Ids follow the submission order.
+  mShadowPass      = MakeDrawPass(0, mShadowShader, CTEXT("ShadowPSO"), true);
+  mOpaquePass      = MakeDrawPass(1, mPBRShader, CTEXT("StandardPSO"));
+  mSkyboxPass      = MakeDrawPass(2, mSkyboxShader, CTEXT("SkyboxPSO"));
+  mTransparentPass = MakeDrawPass(3, mPBRShader, CTEXT("TransparentPSO"));
+}
+
+DrawPass RenderExample::MakeDrawPass(uint32 id, Shader* shader, const CheString& psoName, bool indirect)
+{
+  auto compact = mPSOs.find(psoName + CTEXT("Compact"));
+
+  DrawPass pass;
+  pass.Id           = id;
+  pass.PassShader   = shader;
+  pass.Pipelines[0] = mPSOs[psoName].Get();
+  pass.Pipelines[1] = compact != mPSOs.end() ? compact->second.Get() : pass.Pipelines[0];
+
+  const uint32 shaderIndex = mRenderData->GetShaderIndex(shader);
+  if (indirect && shaderIndex != RenderData::INVALID_INDEX) {
+    const ShaderBinding& binding = mRenderData->GetShaderBinding(shaderIndex);
+    if (binding.ObjectCbvRootIndex != RenderData::INVALID_INDEX && binding.DrawConstantsRootIndex != RenderData::INVALID_INDEX) {
+      pass.CommandSignature = IndirectDrawBuffer::CreateCommandSignature(mGraphics->mD3dDevice.Get(), shader->GetRootSignature(), binding.ObjectCbvRootIndex,
+                                                                         binding.DrawConstantsRootIndex);
+    }
+  }
+  return pass;
+}
+
+void RenderExample::ReserveFrameScratch()
+{
+  uint32 maxDrawCount    = 0;
+  uint32 maxMeshletCount = 0;
+  for (RenderData* renderData : {mRenderData, mSkyboxRenderData}) {
+    uint32 drawCount = 0;
+    for (uint32 i = 0; i < renderData->GetItemCount(); ++i) {
+      const RenderItem& item = renderData->GetItemAt(i);
+      drawCount += static_cast<uint32>(item.GetDrawArgs().size());
+      if (!item.HasMeshlets()) continue;
+      for (uint32 argIndex = 0; argIndex < item.GetDrawArgs().size(); ++argIndex) {
+        maxMeshletCount = std::max<uint32>(maxMeshletCount, item.GetMeshlets(argIndex).GetMeshletCount());
+      }
+    }
+    maxDrawCount = std::max<uint32>(maxDrawCount, drawCount);
+    mCullViews.resize(std::max<uint32>(static_cast<uint32>(mCullViews.size()), renderData->GetItemCount()));
+  }
+  mVisibleDraws.reserve(maxDrawCount);
+  mShadowVisibleDraws.reserve(maxDrawCount);
+  mInstanceBatcher.Reserve(maxDrawCount);
+  for (RecordContext& context : mRecordContexts) context.ClusterRanges.reserve(maxMeshletCount);
+  // Every visible draw is one instance, the shadow pass and the two passes that split the camera draws.
+  mRenderData->ReserveInstances(2 * mRenderData->GetDrawCount());
+  // One command per batch of the shadow pass.
+  mIndirectDraws.Reserve(mGraphics->mD3dDevice.Get(), mRenderData->GetDrawCount());
 }
 
 DEFINE_APPLICATION_MAIN(RenderExample)
\ No newline at end of file
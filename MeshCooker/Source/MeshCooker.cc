@@ -0,0 +1,32 @@
+// Offline cooker: decodes glTF/glb models into the engine native .chm format.
+// Usage: MeshCooker <model.gltf|model.glb> [output.chm]
+#include <cstdio>
+#include "Model/ModelLoader.h"
+#include "Utils/Log/ConsoleLogDevice.h"
+#include "Utils/Log/Logger.h"
+
+int main(int argc, char** argv)
+{
+  if (argc < 2) {
+    printf("Usage: MeshCooker <model.gltf|model.glb> [output.chm]\n");
+    return 1;
+  }
+
+  logger.SetLogDevice(new ConsoleLogDevice());
+
+  const CheString fileName = ConvertToCheString(argv[1]);
+  CheString cookedFileName;
+  if (argc > 2) {
+    cookedFileName = ConvertToCheString(argv[2]);
+  } else {
+    const size_t dot = fileName.find_last_of(CTEXT('.'));
+    cookedFileName   = (dot == CheString::npos ? fileName : fileName.substr(0, dot)) + CTEXT(".chm");
+  }
+
+  ModelLoadOptions options;
+  options.MapBuffers     = true;
+  options.WeldVertices   = true;
+  options.OptimizeMeshes = true;
+  options.GenerateLods   = true;
+  return ModelLoader::CookGLTF(fileName, cookedFileName, options) ? 0 : 1;
+}